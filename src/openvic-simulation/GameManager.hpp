@@ -32,6 +32,8 @@ namespace OpenVic {
 		}
 
 		bool set_roots(Dataloader::path_vector_t const& roots);
+		/* Empty by default, disabling the definitions cache. */
+		void set_definitions_cache_directory(fs::path const& directory);
 
 		bool load_definitions(Dataloader::localisation_callback_t localisation_callback);
 
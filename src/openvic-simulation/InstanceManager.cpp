@@ -1,5 +1,7 @@
 #include "InstanceManager.hpp"
 
+#include <utility>
+
 #include "openvic-simulation/DefinitionManager.hpp"
 #include "openvic-simulation/utility/Logger.hpp"
 
@@ -9,6 +11,7 @@ InstanceManager::InstanceManager(
 	DefinitionManager const& new_definition_manager, gamestate_updated_func_t gamestate_updated_callback,
 	SimulationClock::state_changed_function_t clock_state_changed_callback
 ) : definition_manager { new_definition_manager },
+	market_instance { good_instance_manager },
 	map_instance { new_definition_manager.get_map_definition() },
 	simulation_clock {
 		std::bind(&InstanceManager::tick, this), std::bind(&InstanceManager::update_gamestate, this),
@@ -16,6 +19,8 @@ InstanceManager::InstanceManager(
 	},
 	game_instance_setup { false },
 	game_session_started { false },
+	incremental_modifier_sums { true },
+	verify_incremental_modifier_sums { false },
 	session_start { 0 },
 	bookmark { nullptr },
 	today {},
@@ -40,7 +45,7 @@ void InstanceManager::update_gamestate() {
 	Logger::info("Update: ", today);
 	update_modifier_sums();
 	// Update gamestate...
-	map_instance.update_gamestate(today, definition_manager.get_define_manager());
+	map_instance.update_gamestate(today, definition_manager.get_define_manager(), thread_pool);
 	country_instance_manager.update_gamestate(
 		today, definition_manager.get_define_manager(), definition_manager.get_military_manager().get_unit_type_manager(),
 		definition_manager.get_modifier_manager().get_modifier_effect_cache()
@@ -61,7 +66,44 @@ void InstanceManager::tick() {
 	Logger::info("Tick: ", today);
 
 	// Tick...
-	map_instance.tick(today);
+	unit_instance_manager.tick(map_instance, definition_manager.get_modifier_manager().get_modifier_effect_cache());
+	land_combat_engine.tick(
+		today, map_instance, unit_instance_manager, definition_manager.get_modifier_manager().get_modifier_effect_cache(),
+		definition_manager.get_define_manager().get_military_defines()
+	);
+	naval_combat_engine.tick(
+		today, map_instance, unit_instance_manager, definition_manager.get_modifier_manager().get_modifier_effect_cache(),
+		definition_manager.get_define_manager().get_military_defines(), thread_pool
+	);
+	siege_engine.tick(
+		today, map_instance, unit_instance_manager, country_instance_manager,
+		definition_manager.get_modifier_manager().get_modifier_effect_cache(),
+		definition_manager.get_define_manager().get_military_defines()
+	);
+	attrition_engine.tick(
+		unit_instance_manager, siege_engine,
+		definition_manager.get_modifier_manager().get_modifier_effect_cache(),
+		definition_manager.get_define_manager().get_military_defines()
+	);
+	map_instance.tick(
+		today, country_instance_manager, market_instance, definition_manager.get_modifier_manager().get_modifier_effect_cache(),
+		definition_manager.get_economy_manager().get_production_type_manager(), definition_manager.get_define_manager()
+	);
+	market_instance.execute_orders();
+	map_instance.after_orders_executed(
+		definition_manager.get_modifier_manager().get_modifier_effect_cache(), definition_manager.get_define_manager()
+	);
+	event_scheduler.tick(today, map_instance, country_instance_manager);
+
+	if (today.get_day() == 1) {
+		map_instance.update_pops_monthly(
+			today, country_instance_manager, definition_manager.get_define_manager().get_pops_defines(),
+			definition_manager.get_modifier_manager().get_modifier_effect_cache(), event_scheduler
+		);
+	}
+
+	// Sieges and anything else that changed controllers today take effect together
+	map_instance.apply_controller_changes(event_scheduler);
 
 	set_gamestate_needs_update();
 }
@@ -73,10 +115,20 @@ bool InstanceManager::setup() {
 	}
 
 	bool ret = good_instance_manager.setup(definition_manager.get_economy_manager().get_good_definition_manager());
+	ret &= market_instance.setup();
 	ret &= map_instance.setup(
 		definition_manager.get_economy_manager().get_building_type_manager(),
 		definition_manager.get_pop_manager().get_pop_types(),
-		definition_manager.get_politics_manager().get_ideology_manager().get_ideologies()
+		definition_manager.get_politics_manager().get_ideology_manager().get_ideologies(),
+		definition_manager.get_politics_manager().get_issue_manager()
+	);
+	ret &= map_instance.get_pop_needs_kernel().setup(
+		definition_manager.get_pop_manager().get_pop_types(),
+		definition_manager.get_economy_manager().get_good_definition_manager(),
+		definition_manager.get_define_manager().get_pops_defines(), map_instance.get_province_instance_count()
+	);
+	ret &= map_instance.get_pop_transition_engine().setup(
+		definition_manager.get_pop_manager(), map_instance.get_province_instance_count()
 	);
 	ret &= country_instance_manager.generate_country_instances(
 		definition_manager.get_country_definition_manager(),
@@ -91,6 +143,7 @@ bool InstanceManager::setup() {
 		definition_manager.get_military_manager().get_unit_type_manager().get_regiment_types(),
 		definition_manager.get_military_manager().get_unit_type_manager().get_ship_types()
 	);
+	ret &= event_scheduler.setup(definition_manager.get_event_manager(), map_instance, country_instance_manager);
 
 	game_instance_setup = true;
 
@@ -140,7 +193,11 @@ bool InstanceManager::load_bookmark(Bookmark const* new_bookmark) {
 
 	if (ret) {
 		update_modifier_sums();
-		map_instance.initialise_for_new_game(definition_manager.get_modifier_manager().get_modifier_effect_cache());
+		// RGOs need up to date province and state populations for their first day of production
+		map_instance.update_gamestate(today, definition_manager.get_define_manager(), thread_pool);
+		ret &= map_instance.initialise_for_new_game(
+			market_instance, definition_manager.get_modifier_manager().get_modifier_effect_cache()
+		);
 	}
 
 	return ret;
@@ -186,28 +243,71 @@ bool InstanceManager::expand_selected_province_building(size_t building_index) {
 }
 
 void InstanceManager::update_modifier_sums() {
-	if constexpr (ProvinceInstance::ADD_OWNER_CONTRIBUTION) {
-		// Calculate local province modifier sums first, then national country modifier sums, then loop over owned provinces
-		// adding their contributions to the owner country's modifier sum and loop over them again to add the country's total
-		// (including province contributions) to the provinces' modifier sum. This results in every country and province
-		// having a full copy of all the modifiers affecting them in their modifier sum.
-		map_instance.update_modifier_sums(
-			today, definition_manager.get_modifier_manager().get_static_modifier_cache()
-		);
-		country_instance_manager.update_modifier_sums(
-			today, definition_manager.get_modifier_manager().get_static_modifier_cache()
-		);
-	} else {
-		// Calculate national country modifier sums first, then local province modifier sums, adding province contributions
-		// to owner countries' modifier sums if each province has an owner. This results in every country having a full copy
-		// of all the modifiers affecting them in their modifier sum, but provinces only having their directly/locally applied
-		// modifiers in their modifier sum, hence requiring both province and owner country modifier effect values to be looked
-		// up and added together to get the full effect on the province.
-		country_instance_manager.update_modifier_sums(
-			today, definition_manager.get_modifier_manager().get_static_modifier_cache()
-		);
-		map_instance.update_modifier_sums(
-			today, definition_manager.get_modifier_manager().get_static_modifier_cache()
-		);
+	if (!incremental_modifier_sums) {
+		rebuild_modifier_sums();
+		return;
+	}
+
+	StaticModifierCache const& static_modifier_cache =
+		definition_manager.get_modifier_manager().get_static_modifier_cache();
+
+	// Same order as a full rebuild, although as province contributions are tracked by source it isn't required here
+	map_instance.update_modifier_sums_incremental(today, static_modifier_cache);
+	country_instance_manager.update_modifier_sums_incremental(today, static_modifier_cache);
+
+	if (verify_incremental_modifier_sums) {
+		verify_modifier_sums();
+	}
+}
+
+void InstanceManager::rebuild_modifier_sums() {
+	// Calculate local province modifier sums first, then national country modifier sums, adding the contributions of
+	// controlled provinces to each country's modifier sum. Provinces' modifier sums reference their owner country's
+	// modifier sum as a parent layer, so effect lookups on a province return the total including its owner's modifiers
+	// without them being copied into every province's modifier sum.
+	map_instance.update_modifier_sums(
+		today, definition_manager.get_modifier_manager().get_static_modifier_cache()
+	);
+	country_instance_manager.update_modifier_sums(
+		today, definition_manager.get_modifier_manager().get_static_modifier_cache()
+	);
+}
+
+bool InstanceManager::verify_modifier_sums() {
+	StaticModifierCache const& static_modifier_cache =
+		definition_manager.get_modifier_manager().get_static_modifier_cache();
+
+	// Rebuilt into scratch sums, so checking never changes the live sums or their generations
+	std::vector<ModifierSum> province_sums;
+	map_instance.build_modifier_sums(today, static_modifier_cache, province_sums);
+
+	std::vector<ModifierSum> country_sums;
+	country_instance_manager.build_modifier_sums(today, static_modifier_cache, province_sums, country_sums);
+
+	std::vector<ProvinceInstance> const& provinces = std::as_const(map_instance).get_province_instances();
+	std::vector<CountryInstance> const& countries = country_instance_manager.get_country_instances();
+
+	bool ret = true;
+
+	for (size_t index = 0; index < provinces.size(); ++index) {
+		if (!province_sums[index].has_equal_effect_values(provinces[index].get_modifier_sum())) {
+			Logger::error(
+				"Incrementally updated modifier sum of province ", provinces[index].get_identifier(),
+				" differs from its full rebuild!"
+			);
+			ret = false;
+		}
 	}
-}
\ No newline at end of file
+
+	for (size_t index = 0; index < countries.size(); ++index) {
+		if (!country_sums[index].has_equal_effect_values(countries[index].get_modifier_sum())) {
+			Logger::error(
+				"Incrementally updated modifier sum of country ", countries[index].get_identifier(),
+				" differs from its full rebuild!"
+			);
+			ret = false;
+		}
+	}
+
+	return ret;
+}
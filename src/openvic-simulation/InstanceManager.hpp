@@ -5,11 +5,18 @@
 #include "openvic-simulation/country/CountryInstance.hpp"
 #include "openvic-simulation/diplomacy/CountryRelation.hpp"
 #include "openvic-simulation/economy/GoodInstance.hpp"
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
 #include "openvic-simulation/map/MapInstance.hpp"
 #include "openvic-simulation/map/Mapmode.hpp"
+#include "openvic-simulation/military/Attrition.hpp"
+#include "openvic-simulation/military/LandCombat.hpp"
+#include "openvic-simulation/military/NavalCombat.hpp"
+#include "openvic-simulation/military/Siege.hpp"
 #include "openvic-simulation/military/UnitInstanceGroup.hpp"
+#include "openvic-simulation/misc/EventScheduler.hpp"
 #include "openvic-simulation/misc/SimulationClock.hpp"
 #include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/utility/ThreadPool.hpp"
 
 namespace OpenVic {
 	struct DefinitionManager;
@@ -21,19 +28,39 @@ namespace OpenVic {
 	private:
 		DefinitionManager const& PROPERTY(definition_manager);
 
+		/* Declared first so worker threads outlive every manager whose update phases they run. */
+		ThreadPool PROPERTY_REF(thread_pool);
+
 		CountryInstanceManager PROPERTY_REF(country_instance_manager);
 		CountryRelationManager PROPERTY_REF(country_relation_manager);
 		GoodInstanceManager PROPERTY_REF(good_instance_manager);
+		MarketInstance PROPERTY_REF(market_instance);
 		UnitInstanceManager PROPERTY_REF(unit_instance_manager);
+		LandCombatEngine PROPERTY_REF(land_combat_engine);
+		NavalCombatEngine PROPERTY_REF(naval_combat_engine);
+		SiegeEngine PROPERTY_REF(siege_engine);
+		AttritionEngine PROPERTY_REF(attrition_engine);
 		/* Near the end so it is freed after other managers that may depend on it,
 		 * e.g. if we want to remove military units from the province they're in when they're destructed. */
 		MapInstance PROPERTY_REF(map_instance);
+		EventScheduler PROPERTY_REF(event_scheduler);
 		SimulationClock PROPERTY_REF(simulation_clock);
 
 		bool PROPERTY_CUSTOM_PREFIX(game_instance_setup, is);
 		bool PROPERTY_CUSTOM_PREFIX(game_session_started, is);
 
+		/* If true, modifier sums are updated by only applying what has changed since the previous update rather than
+		 * being rebuilt from scratch. Changes to a modifier source, e.g. a technology being unlocked or a province
+		 * changing hands, mark the group of modifiers it feeds dirty, and only dirty groups are regathered and have
+		 * their changed entries swapped in the sums they feed. */
+		bool PROPERTY_RW(incremental_modifier_sums);
+		/* Debug check which rebuilds every modifier sum into a scratch copy after each incremental update and logs any
+		 * that differ from the live sums, which are left as they are. */
+		bool PROPERTY_RW(verify_incremental_modifier_sums);
+
 		void update_modifier_sums();
+		void rebuild_modifier_sums();
+		bool verify_modifier_sums();
 	public:
 		inline constexpr bool is_bookmark_loaded() const {
 			return bookmark != nullptr;
@@ -1,5 +1,7 @@
 #include "CountryInstance.hpp"
 
+#include <algorithm>
+
 #include "openvic-simulation/country/CountryDefinition.hpp"
 #include "openvic-simulation/defines/Define.hpp"
 #include "openvic-simulation/history/CountryHistory.hpp"
@@ -45,6 +47,10 @@ CountryInstance::CountryInstance(
 	states {},
 	modifier_sum {},
 	event_modifiers {},
+	modifier_groups {},
+	// Every group starts dirty, so the first update gathers them all
+	dirty_modifier_groups { (1 << static_cast<uint8_t>(modifier_group_t::MODIFIER_GROUP_COUNT)) - 1 },
+	earliest_event_modifier_expiry {},
 
 	/* Production */
 	industrial_power { 0 },
@@ -101,6 +107,9 @@ CountryInstance::CountryInstance(
 	prestige { 0 },
 	prestige_rank { 0 },
 	diplomatic_points { 0 },
+	war_enemies {},
+	military_access_countries {},
+	passability_version { 0 },
 
 	/* Military */
 	military_power { 0 },
@@ -181,6 +190,13 @@ bool CountryInstance::is_secondary_power() const {
 	return country_status == COUNTRY_STATUS_SECONDARY_POWER;
 }
 
+void CountryInstance::_set_country_status(country_status_t new_country_status) {
+	if (country_status != new_country_status) {
+		country_status = new_country_status;
+		_mark_modifier_group_dirty(modifier_group_t::STATUS);
+	}
+}
+
 bool CountryInstance::set_country_flag(std::string_view flag, bool warn) {
 	if (flag.empty()) {
 		Logger::error("Attempted to set empty country flag for country ", get_identifier());
@@ -237,6 +253,27 @@ ADD_AND_REMOVE(accepted_culture)
 
 #undef ADD_AND_REMOVE
 
+void CountryInstance::_update_controlled_provinces(
+	std::span<ProvinceInstance* const> lost, std::span<ProvinceInstance* const> gained
+) {
+	if (!lost.empty()) {
+		/* Rebuilt in one pass rather than erasing one at a time, as each erase shifts every later province */
+		ordered_set<ProvinceInstance*> remaining_provinces;
+		remaining_provinces.reserve(controlled_provinces.size() + gained.size());
+		for (ProvinceInstance* province : controlled_provinces) {
+			if (!std::binary_search(lost.begin(), lost.end(), province, std::less<> {})) {
+				remaining_provinces.insert(province);
+			}
+		}
+		controlled_provinces = std::move(remaining_provinces);
+	}
+
+	controlled_provinces.reserve(controlled_provinces.size() + gained.size());
+	for (ProvinceInstance* province : gained) {
+		controlled_provinces.insert(province);
+	}
+}
+
 bool CountryInstance::set_upper_house(Ideology const* ideology, fixed_point_t popularity) {
 	if (ideology != nullptr) {
 		upper_house[*ideology] = popularity;
@@ -250,6 +287,7 @@ bool CountryInstance::set_upper_house(Ideology const* ideology, fixed_point_t po
 bool CountryInstance::set_ruling_party(CountryParty const& new_ruling_party) {
 	if (ruling_party != &new_ruling_party) {
 		ruling_party = &new_ruling_party;
+		_mark_modifier_group_dirty(modifier_group_t::POLITICS);
 
 		return update_rule_set();
 	} else {
@@ -270,6 +308,7 @@ bool CountryInstance::add_reform(Reform const& new_reform) {
 		}
 
 		reform = &new_reform;
+		_mark_modifier_group_dirty(modifier_group_t::POLITICS);
 
 		// TODO - if new_reform.get_reform_group().get_type().is_uncivilised() ?
 		// TODO - new_reform.get_on_execute_trigger() / new_reform.get_on_execute_effect() ?
@@ -280,6 +319,47 @@ bool CountryInstance::add_reform(Reform const& new_reform) {
 	}
 }
 
+bool CountryInstance::is_at_war_with(CountryInstance const& other) const {
+	return war_enemies.contains(const_cast<CountryInstance*>(&other));
+}
+
+bool CountryInstance::set_at_war_with(CountryInstance& other, bool at_war) {
+	if (&other == this) {
+		Logger::error("Country ", get_identifier(), " cannot be at war with itself!");
+		return false;
+	}
+
+	if (at_war) {
+		war_enemies.emplace(&other);
+		other.war_enemies.emplace(this);
+	} else {
+		war_enemies.erase(&other);
+		other.war_enemies.erase(this);
+	}
+	++passability_version;
+	++other.passability_version;
+	return true;
+}
+
+bool CountryInstance::has_military_access_to(CountryInstance const& other) const {
+	return military_access_countries.contains(const_cast<CountryInstance*>(&other));
+}
+
+bool CountryInstance::set_military_access(CountryInstance& grantor, bool has_access) {
+	if (&grantor == this) {
+		Logger::error("Country ", get_identifier(), " cannot grant military access to itself!");
+		return false;
+	}
+
+	if (has_access) {
+		military_access_countries.emplace(&grantor);
+	} else {
+		military_access_countries.erase(&grantor);
+	}
+	++passability_version;
+	return true;
+}
+
 template<UnitType::branch_t Branch>
 bool CountryInstance::add_unit_instance_group(UnitInstanceGroup<Branch>& group) {
 	if (get_unit_instance_groups<Branch>().emplace(static_cast<UnitInstanceGroupBranched<Branch>*>(&group)).second) {
@@ -561,6 +641,7 @@ bool CountryInstance::modify_technology_unlock(Technology const& technology, unl
 	}
 
 	unlock_level += unlock_level_change;
+	_mark_modifier_group_dirty(modifier_group_t::TECHNOLOGY);
 
 	bool ret = true;
 
@@ -607,6 +688,7 @@ bool CountryInstance::modify_invention_unlock(Invention const& invention, unlock
 	}
 
 	unlock_level += unlock_level_change;
+	_mark_modifier_group_dirty(modifier_group_t::TECHNOLOGY);
 
 	bool ret = true;
 
@@ -696,13 +778,19 @@ bool CountryInstance::apply_history_to_country(
 	set_optional(plurality, entry.get_plurality());
 	set_optional(national_value, entry.get_national_value());
 	if (entry.is_civilised()) {
-		country_status = *entry.is_civilised() ? COUNTRY_STATUS_CIVILISED : COUNTRY_STATUS_UNCIVILISED;
+		_set_country_status(*entry.is_civilised() ? COUNTRY_STATUS_CIVILISED : COUNTRY_STATUS_UNCIVILISED);
 	}
 	set_optional(prestige, entry.get_prestige());
 	for (Reform const* reform : entry.get_reforms()) {
 		ret &= add_reform(*reform);
 	}
 	set_optional(tech_school, entry.get_tech_school());
+	if (entry.get_plurality()) {
+		_mark_modifier_group_dirty(modifier_group_t::SCALED);
+	}
+	if (entry.get_national_value() || entry.get_tech_school()) {
+		_mark_modifier_group_dirty(modifier_group_t::POLITICS);
+	}
 	constexpr auto set_bool_map_to_indexed_map =
 		[]<typename T>(IndexedMap<T, bool>& target, ordered_map<T const*, bool> source) {
 			for (auto const& [key, value] : source) {
@@ -788,6 +876,8 @@ void CountryInstance::_update_politics() {
 }
 
 void CountryInstance::_update_population() {
+	const fixed_point_t old_national_literacy = national_literacy;
+
 	total_population = 0;
 	national_literacy = 0;
 	national_consciousness = 0;
@@ -812,6 +902,10 @@ void CountryInstance::_update_population() {
 		national_militancy /= total_population;
 	}
 
+	if (national_literacy != old_national_literacy) {
+		_mark_modifier_group_dirty(modifier_group_t::SCALED);
+	}
+
 	// TODO - update national focus capacity
 }
 
@@ -934,101 +1028,219 @@ bool CountryInstance::update_rule_set() {
 	return rule_set.trim_and_resolve_conflicts(true);
 }
 
-void CountryInstance::update_modifier_sum(Date today, StaticModifierCache const& static_modifier_cache) {
-	// Update sum of national modifiers
-	modifier_sum.clear();
+void CountryInstance::_mark_modifier_group_dirty(modifier_group_t group) {
+	dirty_modifier_groups |= 1 << static_cast<uint8_t>(group);
+}
+
+void CountryInstance::_gather_modifier_group(
+	modifier_group_t group, Date today, StaticModifierCache const& static_modifier_cache,
+	std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+) {
+	using enum ModifierEffect::target_t;
 
 	const ModifierSum::modifier_source_t country_source { this };
 
-	// Erase expired event modifiers and add non-expired ones to the sum
-	std::erase_if(event_modifiers, [this, today, &country_source](ModifierInstance const& modifier) -> bool {
-		if (today <= modifier.get_expiry_date()) {
-			modifier_sum.add_modifier(*modifier.get_modifier(), country_source);
-			return false;
-		} else {
-			return true;
+	// Matches ModifierSum::add_modifier, skipping null modifiers and zero multipliers
+	const auto add_modifier = [&modifier_entries, &country_source](
+		Modifier const* modifier, fixed_point_t multiplier = fixed_point_t::_1()
+	) -> void {
+		if (modifier != nullptr && multiplier != fixed_point_t::_0()) {
+			modifier_entries.emplace_back(modifier, multiplier, country_source, NO_TARGETS);
 		}
-	});
+	};
 
-	// Add static modifiers
-	modifier_sum.add_modifier(static_modifier_cache.get_base_modifier(), country_source);
+	switch (group) {
+	case modifier_group_t::EVENT:
+		// Erase expired event modifiers and add non-expired ones to the list
+		std::erase_if(event_modifiers, [today, &add_modifier](ModifierInstance const& modifier) -> bool {
+			if (today <= modifier.get_expiry_date()) {
+				add_modifier(modifier.get_modifier());
+				return false;
+			} else {
+				return true;
+			}
+		});
+
+		if (!event_modifiers.empty()) {
+			earliest_event_modifier_expiry = std::min_element(
+				event_modifiers.begin(), event_modifiers.end(),
+				[](ModifierInstance const& lhs, ModifierInstance const& rhs) -> bool {
+					return lhs.get_expiry_date() < rhs.get_expiry_date();
+				}
+			)->get_expiry_date();
+		}
+		break;
+
+	case modifier_group_t::STATUS:
+		add_modifier(&static_modifier_cache.get_base_modifier());
+
+		switch (country_status) {
+			using enum country_status_t;
+		case COUNTRY_STATUS_GREAT_POWER:
+			add_modifier(&static_modifier_cache.get_great_power());
+			break;
+		case COUNTRY_STATUS_SECONDARY_POWER:
+			add_modifier(&static_modifier_cache.get_secondary_power());
+			break;
+		case COUNTRY_STATUS_CIVILISED:
+			add_modifier(&static_modifier_cache.get_civilised());
+			break;
+		default:
+			add_modifier(&static_modifier_cache.get_uncivilised());
+		}
+		if (is_disarmed()) {
+			add_modifier(&static_modifier_cache.get_disarming());
+		}
+		// TODO - difficulty modifiers, war, peace, debt_default_to, bad_debter, generalised_debt_default,
+		//        total_occupation, total_blockaded, in_bankrupcy
+
+		// TODO - handle triggered modifiers
+		break;
 
-	switch (country_status) {
-		using enum country_status_t;
-	case COUNTRY_STATUS_GREAT_POWER:
-		modifier_sum.add_modifier(static_modifier_cache.get_great_power(), country_source);
+	case modifier_group_t::SCALED:
+		add_modifier(&static_modifier_cache.get_war_exhaustion(), war_exhaustion);
+		add_modifier(&static_modifier_cache.get_infamy(), infamy);
+		add_modifier(&static_modifier_cache.get_literacy(), national_literacy);
+		add_modifier(&static_modifier_cache.get_plurality(), plurality);
 		break;
-	case COUNTRY_STATUS_SECONDARY_POWER:
-		modifier_sum.add_modifier(static_modifier_cache.get_secondary_power(), country_source);
+
+	case modifier_group_t::POLITICS:
+		if (ruling_party != nullptr) {
+			for (Issue const* issue : ruling_party->get_policies()) {
+				// The ruling party's issues here could be null as they're stored in an IndexedMap which has
+				// values for every IssueGroup regardless of whether or not they have a policy set.
+				add_modifier(issue);
+			}
+		}
+
+		for (Reform const* reform : reforms) {
+			// The country's reforms here could be null as they're stored in an IndexedMap which has
+			// values for every ReformGroup regardless of whether or not they have a reform set.
+			add_modifier(reform);
+		}
+
+		add_modifier(national_value);
+
+		add_modifier(tech_school);
 		break;
-	case COUNTRY_STATUS_CIVILISED:
-		modifier_sum.add_modifier(static_modifier_cache.get_civilised(), country_source);
+
+	case modifier_group_t::TECHNOLOGY:
+		for (Technology const& technology : *technology_unlock_levels.get_keys()) {
+			if (is_technology_unlocked(technology)) {
+				add_modifier(&technology);
+			}
+		}
+
+		for (Invention const& invention : *invention_unlock_levels.get_keys()) {
+			if (is_invention_unlocked(invention)) {
+				add_modifier(&invention);
+			}
+		}
 		break;
+
 	default:
-		modifier_sum.add_modifier(static_modifier_cache.get_uncivilised(), country_source);
+		break;
 	}
-	if (is_disarmed()) {
-		modifier_sum.add_modifier(static_modifier_cache.get_disarming(), country_source);
+}
+
+void CountryInstance::_gather_national_modifiers(
+	Date today, StaticModifierCache const& static_modifier_cache,
+	std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+) {
+	modifier_entries.clear();
+
+	for (uint8_t group = 0; group < static_cast<uint8_t>(modifier_group_t::MODIFIER_GROUP_COUNT); ++group) {
+		_gather_modifier_group(static_cast<modifier_group_t>(group), today, static_modifier_cache, modifier_entries);
 	}
-	modifier_sum.add_modifier(static_modifier_cache.get_war_exhaustion(), country_source, war_exhaustion);
-	modifier_sum.add_modifier(static_modifier_cache.get_infamy(), country_source, infamy);
-	modifier_sum.add_modifier(static_modifier_cache.get_literacy(), country_source, national_literacy);
-	modifier_sum.add_modifier(static_modifier_cache.get_plurality(), country_source, plurality);
-	// TODO - difficulty modifiers, war, peace, debt_default_to, bad_debter, generalised_debt_default,
-	//        total_occupation, total_blockaded, in_bankrupcy
+}
 
-	// TODO - handle triggered modifiers
+void CountryInstance::update_modifier_sum(Date today, StaticModifierCache const& static_modifier_cache) {
+	// Update sum of national modifiers
+	modifier_sum.clear();
 
-	if (ruling_party != nullptr) {
-		for (Issue const* issue : ruling_party->get_policies()) {
-			// The ruling party's issues here could be null as they're stored in an IndexedMap which has
-			// values for every IssueGroup regardless of whether or not they have a policy set.
-			modifier_sum.add_modifier_nullcheck(issue, country_source);
-		}
+	for (uint8_t group = 0; group < static_cast<uint8_t>(modifier_group_t::MODIFIER_GROUP_COUNT); ++group) {
+		std::vector<ModifierSum::modifier_entry_t>& group_entries = modifier_groups[group];
+		group_entries.clear();
+		_gather_modifier_group(static_cast<modifier_group_t>(group), today, static_modifier_cache, group_entries);
+		modifier_sum.add_modifiers(group_entries);
 	}
+	dirty_modifier_groups = 0;
 
-	for (Reform const* reform : reforms) {
-		// The country's reforms here could be null as they're stored in an IndexedMap which has
-		// values for every ReformGroup regardless of whether or not they have a reform set.
-		modifier_sum.add_modifier_nullcheck(reform, country_source);
+	// Add province base modifiers (with local province modifier effects removed). Owned provinces' sums reference this
+	// sum as their parent layer, so there's no need to copy it back into them.
+	for (ProvinceInstance const* province : controlled_provinces) {
+		contribute_province_modifier_sum(*province);
 	}
 
-	modifier_sum.add_modifier_nullcheck(national_value, country_source);
+	// TODO - calculate stats for each unit type (locked and unlocked)
+}
 
-	modifier_sum.add_modifier_nullcheck(tech_school, country_source);
+void CountryInstance::update_modifier_sum_incremental(
+	Date today, StaticModifierCache const& static_modifier_cache, std::vector<ModifierSum::modifier_entry_t>& scratch
+) {
+	if (!event_modifiers.empty() && today > earliest_event_modifier_expiry) {
+		_mark_modifier_group_dirty(modifier_group_t::EVENT);
+	}
 
-	for (Technology const& technology : *technology_unlock_levels.get_keys()) {
-		if (is_technology_unlocked(technology)) {
-			modifier_sum.add_modifier(technology, country_source);
+	for (uint8_t group = 0; dirty_modifier_groups != 0; ++group) {
+		const uint8_t group_bit = 1 << group;
+		if ((dirty_modifier_groups & group_bit) == 0) {
+			continue;
 		}
-	}
+		dirty_modifier_groups &= ~group_bit;
+
+		std::vector<ModifierSum::modifier_entry_t>& group_entries = modifier_groups[group];
+
+		scratch.clear();
+		_gather_modifier_group(static_cast<modifier_group_t>(group), today, static_modifier_cache, scratch);
+
+		std::span<const ModifierSum::modifier_entry_t> removed_entries = group_entries;
+		std::span<const ModifierSum::modifier_entry_t> added_entries = scratch;
+		ModifierSum::trim_unchanged_modifiers(removed_entries, added_entries);
 
-	for (Invention const& invention : *invention_unlock_levels.get_keys()) {
-		if (is_invention_unlocked(invention)) {
-			modifier_sum.add_modifier(invention, country_source);
+		if (!removed_entries.empty() || !added_entries.empty()) {
+			modifier_sum.remove_modifiers(removed_entries);
+			modifier_sum.add_modifiers(added_entries);
 		}
+
+		group_entries.swap(scratch);
 	}
+}
 
-	if constexpr (ProvinceInstance::ADD_OWNER_CONTRIBUTION) {
-		// Add province base modifiers (with local province modifier effects removed)
-		for (ProvinceInstance const* province : controlled_provinces) {
-			contribute_province_modifier_sum(province->get_modifier_sum());
-		}
+void CountryInstance::build_modifier_sum(
+	Date today, StaticModifierCache const& static_modifier_cache, std::span<const ModifierSum> province_sums,
+	ModifierSum& sum, std::vector<ModifierSum::modifier_entry_t>& scratch
+) {
+	using enum ModifierEffect::target_t;
 
-		// This has to be done after adding all province modifiers to the country's sum, otherwise provinces
-		// earlier in the list wouldn't be affected by modifiers from provinces later in the list.
-		for (ProvinceInstance* province : owned_provinces) {
-			province->contribute_country_modifier_sum(modifier_sum);
-		}
+	sum.clear();
+
+	_gather_national_modifiers(today, static_modifier_cache, scratch);
+	sum.add_modifiers(scratch);
+
+	for (ProvinceInstance const* province : controlled_provinces) {
+		sum.add_modifier_sum_exclude_targets(province_sums[province->get_province_definition().get_index() - 1], PROVINCE);
 	}
+}
 
-	// TODO - calculate stats for each unit type (locked and unlocked)
+void CountryInstance::contribute_province_modifier_sum(ProvinceInstance const& province) {
+	using enum ModifierEffect::target_t;
+
+	modifier_sum.add_modifier_sum_exclude_targets(province.get_modifier_sum(), PROVINCE);
 }
 
-void CountryInstance::contribute_province_modifier_sum(ModifierSum const& province_modifier_sum) {
+void CountryInstance::remove_province_modifier_contribution(ProvinceInstance const& province) {
+	modifier_sum.remove_modifiers_by_source(&province);
+}
+
+void CountryInstance::update_province_modifier_contribution(
+	std::span<const ModifierSum::modifier_entry_t> removed_entries,
+	std::span<const ModifierSum::modifier_entry_t> added_entries
+) {
 	using enum ModifierEffect::target_t;
 
-	modifier_sum.add_modifier_sum_exclude_targets(province_modifier_sum, PROVINCE);
+	modifier_sum.remove_modifiers(removed_entries, PROVINCE);
+	modifier_sum.add_modifiers(added_entries, PROVINCE);
 }
 
 fixed_point_t CountryInstance::get_modifier_effect_value(ModifierEffect const& effect) const {
@@ -1152,7 +1364,7 @@ void CountryInstanceManager::update_rankings(Date today, DefineManager const& de
 	// ahead for countries below the max great power rank but still within the demotion grace period.
 	for (CountryInstance* great_power : great_powers) {
 		if (great_power->get_total_rank() > max_great_power_rank && great_power->get_lose_great_power_date() < today) {
-			great_power->country_status = COUNTRY_STATUS_CIVILISED;
+			great_power->_set_country_status(COUNTRY_STATUS_CIVILISED);
 		}
 	}
 	std::erase_if(great_powers, [](CountryInstance const* country) -> bool {
@@ -1162,7 +1374,7 @@ void CountryInstanceManager::update_rankings(Date today, DefineManager const& de
 	// Demote all secondary powers and clear the list. We will rebuilt the whole list from scratch, so there's no need to
 	// keep countries which are still above the max secondary power rank (they might become great powers instead anyway).
 	for (CountryInstance* secondary_power : secondary_powers) {
-		secondary_power->country_status = COUNTRY_STATUS_CIVILISED;
+		secondary_power->_set_country_status(COUNTRY_STATUS_CIVILISED);
 	}
 	secondary_powers.clear();
 
@@ -1188,11 +1400,11 @@ void CountryInstanceManager::update_rankings(Date today, DefineManager const& de
 		if (great_powers.size() < max_great_power_rank && country->get_total_rank() <= max_great_power_rank) {
 			// The country is eligible for great power status and there are still slots available,
 			// so it is promoted and added to the list.
-			country->country_status = COUNTRY_STATUS_GREAT_POWER;
+			country->_set_country_status(COUNTRY_STATUS_GREAT_POWER);
 			great_powers.push_back(country);
 		} else if (country->get_total_rank() <= max_secondary_power_rank) {
 			// The country is eligible for secondary power status and so is promoted and added to the list.
-			country->country_status = COUNTRY_STATUS_SECONDARY_POWER;
+			country->_set_country_status(COUNTRY_STATUS_SECONDARY_POWER);
 			secondary_powers.push_back(country);
 		}
 	}
@@ -1304,6 +1516,30 @@ void CountryInstanceManager::update_modifier_sums(Date today, StaticModifierCach
 	}
 }
 
+void CountryInstanceManager::update_modifier_sums_incremental(
+	Date today, StaticModifierCache const& static_modifier_cache
+) {
+	std::vector<ModifierSum::modifier_entry_t> scratch;
+
+	for (CountryInstance& country : country_instances.get_items()) {
+		country.update_modifier_sum_incremental(today, static_modifier_cache, scratch);
+	}
+}
+
+void CountryInstanceManager::build_modifier_sums(
+	Date today, StaticModifierCache const& static_modifier_cache, std::span<const ModifierSum> province_sums,
+	std::vector<ModifierSum>& sums
+) {
+	std::vector<ModifierSum::modifier_entry_t> scratch;
+
+	sums.resize(country_instances.get_items().size());
+	for (size_t index = 0; index < sums.size(); ++index) {
+		country_instances.get_items()[index].build_modifier_sum(
+			today, static_modifier_cache, province_sums, sums[index], scratch
+		);
+	}
+}
+
 void CountryInstanceManager::update_gamestate(
 	Date today, DefineManager const& define_manager, UnitTypeManager const& unit_type_manager,
 	ModifierEffectCache const& modifier_effect_cache
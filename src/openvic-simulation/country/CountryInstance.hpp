@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 #include <plf_colony.h>
@@ -42,6 +45,7 @@ namespace OpenVic {
 	 * but can be swapped with other CountryInstance's CountryDefinition when switching tags. */
 	struct CountryInstance {
 		friend struct CountryInstanceManager;
+		friend struct MapInstance;
 
 		/*
 			Westernisation Progress vs Status for Uncivilised Countries:
@@ -87,6 +91,23 @@ namespace OpenVic {
 		ModifierSum PROPERTY(modifier_sum);
 		std::vector<ModifierInstance> PROPERTY(event_modifiers);
 
+		/* Incremental modifier sum bookkeeping, as for provinces: the national modifiers currently in modifier_sum are
+		 * kept in groups by what they depend on, and whatever changes a group's inputs marks it dirty so only that
+		 * group's changed entries are swapped at the next update. */
+		enum struct modifier_group_t : uint8_t {
+			EVENT, // Event modifiers, until they expire
+			STATUS, // Base modifier, great/secondary power or civilisation status and disarmament
+			SCALED, // Modifiers scaled by war exhaustion, infamy, literacy and plurality
+			POLITICS, // Ruling party policies, reforms, national value and tech school
+			TECHNOLOGY, // Unlocked technologies and inventions
+			MODIFIER_GROUP_COUNT
+		};
+		std::array<
+			std::vector<ModifierSum::modifier_entry_t>, static_cast<size_t>(modifier_group_t::MODIFIER_GROUP_COUNT)
+		> modifier_groups;
+		uint8_t dirty_modifier_groups; // One bit per modifier_group_t
+		Date earliest_event_modifier_expiry; // Only meaningful while there are event modifiers
+
 		/* Production */
 		fixed_point_t PROPERTY(industrial_power);
 		std::vector<std::pair<State const*, fixed_point_t>> PROPERTY(industrial_power_from_states);
@@ -150,7 +171,13 @@ namespace OpenVic {
 		fixed_point_t PROPERTY(prestige);
 		size_t PROPERTY(prestige_rank);
 		fixed_point_t PROPERTY(diplomatic_points);
-		// TODO - colonial power, current wars
+		// TODO - colonial power, wars
+		/* Countries this one is at war with, kept symmetric by set_at_war_with. */
+		ordered_set<CountryInstance*> PROPERTY(war_enemies);
+		/* Countries granting this one military access through their land. */
+		ordered_set<CountryInstance*> PROPERTY(military_access_countries);
+		/* Incremented whenever the wars or military access that decide where this country's armies may go change. */
+		uint32_t PROPERTY(passability_version);
 
 		/* Military */
 		fixed_point_t PROPERTY(military_power);
@@ -200,6 +227,13 @@ namespace OpenVic {
 			decltype(ship_type_unlock_levels)::keys_t const& ship_type_unlock_levels_keys
 		);
 
+		void _set_country_status(country_status_t new_country_status);
+
+		/* Applies a batch of controller changes, lost must be sorted by address. */
+		void _update_controlled_provinces(
+			std::span<ProvinceInstance* const> lost, std::span<ProvinceInstance* const> gained
+		);
+
 	public:
 		std::string_view get_identifier() const;
 
@@ -227,6 +261,11 @@ namespace OpenVic {
 		bool set_ruling_party(CountryParty const& new_ruling_party);
 		bool add_reform(Reform const& new_reform);
 
+		bool is_at_war_with(CountryInstance const& other) const;
+		bool set_at_war_with(CountryInstance& other, bool at_war);
+		bool has_military_access_to(CountryInstance const& other) const;
+		bool set_military_access(CountryInstance& grantor, bool has_access);
+
 		template<UnitType::branch_t Branch>
 		bool add_unit_instance_group(UnitInstanceGroup<Branch>& group);
 		template<UnitType::branch_t Branch>
@@ -304,10 +343,41 @@ namespace OpenVic {
 
 		bool update_rule_set();
 
+		void _mark_modifier_group_dirty(modifier_group_t group);
+		// Appends the group's current entries to modifier_entries.
+		void _gather_modifier_group(
+			modifier_group_t group, Date today, StaticModifierCache const& static_modifier_cache,
+			std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+		);
+		void _gather_national_modifiers(
+			Date today, StaticModifierCache const& static_modifier_cache,
+			std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+		);
+
 	public:
 
 		void update_modifier_sum(Date today, StaticModifierCache const& static_modifier_cache);
-		void contribute_province_modifier_sum(ModifierSum const& province_modifier_sum);
+		/* Only regathers the national modifier groups marked dirty since the last update, swapping their changed
+		 * entries in this country's sum. Controlled provinces apply their own changes, see
+		 * ProvinceInstance::update_modifier_sum_incremental. */
+		void update_modifier_sum_incremental(
+			Date today, StaticModifierCache const& static_modifier_cache,
+			std::vector<ModifierSum::modifier_entry_t>& scratch
+		);
+		/* Builds the sum a full update would produce into sum, leaving this country's own sum untouched. province_sums
+		 * holds the local sums of all provinces, in province instance order, to take controlled provinces' contributions
+		 * from. */
+		void build_modifier_sum(
+			Date today, StaticModifierCache const& static_modifier_cache, std::span<const ModifierSum> province_sums,
+			ModifierSum& sum, std::vector<ModifierSum::modifier_entry_t>& scratch
+		);
+		void contribute_province_modifier_sum(ProvinceInstance const& province);
+		void remove_province_modifier_contribution(ProvinceInstance const& province);
+		// Swaps entries of a controlled province's contribution which have changed, without touching the rest.
+		void update_province_modifier_contribution(
+			std::span<const ModifierSum::modifier_entry_t> removed_entries,
+			std::span<const ModifierSum::modifier_entry_t> added_entries
+		);
 		fixed_point_t get_modifier_effect_value(ModifierEffect const& effect) const;
 		fixed_point_t get_modifier_effect_value_nullcheck(ModifierEffect const* effect) const;
 		void push_contributing_modifiers(
@@ -364,6 +434,12 @@ namespace OpenVic {
 		);
 
 		void update_modifier_sums(Date today, StaticModifierCache const& static_modifier_cache);
+		void update_modifier_sums_incremental(Date today, StaticModifierCache const& static_modifier_cache);
+		// Builds every country's sum into sums, in country instance order, see CountryInstance::build_modifier_sum.
+		void build_modifier_sums(
+			Date today, StaticModifierCache const& static_modifier_cache, std::span<const ModifierSum> province_sums,
+			std::vector<ModifierSum>& sums
+		);
 		void update_gamestate(
 			Date today, DefineManager const& define_manager, UnitTypeManager const& unit_type_manager,
 			ModifierEffectCache const& modifier_effect_cache
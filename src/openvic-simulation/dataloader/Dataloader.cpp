@@ -1,5 +1,7 @@
 #include "Dataloader.hpp"
 
+#include <sstream>
+
 #include <openvic-dataloader/csv/Parser.hpp>
 #include <openvic-dataloader/detail/CallbackOStream.hpp>
 #include <openvic-dataloader/v2script/Parser.hpp>
@@ -8,6 +10,8 @@
 #include <lexy-vdf/Parser.hpp>
 
 #include "openvic-simulation/DefinitionManager.hpp"
+#include "openvic-simulation/dataloader/DefinitionsCache.hpp"
+#include "openvic-simulation/scripts/ConditionBytecode.hpp"
 #include "openvic-simulation/utility/Logger.hpp"
 #include "openvic-simulation/utility/StringUtils.hpp"
 
@@ -17,21 +21,24 @@ using namespace ovdl;
 
 using StringUtils::append_string_views;
 
-#if defined(_WIN32) || (defined(__APPLE__) && defined(__MACH__))
-#define FILESYSTEM_CASE_INSENSITIVE
-#endif
-
-#if !defined(_WIN32)
-#define FILESYSTEM_NEEDS_FORWARD_SLASHES
-#endif
-
-static fs::path ensure_forward_slash_path(std::string_view path) {
-#if defined(FILESYSTEM_NEEDS_FORWARD_SLASHES)
-	/* Back-slashes need to be converted into forward-slashes */
-	return StringUtils::make_forward_slash_path(StringUtils::remove_leading_slashes(path));
-#else
-	return path;
-#endif
+/* Turns a path relative to a root into the form used as a file index key: forward-slash separated, with no leading,
+ * trailing or repeated slashes. */
+static std::string _get_index_key(std::string_view path) {
+	std::string key;
+	key.reserve(path.size());
+	for (const char c : path) {
+		if (c == '/' || c == '\\') {
+			if (!key.empty() && key.back() != '/') {
+				key.push_back('/');
+			}
+		} else {
+			key.push_back(c);
+		}
+	}
+	if (!key.empty() && key.back() == '/') {
+		key.pop_back();
+	}
+	return key;
 }
 
 bool Dataloader::set_roots(path_vector_t const& new_roots) {
@@ -58,39 +65,114 @@ bool Dataloader::set_roots(path_vector_t const& new_roots) {
 		Logger::error("Dataloader has no roots after attempting to add ", new_roots.size());
 		ret = false;
 	}
+	refresh_file_index();
 	return ret;
 }
 
-fs::path Dataloader::lookup_file(std::string_view path, bool print_error) const {
-	const fs::path filepath { ensure_forward_slash_path(path) };
+void Dataloader::set_definitions_cache_directory(fs::path const& new_definitions_cache_directory) {
+	definitions_cache_directory = new_definitions_cache_directory;
+}
 
-#if defined(FILESYSTEM_CASE_INSENSITIVE)
-	/* Case-insensitive filesystem */
-	for (fs::path const& root : roots) {
-		const fs::path composed = root / filepath;
-		if (fs::is_regular_file(composed)) {
-			return composed;
+void Dataloader::refresh_file_index() {
+	directory_indices.clear();
+	file_index.clear();
+
+	/* A directory being iterated, with its canonical path so that symlinks leading back into it aren't followed. */
+	struct open_directory_t {
+		fs::directory_iterator iterator;
+		fs::path canonical_path;
+	};
+
+	/* Walked with an explicit stack rather than a recursive_directory_iterator, which ends the whole walk at the first
+	 * error and follows directory symlinks round in circles. Entries are still visited in pre-order, each directory's
+	 * entries directly following it. */
+	std::vector<open_directory_t> open_directories;
+
+	const auto open_directory = [&open_directories](fs::path const& directory) -> void {
+		std::error_code ec;
+		fs::path canonical_path = fs::canonical(directory, ec);
+		if (ec) {
+			Logger::warning("Skipping directory ", directory, " while indexing files: ", ec.message());
+			return;
 		}
-	}
-#else
-	/* Case-sensitive filesystem */
-	const std::string_view filename = StringUtils::get_filename(path);
-	for (fs::path const& root : roots) {
-		const fs::path composed = root / filepath;
-		if (fs::is_regular_file(composed)) {
-			return composed;
+
+		for (open_directory_t const& ancestor : open_directories) {
+			if (ancestor.canonical_path == canonical_path) {
+				Logger::warning("Skipping directory ", directory, " while indexing files: it links back to ", canonical_path);
+				return;
+			}
 		}
-		std::error_code ec;
-		for (fs::directory_entry const& entry : fs::directory_iterator { composed.parent_path(), ec }) {
-			if (entry.is_regular_file()) {
-				const fs::path file = entry;
-				if (StringUtils::strings_equal_case_insensitive(file.filename().string(), filename)) {
-					return file;
-				}
+
+		fs::directory_iterator iterator { directory, fs::directory_options::skip_permission_denied, ec };
+		if (ec) {
+			Logger::warning("Skipping directory ", directory, " while indexing files: ", ec.message());
+			return;
+		}
+
+		open_directories.push_back({ std::move(iterator), std::move(canonical_path) });
+	};
+
+	for (fs::path const& root : roots) {
+		directory_index_t& directory_index = directory_indices.emplace_back();
+		directory_index.emplace(std::string {}, std::vector<index_entry_t> {});
+
+		const size_t root_len = root.generic_string().size();
+		open_directory(root);
+
+		while (!open_directories.empty()) {
+			fs::directory_iterator& iterator = open_directories.back().iterator;
+			if (iterator == fs::directory_iterator {}) {
+				open_directories.pop_back();
+				continue;
+			}
+
+			const fs::directory_entry entry = *iterator;
+
+			/* A failed increment ends the iterator, so only the rest of this one directory is lost */
+			std::error_code ec;
+			iterator.increment(ec);
+			if (ec) {
+				Logger::warning(
+					"Failed to read the rest of directory ", entry.path().parent_path(), " while indexing files: ", ec.message()
+				);
+				iterator = {};
+			}
+
+			const bool is_directory = entry.is_directory(ec);
+			if (!is_directory && !entry.is_regular_file(ec)) {
+				continue;
+			}
+
+			const std::string full_path = entry.path().generic_string();
+			std::string relative_path = _get_index_key(std::string_view { full_path }.substr(root_len));
+			const std::string parent_key = _get_index_key(std::string_view { relative_path }.substr(
+				0, relative_path.size() - StringUtils::get_filename(relative_path).size()
+			));
+
+			if (is_directory) {
+				directory_index.emplace(relative_path, std::vector<index_entry_t> {});
+			} else {
+				/* Roots are in priority order, so a file found under an earlier root hides any later ones */
+				file_index.emplace(relative_path, entry.path());
+			}
+
+			/* The parent is always visited before its entries, so it's already in the index */
+			directory_index[parent_key].push_back({ entry.path(), std::move(relative_path), is_directory });
+
+			if (is_directory) {
+				open_directory(entry.path());
 			}
 		}
 	}
-#endif
+
+	Logger::info("Indexed ", file_index.size(), " files across ", roots.size(), " dataloader roots");
+}
+
+fs::path Dataloader::lookup_file(std::string_view path, bool print_error) const {
+	const decltype(file_index)::const_iterator it = file_index.find(_get_index_key(path));
+	if (it != file_index.end()) {
+		return it->second;
+	}
 
 	if (print_error) {
 		Logger::error("Lookup for \"", path, "\" failed!");
@@ -109,40 +191,56 @@ fs::path Dataloader::lookup_image_file(std::string_view path) const {
 	return lookup_file(path);
 }
 
-template<typename _DirIterator, UniqueFileKey _UniqueKey>
+template<UniqueFileKey _UniqueKey>
 Dataloader::path_vector_t Dataloader::_lookup_files_in_dir(
-	std::string_view path, fs::path const& extension, _UniqueKey const& unique_key
+	std::string_view path, fs::path const& extension, bool recursive, _UniqueKey const& unique_key
 ) const {
-	const fs::path dirpath { ensure_forward_slash_path(path) };
+	const std::string dir_key = _get_index_key(path);
 	path_vector_t ret;
 	struct file_entry_t {
-		fs::path file;
+		fs::path const* file;
 		fs::path const* root;
 	};
-	string_map_t<file_entry_t> found_files;
-	for (fs::path const& root : roots) {
-		const size_t root_len = root.string().size();
-		std::error_code ec;
-		for (fs::directory_entry const& entry : _DirIterator { root / dirpath, ec }) {
-			if (entry.is_regular_file()) {
-				fs::path file = entry;
-				if (extension.empty() || file.extension() == extension) {
-					const std::string full_path = file.string();
-					std::string_view relative_path = full_path;
-					relative_path.remove_prefix(root_len);
-					relative_path = StringUtils::remove_leading_slashes(relative_path);
-					const std::string_view key = unique_key(relative_path);
-					if (!key.empty()) {
-						const typename decltype(found_files)::const_iterator it = found_files.find(key);
-						if (it == found_files.end()) {
-							found_files.emplace(key, file_entry_t { file, &root });
-							ret.emplace_back(std::move(file));
-						} else if (it->second.root == &root) {
-							Logger::warning(
-								"Files under the same root with conflicting keys: ", it->first, " - ", it->second.file,
-								" (accepted) and ", key, " - ", file, " (rejected)"
-							);
-						}
+	case_insensitive_string_map_t<file_entry_t> found_files;
+	/* Pre-order traversal, matching the order refresh_file_index visited the entries in */
+	std::vector<std::pair<std::vector<index_entry_t> const*, size_t>> stack;
+	for (size_t root_index = 0; root_index < roots.size(); ++root_index) {
+		fs::path const& root = roots[root_index];
+		directory_index_t const& directory_index = directory_indices[root_index];
+
+		const directory_index_t::const_iterator dir_it = directory_index.find(dir_key);
+		if (dir_it == directory_index.end()) {
+			continue;
+		}
+		stack.emplace_back(&dir_it->second, 0);
+
+		while (!stack.empty()) {
+			auto& [entries, next] = stack.back();
+			if (next >= entries->size()) {
+				stack.pop_back();
+				continue;
+			}
+			index_entry_t const& entry = (*entries)[next++];
+
+			if (entry.is_directory) {
+				if (recursive) {
+					const directory_index_t::const_iterator sub_dir_it = directory_index.find(entry.relative_path);
+					if (sub_dir_it != directory_index.end()) {
+						stack.emplace_back(&sub_dir_it->second, 0);
+					}
+				}
+			} else if (extension.empty() || entry.path.extension() == extension) {
+				const std::string_view key = unique_key(entry.relative_path);
+				if (!key.empty()) {
+					const typename decltype(found_files)::const_iterator it = found_files.find(key);
+					if (it == found_files.end()) {
+						found_files.emplace(key, file_entry_t { &entry.path, &root });
+						ret.push_back(entry.path);
+					} else if (it->second.root == &root) {
+						Logger::warning(
+							"Files under the same root with conflicting keys: ", it->first, " - ", *it->second.file,
+							" (accepted) and ", key, " - ", entry.path, " (rejected)"
+						);
 					}
 				}
 			}
@@ -152,11 +250,11 @@ Dataloader::path_vector_t Dataloader::_lookup_files_in_dir(
 }
 
 Dataloader::path_vector_t Dataloader::lookup_files_in_dir(std::string_view path, fs::path const& extension) const {
-	return _lookup_files_in_dir<fs::directory_iterator>(path, extension, std::identity {});
+	return _lookup_files_in_dir(path, extension, false, std::identity {});
 }
 
 Dataloader::path_vector_t Dataloader::lookup_files_in_dir_recursive(std::string_view path, fs::path const& extension) const {
-	return _lookup_files_in_dir<fs::recursive_directory_iterator>(path, extension, std::identity {});
+	return _lookup_files_in_dir(path, extension, true, std::identity {});
 }
 
 static std::string_view _extract_basic_identifier_prefix_from_path(std::string_view path) {
@@ -166,13 +264,13 @@ static std::string_view _extract_basic_identifier_prefix_from_path(std::string_v
 Dataloader::path_vector_t Dataloader::lookup_basic_indentifier_prefixed_files_in_dir(
 	std::string_view path, fs::path const& extension
 ) const {
-	return _lookup_files_in_dir<fs::directory_iterator>(path, extension, _extract_basic_identifier_prefix_from_path);
+	return _lookup_files_in_dir(path, extension, false, _extract_basic_identifier_prefix_from_path);
 }
 
 Dataloader::path_vector_t Dataloader::lookup_basic_indentifier_prefixed_files_in_dir_recursive(
 	std::string_view path, fs::path const& extension
 ) const {
-	return _lookup_files_in_dir<fs::recursive_directory_iterator>(path, extension, _extract_basic_identifier_prefix_from_path);
+	return _lookup_files_in_dir(path, extension, true, _extract_basic_identifier_prefix_from_path);
 }
 
 bool Dataloader::apply_to_files(path_vector_t const& files, callback_t<fs::path const&> callback) const {
@@ -187,58 +285,93 @@ bool Dataloader::apply_to_files(path_vector_t const& files, callback_t<fs::path
 }
 
 string_set_t Dataloader::lookup_dirs_in_dir(std::string_view path) const {
-	const fs::path dirpath { ensure_forward_slash_path(path) };
+	const std::string dir_key = _get_index_key(path);
 	string_set_t ret;
-	for (fs::path const& root : roots) {
-		std::error_code ec;
-		for (fs::directory_entry const& entry : fs::directory_iterator { root / dirpath, ec }) {
-			if (entry.is_directory()) {
-				ret.emplace(entry.path().filename().string());
+	for (directory_index_t const& directory_index : directory_indices) {
+		const directory_index_t::const_iterator it = directory_index.find(dir_key);
+		if (it == directory_index.end()) {
+			continue;
+		}
+		for (index_entry_t const& entry : it->second) {
+			if (entry.is_directory) {
+				ret.emplace(entry.path.filename().string());
 			}
 		}
 	}
 	return ret;
 }
 
+template<typename... Args>
+static void _append_parser_error(std::vector<std::string>& errors, Args const&... args) {
+	std::stringstream stream;
+	((stream << args), ...);
+	errors.push_back(stream.str());
+}
+
+/* Errors are collected rather than logged, as the Logger isn't thread-safe and parses may run on worker threads. */
 template<std::derived_from<detail::BasicParser> Parser, bool (*parse_func)(Parser&)>
-static Parser _run_ovdl_parser(fs::path const& path) {
+static Parser _run_ovdl_parser(fs::path const& path, std::vector<std::string>& errors) {
+	struct error_log_t {
+		std::string buffer;
+		std::vector<std::string>& errors;
+	} error_log { {}, errors };
+
 	Parser parser;
-	std::string buffer;
 	auto error_log_stream = detail::make_callback_stream<char>(
 		[](void const* s, std::streamsize n, void* user_data) -> std::streamsize {
 			if (s != nullptr && n > 0 && user_data != nullptr) {
-				static_cast<std::string*>(user_data)->append(static_cast<char const*>(s), n);
+				static_cast<error_log_t*>(user_data)->buffer.append(static_cast<char const*>(s), n);
 				return n;
 			} else {
-				Logger::error("Invalid input to parser error log callback: ", s, " / ", n, " / ", user_data);
+				if (user_data != nullptr) {
+					_append_parser_error(
+						static_cast<error_log_t*>(user_data)->errors, "Invalid input to parser error log callback: ", s,
+						" / ", n, " / ", user_data
+					);
+				}
 				return 0;
 			}
 		},
-		&buffer
+		&error_log
 	);
+	std::string& buffer = error_log.buffer;
 	parser.set_error_log_to(error_log_stream);
 	parser.load_from_file(path);
 	if (!buffer.empty()) {
-		Logger::error("Parser load errors for ", path, ":\n\n", buffer, "\n");
+		_append_parser_error(errors, "Parser load errors for ", path, ":\n\n", buffer, "\n");
 		buffer.clear();
 	}
 	if (parser.has_fatal_error() || parser.has_error()) {
-		Logger::error("Parser errors while loading ", path);
+		_append_parser_error(errors, "Parser errors while loading ", path);
 		return parser;
 	}
 	if (!parse_func(parser)) {
-		Logger::error("Parse function returned false for ", path, "!");
+		_append_parser_error(errors, "Parse function returned false for ", path, "!");
 	}
 	if (!buffer.empty()) {
-		Logger::error("Parser parse errors for ", path, ":\n\n", buffer, "\n");
+		_append_parser_error(errors, "Parser parse errors for ", path, ":\n\n", buffer, "\n");
 		buffer.clear();
 	}
 	if (parser.has_fatal_error() || parser.has_error()) {
-		Logger::error("Parser errors while parsing ", path);
+		_append_parser_error(errors, "Parser errors while parsing ", path);
 	}
 	return parser;
 }
 
+static void _log_parser_errors(std::vector<std::string> const& errors) {
+	for (std::string const& message : errors) {
+		Logger::error(std::string_view { message });
+	}
+}
+
+template<std::derived_from<detail::BasicParser> Parser, bool (*parse_func)(Parser&)>
+static Parser _run_ovdl_parser(fs::path const& path) {
+	std::vector<std::string> errors;
+	Parser parser = _run_ovdl_parser<Parser, parse_func>(path, errors);
+	_log_parser_errors(errors);
+	return parser;
+}
+
 static bool _v2script_parse(v2script::Parser& parser) {
 	return parser.simple_parse();
 }
@@ -271,13 +404,68 @@ void Dataloader::free_cache() {
 	cached_parsers.clear();
 }
 
+bool Dataloader::_parse_defines_and_apply_to_files(
+	path_vector_t const& files, parsed_file_callback_t callback, std::vector<v2script::Parser>* cache
+) const {
+	bool ret = true;
+
+	/* Files are handled in batches so only a limited number of Node trees are held at once, beyond those cached */
+	std::vector<v2script::Parser> parsers;
+	std::vector<std::vector<std::string>> errors;
+
+	for (size_t batch_begin = 0; batch_begin < files.size(); batch_begin += PARSE_BATCH_SIZE) {
+		const size_t batch_size = std::min(files.size() - batch_begin, PARSE_BATCH_SIZE);
+
+		parsers.clear();
+		parsers.resize(batch_size);
+		errors.clear();
+		errors.resize(batch_size);
+
+		const auto parse_files = [&files, &parsers, &errors, batch_begin](size_t, size_t begin, size_t end) {
+			for (size_t index = begin; index < end; ++index) {
+				parsers[index] =
+					_run_ovdl_parser<v2script::Parser, &_v2script_parse>(files[batch_begin + index], errors[index]);
+			}
+		};
+
+		/* Files vary a lot in size, so each is its own chunk */
+		if (thread_pool != nullptr) {
+			thread_pool->parallel_for(batch_size, 1, parse_files);
+		} else {
+			parse_files(0, 0, batch_size);
+		}
+
+		/* Semantic loading stays serial and in file order, so the result is the same as parsing files one at a time */
+		for (size_t index = 0; index < batch_size; ++index) {
+			fs::path const& file = files[batch_begin + index];
+			_log_parser_errors(errors[index]);
+
+			v2script::Parser& parser = cache != nullptr ? cache->emplace_back(std::move(parsers[index])) : parsers[index];
+			if (!callback(file, parser)) {
+				Logger::error("Callback failed for file: ", file);
+				ret = false;
+			}
+		}
+	}
+
+	return ret;
+}
+
+bool Dataloader::parse_defines_and_apply_to_files(path_vector_t const& files, parsed_file_callback_t callback) const {
+	return _parse_defines_and_apply_to_files(files, callback, nullptr);
+}
+
+bool Dataloader::parse_defines_cached_and_apply_to_files(path_vector_t const& files, parsed_file_callback_t callback) {
+	return _parse_defines_and_apply_to_files(files, callback, &cached_parsers);
+}
+
 bool Dataloader::_load_interface_files(UIManager& ui_manager) const {
 	static constexpr std::string_view interface_directory = "interface/";
 
-	bool ret = apply_to_files(
+	bool ret = parse_defines_and_apply_to_files(
 		lookup_files_in_dir(interface_directory, ".gfx"),
-		[&ui_manager](fs::path const& file) -> bool {
-			return ui_manager.load_gfx_file(parse_defines(file).get_file_node());
+		[&ui_manager](fs::path const&, v2script::Parser& parser) -> bool {
+			return ui_manager.load_gfx_file(parser.get_file_node());
 		}
 	);
 	ui_manager.lock_gfx_registries();
@@ -327,11 +515,11 @@ bool Dataloader::_load_pop_types(DefinitionManager& definition_manager) {
 
 	pop_manager.reserve_all_pop_types(pop_type_files.size());
 
-	bool ret = apply_to_files(
+	bool ret = parse_defines_cached_and_apply_to_files(
 		pop_type_files,
-		[this, &pop_manager, &good_definition_manager, &ideology_manager](fs::path const& file) -> bool {
+		[&pop_manager, &good_definition_manager, &ideology_manager](fs::path const& file, v2script::Parser& parser) -> bool {
 			return pop_manager.load_pop_type_file(
-				file.stem().string(), good_definition_manager, ideology_manager, parse_defines_cached(file).get_file_node()
+				file.stem().string(), good_definition_manager, ideology_manager, parser.get_file_node()
 			);
 		}
 	);
@@ -364,14 +552,14 @@ bool Dataloader::_load_units(DefinitionManager& definition_manager) const {
 
 	unit_type_manager.reserve_all_unit_types(unit_files.size());
 
-	bool ret = apply_to_files(
+	bool ret = parse_defines_and_apply_to_files(
 		unit_files,
-		[&definition_manager, &unit_type_manager](fs::path const& file) -> bool {
+		[&definition_manager, &unit_type_manager](fs::path const&, v2script::Parser& parser) -> bool {
 			return unit_type_manager.load_unit_type_file(
 				definition_manager.get_economy_manager().get_good_definition_manager(),
 				definition_manager.get_map_definition().get_terrain_type_manager(),
 				definition_manager.get_modifier_manager(),
-				parse_defines(file)
+				parser
 			);
 		}
 	);
@@ -444,14 +632,14 @@ bool Dataloader::_load_technologies(DefinitionManager& definition_manager) {
 	}
 
 	static constexpr std::string_view technologies_directory = "technologies";
-	if (!apply_to_files(
+	if (!parse_defines_cached_and_apply_to_files(
 		lookup_files_in_dir(technologies_directory, ".txt"),
-		[this, &definition_manager, &technology_manager, &modifier_manager](fs::path const& file) -> bool {
+		[&definition_manager, &technology_manager, &modifier_manager](fs::path const&, v2script::Parser& parser) -> bool {
 			return technology_manager.load_technologies_file(
 				modifier_manager,
 				definition_manager.get_military_manager().get_unit_type_manager(),
 				definition_manager.get_economy_manager().get_building_type_manager(),
-				parse_defines_cached(file).get_file_node()
+				parser.get_file_node()
 			);
 		}
 	)) {
@@ -471,15 +659,15 @@ bool Dataloader::_load_inventions(DefinitionManager& definition_manager) {
 
 	InventionManager& invention_manager = definition_manager.get_research_manager().get_invention_manager();
 
-	bool ret = apply_to_files(
+	bool ret = parse_defines_cached_and_apply_to_files(
 		lookup_files_in_dir(inventions_directory, ".txt"),
-		[this, &definition_manager, &invention_manager](fs::path const& file) -> bool {
+		[&definition_manager, &invention_manager](fs::path const&, v2script::Parser& parser) -> bool {
 			return invention_manager.load_inventions_file(
 				definition_manager.get_modifier_manager(),
 				definition_manager.get_military_manager().get_unit_type_manager(),
 				definition_manager.get_economy_manager().get_building_type_manager(),
 				definition_manager.get_crime_manager(),
-				parse_defines_cached(file).get_file_node()
+				parser.get_file_node()
 			);
 		}
 	);
@@ -494,10 +682,10 @@ bool Dataloader::_load_decisions(DefinitionManager& definition_manager) {
 
 	DecisionManager& decision_manager = definition_manager.get_decision_manager();
 
-	bool ret = apply_to_files(
+	bool ret = parse_defines_cached_and_apply_to_files(
 		lookup_files_in_dir(decisions_directory, ".txt"),
-		[this, &decision_manager](fs::path const& file) -> bool {
-			return decision_manager.load_decision_file(parse_defines_cached(file).get_file_node());
+		[&decision_manager](fs::path const&, v2script::Parser& parser) -> bool {
+			return decision_manager.load_decision_file(parser.get_file_node());
 		}
 	);
 
@@ -522,9 +710,11 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 		country_history_manager.reserve_more_country_histories(country_history_files.size());
 		deployment_manager.reserve_more_deployments(country_history_files.size());
 
-		ret &= apply_to_files(
+		ret &= parse_defines_and_apply_to_files(
 			country_history_files,
-			[this, &definition_manager, &country_history_manager, unused_history_file_warnings](fs::path const& file) -> bool {
+			[this, &definition_manager, &country_history_manager, unused_history_file_warnings](
+				fs::path const& file, v2script::Parser& parser
+			) -> bool {
 				const std::string filename = file.stem().string();
 				const std::string_view country_id = extract_basic_identifier_prefix(filename);
 
@@ -541,7 +731,7 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 					definition_manager, *this, *country,
 					definition_manager.get_politics_manager().get_ideology_manager().get_ideologies(),
 					definition_manager.get_politics_manager().get_government_type_manager().get_government_types(),
-					parse_defines(file).get_file_node()
+					parser.get_file_node()
 				);
 			}
 		);
@@ -565,10 +755,10 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 
 		province_history_manager.reserve_more_province_histories(province_history_files.size());
 
-		ret &= apply_to_files(
+		ret &= parse_defines_and_apply_to_files(
 			province_history_files,
-			[this, &definition_manager, &province_history_manager, &map_definition, unused_history_file_warnings](
-				fs::path const& file
+			[&definition_manager, &province_history_manager, &map_definition, unused_history_file_warnings](
+				fs::path const& file, v2script::Parser& parser
 			) -> bool {
 				const std::string filename = file.stem().string();
 				const std::string_view province_id = extract_basic_identifier_prefix(filename);
@@ -582,7 +772,7 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 				}
 
 				return province_history_manager.load_province_history_file(
-					definition_manager, *province, parse_defines(file).get_file_node()
+					definition_manager, *province, parser.get_file_node()
 				);
 			}
 		);
@@ -601,13 +791,13 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 			if (successful && date <= last_bookmark_date) {
 				bool non_integer_size = false;
 
-				ret &= apply_to_files(
+				ret &= parse_defines_and_apply_to_files(
 					lookup_files_in_dir(StringUtils::append_string_views(pop_history_directory, dir), ".txt"),
-					[this, &definition_manager, &province_history_manager, date, &non_integer_size](
-						fs::path const& file
+					[&definition_manager, &province_history_manager, date, &non_integer_size](
+						fs::path const&, v2script::Parser& parser
 					) -> bool {
 						return province_history_manager.load_pop_history_file(
-							definition_manager, date, parse_defines(file).get_file_node(), &non_integer_size
+							definition_manager, date, parser.get_file_node(), &non_integer_size
 						);
 					}
 				);
@@ -628,14 +818,42 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 
 		static constexpr std::string_view diplomacy_history_directory = "history/diplomacy";
 
-		ret &= apply_to_files(
-			lookup_files_in_dir(diplomacy_history_directory, ".txt"),
-			[this, &definition_manager, &diplomatic_history_manager](fs::path const& file) -> bool {
-				return diplomatic_history_manager.load_diplomacy_history_file(
-					definition_manager.get_country_definition_manager(), parse_defines(file).get_file_node()
-				);
+		/* The cached countries are stored by index, so the key also covers the country definitions in common */
+		static constexpr std::string_view diplomacy_history_cache_file = "diplomacy_history.ovdc";
+		static constexpr std::array<std::string_view, 2> diplomacy_history_cache_directories {
+			diplomacy_history_directory, "common"
+		};
+
+		const bool use_cache = !definitions_cache_directory.empty();
+		const fs::path cache_path = definitions_cache_directory / diplomacy_history_cache_file;
+		const DefinitionsCache::key_t cache_key = use_cache
+			? DefinitionsCache::compute_key(roots, diplomacy_history_cache_directories)
+			: 0;
+
+		DefinitionsCache::Reader cache_reader;
+		if (!(
+			use_cache && cache_reader.open(cache_path, cache_key) && diplomatic_history_manager.load_diplomacy_history_cache(
+				definition_manager.get_country_definition_manager(), cache_reader
+			)
+		)) {
+			const bool diplomacy_ret = parse_defines_and_apply_to_files(
+				lookup_files_in_dir(diplomacy_history_directory, ".txt"),
+				[&definition_manager, &diplomatic_history_manager](fs::path const&, v2script::Parser& parser) -> bool {
+					return diplomatic_history_manager.load_diplomacy_history_file(
+						definition_manager.get_country_definition_manager(), parser.get_file_node()
+					);
+				}
+			);
+
+			/* Only cleanly loaded history is cached, so that its errors are reported again next time */
+			if (diplomacy_ret && use_cache) {
+				DefinitionsCache::Writer cache_writer;
+				diplomatic_history_manager.save_diplomacy_history_cache(cache_writer);
+				cache_writer.save(cache_path, cache_key);
 			}
-		);
+
+			ret &= diplomacy_ret;
+		}
 
 		/* War History */
 		static constexpr std::string_view war_history_directory = "history/wars";
@@ -643,11 +861,11 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 
 		diplomatic_history_manager.reserve_more_wars(war_history_files.size());
 
-		ret &= apply_to_files(
+		ret &= parse_defines_and_apply_to_files(
 			war_history_files,
-			[this, &definition_manager, &diplomatic_history_manager](fs::path const& file) -> bool {
+			[&definition_manager, &diplomatic_history_manager](fs::path const&, v2script::Parser& parser) -> bool {
 				return diplomatic_history_manager.load_war_history_file(
-					definition_manager, parse_defines(file).get_file_node()
+					definition_manager, parser.get_file_node()
 				);
 			}
 		);
@@ -661,11 +879,11 @@ bool Dataloader::_load_history(DefinitionManager& definition_manager, bool unuse
 bool Dataloader::_load_events(DefinitionManager& definition_manager) {
 	static constexpr std::string_view events_directory = "events";
 
-	const bool ret = apply_to_files(
+	const bool ret = parse_defines_cached_and_apply_to_files(
 		lookup_files_in_dir(events_directory, ".txt"),
-		[this, &definition_manager](fs::path const& file) -> bool {
+		[&definition_manager](fs::path const&, v2script::Parser& parser) -> bool {
 			return definition_manager.get_event_manager().load_event_file(
-				definition_manager.get_politics_manager().get_issue_manager(), parse_defines_cached(file).get_file_node()
+				definition_manager.get_politics_manager().get_issue_manager(), parser.get_file_node()
 			);
 		}
 	);
@@ -783,13 +1001,35 @@ bool Dataloader::_load_map_dir(DefinitionManager& definition_manager) const {
 		ret = false;
 	}
 
-	if (!map_definition.load_map_images(
-		lookup_file(append_string_views(map_directory, provinces)),
-		lookup_file(append_string_views(map_directory, terrain)),
-		lookup_file(append_string_views(map_directory, rivers)), false
-	)) {
-		Logger::error("Failed to load map images!");
-		ret = false;
+	{
+		/* Decoding the map BMPs is the slowest part of loading the map, so its results are cached between runs. The key
+		 * covers the whole map directory, as the province and terrain definitions determine the cached indices. */
+		static constexpr std::string_view map_images_cache_file = "map_images.ovdc";
+		static constexpr std::array<std::string_view, 1> map_images_cache_directories { map_directory };
+
+		const bool use_cache = !definitions_cache_directory.empty();
+		const fs::path cache_path = definitions_cache_directory / map_images_cache_file;
+		const DefinitionsCache::key_t cache_key = use_cache
+			? DefinitionsCache::compute_key(roots, map_images_cache_directories)
+			: 0;
+
+		DefinitionsCache::Reader cache_reader;
+		if (!(use_cache && cache_reader.open(cache_path, cache_key) && map_definition.load_map_image_cache(cache_reader))) {
+			if (map_definition.load_map_images(
+				lookup_file(append_string_views(map_directory, provinces)),
+				lookup_file(append_string_views(map_directory, terrain)),
+				lookup_file(append_string_views(map_directory, rivers)), false
+			)) {
+				if (use_cache) {
+					DefinitionsCache::Writer cache_writer;
+					map_definition.save_map_image_cache(cache_writer);
+					cache_writer.save(cache_path, cache_key);
+				}
+			} else {
+				Logger::error("Failed to load map images!");
+				ret = false;
+			}
+		}
 	}
 
 	if (map_definition.generate_and_load_province_adjacencies(
@@ -826,6 +1066,11 @@ bool Dataloader::_load_map_dir(DefinitionManager& definition_manager) const {
 		ret = false;
 	}
 
+	if (!map_definition.build_province_graphs()) {
+		Logger::error("Failed to build province graphs!");
+		ret = false;
+	}
+
 	return ret;
 }
 
@@ -892,6 +1137,9 @@ bool Dataloader::load_defines(DefinitionManager& definition_manager) {
 	static constexpr std::string_view triggered_modifiers_file = "common/triggered_modifiers.txt";
 	static constexpr std::string_view on_actions_file = "common/on_actions.txt";
 
+	/* Workers for parsing whole directories of files at once, stopped again once loading is done */
+	thread_pool = std::make_unique<ThreadPool>();
+
 	bool ret = true;
 
 	if (!definition_manager.get_mapmode_manager().setup_mapmodes()) {
@@ -1113,6 +1361,7 @@ bool Dataloader::load_defines(DefinitionManager& definition_manager) {
 	ret &= parse_scripts(definition_manager);
 
 	free_cache();
+	thread_pool.reset();
 
 	return ret;
 }
@@ -1141,6 +1390,7 @@ bool Dataloader::parse_scripts(DefinitionManager& definition_manager) const {
 	PARSE_SCRIPTS("event", definition_manager.get_event_manager());
 	PARSE_SCRIPTS("song chance", definition_manager.get_song_chance_manager());
 	PARSE_SCRIPTS("national focus", definition_manager.get_politics_manager().get_national_focus_manager());
+	ConditionBytecode::log_unsupported_conditions();
 	return ret;
 }
 
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <memory>
+
 #include <openvic-dataloader/csv/Parser.hpp>
 #include <openvic-dataloader/v2script/Parser.hpp>
 
 #include "openvic-simulation/dataloader/NodeTools.hpp"
+#include "openvic-simulation/utility/ThreadPool.hpp"
 
 namespace OpenVic {
 	namespace fs = std::filesystem;
@@ -19,10 +22,33 @@ namespace OpenVic {
 	class Dataloader {
 	public:
 		using path_vector_t = std::vector<fs::path>;
+		/* Args: file, the file's Parser */
+		using parsed_file_callback_t = NodeTools::callback_t<fs::path const&, ovdl::v2script::Parser&>;
 
 	private:
+		/* The number of files parsed together before their callbacks are run. */
+		static constexpr size_t PARSE_BATCH_SIZE = 256;
+
+		struct index_entry_t {
+			fs::path path;
+			/* Forward-slash separated and relative to the entry's root, also its key if it's a directory. */
+			std::string relative_path;
+			bool is_directory;
+		};
+		/* Every directory under a root, including the root itself with an empty key, mapped to its entries in directory
+		 * iteration order. */
+		using directory_index_t = case_insensitive_string_map_t<std::vector<index_entry_t>>;
+
 		path_vector_t PROPERTY(roots);
+		/* Built by refresh_file_index, so lookups don't need to touch the filesystem. */
+		std::vector<directory_index_t> directory_indices;
+		/* Every file's path relative to its root, mapped to its real path under the first root it's found in. */
+		case_insensitive_string_map_t<fs::path> file_index;
 		std::vector<ovdl::v2script::Parser> cached_parsers;
+		/* Only exists while load_defines is running, otherwise files are parsed on the calling thread. */
+		std::unique_ptr<ThreadPool> thread_pool;
+		/* Where binary caches of loaded definitions are kept, or empty to always load from the roots. */
+		fs::path PROPERTY(definitions_cache_directory);
 
 		bool _load_interface_files(UIManager& ui_manager) const;
 		bool _load_pop_types(DefinitionManager& definition_manager);
@@ -38,12 +64,12 @@ namespace OpenVic {
 		bool _load_decisions(DefinitionManager& definition_manager);
 		bool _load_history(DefinitionManager& definition_manager, bool unused_history_file_warnings) const;
 
-		/* _DirIterator is fs::directory_iterator or fs::recursive_directory_iterator. _UniqueKey is the type of a callable
-		 * which converts a string_view filepath with root removed into a string_view unique key. Any path whose key is empty
-		 * or matches an earlier found path's key is discarded, ensuring each looked up path's key is non-empty and unique. */
-		template<typename _DirIterator, UniqueFileKey _UniqueKey>
+		/* _UniqueKey is the type of a callable which converts a string_view filepath with root removed into a string_view
+		 * unique key. Any path whose key is empty or matches an earlier found path's key is discarded, ensuring each looked
+		 * up path's key is non-empty and unique. */
+		template<UniqueFileKey _UniqueKey>
 		path_vector_t _lookup_files_in_dir(
-			std::string_view path, fs::path const& extension, _UniqueKey const& unique_key
+			std::string_view path, fs::path const& extension, bool recursive, _UniqueKey const& unique_key
 		) const;
 
 	public:
@@ -56,6 +82,19 @@ namespace OpenVic {
 		 * is only guaranteed to be valid until the function is next called. */
 		ovdl::v2script::Parser& parse_defines_cached(fs::path const& path);
 
+	private:
+		bool _parse_defines_and_apply_to_files(
+			path_vector_t const& files, parsed_file_callback_t callback, std::vector<ovdl::v2script::Parser>* cache
+		) const;
+
+	public:
+		/* Parse all of the files, concurrently while load_defines is running, then call the callback with each file and
+		 * its Parser on the calling thread, in the order of files. Only parsing is concurrent, so the loaded result is the
+		 * same as when parsing and loading the files one at a time. */
+		bool parse_defines_and_apply_to_files(path_vector_t const& files, parsed_file_callback_t callback) const;
+		/* As parse_defines_and_apply_to_files, with the Parsers cached as by parse_defines_cached. */
+		bool parse_defines_cached_and_apply_to_files(path_vector_t const& files, parsed_file_callback_t callback);
+
 	private:
 		/* Clear the cache vector, freeing all cached Parsers and their Node trees. Pointers to cached Parsers' Nodes should
 		 * be set to null before this is called to avoid segfaults. */
@@ -88,9 +127,14 @@ namespace OpenVic {
 
 		/* In reverse-load order, so base defines first and final loaded mod last */
 		bool set_roots(path_vector_t const& new_roots);
+		/* Rebuild the index of every file and directory under the roots, which all lookups are answered from. Called by
+		 * set_roots, and needed again if files are added, removed or renamed under a root after that. */
+		void refresh_file_index();
+		void set_definitions_cache_directory(fs::path const& new_definitions_cache_directory);
 
 		/* REQUIREMENTS:
 		 * DAT-24
+		 * Case-insensitive, on every platform.
 		 */
 		fs::path lookup_file(std::string_view path, bool print_error = true) const;
 		/* If the path ends with the extension ".tga", then this function will first try to load the file with the extension
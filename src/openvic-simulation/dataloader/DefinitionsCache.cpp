@@ -0,0 +1,177 @@
+#include "DefinitionsCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+namespace {
+	static constexpr uint32_t CACHE_MAGIC = 0x4344564F; /* "OVDC" */
+
+#pragma pack(push, 1)
+	struct cache_header_t {
+		uint32_t magic;
+		uint32_t version;
+		DefinitionsCache::key_t key;
+	};
+#pragma pack(pop)
+
+	/* FNV-1a, so keys stay the same between runs and standard library implementations */
+	struct key_hasher_t {
+		DefinitionsCache::key_t value = 0xCBF29CE484222325;
+
+		void add_bytes(void const* data, size_t size) {
+			uint8_t const* bytes = static_cast<uint8_t const*>(data);
+			for (size_t index = 0; index < size; ++index) {
+				value = (value ^ bytes[index]) * 0x100000001B3;
+			}
+		}
+
+		void add_string(std::string_view string) {
+			add_value<uint64_t>(string.size());
+			add_bytes(string.data(), string.size());
+		}
+
+		template<typename T>
+		void add_value(T value) {
+			add_bytes(&value, sizeof(T));
+		}
+	};
+}
+
+DefinitionsCache::key_t DefinitionsCache::compute_key(
+	std::span<const fs::path> roots, std::span<const std::string_view> directories
+) {
+	struct file_stamp_t {
+		std::string relative_path;
+		uint64_t size;
+		int64_t modified;
+	};
+
+	key_hasher_t hasher;
+	hasher.add_value(FORMAT_VERSION);
+
+	for (fs::path const& root : roots) {
+		hasher.add_string(root.generic_string());
+
+		/* Directory iteration order is unspecified, so files are sorted before hashing */
+		std::vector<file_stamp_t> files;
+		for (std::string_view directory : directories) {
+			std::error_code ec;
+			for (fs::directory_entry const& entry : fs::recursive_directory_iterator { root / directory, ec }) {
+				if (!entry.is_regular_file(ec)) {
+					continue;
+				}
+				files.push_back({
+					fs::relative(entry.path(), root, ec).generic_string(),
+					static_cast<uint64_t>(entry.file_size(ec)),
+					static_cast<int64_t>(entry.last_write_time(ec).time_since_epoch().count())
+				});
+			}
+		}
+		std::sort(files.begin(), files.end(), [](file_stamp_t const& lhs, file_stamp_t const& rhs) -> bool {
+			return lhs.relative_path < rhs.relative_path;
+		});
+
+		hasher.add_value<uint64_t>(files.size());
+		for (file_stamp_t const& file : files) {
+			hasher.add_string(file.relative_path);
+			hasher.add_value(file.size);
+			hasher.add_value(file.modified);
+		}
+	}
+
+	return hasher.value;
+}
+
+void DefinitionsCache::Writer::write_bytes(void const* data, size_t size) {
+	uint8_t const* bytes = static_cast<uint8_t const*>(data);
+	buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+bool DefinitionsCache::Writer::save(fs::path const& path, key_t key) const {
+	std::error_code ec;
+	fs::create_directories(path.parent_path(), ec);
+
+	/* Written to a temporary file first so an interrupted write can't leave a truncated cache with a valid header */
+	fs::path temporary_path = path;
+	temporary_path += ".tmp";
+
+	{
+		std::ofstream file { temporary_path, std::ios::binary | std::ios::trunc };
+		if (file.fail()) {
+			Logger::error("Failed to open definitions cache file for writing: ", temporary_path);
+			return false;
+		}
+
+		const cache_header_t header { CACHE_MAGIC, FORMAT_VERSION, key };
+		file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+		file.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+		if (file.fail()) {
+			Logger::error("Failed to write definitions cache file: ", temporary_path);
+			return false;
+		}
+	}
+
+	fs::rename(temporary_path, path, ec);
+	if (ec) {
+		Logger::error("Failed to move definitions cache file into place: ", path, " (", ec.message(), ")");
+		fs::remove(temporary_path, ec);
+		return false;
+	}
+
+	Logger::info("Wrote ", buffer.size(), " bytes to definitions cache: ", path);
+	return true;
+}
+
+bool DefinitionsCache::Reader::open(fs::path const& path, key_t key) {
+	buffer.clear();
+	offset = 0;
+
+	std::ifstream file { path, std::ios::binary | std::ios::ate };
+	if (file.fail()) {
+		return false;
+	}
+
+	const std::streamsize file_size = file.tellg();
+	if (file_size < static_cast<std::streamsize>(sizeof(cache_header_t))) {
+		Logger::warning("Ignoring truncated definitions cache: ", path);
+		return false;
+	}
+
+	buffer.resize(file_size);
+	file.seekg(0, std::ios::beg);
+	file.read(reinterpret_cast<char*>(buffer.data()), file_size);
+	if (file.fail()) {
+		Logger::warning("Failed to read definitions cache: ", path);
+		buffer.clear();
+		return false;
+	}
+
+	cache_header_t header;
+	std::memcpy(&header, buffer.data(), sizeof(header));
+	if (header.magic != CACHE_MAGIC || header.version != FORMAT_VERSION || header.key != key) {
+		Logger::info("Definitions cache is out of date: ", path);
+		buffer.clear();
+		return false;
+	}
+
+	offset = sizeof(header);
+	return true;
+}
+
+bool DefinitionsCache::Reader::read_bytes(void* data, size_t size) {
+	if (size > buffer.size() - offset) {
+		return false;
+	}
+	std::memcpy(data, buffer.data() + offset, size);
+	offset += size;
+	return true;
+}
+
+bool DefinitionsCache::Reader::is_at_end() const {
+	return offset == buffer.size();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace OpenVic {
+	namespace fs = std::filesystem;
+
+	/* A versioned binary cache of loaded definitions, so they can be restored on later startups without going back to
+	 * the files they were loaded from. A cache file is only accepted if it was written by the same format version and
+	 * with the same key, a hash of the dataloader roots and the relative path, size and modification time of every file
+	 * the cached data was loaded from. Data is stored as raw trivially copyable values, with references between
+	 * definitions stored as registry indices to be fixed up on load, so cache files are only valid on the machine and
+	 * build that wrote them. */
+	struct DefinitionsCache {
+		using key_t = uint64_t;
+
+		/* Increment whenever the layout of any cached data changes. */
+		static constexpr uint32_t FORMAT_VERSION = 2;
+
+		/* Hash of the roots and every file found recursively under any of the directories in any of the roots. */
+		static key_t compute_key(std::span<const fs::path> roots, std::span<const std::string_view> directories);
+
+		struct Writer {
+		private:
+			std::vector<uint8_t> buffer;
+
+		public:
+			template<typename T>
+			requires std::is_trivially_copyable_v<T>
+			void write(T const& value) {
+				write_bytes(&value, sizeof(T));
+			}
+
+			template<typename T>
+			requires std::is_trivially_copyable_v<T>
+			void write_span(std::span<const T> values) {
+				write<uint64_t>(values.size());
+				write_bytes(values.data(), values.size_bytes());
+			}
+
+			void write_bytes(void const* data, size_t size);
+
+			/* Writes the header followed by everything written so far, replacing any existing file. */
+			bool save(fs::path const& path, key_t key) const;
+		};
+
+		struct Reader {
+		private:
+			std::vector<uint8_t> buffer;
+			size_t offset = 0;
+
+		public:
+			/* Reads the whole file, returning false if it is missing or its header doesn't match the version and key. */
+			bool open(fs::path const& path, key_t key);
+
+			template<typename T>
+			requires std::is_trivially_copyable_v<T>
+			bool read(T& value) {
+				return read_bytes(&value, sizeof(T));
+			}
+
+			template<typename T>
+			requires std::is_trivially_copyable_v<T>
+			bool read_vector(std::vector<T>& values) {
+				uint64_t size = 0;
+				if (!read(size) || size > (buffer.size() - offset) / sizeof(T)) {
+					return false;
+				}
+				values.resize(size);
+				return read_bytes(values.data(), size * sizeof(T));
+			}
+
+			bool read_bytes(void* data, size_t size);
+
+			bool is_at_end() const;
+		};
+	};
+}
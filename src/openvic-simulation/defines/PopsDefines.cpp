@@ -63,7 +63,8 @@ PopsDefines::PopsDefines()
 	movement_support_uh_factor {},
 	rebel_occupation_strength_bonus {},
 	large_population_limit {},
-	large_population_influence_penalty_chunk {} {}
+	large_population_influence_penalty_chunk {},
+	needs_pop_size { 200000 } {}
 
 std::string_view PopsDefines::get_name() const {
 	return "pops";
@@ -137,6 +138,7 @@ node_callback_t PopsDefines::expect_defines() {
 			expect_fixed_point(assign_variable_callback(rebel_occupation_strength_bonus)),
 		"LARGE_POPULATION_LIMIT", ONE_EXACTLY, expect_uint(assign_variable_callback(large_population_limit)),
 		"LARGE_POPULATION_INFLUENCE_PENALTY_CHUNK", ONE_EXACTLY,
-			expect_uint(assign_variable_callback(large_population_influence_penalty_chunk))
+			expect_uint(assign_variable_callback(large_population_influence_penalty_chunk)),
+		"NEEDS_POP_SIZE", ZERO_OR_ONE, expect_uint(assign_variable_callback(needs_pop_size))
 	);
 }
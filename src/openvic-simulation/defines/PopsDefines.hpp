@@ -73,6 +73,9 @@ namespace OpenVic {
 		fixed_point_t PROPERTY(rebel_occupation_strength_bonus);
 		Pop::pop_size_t PROPERTY(large_population_limit);
 		Pop::pop_size_t PROPERTY(large_population_influence_penalty_chunk);
+		/* The number of people PopType needs quantities are given for. Not in the base game's defines, which assume
+		 * 200000, so only needs setting by mods which scale needs differently. */
+		Pop::pop_size_t PROPERTY(needs_pop_size);
 
 		PopsDefines();
 
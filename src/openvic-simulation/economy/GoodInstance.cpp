@@ -4,7 +4,17 @@ using namespace OpenVic;
 
 GoodInstance::GoodInstance(GoodDefinition const& new_good_definition)
   : HasIdentifierAndColour { new_good_definition }, good_definition { new_good_definition },
-	price { new_good_definition.get_base_price() }, is_available { new_good_definition.get_is_available_from_start() } {}
+	price { new_good_definition.get_base_price() }, is_available { new_good_definition.get_is_available_from_start() },
+	total_supply_yesterday { fixed_point_t::_0() }, total_demand_yesterday { fixed_point_t::_0() },
+	quantity_traded_yesterday { fixed_point_t::_0() } {}
+
+GoodInstance& GoodInstanceManager::get_good_instance_from_definition(GoodDefinition const& good) {
+	return good_instances.get_items()[good.get_index()];
+}
+
+GoodInstance const& GoodInstanceManager::get_good_instance_from_definition(GoodDefinition const& good) const {
+	return good_instances.get_items()[good.get_index()];
+}
 
 bool GoodInstanceManager::setup(GoodDefinitionManager const& good_definition_manager) {
 	if (good_instances_are_locked()) {
@@ -7,15 +7,20 @@
 
 namespace OpenVic {
 	struct GoodInstanceManager;
+	struct MarketInstance;
 
 	struct GoodInstance : HasIdentifierAndColour {
 		friend struct GoodInstanceManager;
+		friend struct MarketInstance;
 
 	private:
 		GoodDefinition const& PROPERTY(good_definition);
 		fixed_point_t PROPERTY(price);
 		bool PROPERTY(is_available);
-		// TODO - supply, demand, actual bought
+		/* Totals from the most recent market clearing, at the price before it was updated. */
+		fixed_point_t PROPERTY(total_supply_yesterday);
+		fixed_point_t PROPERTY(total_demand_yesterday);
+		fixed_point_t PROPERTY(quantity_traded_yesterday);
 
 		GoodInstance(GoodDefinition const& new_good_definition);
 
@@ -24,10 +29,15 @@ namespace OpenVic {
 	};
 
 	struct GoodInstanceManager {
+		friend struct MarketInstance;
+
 	private:
 		IdentifierRegistry<GoodInstance> IDENTIFIER_REGISTRY(good_instance);
 
 	public:
+		GoodInstance& get_good_instance_from_definition(GoodDefinition const& good);
+		GoodInstance const& get_good_instance_from_definition(GoodDefinition const& good) const;
+
 		bool setup(GoodDefinitionManager const& good_definition_manager);
 	};
 }
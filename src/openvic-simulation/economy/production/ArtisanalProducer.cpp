@@ -1,13 +1,108 @@
 #include "ArtisanalProducer.hpp"
 
+#include <algorithm>
+
+#include "openvic-simulation/economy/production/ProductionType.hpp"
+#include "openvic-simulation/pop/Pop.hpp"
+
 using namespace OpenVic;
 
+ArtisanalProducer::ArtisanalProducer() : ArtisanalProducer { nullptr, {}, fixed_point_t::_0(), {} } {}
+
 ArtisanalProducer::ArtisanalProducer(
-	ProductionType const& new_production_type,
+	ProductionType const* new_production_type_nullable,
 	GoodDefinition::good_definition_map_t&& new_stockpile,
 	fixed_point_t new_current_production,
 	GoodDefinition::good_definition_map_t&& new_current_needs
-) : production_type { new_production_type },
+) : production_type_nullable { new_production_type_nullable },
 	stockpile { std::move(new_stockpile) },
 	current_production { new_current_production },
-	current_needs { std::move(new_current_needs) } {}
+	current_needs { std::move(new_current_needs) },
+	purchase_results(
+		new_production_type_nullable != nullptr ? new_production_type_nullable->get_input_goods().size() : 0,
+		{ fixed_point_t::_0(), fixed_point_t::_0() }
+	),
+	sale_result { fixed_point_t::_0(), fixed_point_t::_0() } {}
+
+void ArtisanalProducer::set_production_type(ProductionType const* new_production_type_nullable) {
+	if (production_type_nullable == new_production_type_nullable) {
+		return;
+	}
+
+	production_type_nullable = new_production_type_nullable;
+	stockpile.clear();
+	current_needs.clear();
+	current_production = fixed_point_t::_0();
+	purchase_results.assign(
+		production_type_nullable != nullptr ? production_type_nullable->get_input_goods().size() : 0,
+		{ fixed_point_t::_0(), fixed_point_t::_0() }
+	);
+	sale_result = { fixed_point_t::_0(), fixed_point_t::_0() };
+}
+
+void ArtisanalProducer::tick(Pop& pop, MarketInstance& market_instance, efficiency_t const& efficiency) {
+	if (production_type_nullable == nullptr || production_type_nullable->get_base_workforce_size() <= 0) {
+		current_production = fixed_point_t::_0();
+		return;
+	}
+
+	ProductionType const& production_type = *production_type_nullable;
+
+	// Artisans work as a production unit per base workforce's worth of pop size
+	const fixed_point_t scale = fixed_point_t::parse(pop.get_size()) / production_type.get_base_workforce_size()
+		* efficiency.throughput;
+	const fixed_point_t input_scale = scale * efficiency.input;
+
+	fixed_point_t input_ratio = fixed_point_t::_1();
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		const fixed_point_t required = base_quantity * input_scale;
+		if (required > fixed_point_t::_0()) {
+			input_ratio = std::min(input_ratio, stockpile[good] / required);
+		}
+	}
+
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		fixed_point_t& stocked = stockpile[good];
+		stocked = std::max(stocked - base_quantity * input_scale * input_ratio, fixed_point_t::_0());
+	}
+
+	current_production = production_type.get_base_output_quantity() * scale * efficiency.output * input_ratio;
+	market_instance.place_sell_order(production_type.get_output_good(), current_production, &sale_result);
+
+	// Restock for tomorrow, buying as much as the pop's uncommitted cash covers
+	fixed_point_t restock_cost = fixed_point_t::_0();
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		fixed_point_t& needed = current_needs[good];
+		needed = std::max(base_quantity * input_scale - stockpile[good], fixed_point_t::_0());
+		restock_cost += needed * market_instance.get_price(*good);
+	}
+
+	const fixed_point_t cash = pop.get_unreserved_cash();
+	const fixed_point_t purchase_factor = restock_cost > cash ? cash / restock_cost : fixed_point_t::_1();
+
+	// Reserve what the orders can cost at most, so the pop's needs are budgeted from what's left
+	fixed_point_t reserved = fixed_point_t::_0();
+	size_t input_index = 0;
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		const fixed_point_t quantity = current_needs[good] * purchase_factor;
+		reserved += quantity * market_instance.get_price(*good);
+		market_instance.place_buy_order(*good, quantity, &purchase_results[input_index++]);
+	}
+	pop.reserve_cash(reserved);
+}
+
+void ArtisanalProducer::after_orders_executed(Pop& pop) {
+	if (production_type_nullable == nullptr) {
+		return;
+	}
+
+	fixed_point_t spendings = fixed_point_t::_0();
+	size_t input_index = 0;
+	for (auto const& [good, base_quantity] : production_type_nullable->get_input_goods()) {
+		MarketInstance::order_result_t const& result = purchase_results[input_index++];
+		stockpile[good] += result.quantity;
+		spendings += result.money;
+	}
+
+	pop.add_artisanal_income(sale_result.money - spendings);
+}
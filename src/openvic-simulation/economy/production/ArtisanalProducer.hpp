@@ -1,22 +1,48 @@
 #pragma once
 
+#include <vector>
+
 #include "openvic-simulation/economy/GoodDefinition.hpp"
-#include "openvic-simulation/economy/production/ProductionType.hpp"
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
 #include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
 #include "openvic-simulation/utility/Getters.hpp"
 
 namespace OpenVic {
+	struct ProductionType;
+	struct Pop;
+
+	/* An artisan pop's workshop. The pop's state decides which artisanal production type it works on (see
+	 * State::_tick_artisans), after which tick turns stockpiled inputs into output, sells the output and buys inputs for
+	 * the next day with the pop's own cash, reserving it before the pop's needs are budgeted. Switching production type
+	 * sells nothing back: the old stockpile is dropped, which is what makes frequent switching unattractive. */
 	struct ArtisanalProducer {
 	private:
-		ProductionType const& PROPERTY(production_type);
+		ProductionType const* PROPERTY(production_type_nullable);
 		GoodDefinition::good_definition_map_t PROPERTY(stockpile);
 		fixed_point_t PROPERTY(current_production);
 		GoodDefinition::good_definition_map_t PROPERTY(current_needs);
 
+		/* Order results, with purchase_results in the same order as the production type's input goods. */
+		std::vector<MarketInstance::order_result_t> purchase_results;
+		MarketInstance::order_result_t sale_result;
+
 	public:
+		/* The multipliers applied to every artisan working on a production type in a state. */
+		struct efficiency_t {
+			fixed_point_t throughput;
+			fixed_point_t output;
+			fixed_point_t input;
+		};
+
+		ArtisanalProducer();
 		ArtisanalProducer(
-			ProductionType const& new_production_type, GoodDefinition::good_definition_map_t&& new_stockpile,
+			ProductionType const* new_production_type_nullable, GoodDefinition::good_definition_map_t&& new_stockpile,
 			fixed_point_t new_current_production, GoodDefinition::good_definition_map_t&& new_current_needs
 		);
+
+		void set_production_type(ProductionType const* new_production_type_nullable);
+
+		void tick(Pop& pop, MarketInstance& market_instance, efficiency_t const& efficiency);
+		void after_orders_executed(Pop& pop);
 	};
 }
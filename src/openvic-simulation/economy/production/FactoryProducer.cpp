@@ -1,5 +1,12 @@
 #include "FactoryProducer.hpp"
 
+#include <algorithm>
+
+#include "openvic-simulation/defines/EconomyDefines.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/map/State.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
 using namespace OpenVic;
 
 FactoryProducer::FactoryProducer(
@@ -8,7 +15,7 @@ FactoryProducer::FactoryProducer(
 	fixed_point_t new_revenue_yesterday,
 	fixed_point_t new_output_quantity_yesterday,
 	fixed_point_t new_unsold_quantity_yesterday,
-	ordered_map<Pop*, Pop::pop_size_t>&& new_employees,
+	std::vector<Employee>&& new_employees,
 	GoodDefinition::good_definition_map_t&& new_stockpile,
 	fixed_point_t new_budget,
 	fixed_point_t new_balance_yesterday,
@@ -38,7 +45,21 @@ FactoryProducer::FactoryProducer(
 	days_without_input { new_days_without_input },
 	hiring_priority { new_hiring_priority },
 	profit_history_current { new_profit_history_current },
-	daily_profit_history { std::move(new_daily_profit_history) } {}
+	daily_profit_history { std::move(new_daily_profit_history) },
+	employee_count_per_job(new_production_type.get_jobs().size(), 0),
+	total_employees_count_cache { 0 },
+	total_paid_employees_count_cache { 0 },
+	purchase_results(new_production_type.get_input_goods().size(), { fixed_point_t::_0(), fixed_point_t::_0() }),
+	sale_result { fixed_point_t::_0(), fixed_point_t::_0() } {
+
+	// Loaded employees aren't attributed to jobs until the next hiring, but still count towards today's totals
+	for (Employee const& employee : employees) {
+		total_employees_count_cache += employee.get_size();
+		if (!employee.pop.get_type()->get_is_slave()) {
+			total_paid_employees_count_cache += employee.get_size();
+		}
+	}
+}
 
 FactoryProducer::FactoryProducer(ProductionType const& new_production_type, fixed_point_t new_size_multiplier)
 	: FactoryProducer { new_production_type, new_size_multiplier, 0, 0, 0, {}, {}, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, {} } {}
@@ -50,9 +71,226 @@ fixed_point_t FactoryProducer::get_profitability_yesterday() const {
 fixed_point_t FactoryProducer::get_average_profitability_last_seven_days() const {
 	fixed_point_t sum = 0;
 
-	for (int i = 0; i <= profit_history_current; i++) {
-		sum += daily_profit_history[i];
+	// Days before the factory existed count as zero profit
+	for (fixed_point_t const& profit : daily_profit_history) {
+		sum += profit;
+	}
+
+	return sum / DAYS_OF_HISTORY;
+}
+
+Pop::pop_size_t FactoryProducer::get_max_employee_count() const {
+	return static_cast<Pop::pop_size_t>((size_multiplier * production_type.get_base_workforce_size()).floor());
+}
+
+void FactoryProducer::_clear_employees() {
+	employees.clear();
+	std::fill(employee_count_per_job.begin(), employee_count_per_job.end(), 0);
+	total_employees_count_cache = 0;
+	total_paid_employees_count_cache = 0;
+}
+
+void FactoryProducer::_add_employee(size_t job_index, Pop& pop, Pop::pop_size_t size) {
+	if (size <= 0) {
+		return;
+	}
+
+	employees.emplace_back(pop, size);
+	employee_count_per_job[job_index] += size;
+	total_employees_count_cache += size;
+	if (!pop.get_type()->get_is_slave()) {
+		total_paid_employees_count_cache += size;
+	}
+}
+
+fixed_point_t FactoryProducer::_get_owner_effect(State const& state, Job::effect_t effect_type) const {
+	std::optional<Job> const& owner = production_type.get_owner();
+	if (!owner.has_value() || owner->get_pop_type() == nullptr || owner->get_effect_type() != effect_type) {
+		return fixed_point_t::_0();
+	}
+
+	const Pop::pop_size_t state_population = state.get_total_population();
+	if (state_population <= 0) {
+		return fixed_point_t::_0();
+	}
+
+	Pop::pop_size_t owner_count = 0;
+	for (Pop const* owner_pop : state.get_pops_by_type()[*owner->get_pop_type()]) {
+		owner_count += owner_pop->get_size();
+	}
+
+	return owner->get_effect_multiplier() * owner_count / state_population;
+}
+
+void FactoryProducer::tick(
+	State const& state, MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+	EconomyDefines const& economy_defines, ConditionContext const& context
+) {
+	const Pop::pop_size_t max_employee_count = get_max_employee_count();
+	ProvinceInstance const* location = state.get_capital();
+
+	if (max_employee_count <= 0 || location == nullptr) {
+		output_quantity_yesterday = 0;
+		return;
+	}
+
+	fixed_point_t throughput_multiplier = fixed_point_t::_1();
+	fixed_point_t output_multiplier = fixed_point_t::_1();
+	fixed_point_t input_multiplier = fixed_point_t::_1();
+
+	// The capital's modifier sum is layered on the owner's, so this picks up both national and local effects
+	throughput_multiplier += location->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_factory_throughput())
+		+ location->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_local_factory_throughput());
+	output_multiplier += location->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_factory_output())
+		+ location->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_local_factory_output());
+	input_multiplier += location->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_factory_input())
+		+ location->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_local_factory_input());
+
+	auto const& good_effects = modifier_effect_cache.get_good_effects()[production_type.get_output_good()];
+	throughput_multiplier += location->get_modifier_effect_value_nullcheck(good_effects.get_factory_goods_throughput());
+	output_multiplier += location->get_modifier_effect_value_nullcheck(good_effects.get_factory_goods_output());
+	input_multiplier += location->get_modifier_effect_value_nullcheck(good_effects.get_factory_goods_input());
+
+	for (ProductionType::bonus_t const& bonus : production_type.get_bonuses()) {
+		if (bonus.first.evaluate(context.this_scope, context)) {
+			throughput_multiplier += bonus.second;
+		}
+	}
+
+	throughput_multiplier += _get_owner_effect(state, Job::effect_t::THROUGHPUT);
+	output_multiplier += _get_owner_effect(state, Job::effect_t::OUTPUT);
+	input_multiplier += _get_owner_effect(state, Job::effect_t::INPUT);
+
+	fixed_point_t throughput_from_workers = fixed_point_t::_0();
+	fixed_point_t output_from_workers = fixed_point_t::_1();
+	std::vector<Job> const& jobs = production_type.get_jobs();
+	for (size_t job_index = 0; job_index < jobs.size(); ++job_index) {
+		Job const& job = jobs[job_index];
+
+		const fixed_point_t effect_multiplier = job.get_effect_multiplier();
+		fixed_point_t relative_to_workforce =
+			fixed_point_t::parse(employee_count_per_job[job_index]) / fixed_point_t::parse(max_employee_count);
+		const fixed_point_t amount = job.get_amount();
+		if (effect_multiplier != fixed_point_t::_1() && relative_to_workforce > amount) {
+			relative_to_workforce = amount;
+		}
+
+		switch (job.get_effect_type()) {
+			case Job::effect_t::INPUT:
+				input_multiplier += effect_multiplier * relative_to_workforce;
+				break;
+			case Job::effect_t::OUTPUT:
+				output_from_workers += effect_multiplier * relative_to_workforce;
+				break;
+			case Job::effect_t::THROUGHPUT:
+				throughput_from_workers += effect_multiplier * relative_to_workforce;
+				break;
+			default:
+				Logger::error("Invalid job effect in factory ", production_type.get_identifier());
+				break;
+		}
+	}
+
+	throughput_multiplier = std::max(throughput_multiplier, fixed_point_t::_0()) * throughput_from_workers;
+	output_multiplier = std::max(output_multiplier, fixed_point_t::_0()) * output_from_workers;
+	input_multiplier = std::max(input_multiplier, fixed_point_t::_0());
+
+	// Production is limited by whichever input is shortest relative to what today's throughput needs
+	const fixed_point_t input_scale = size_multiplier * throughput_multiplier * input_multiplier;
+	fixed_point_t input_ratio = fixed_point_t::_1();
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		const fixed_point_t required = base_quantity * input_scale;
+		if (required > fixed_point_t::_0()) {
+			input_ratio = std::min(input_ratio, stockpile[good] / required);
+		}
+	}
+
+	if (input_ratio > fixed_point_t::_0()) {
+		days_without_input = 0;
+	} else if (!production_type.get_input_goods().empty()) {
+		++days_without_input;
+	}
+
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		fixed_point_t& stocked = stockpile[good];
+		stocked = std::max(stocked - base_quantity * input_scale * input_ratio, fixed_point_t::_0());
+	}
+
+	output_quantity_yesterday = production_type.get_base_output_quantity() * size_multiplier * throughput_multiplier
+		* output_multiplier * input_ratio;
+	market_instance.place_sell_order(production_type.get_output_good(), output_quantity_yesterday, &sale_result);
+
+	/* Restock for tomorrow at today's throughput. Factories always buy at least the minimum purchase factor of what they
+	 * need, going into debt if necessary, and otherwise spend at most the drawdown factor of their budget. */
+	fixed_point_t restock_cost = fixed_point_t::_0();
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		const fixed_point_t missing = base_quantity * input_scale - stockpile[good];
+		if (missing > fixed_point_t::_0()) {
+			restock_cost += missing * market_instance.get_price(*good);
+		}
+	}
+
+	fixed_point_t purchase_factor = fixed_point_t::_1();
+	if (restock_cost > fixed_point_t::_0()) {
+		const fixed_point_t affordable = std::max(budget, fixed_point_t::_0())
+			* economy_defines.get_factory_purchase_drawdown_factor() / restock_cost;
+		purchase_factor = std::clamp(affordable, economy_defines.get_factory_purchase_min_factor(), fixed_point_t::_1());
+	}
+
+	size_t input_index = 0;
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		const fixed_point_t missing = base_quantity * input_scale - stockpile[good];
+		market_instance.place_buy_order(*good, missing * purchase_factor, &purchase_results[input_index++]);
+	}
+}
+
+void FactoryProducer::after_orders_executed(EconomyDefines const& economy_defines) {
+	fixed_point_t spendings = fixed_point_t::_0();
+	size_t input_index = 0;
+	for (auto const& [good, base_quantity] : production_type.get_input_goods()) {
+		MarketInstance::order_result_t const& result = purchase_results[input_index++];
+		stockpile[good] += result.quantity;
+		spendings += result.money;
+	}
+
+	revenue_yesterday = sale_result.money;
+	unsold_quantity_yesterday = output_quantity_yesterday - sale_result.quantity;
+	market_spendings_yesterday = spendings;
+
+	const fixed_point_t profit = revenue_yesterday - market_spendings_yesterday;
+
+	// Workers are paid from profit, less what the factory keeps back, plus anything beyond its savings cap
+	paychecks_yesterday = fixed_point_t::_0();
+	if (profit > fixed_point_t::_0() && total_paid_employees_count_cache > 0) {
+		const fixed_point_t kept = profit * economy_defines.get_factory_paychecks_leftover_factor();
+		paychecks_yesterday = profit - kept;
+		budget += kept;
+
+		const fixed_point_t max_savings = economy_defines.get_max_factory_money_save() * size_multiplier;
+		if (budget > max_savings) {
+			paychecks_yesterday += budget - max_savings;
+			budget = max_savings;
+		}
+
+		for (Employee& employee : employees) {
+			if (!employee.pop.get_type()->get_is_slave()) {
+				employee.pop.add_factory_worker_income(
+					paychecks_yesterday * employee.get_size() / total_paid_employees_count_cache
+				);
+			}
+		}
+	} else {
+		budget += profit;
+	}
+
+	balance_yesterday = profit - paychecks_yesterday;
+
+	if (profit < fixed_point_t::_0()) {
+		++unprofitable_days;
+	} else {
+		unprofitable_days = 0;
 	}
 
-	return sum / (1 + profit_history_current);
+	profit_history_current = (profit_history_current + 1) % DAYS_OF_HISTORY;
+	daily_profit_history[profit_history_current] = profit;
 }
@@ -1,14 +1,29 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <vector>
 
 #include "openvic-simulation/economy/GoodDefinition.hpp"
+#include "openvic-simulation/economy/production/Employee.hpp"
 #include "openvic-simulation/economy/production/ProductionType.hpp"
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
 #include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
 #include "openvic-simulation/utility/Getters.hpp"
 
 namespace OpenVic {
+	struct State;
+	struct EconomyDefines;
+
+	/* A factory's daily cycle, driven by its state:
+	 *  - the state hires workers for all of its factories at once (see State::_hire_factory_workers),
+	 *  - tick consumes inputs from the stockpile, produces output with throughput, efficiency and bonus multipliers,
+	 *    places a sell order for the output and buy orders to refill the stockpile for tomorrow,
+	 *  - after_orders_executed banks the purchases and sales, pays wages and records the day's profit. */
 	struct FactoryProducer {
+		friend struct State;
+
 	private:
 		static constexpr uint8_t DAYS_OF_HISTORY = 7;
 		using daily_profit_history_t = std::array<fixed_point_t, DAYS_OF_HISTORY>;
@@ -20,7 +35,7 @@ namespace OpenVic {
 		fixed_point_t PROPERTY(output_quantity_yesterday);
 		fixed_point_t PROPERTY(unsold_quantity_yesterday);
 		fixed_point_t PROPERTY(size_multiplier);
-		ordered_map<Pop*, Pop::pop_size_t> PROPERTY(employees);
+		std::vector<Employee> PROPERTY(employees);
 		GoodDefinition::good_definition_map_t PROPERTY(stockpile);
 		fixed_point_t PROPERTY(budget);
 		fixed_point_t PROPERTY(balance_yesterday);
@@ -32,19 +47,43 @@ namespace OpenVic {
 		uint32_t PROPERTY(days_without_input);
 		uint8_t PROPERTY_RW(hiring_priority);
 
+		/* Per job in production_type, the number of employees hired for it today. */
+		std::vector<Pop::pop_size_t> employee_count_per_job;
+		Pop::pop_size_t PROPERTY(total_employees_count_cache);
+		Pop::pop_size_t PROPERTY(total_paid_employees_count_cache);
+
+		/* Order results, with purchase_results in the same order as production_type's input goods. */
+		std::vector<MarketInstance::order_result_t> purchase_results;
+		MarketInstance::order_result_t sale_result;
+
+		void _clear_employees();
+		void _add_employee(size_t job_index, Pop& pop, Pop::pop_size_t size);
+
+		fixed_point_t _get_owner_effect(State const& state, Job::effect_t effect_type) const;
+
 	public:
 		FactoryProducer(
 			ProductionType const& new_production_type, fixed_point_t new_size_multiplier, fixed_point_t new_revenue_yesterday,
 			fixed_point_t new_output_quantity_yesterday, fixed_point_t new_unsold_quantity_yesterday,
-			ordered_map<Pop*, Pop::pop_size_t>&& new_employees, GoodDefinition::good_definition_map_t&& new_stockpile,
+			std::vector<Employee>&& new_employees, GoodDefinition::good_definition_map_t&& new_stockpile,
 			fixed_point_t new_budget, fixed_point_t new_balance_yesterday, fixed_point_t new_received_investments_yesterday,
 			fixed_point_t new_market_spendings_yesterday, fixed_point_t new_paychecks_yesterday, uint32_t new_unprofitable_days,
 			uint32_t new_subsidised_days, uint32_t new_days_without_input, uint8_t new_hiring_priority,
 			uint8_t new_profit_history_current, daily_profit_history_t&& new_daily_profit_history
 		);
 		FactoryProducer(ProductionType const& new_production_type, fixed_point_t new_size_multiplier);
+		FactoryProducer(FactoryProducer&&) = default;
 
 		fixed_point_t get_profitability_yesterday() const;
 		fixed_point_t get_average_profitability_last_seven_days() const;
+
+		/* The number of workers the factory can employ at its current size. */
+		Pop::pop_size_t get_max_employee_count() const;
+
+		void tick(
+			State const& state, MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+			EconomyDefines const& economy_defines, ConditionContext const& context
+		);
+		void after_orders_executed(EconomyDefines const& economy_defines);
 	};
 }
@@ -52,8 +52,9 @@ bool ProductionType::parse_scripts(DefinitionManager const& definition_manager)
 }
 
 ProductionTypeManager::ProductionTypeManager() :
+	rgo_owner_sprite { 0 },
 	good_to_rgo_production_type { nullptr },
-	rgo_owner_sprite { 0 } {}
+	good_to_artisan_production_type { nullptr } {}
 
 node_callback_t ProductionTypeManager::_expect_job(
 	GoodDefinitionManager const& good_definition_manager, PopManager const& pop_manager, callback_t<Job&&> callback
@@ -183,6 +184,13 @@ bool ProductionTypeManager::add_production_type(
 		//else ignore, we already have an rgo pt
 	}
 
+	if (ret && (template_type == ARTISAN)) {
+		ProductionType const*& current_artisan_pt = good_to_artisan_production_type[*output_good];
+		if (current_artisan_pt == nullptr) {
+			current_artisan_pt = &production_types.get_items().back();
+		}
+	}
+
 	if (rgo_owner_sprite <= 0 && ret && template_type == RGO && owner.has_value() && owner->get_pop_type() != nullptr) {
 		/* Set rgo owner sprite to that of the first RGO owner we find. */
 		rgo_owner_sprite = owner->get_pop_type()->get_sprite();
@@ -241,6 +249,7 @@ bool ProductionTypeManager::load_production_types_file(
 
 	/* Pass #3: actually load production types */
 	good_to_rgo_production_type.set_keys(&good_definition_manager.get_good_definitions());
+	good_to_artisan_production_type.set_keys(&good_definition_manager.get_good_definitions());
 
 	reserve_more_production_types(expected_types);
 	ret &= expect_dictionary(
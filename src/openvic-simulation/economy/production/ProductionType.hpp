@@ -84,6 +84,7 @@ namespace OpenVic {
 		IdentifierRegistry<ProductionType> IDENTIFIER_REGISTRY(production_type);
 		PopType::sprite_t PROPERTY(rgo_owner_sprite);
 		IndexedMap<GoodDefinition, ProductionType const*> PROPERTY(good_to_rgo_production_type);
+		IndexedMap<GoodDefinition, ProductionType const*> PROPERTY(good_to_artisan_production_type);
 
 		NodeTools::node_callback_t _expect_job(
 			GoodDefinitionManager const& good_definition_manager, PopManager const& pop_manager,
@@ -1,9 +1,11 @@
 #include "ResourceGatheringOperation.hpp"
 
+#include <algorithm>
 #include <vector>
 
 #include "openvic-simulation/economy/production/Employee.hpp"
 #include "openvic-simulation/economy/production/ProductionType.hpp"
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
 #include "openvic-simulation/map/ProvinceInstance.hpp"
 #include "openvic-simulation/map/State.hpp"
 #include "openvic-simulation/modifier/ModifierEffectCache.hpp"
@@ -32,7 +34,10 @@ ResourceGatheringOperation::ResourceGatheringOperation(
 	total_paid_employees_count_cache { 0 },
 	total_owner_income_cache { },
 	total_employee_income_cache { },
-	employee_count_per_type_cache { &pop_type_keys }
+	employee_count_per_type_cache { &pop_type_keys },
+	total_worker_count_in_province_cache { 0 },
+	total_owner_count_in_state_cache { 0 },
+	sale_result { fixed_point_t::_0(), fixed_point_t::_0() }
 { }
 
 ResourceGatheringOperation::ResourceGatheringOperation(decltype(employee_count_per_type_cache)::keys_t const& pop_type_keys) : ResourceGatheringOperation {
@@ -41,7 +46,9 @@ ResourceGatheringOperation::ResourceGatheringOperation(decltype(employee_count_p
 	fixed_point_t::_0(), {}, pop_type_keys
 } {}
 
-void ResourceGatheringOperation::initialise_for_new_game(ProvinceInstance& location, ModifierEffectCache const& modifier_effect_cache) {
+void ResourceGatheringOperation::initialise_for_new_game(
+	ProvinceInstance& location, MarketInstance const& market_instance, ModifierEffectCache const& modifier_effect_cache
+) {
 	if (production_type_nullable == nullptr) {
 		output_quantity_yesterday = 0;
 		revenue_yesterday = 0;
@@ -49,14 +56,71 @@ void ResourceGatheringOperation::initialise_for_new_game(ProvinceInstance& locat
 	}
 
 	ProductionType const& production_type = *production_type_nullable;
+	_update_workforce_and_produce(location, modifier_effect_cache);
+	// Nothing has been sold yet, so the opening output is valued at the current market price
+	revenue_yesterday = output_quantity_yesterday * market_instance.get_price(production_type.get_output_good());
+	pay_employees(location, revenue_yesterday);
+}
+
+void ResourceGatheringOperation::tick(
+	ProvinceInstance& location, MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache
+) {
+	if (production_type_nullable == nullptr) {
+		output_quantity_yesterday = 0;
+		sale_result = { fixed_point_t::_0(), fixed_point_t::_0() };
+		return;
+	}
+
+	_update_workforce_and_produce(location, modifier_effect_cache);
+	market_instance.place_sell_order(production_type_nullable->get_output_good(), output_quantity_yesterday, &sale_result);
+}
+
+void ResourceGatheringOperation::after_orders_executed(ProvinceInstance& location) {
+	if (production_type_nullable == nullptr) {
+		revenue_yesterday = 0;
+		unsold_quantity_yesterday = 0;
+		return;
+	}
+
+	revenue_yesterday = sale_result.money;
+	unsold_quantity_yesterday = output_quantity_yesterday - sale_result.quantity;
+	pay_employees(location, revenue_yesterday);
+}
+
+void ResourceGatheringOperation::_update_workforce_and_produce(
+	ProvinceInstance& location, ModifierEffectCache const& modifier_effect_cache
+) {
 	const fixed_point_t size_modifier = calculate_size_modifier(location, modifier_effect_cache);
-	const Pop::pop_size_t total_worker_count_in_province = update_size_and_return_total_worker_count(location, modifier_effect_cache, size_modifier);
-	hire(location, total_worker_count_in_province);
-	Pop::pop_size_t total_owner_count_in_state_cache = 0;
-	std::vector<Pop*> owner_pops_cache {};
-	output_quantity_yesterday = produce(location, owner_pops_cache, total_owner_count_in_state_cache, modifier_effect_cache, size_modifier);
-	revenue_yesterday = output_quantity_yesterday * production_type.get_output_good().get_base_price(); //TODO sell on market
-	pay_employees(location, revenue_yesterday, total_worker_count_in_province, owner_pops_cache, total_owner_count_in_state_cache);	
+	total_worker_count_in_province_cache = update_size_and_return_total_worker_count(location, modifier_effect_cache, size_modifier);
+	hire(location, total_worker_count_in_province_cache);
+	output_quantity_yesterday = produce(location, modifier_effect_cache, size_modifier);
+}
+
+/* Calls func once for every pop in location whose type has a job in the RGO's production type. */
+template<typename Func>
+void ResourceGatheringOperation::_for_each_worker_pop(ProvinceInstance& location, Func&& func) const {
+	std::vector<Job> const& jobs = production_type_nullable->get_jobs();
+	for (auto job_it = jobs.begin(); job_it != jobs.end(); ++job_it) {
+		PopType const* pop_type = job_it->get_pop_type();
+		if (pop_type == nullptr || std::any_of(jobs.begin(), job_it, [pop_type](Job const& job) -> bool {
+			return job.get_pop_type() == pop_type;
+		})) {
+			continue;
+		}
+
+		for (Pop* pop : location.get_pops_by_type()[*pop_type]) {
+			func(*pop);
+		}
+	}
+}
+
+std::vector<Pop*> const* ResourceGatheringOperation::_get_owner_pops(ProvinceInstance const& location) const {
+	std::optional<Job> const& owner = production_type_nullable->get_owner();
+	State const* state = location.get_state();
+	if (!owner.has_value() || owner->get_pop_type() == nullptr || state == nullptr) {
+		return nullptr;
+	}
+	return &state->get_pops_by_type()[*owner->get_pop_type()];
 }
 
 Pop::pop_size_t ResourceGatheringOperation::update_size_and_return_total_worker_count(
@@ -72,17 +136,9 @@ Pop::pop_size_t ResourceGatheringOperation::update_size_and_return_total_worker_
 	
 	Pop::pop_size_t total_worker_count_in_province = 0; //not counting equivalents
 	ProductionType const& production_type = *production_type_nullable;
-	std::vector<Job> const& jobs = production_type.get_jobs();
-	//can't use pop_type_distribution as it is not filled correctly yet (possibly due to equivalent pop type conversion)
-	for (Pop const& pop : location.get_pops()){
-		PopType const* pop_type = pop.get_type();
-		for(Job const& job : jobs) {
-			if (job.get_pop_type() == pop_type) {
-				total_worker_count_in_province += pop.get_size();
-				break;
-			}
-		}
-	}
+	_for_each_worker_pop(location, [&total_worker_count_in_province](Pop const& pop) -> void {
+		total_worker_count_in_province += pop.get_size();
+	});
 	
 	fixed_point_t base_size_modifier = fixed_point_t::_1();
 	if (production_type.is_farm()) {
@@ -126,13 +182,12 @@ fixed_point_t ResourceGatheringOperation::calculate_size_modifier(ProvinceInstan
 void ResourceGatheringOperation::hire(ProvinceInstance& location, Pop::pop_size_t available_worker_count) {
 	total_employees_count_cache = 0;
 	total_paid_employees_count_cache=0;
+	employees.clear();
+	employee_count_per_type_cache.fill(0);
 	if (production_type_nullable == nullptr) {
-		employees.clear();
-		employee_count_per_type_cache.fill(fixed_point_t::_0());
 		return;
 	}
 
-	ProductionType const& production_type = *production_type_nullable;
 	if (max_employee_count_cache <= 0) { return; }
 	if (available_worker_count <= 0) { return; }
 
@@ -146,37 +201,28 @@ void ResourceGatheringOperation::hire(ProvinceInstance& location, Pop::pop_size_
 		proportion_to_hire = max_worker_count_real / available_worker_count_real;
 	}
 	
-	std::vector<Job> const& jobs = production_type.get_jobs();
-	for (Pop& pop : location.get_mutable_pops()){
+	_for_each_worker_pop(location, [this, proportion_to_hire](Pop& pop) -> void {
 		PopType const& pop_type = *pop.get_type();
-		for(Job const& job : jobs) {
-			if (job.get_pop_type() == &pop_type) {
-				const Pop::pop_size_t pop_size_to_hire = static_cast<Pop::pop_size_t>((proportion_to_hire * pop.get_size()).floor());
-				employee_count_per_type_cache[pop_type] += pop_size_to_hire;
-				employees.emplace_back(pop, pop_size_to_hire);
-				total_employees_count_cache += pop_size_to_hire;
-				if (!pop_type.get_is_slave()) {
-					total_paid_employees_count_cache += pop_size_to_hire;
-				}
-				break;
-			}
+		const Pop::pop_size_t pop_size_to_hire = static_cast<Pop::pop_size_t>((proportion_to_hire * pop.get_size()).floor());
+		employee_count_per_type_cache[pop_type] += pop_size_to_hire;
+		employees.emplace_back(pop, pop_size_to_hire);
+		total_employees_count_cache += pop_size_to_hire;
+		if (!pop_type.get_is_slave()) {
+			total_paid_employees_count_cache += pop_size_to_hire;
 		}
-	}
+	});
 }
 
 fixed_point_t ResourceGatheringOperation::produce(
 	ProvinceInstance& location,
-	std::vector<Pop*>& owner_pops_cache,
-	Pop::pop_size_t& total_owner_count_in_state_cache,
 	ModifierEffectCache const& modifier_effect_cache,
 	const fixed_point_t size_modifier
 ) {
+	total_owner_count_in_state_cache = 0;
 	if (size_modifier == fixed_point_t::_0()){
 		return fixed_point_t::_0();
 	}
 
-	total_owner_count_in_state_cache = 0;
-	owner_pops_cache = {};
 	if (production_type_nullable == nullptr || max_employee_count_cache <= 0) {
 		return fixed_point_t::_0();
 	}
@@ -200,24 +246,12 @@ fixed_point_t ResourceGatheringOperation::produce(
 			return fixed_point_t::_0();
 		}
 		State const& state = *state_nullable;
-		Pop::pop_size_t state_population = 0; //state.get_total_population() is not filled yet
-		std::vector<ProvinceInstance*> const& provinces_in_state = state.get_provinces();
-		for (ProvinceInstance* const province_nullable : provinces_in_state) {
-			if (province_nullable == nullptr) {
-				Logger::error("State ", state.get_identifier(), " has nullptr in provinces.");
-				return fixed_point_t::_0();
-			}
-			ProvinceInstance& province = *province_nullable;
-			for (Pop& pop : province.get_mutable_pops()){
-				state_population += pop.get_size();
-				if (&owner_pop_type == pop.get_type()) {
-					owner_pops_cache.push_back(&pop);
-					total_owner_count_in_state_cache += pop.get_size();
-				}
-			}
+		const Pop::pop_size_t state_population = state.get_total_population();
+		for (Pop const* owner_pop : state.get_pops_by_type()[owner_pop_type]) {
+			total_owner_count_in_state_cache += owner_pop->get_size();
 		}
 
-		if (total_owner_count_in_state_cache > 0) {
+		if (total_owner_count_in_state_cache > 0 && state_population > 0) {
 			switch (owner_job.get_effect_type()) {
 				case Job::effect_t::OUTPUT:
 					output_multilpier += owner_job.get_effect_multiplier() * total_owner_count_in_state_cache / state_population;
@@ -289,13 +323,8 @@ fixed_point_t ResourceGatheringOperation::produce(
 		* output_multilpier * output_from_workers;
 }
 
-void ResourceGatheringOperation::pay_employees(
-	ProvinceInstance& location,
-	const fixed_point_t revenue,
-	const Pop::pop_size_t total_worker_count_in_province,
-	std::vector<Pop*>& owner_pops_cache,
-	const Pop::pop_size_t total_owner_count_in_state_cache
-) {
+void ResourceGatheringOperation::pay_employees(ProvinceInstance& location, const fixed_point_t revenue) {
+	const Pop::pop_size_t total_worker_count_in_province = total_worker_count_in_province_cache;
 	total_owner_income_cache = 0;
 	total_employee_income_cache = 0;
 	if (production_type_nullable == nullptr || revenue <= 0 || total_worker_count_in_province <= 0) {
@@ -303,21 +332,17 @@ void ResourceGatheringOperation::pay_employees(
 		if (total_worker_count_in_province < 0) { Logger::error("Negative total worker count for province ", location.get_identifier()); }
 		return;
 	}
-	
-	ProductionType const& production_type = *production_type_nullable;
 
 	fixed_point_t revenue_left = revenue;
-	if (total_owner_count_in_state_cache > 0) {
-		Job const& owner_job = production_type.get_owner().value();
-		PopType const* owner_job_pop_type_nullable = owner_job.get_pop_type();
-		
+	std::vector<Pop*> const* owner_pops = _get_owner_pops(location);
+	if (total_owner_count_in_state_cache > 0 && owner_pops != nullptr) {
 		fixed_point_t owner_share = (fixed_point_t::_2() * total_owner_count_in_state_cache / total_worker_count_in_province);
 		constexpr fixed_point_t upper_limit = fixed_point_t::_0_50();
 		if (owner_share > upper_limit) {
 			owner_share = upper_limit;
 		}
 
-		for(Pop* owner_pop_nullable : owner_pops_cache) {
+		for(Pop* owner_pop_nullable : *owner_pops) {
 			Pop& owner_pop = *owner_pop_nullable;
 			const fixed_point_t income_for_this_pop = revenue_left * owner_share * owner_pop.get_size() / total_owner_count_in_state_cache;
 			owner_pop.add_rgo_owner_income(income_for_this_pop);
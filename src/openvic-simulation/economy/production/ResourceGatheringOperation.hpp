@@ -2,12 +2,16 @@
 
 #include "openvic-simulation/economy/production/Employee.hpp"
 #include "openvic-simulation/economy/production/ProductionType.hpp"
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
 #include "openvic-simulation/modifier/ModifierEffectCache.hpp"
 #include "openvic-simulation/pop/Pop.hpp"
 #include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
 #include "openvic-simulation/utility/Getters.hpp"
 
 namespace OpenVic {
+	/* Employs the pops of its production type's job types in its province and sells their output on the market
+	 * each day. The job and owner pops are found through the state's per-type pop index, so each day's work is
+	 * linear in the pops that can actually work for or own the RGO rather than in the whole state's population. */
 	struct ResourceGatheringOperation {
 	private:
 		ProductionType const* PROPERTY_RW(production_type_nullable);
@@ -22,6 +26,13 @@ namespace OpenVic {
 		fixed_point_t PROPERTY(total_owner_income_cache);
 		fixed_point_t PROPERTY(total_employee_income_cache);
 		IndexedMap<PopType, Pop::pop_size_t> PROPERTY(employee_count_per_type_cache);
+		Pop::pop_size_t PROPERTY(total_worker_count_in_province_cache);
+		Pop::pop_size_t PROPERTY(total_owner_count_in_state_cache);
+		MarketInstance::order_result_t sale_result;
+
+		template<typename Func>
+		void _for_each_worker_pop(ProvinceInstance& location, Func&& func) const;
+		std::vector<Pop*> const* _get_owner_pops(ProvinceInstance const& location) const;
 
 		Pop::pop_size_t update_size_and_return_total_worker_count(
 			ProvinceInstance& location,
@@ -32,18 +43,11 @@ namespace OpenVic {
 		void hire(ProvinceInstance& location, const Pop::pop_size_t available_worker_count);
 		fixed_point_t produce(
 			ProvinceInstance& location,
-			std::vector<Pop*>& owner_pops_cache,
-			Pop::pop_size_t& total_owner_count_in_state_cache,
 			ModifierEffectCache const& modifier_effect_cache,
 			const fixed_point_t size_modifier
 		);
-		void pay_employees(
-			ProvinceInstance& location,
-			const fixed_point_t revenue,
-			const Pop::pop_size_t total_worker_count_in_province,
-			std::vector<Pop*>& owner_pops_cache,
-			const Pop::pop_size_t total_owner_count_in_state_cache
-		);
+		void pay_employees(ProvinceInstance& location, const fixed_point_t revenue);
+		void _update_workforce_and_produce(ProvinceInstance& location, ModifierEffectCache const& modifier_effect_cache);
 
 	public:
 		ResourceGatheringOperation(
@@ -59,6 +63,13 @@ namespace OpenVic {
 		constexpr bool is_valid() const {
 			return production_type_nullable != nullptr;
 		}
-		void initialise_for_new_game(ProvinceInstance& location, ModifierEffectCache const& modifier_effect_cache);
+		void initialise_for_new_game(
+			ProvinceInstance& location, MarketInstance const& market_instance, ModifierEffectCache const& modifier_effect_cache
+		);
+
+		/* Hires, produces and places a sell order for the day's output, which is paid out to the workers and owners
+		 * by after_orders_executed once the market has cleared. */
+		void tick(ProvinceInstance& location, MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache);
+		void after_orders_executed(ProvinceInstance& location);
 	};
 }
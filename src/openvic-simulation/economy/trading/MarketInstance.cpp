@@ -0,0 +1,149 @@
+#include "MarketInstance.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/economy/GoodDefinition.hpp"
+#include "openvic-simulation/economy/GoodInstance.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+MarketInstance::MarketInstance(GoodInstanceManager& new_good_instance_manager)
+  : good_instance_manager { new_good_instance_manager },
+	buy_orders_executed_yesterday { 0 },
+	sell_orders_executed_yesterday { 0 } {}
+
+bool MarketInstance::setup() {
+	if (!good_instance_manager.good_instances_are_locked()) {
+		Logger::error("Cannot set up market - good instances are not locked!");
+		return false;
+	}
+
+	buy_orders.clear();
+	sell_orders.clear();
+	clearing.assign(good_instance_manager.get_good_instance_count(), {});
+
+	return true;
+}
+
+void MarketInstance::reserve_orders(size_t buy_order_count, size_t sell_order_count) {
+	buy_orders.reserve(buy_order_count);
+	sell_orders.reserve(sell_order_count);
+}
+
+fixed_point_t MarketInstance::get_price(GoodDefinition const& good) const {
+	return good_instance_manager.get_good_instance_from_definition(good).get_price();
+}
+
+bool MarketInstance::is_good_available(GoodDefinition const& good) const {
+	return good_instance_manager.get_good_instance_from_definition(good).get_is_available();
+}
+
+void MarketInstance::_place_order(
+	std::vector<order_t>& orders, GoodDefinition const& good, fixed_point_t quantity, order_result_t* result
+) {
+	if (result != nullptr) {
+		*result = { fixed_point_t::_0(), fixed_point_t::_0() };
+	}
+
+	if (quantity <= fixed_point_t::_0()) {
+		return;
+	}
+
+	if (good.get_index() >= clearing.size()) {
+		Logger::error("Cannot place order for ", good.get_identifier(), " - market not set up!");
+		return;
+	}
+
+	orders.push_back({ static_cast<uint32_t>(good.get_index()), quantity, result });
+}
+
+void MarketInstance::place_buy_order(GoodDefinition const& good, fixed_point_t quantity, order_result_t* result) {
+	_place_order(buy_orders, good, quantity, result);
+}
+
+void MarketInstance::place_sell_order(GoodDefinition const& good, fixed_point_t quantity, order_result_t* result) {
+	_place_order(sell_orders, good, quantity, result);
+}
+
+void MarketInstance::execute_orders() {
+	std::vector<GoodInstance>& good_instances = good_instance_manager.good_instances.get_items();
+
+	for (good_clearing_t& good_clearing : clearing) {
+		good_clearing.supply = fixed_point_t::_0();
+		good_clearing.demand = fixed_point_t::_0();
+	}
+
+	for (order_t const& order : sell_orders) {
+		clearing[order.good_index].supply += order.quantity;
+	}
+	for (order_t const& order : buy_orders) {
+		clearing[order.good_index].demand += order.quantity;
+	}
+
+	// Whichever side of a good's market is larger is rationed pro rata, the other is filled completely
+	for (size_t index = 0; index < clearing.size(); ++index) {
+		good_clearing_t& good_clearing = clearing[index];
+		GoodInstance const& good_instance = good_instances[index];
+
+		good_clearing.price = good_instance.get_price();
+
+		if (!good_instance.get_is_available()) {
+			good_clearing.buy_fill_ratio = fixed_point_t::_0();
+			good_clearing.sell_fill_ratio = fixed_point_t::_0();
+		} else if (good_clearing.demand > good_clearing.supply) {
+			good_clearing.buy_fill_ratio = good_clearing.supply / good_clearing.demand;
+			good_clearing.sell_fill_ratio = fixed_point_t::_1();
+		} else if (good_clearing.supply > good_clearing.demand) {
+			good_clearing.buy_fill_ratio = fixed_point_t::_1();
+			good_clearing.sell_fill_ratio = good_clearing.demand / good_clearing.supply;
+		} else {
+			good_clearing.buy_fill_ratio = fixed_point_t::_1();
+			good_clearing.sell_fill_ratio = fixed_point_t::_1();
+		}
+	}
+
+	const auto write_results = [this](std::vector<order_t> const& orders, bool is_buy) -> void {
+		for (order_t const& order : orders) {
+			if (order.result == nullptr) {
+				continue;
+			}
+			good_clearing_t const& good_clearing = clearing[order.good_index];
+			const fixed_point_t quantity = order.quantity
+				* (is_buy ? good_clearing.buy_fill_ratio : good_clearing.sell_fill_ratio);
+			*order.result = { quantity, quantity * good_clearing.price };
+		}
+	};
+	write_results(buy_orders, true);
+	write_results(sell_orders, false);
+
+	// Prices move by up to the maximum daily change, scaled by how unbalanced the market is
+	for (size_t index = 0; index < clearing.size(); ++index) {
+		good_clearing_t const& good_clearing = clearing[index];
+		GoodInstance& good_instance = good_instances[index];
+
+		good_instance.total_supply_yesterday = good_clearing.supply;
+		good_instance.total_demand_yesterday = good_clearing.demand;
+		good_instance.quantity_traded_yesterday = good_instance.get_is_available()
+			? std::min(good_clearing.supply, good_clearing.demand) : fixed_point_t::_0();
+
+		const fixed_point_t larger_side = std::max(good_clearing.supply, good_clearing.demand);
+		if (!good_instance.get_is_available() || larger_side == fixed_point_t::_0()) {
+			continue;
+		}
+
+		const fixed_point_t base_price = good_instance.get_good_definition().get_base_price();
+		const fixed_point_t imbalance = (good_clearing.demand - good_clearing.supply) / larger_side;
+
+		good_instance.price = std::clamp(
+			good_clearing.price + imbalance * MAX_DAILY_PRICE_CHANGE_FACTOR * base_price,
+			MIN_PRICE_FACTOR * base_price, MAX_PRICE_FACTOR * base_price
+		);
+	}
+
+	buy_orders_executed_yesterday = buy_orders.size();
+	sell_orders_executed_yesterday = sell_orders.size();
+
+	buy_orders.clear();
+	sell_orders.clear();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct GoodDefinition;
+	struct GoodInstance;
+	struct GoodInstanceManager;
+
+	/* The world market. Producers and consumers place buy and sell orders over the course of a day, then
+	 * execute_orders clears every good at once: totals are gathered into dense arrays indexed by good, each good is
+	 * filled pro rata on whichever side is short, every order's result is written to the slot it was placed with,
+	 * and finally every GoodInstance's price is moved towards balancing its supply and demand.
+	 *
+	 * Orders are small fixed-size records in buffers that keep their capacity between days, so once the market has
+	 * warmed up placing and clearing orders allocates nothing. */
+	struct MarketInstance {
+		/* Written when orders are executed: the quantity actually bought or sold and the money paid or received. */
+		struct order_result_t {
+			fixed_point_t quantity;
+			fixed_point_t money;
+		};
+
+		/* A good's price may never leave [MIN_PRICE_FACTOR, MAX_PRICE_FACTOR] times its base price, and may move at most
+		 * MAX_DAILY_PRICE_CHANGE_FACTOR times its base price per day, with the full change applied only when one side of
+		 * the market is empty. */
+		static constexpr fixed_point_t MIN_PRICE_FACTOR = fixed_point_t::_1() * 22 / 100;
+		static constexpr fixed_point_t MAX_PRICE_FACTOR = fixed_point_t::_1() * 5;
+		static constexpr fixed_point_t MAX_DAILY_PRICE_CHANGE_FACTOR = fixed_point_t::_1() / 100;
+
+	private:
+		struct order_t {
+			uint32_t good_index;
+			fixed_point_t quantity;
+			order_result_t* result;
+		};
+
+		struct good_clearing_t {
+			fixed_point_t supply;
+			fixed_point_t demand;
+			fixed_point_t buy_fill_ratio;
+			fixed_point_t sell_fill_ratio;
+			fixed_point_t price;
+		};
+
+		GoodInstanceManager& good_instance_manager;
+
+		std::vector<order_t> buy_orders;
+		std::vector<order_t> sell_orders;
+		std::vector<good_clearing_t> clearing;
+
+		size_t PROPERTY(buy_orders_executed_yesterday);
+		size_t PROPERTY(sell_orders_executed_yesterday);
+
+		void _place_order(std::vector<order_t>& orders, GoodDefinition const& good, fixed_point_t quantity, order_result_t* result);
+
+	public:
+		MarketInstance(GoodInstanceManager& new_good_instance_manager);
+
+		/* Must be called once the good instances have been set up, and before any orders are placed. */
+		bool setup();
+
+		/* Pre-sizes the order buffers, e.g. with the previous day's counts. */
+		void reserve_orders(size_t buy_order_count, size_t sell_order_count);
+
+		/* The price orders placed today will be executed at. */
+		fixed_point_t get_price(GoodDefinition const& good) const;
+		/* Orders for unavailable goods are accepted but never filled. */
+		bool is_good_available(GoodDefinition const& good) const;
+
+		/* result may be nullptr if the caller doesn't need to know how the order was filled, otherwise it must stay valid
+		 * until orders are next executed. Non-positive quantities are ignored. */
+		void place_buy_order(GoodDefinition const& good, fixed_point_t quantity, order_result_t* result);
+		void place_sell_order(GoodDefinition const& good, fixed_point_t quantity, order_result_t* result);
+
+		void execute_orders();
+	};
+}
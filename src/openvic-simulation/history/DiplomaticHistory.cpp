@@ -215,6 +215,151 @@ bool DiplomaticHistoryManager::load_diplomacy_history_file(
 	)(root);
 }
 
+void DiplomaticHistoryManager::save_diplomacy_history_cache(DefinitionsCache::Writer& writer) const {
+	const auto write_country = [&writer](CountryDefinition const* country) -> void {
+		writer.write<uint32_t>(country != nullptr ? static_cast<uint32_t>(country->get_index()) : NO_CACHED_COUNTRY);
+	};
+	const auto write_period = [&writer](Period const& period) -> void {
+		writer.write(period.get_start_date());
+		writer.write<uint8_t>(period.get_end_date().has_value());
+		writer.write(period.get_end_date().value_or(Date {}));
+	};
+
+	writer.write<uint64_t>(alliances.size());
+	for (AllianceHistory const& alliance : alliances) {
+		write_country(alliance.first);
+		write_country(alliance.second);
+		write_period(alliance.period);
+	}
+
+	writer.write<uint64_t>(reparations.size());
+	for (ReparationsHistory const& reparation : reparations) {
+		write_country(reparation.receiver);
+		write_country(reparation.sender);
+		write_period(reparation.period);
+	}
+
+	writer.write<uint64_t>(subjects.size());
+	for (SubjectHistory const& subject : subjects) {
+		write_country(subject.overlord);
+		write_country(subject.subject);
+		writer.write<uint8_t>(static_cast<uint8_t>(subject.type));
+		write_period(subject.period);
+	}
+}
+
+bool DiplomaticHistoryManager::load_diplomacy_history_cache(
+	CountryDefinitionManager const& country_definition_manager, DefinitionsCache::Reader& reader
+) {
+	if (locked) {
+		Logger::error("Cannot load diplomacy history cache - already locked!");
+		return false;
+	}
+
+	/* Cached indices are fixed up into pointers to the currently loaded countries */
+	const auto read_country = [&reader, &country_definition_manager](CountryDefinition const*& country) -> bool {
+		uint32_t index = NO_CACHED_COUNTRY;
+		if (!reader.read(index)) {
+			return false;
+		}
+		if (index == NO_CACHED_COUNTRY) {
+			country = nullptr;
+			return true;
+		}
+		country = country_definition_manager.get_country_definition_by_index(index);
+		if (country == nullptr) {
+			Logger::warning("Invalid diplomacy history cache: country index ", index, " out of range");
+			return false;
+		}
+		return true;
+	};
+	const auto read_period = [&reader](std::optional<Period>& period) -> bool {
+		Date start {}, end {};
+		uint8_t has_end = 0;
+		if (!(reader.read(start) && reader.read(has_end) && reader.read(end))) {
+			return false;
+		}
+		period.emplace(start, has_end != 0 ? std::optional<Date> { end } : std::nullopt);
+		return true;
+	};
+
+	/* Everything is read into locals first so a bad cache leaves the history as it was */
+	std::vector<AllianceHistory> cached_alliances;
+	std::vector<ReparationsHistory> cached_reparations;
+	std::vector<SubjectHistory> cached_subjects;
+
+	uint64_t count = 0;
+	if (!reader.read(count)) {
+		Logger::warning("Invalid diplomacy history cache: truncated alliance data");
+		return false;
+	}
+	for (size_t index = 0; index < count; ++index) {
+		CountryDefinition const* first = nullptr;
+		CountryDefinition const* second = nullptr;
+		std::optional<Period> period;
+		if (!(read_country(first) && read_country(second) && read_period(period))) {
+			Logger::warning("Invalid diplomacy history cache: bad alliance data");
+			return false;
+		}
+		cached_alliances.push_back({ first, second, *period });
+	}
+
+	if (!reader.read(count)) {
+		Logger::warning("Invalid diplomacy history cache: truncated reparations data");
+		return false;
+	}
+	for (size_t index = 0; index < count; ++index) {
+		CountryDefinition const* receiver = nullptr;
+		CountryDefinition const* sender = nullptr;
+		std::optional<Period> period;
+		if (!(read_country(receiver) && read_country(sender) && read_period(period))) {
+			Logger::warning("Invalid diplomacy history cache: bad reparations data");
+			return false;
+		}
+		cached_reparations.push_back({ receiver, sender, *period });
+	}
+
+	if (!reader.read(count)) {
+		Logger::warning("Invalid diplomacy history cache: truncated subject data");
+		return false;
+	}
+	for (size_t index = 0; index < count; ++index) {
+		CountryDefinition const* overlord = nullptr;
+		CountryDefinition const* subject = nullptr;
+		uint8_t type = 0;
+		std::optional<Period> period;
+		if (
+			!(read_country(overlord) && read_country(subject) && reader.read(type) && read_period(period))
+				|| type > static_cast<uint8_t>(SubjectHistory::type_t::SUBSTATE)
+		) {
+			Logger::warning("Invalid diplomacy history cache: bad subject data");
+			return false;
+		}
+		cached_subjects.push_back({ overlord, subject, static_cast<SubjectHistory::type_t>(type), *period });
+	}
+
+	if (!reader.is_at_end()) {
+		Logger::warning("Invalid diplomacy history cache: unexpected trailing data");
+		return false;
+	}
+
+	for (AllianceHistory& alliance : cached_alliances) {
+		alliances.push_back(std::move(alliance));
+	}
+	for (ReparationsHistory& reparation : cached_reparations) {
+		reparations.push_back(std::move(reparation));
+	}
+	for (SubjectHistory& subject : cached_subjects) {
+		subjects.push_back(std::move(subject));
+	}
+
+	Logger::info(
+		"Loaded diplomacy history from cache: ", cached_alliances.size(), " alliances, ", cached_reparations.size(),
+		" reparations and ", cached_subjects.size(), " subjects."
+	);
+	return true;
+}
+
 bool DiplomaticHistoryManager::load_war_history_file(DefinitionManager const& definition_manager, ast::NodeCPtr root) {
 	std::string_view name {};
 	std::vector<WarHistory::war_participant_t> attackers {};
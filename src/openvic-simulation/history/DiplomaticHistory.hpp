@@ -1,8 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <vector>
 
+#include "openvic-simulation/dataloader/DefinitionsCache.hpp"
 #include "openvic-simulation/dataloader/NodeTools.hpp"
 #include "openvic-simulation/history/Period.hpp"
 #include "openvic-simulation/types/Date.hpp"
@@ -108,6 +110,9 @@ namespace OpenVic {
 
 	struct DiplomaticHistoryManager {
 	private:
+		/* Stands in for a null country in the diplomacy history cache. */
+		static constexpr uint32_t NO_CACHED_COUNTRY = UINT32_MAX;
+
 		std::vector<AllianceHistory> alliances;
 		std::vector<ReparationsHistory> reparations;
 		std::vector<SubjectHistory> subjects;
@@ -129,6 +134,12 @@ namespace OpenVic {
 		std::vector<WarHistory const*> get_wars(Date date) const;
 
 		bool load_diplomacy_history_file(CountryDefinitionManager const& country_definition_manager, ast::NodeCPtr root);
+		/* Everything load_diplomacy_history_file adds (alliances, reparations and subjects, but not wars), with countries
+		 * stored by index. Loading a cache only adds anything if the whole cache is valid for the loaded countries. */
+		void save_diplomacy_history_cache(DefinitionsCache::Writer& writer) const;
+		bool load_diplomacy_history_cache(
+			CountryDefinitionManager const& country_definition_manager, DefinitionsCache::Reader& reader
+		);
 		bool load_war_history_file(DefinitionManager const& definition_manager, ast::NodeCPtr root);
 	};
 }
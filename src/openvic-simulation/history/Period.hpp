@@ -3,12 +3,13 @@
 #include <optional>
 
 #include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
 
 namespace OpenVic {
 	struct Period {
 	private:
-		const Date start_date;
-		std::optional<Date> end_date;
+		const Date PROPERTY(start_date);
+		std::optional<Date> PROPERTY(end_date);
 
 	public:
 		Period(Date new_start_date, std::optional<Date> new_end_date);
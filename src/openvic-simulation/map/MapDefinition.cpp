@@ -14,7 +14,9 @@
 using namespace OpenVic;
 using namespace OpenVic::NodeTools;
 
-MapDefinition::MapDefinition() : dims { 0, 0 }, max_provinces { ProvinceDefinition::MAX_INDEX } {}
+MapDefinition::MapDefinition()
+  : dims { 0, 0 }, unrecognised_province_colour_count { 0 }, max_provinces { ProvinceDefinition::MAX_INDEX },
+	land_graph { ProvinceGraph::kind_t::LAND }, naval_graph { ProvinceGraph::kind_t::NAVAL } {}
 
 RiverSegment::RiverSegment(uint8_t new_size, std::vector<ivec2_t>&& new_points)
 	: size { new_size }, points { std::move(new_points) } {}
@@ -633,11 +635,8 @@ bool MapDefinition::load_map_images(fs::path const& province_path, fs::path cons
 		}
 	}
 
-	if (!unrecognised_province_colours.empty()) {
-		Logger::warning("Province image contains ", unrecognised_province_colours.size(), " unrecognised province colours");
-	}
+	unrecognised_province_colour_count = unrecognised_province_colours.size();
 
-	size_t missing = 0;
 	for (size_t array_index = 0; array_index < province_definitions.size(); ++array_index) {
 		ProvinceDefinition* province = province_definitions.get_item_by_index(array_index);
 
@@ -650,16 +649,10 @@ bool MapDefinition::load_map_images(fs::path const& province_path, fs::path cons
 
 		if (province->on_map) {
 			province->centre = pixel_position_sum_per_province[array_index] / pixel_count;
-		} else {
-			if (detailed_errors) {
-				Logger::warning("Province missing from shape image: ", province->to_string());
-			}
-			missing++;
 		}
 	}
-	if (missing > 0) {
-		Logger::warning("Province image is missing ", missing, " province colours");
-	}
+
+	_warn_map_image_issues(detailed_errors);
 
 	// Constants in the River BMP Palette
 	static constexpr uint8_t START_COLOUR = 0;
@@ -882,6 +875,166 @@ bool MapDefinition::_generate_standard_province_adjacencies() {
 	return changed;
 }
 
+void MapDefinition::_warn_map_image_issues(bool detailed_errors) const {
+	if (unrecognised_province_colour_count > 0) {
+		Logger::warning("Province image contains ", unrecognised_province_colour_count, " unrecognised province colours");
+	}
+
+	size_t missing = 0;
+	for (ProvinceDefinition const& province : province_definitions.get_items()) {
+		if (!province.on_map) {
+			if (detailed_errors) {
+				Logger::warning("Province missing from shape image: ", province.to_string());
+			}
+			missing++;
+		}
+	}
+	if (missing > 0) {
+		Logger::warning("Province image is missing ", missing, " province colours");
+	}
+}
+
+void MapDefinition::save_map_image_cache(DefinitionsCache::Writer& writer) const {
+	writer.write(dims);
+	writer.write_span<shape_pixel_t>(province_shape_image);
+	writer.write<uint64_t>(unrecognised_province_colour_count);
+
+	std::vector<TerrainType> const& terrain_types = terrain_type_manager.get_terrain_types();
+
+	writer.write<uint64_t>(province_definitions.size());
+	for (ProvinceDefinition const& province : province_definitions.get_items()) {
+		const uint32_t terrain_index = province.default_terrain_type != nullptr
+			? static_cast<uint32_t>(province.default_terrain_type - terrain_types.data())
+			: NO_CACHED_TERRAIN_TYPE;
+		writer.write(terrain_index);
+		writer.write<uint8_t>(province.on_map);
+		writer.write(province.centre.x.get_raw_value());
+		writer.write(province.centre.y.get_raw_value());
+	}
+
+	writer.write<uint64_t>(rivers.size());
+	for (river_t const& river : rivers) {
+		writer.write<uint64_t>(river.size());
+		for (RiverSegment const& segment : river) {
+			writer.write(segment.get_size());
+			writer.write_span<ivec2_t>(segment.get_points());
+		}
+	}
+}
+
+bool MapDefinition::load_map_image_cache(DefinitionsCache::Reader& reader) {
+	if (!province_definitions_are_locked() || !terrain_type_manager.terrain_type_mappings_are_locked()) {
+		Logger::error("Map image cache cannot be loaded until after provinces and terrain type mappings are locked!");
+		return false;
+	}
+
+	struct cached_province_t {
+		TerrainType const* default_terrain_type;
+		bool on_map;
+		fvec2_t centre;
+	};
+
+	/* Everything is read into locals first so a bad cache leaves the map as it was */
+	ivec2_t cached_dims;
+	std::vector<shape_pixel_t> cached_shape_image;
+	if (
+		!reader.read(cached_dims) || !reader.read_vector(cached_shape_image)
+			|| cached_dims.x < 0 || cached_dims.y < 0
+			|| cached_shape_image.size() != static_cast<size_t>(cached_dims.x) * cached_dims.y
+	) {
+		Logger::warning("Invalid map image cache: bad shape image");
+		return false;
+	}
+
+	for (shape_pixel_t const& pixel : cached_shape_image) {
+		if (pixel.index > province_definitions.size()) {
+			Logger::warning("Invalid map image cache: shape image province index ", pixel.index, " out of range");
+			return false;
+		}
+	}
+
+	uint64_t cached_unrecognised_province_colour_count = 0;
+	if (!reader.read(cached_unrecognised_province_colour_count)) {
+		Logger::warning("Invalid map image cache: truncated shape image data");
+		return false;
+	}
+
+	std::vector<TerrainType> const& terrain_types = terrain_type_manager.get_terrain_types();
+
+	uint64_t province_count = 0;
+	if (!reader.read(province_count) || province_count != province_definitions.size()) {
+		Logger::warning("Invalid map image cache: province count doesn't match the loaded provinces");
+		return false;
+	}
+
+	std::vector<cached_province_t> cached_provinces;
+	cached_provinces.reserve(province_count);
+	for (size_t index = 0; index < province_count; ++index) {
+		uint32_t terrain_index = NO_CACHED_TERRAIN_TYPE;
+		uint8_t on_map = 0;
+		int64_t centre_x = 0, centre_y = 0;
+		if (!(reader.read(terrain_index) && reader.read(on_map) && reader.read(centre_x) && reader.read(centre_y))) {
+			Logger::warning("Invalid map image cache: truncated province data");
+			return false;
+		}
+		if (terrain_index != NO_CACHED_TERRAIN_TYPE && terrain_index >= terrain_types.size()) {
+			Logger::warning("Invalid map image cache: terrain type index ", terrain_index, " out of range");
+			return false;
+		}
+		cached_provinces.push_back({
+			terrain_index != NO_CACHED_TERRAIN_TYPE ? &terrain_types[terrain_index] : nullptr, on_map != 0,
+			{ fixed_point_t::parse_raw(centre_x), fixed_point_t::parse_raw(centre_y) }
+		});
+	}
+
+	uint64_t river_count = 0;
+	if (!reader.read(river_count)) {
+		Logger::warning("Invalid map image cache: truncated river data");
+		return false;
+	}
+
+	std::vector<river_t> cached_rivers;
+	for (size_t river_index = 0; river_index < river_count; ++river_index) {
+		uint64_t segment_count = 0;
+		if (!reader.read(segment_count)) {
+			Logger::warning("Invalid map image cache: truncated river data");
+			return false;
+		}
+
+		river_t& river = cached_rivers.emplace_back();
+		for (size_t segment_index = 0; segment_index < segment_count; ++segment_index) {
+			uint8_t size = 0;
+			std::vector<ivec2_t> points;
+			if (!reader.read(size) || !reader.read_vector(points)) {
+				Logger::warning("Invalid map image cache: truncated river data");
+				return false;
+			}
+			river.push_back({ size, std::move(points) });
+		}
+	}
+
+	if (!reader.is_at_end()) {
+		Logger::warning("Invalid map image cache: unexpected trailing data");
+		return false;
+	}
+
+	dims = cached_dims;
+	province_shape_image = std::move(cached_shape_image);
+	unrecognised_province_colour_count = cached_unrecognised_province_colour_count;
+	rivers = std::move(cached_rivers);
+
+	for (size_t index = 0; index < cached_provinces.size(); ++index) {
+		ProvinceDefinition* province = province_definitions.get_item_by_index(index);
+		province->default_terrain_type = cached_provinces[index].default_terrain_type;
+		province->on_map = cached_provinces[index].on_map;
+		province->centre = cached_provinces[index].centre;
+	}
+
+	Logger::info("Loaded map images from cache: ", dims.x, "x", dims.y, " pixels and ", rivers.size(), " rivers.");
+	_warn_map_image_issues(false);
+	return true;
+}
+
 bool MapDefinition::generate_and_load_province_adjacencies(std::vector<LineObject> const& additional_adjacencies) {
 	bool ret = _generate_standard_province_adjacencies();
 	if (!ret) {
@@ -1048,3 +1201,21 @@ bool MapDefinition::load_continent_file(ModifierManager const& modifier_manager,
 
 	return ret;
 }
+
+bool MapDefinition::build_province_graphs() {
+	if (!province_definitions_are_locked()) {
+		Logger::error("Cannot build province graphs - province definitions are not locked!");
+		return false;
+	}
+
+	bool ret = land_graph.build(*this);
+	ret &= naval_graph.build(*this);
+
+	if (ret) {
+		Logger::info(
+			"Built province graphs with ", land_graph.get_edge_count(), " land and ", naval_graph.get_edge_count(),
+			" naval edges"
+		);
+	}
+	return ret;
+}
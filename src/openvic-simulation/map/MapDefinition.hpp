@@ -7,7 +7,9 @@
 
 #include <openvic-dataloader/csv/LineObject.hpp>
 
+#include "openvic-simulation/dataloader/DefinitionsCache.hpp"
 #include "openvic-simulation/map/ProvinceDefinition.hpp"
+#include "openvic-simulation/map/ProvinceGraph.hpp"
 #include "openvic-simulation/map/Region.hpp"
 #include "openvic-simulation/map/TerrainType.hpp"
 #include "openvic-simulation/types/Colour.hpp"
@@ -51,6 +53,9 @@ namespace OpenVic {
 		using colour_index_map_t = ordered_map<colour_t, ProvinceDefinition::index_t>;
 		using river_t = std::vector<RiverSegment>;
 
+		/* Stands in for a null default terrain type in the map image cache. */
+		static constexpr uint32_t NO_CACHED_TERRAIN_TYPE = UINT32_MAX;
+
 		IdentifierRegistry<ProvinceDefinition> IDENTIFIER_REGISTRY_CUSTOM_INDEX_OFFSET(province_definition, 1);
 		IdentifierRegistry<Region> IDENTIFIER_REGISTRY(region);
 		IdentifierRegistry<Climate> IDENTIFIER_REGISTRY(climate);
@@ -61,12 +66,20 @@ namespace OpenVic {
 		std::vector<river_t> PROPERTY(rivers); // TODO: calculate provinces affected by crossing
 		ivec2_t PROPERTY(dims);
 		std::vector<shape_pixel_t> PROPERTY(province_shape_image);
+		/* Kept so that the map image cache can warn about them again when it's loaded instead of the images. */
+		size_t unrecognised_province_colour_count;
 		colour_index_map_t colour_index_map;
 
 		ProvinceDefinition::index_t PROPERTY(max_provinces);
 
+		/* Built once all adjacencies and positions are loaded, used for all army and navy pathfinding. */
+		ProvinceGraph PROPERTY(land_graph);
+		ProvinceGraph PROPERTY(naval_graph);
+
 		ProvinceDefinition::index_t get_index_from_colour(colour_t colour) const;
 		bool _generate_standard_province_adjacencies();
+		/* Warns about unrecognised province colours and provinces missing from the shape image. */
+		void _warn_map_image_issues(bool detailed_errors) const;
 
 		inline constexpr int32_t get_pixel_index_from_pos(ivec2_t pos) const {
 			return pos.x + pos.y * dims.x;
@@ -121,8 +134,15 @@ namespace OpenVic {
 		static bool load_region_colours(ast::NodeCPtr root, std::vector<colour_t>& colours);
 		bool load_region_file(ast::NodeCPtr root, std::vector<colour_t> const& colours);
 		bool load_map_images(fs::path const& province_path, fs::path const& terrain_path, fs::path const& rivers_path, bool detailed_errors);
+		/* Everything load_map_images generates, with terrain types stored by index. Loading a cache only changes the map if
+		 * the whole cache is valid for the currently loaded provinces and terrain types, and repeats the summary warnings
+		 * load_map_images gave. */
+		void save_map_image_cache(DefinitionsCache::Writer& writer) const;
+		bool load_map_image_cache(DefinitionsCache::Reader& reader);
 		bool generate_and_load_province_adjacencies(std::vector<ovdl::csv::LineObject> const& additional_adjacencies);
 		bool load_climate_file(ModifierManager const& modifier_manager, ast::NodeCPtr root);
 		bool load_continent_file(ModifierManager const& modifier_manager, ast::NodeCPtr root);
+		/* Must be called after province positions are loaded, as they determine the graphs' edge distances */
+		bool build_province_graphs();
 	};
 }
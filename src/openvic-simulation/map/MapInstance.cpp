@@ -1,14 +1,22 @@
 #include "MapInstance.hpp"
 
+#include <algorithm>
+
+#include "openvic-simulation/country/CountryDefinition.hpp"
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/defines/Define.hpp"
 #include "openvic-simulation/history/ProvinceHistory.hpp"
 #include "openvic-simulation/map/MapDefinition.hpp"
+#include "openvic-simulation/misc/EventScheduler.hpp"
 #include "openvic-simulation/utility/Logger.hpp"
+#include "openvic-simulation/utility/ThreadPool.hpp"
 
 using namespace OpenVic;
 
 MapInstance::MapInstance(MapDefinition const& new_map_definition)
-  : map_definition { new_map_definition }, selected_province { nullptr }, highest_province_population { 0 },
-	total_map_population { 0 } {}
+  : map_definition { new_map_definition }, land_path_cache { new_map_definition, new_map_definition.get_land_graph() },
+	selected_province { nullptr }, highest_province_population { 0 }, total_map_population { 0 },
+	passability_map_version { 0 } {}
 
 ProvinceInstance& MapInstance::get_province_instance_from_definition(ProvinceDefinition const& province) {
 	return province_instances.get_items()[province.get_index() - 1];
@@ -18,6 +26,153 @@ ProvinceInstance const& MapInstance::get_province_instance_from_definition(Provi
 	return province_instances.get_items()[province.get_index() - 1];
 }
 
+void MapInstance::build_passability_mask(CountryInstance const& country, passability_mask_t& mask) const {
+	std::vector<ProvinceInstance> const& provinces = province_instances.get_items();
+
+	mask.provinces.assign(provinces.size(), false);
+
+	for (size_t index = 0; index < provinces.size(); ++index) {
+		ProvinceInstance const& province = provinces[index];
+		CountryInstance const* owner = province.get_owner();
+		CountryInstance const* controller = province.get_controller();
+
+		/* Enemy land is passable, it's where the country's armies go to fight and siege */
+		mask.provinces[index] = province.get_province_definition().is_water() || owner == nullptr || owner == &country
+			|| controller == &country || country.has_military_access_to(*owner) || country.is_at_war_with(*owner)
+			|| (controller != nullptr && country.is_at_war_with(*controller));
+	}
+
+	/* Whether a canal can be used also depends on its land province, which the pathfinder checks per adjacency */
+	mask.canals.set();
+	mask.canals.reset(ProvinceDefinition::adjacency_t::NO_CANAL);
+}
+
+passability_mask_t const& MapInstance::get_passability_mask(CountryInstance const& country) {
+	const size_t index = country.get_country_definition()->get_index();
+
+	if (index >= passability_masks.size()) {
+		passability_masks.resize(index + 1);
+	}
+
+	country_passability_t& passability = passability_masks[index];
+
+	if (passability.built && passability.country_version != country.get_passability_version()) {
+		land_path_cache.invalidate_mask(index);
+	}
+
+	if (!passability.built || passability.country_version != country.get_passability_version()
+		|| passability.map_version != passability_map_version) {
+		build_passability_mask(country, passability.mask);
+		passability.country_version = country.get_passability_version();
+		passability.map_version = passability_map_version;
+		passability.built = true;
+	}
+
+	return passability.mask;
+}
+
+void MapInstance::invalidate_province_passability(ProvinceInstance const& province) {
+	++passability_map_version;
+	land_path_cache.invalidate_province(province.get_province_definition());
+}
+
+void MapInstance::queue_controller_change(ProvinceInstance& province, CountryInstance* new_controller) {
+	pending_controller_changes.push_back({ &province, new_controller });
+}
+
+void MapInstance::apply_controller_changes(EventScheduler& event_scheduler) {
+	if (pending_controller_changes.empty()) {
+		return;
+	}
+
+	/* Stable, so that of several changes to one province the last queued is kept */
+	std::stable_sort(
+		pending_controller_changes.begin(), pending_controller_changes.end(),
+		[](controller_change_t const& lhs, controller_change_t const& rhs) -> bool {
+			return lhs.province->get_province_definition().get_index() < rhs.province->get_province_definition().get_index();
+		}
+	);
+
+	struct country_change_t {
+		CountryInstance* country;
+		ProvinceInstance* province;
+		bool gained;
+	};
+
+	std::vector<country_change_t> country_changes;
+	std::vector<ProvinceInstance*> country_provinces;
+	std::vector<State*> changed_states;
+
+	for (auto it = pending_controller_changes.begin(); it != pending_controller_changes.end(); ++it) {
+		if (std::next(it) != pending_controller_changes.end() && std::next(it)->province == it->province) {
+			continue;
+		}
+
+		ProvinceInstance& province = *it->province;
+		if (province.controller == it->new_controller) {
+			continue;
+		}
+
+		if (province.controller != nullptr) {
+			country_changes.push_back({ province.controller, &province, false });
+		}
+		if (it->new_controller != nullptr) {
+			country_changes.push_back({ it->new_controller, &province, true });
+		}
+		province.controller = it->new_controller;
+		event_scheduler.mark_scope_dirty(&province);
+
+		if (province.state != nullptr) {
+			changed_states.push_back(province.state);
+		}
+
+		invalidate_province_passability(province);
+	}
+
+	pending_controller_changes.clear();
+
+	/* Grouped by country, losses before gains, so each country's controlled provinces are rebuilt at most once */
+	std::sort(
+		country_changes.begin(), country_changes.end(), [](country_change_t const& lhs, country_change_t const& rhs) -> bool {
+			if (lhs.country != rhs.country) {
+				return std::less<> {}(lhs.country, rhs.country);
+			}
+			if (lhs.gained != rhs.gained) {
+				return !lhs.gained;
+			}
+			return std::less<> {}(lhs.province, rhs.province);
+		}
+	);
+
+	for (auto begin = country_changes.begin(); begin != country_changes.end();) {
+		CountryInstance* country = begin->country;
+		const auto gained_begin = std::find_if(begin, country_changes.end(), [country](country_change_t const& change) {
+			return change.country != country || change.gained;
+		});
+		const auto end = std::find_if(gained_begin, country_changes.end(), [country](country_change_t const& change) {
+			return change.country != country;
+		});
+
+		country_provinces.clear();
+		for (auto change = begin; change != end; ++change) {
+			country_provinces.push_back(change->province);
+		}
+
+		const std::span<ProvinceInstance* const> provinces = country_provinces;
+		const size_t lost_count = gained_begin - begin;
+		country->_update_controlled_provinces(provinces.first(lost_count), provinces.subspan(lost_count));
+		event_scheduler.mark_scope_dirty(country);
+
+		begin = end;
+	}
+
+	std::sort(changed_states.begin(), changed_states.end(), std::less<> {});
+	changed_states.erase(std::unique(changed_states.begin(), changed_states.end()), changed_states.end());
+	for (State* state : changed_states) {
+		state->update_occupation();
+	}
+}
+
 void MapInstance::set_selected_province(ProvinceDefinition::index_t index) {
 	if (index == ProvinceDefinition::NULL_INDEX) {
 		selected_province = nullptr;
@@ -44,7 +199,8 @@ ProvinceDefinition::index_t MapInstance::get_selected_province_index() const {
 bool MapInstance::setup(
 	BuildingTypeManager const& building_type_manager,
 	decltype(ProvinceInstance::pop_type_distribution)::keys_t const& pop_type_keys,
-	decltype(ProvinceInstance::ideology_distribution)::keys_t const& ideology_keys
+	decltype(ProvinceInstance::ideology_distribution)::keys_t const& ideology_keys,
+	IssueManager const& issue_manager
 ) {
 	if (province_instances_are_locked()) {
 		Logger::error("Cannot setup map - province instances are locked!");
@@ -55,12 +211,12 @@ bool MapInstance::setup(
 		return false;
 	}
 
-	bool ret = true;
+	bool ret = pop_store.setup(ideology_keys, issue_manager);
 
 	province_instances.reserve(map_definition.get_province_definition_count());
 
 	for (ProvinceDefinition const& province : map_definition.get_province_definitions()) {
-		ret &= province_instances.add_item({ province, pop_type_keys, ideology_keys });
+		ret &= province_instances.add_item({ province, pop_type_keys, ideology_keys, pop_store });
 	}
 
 	province_instances.lock();
@@ -77,6 +233,8 @@ bool MapInstance::setup(
 		return false;
 	}
 
+	ret &= land_path_cache.setup();
+
 	return ret;
 }
 
@@ -134,35 +292,125 @@ void MapInstance::update_modifier_sums(Date today, StaticModifierCache const& st
 	}
 }
 
-void MapInstance::update_gamestate(Date today, DefineManager const& define_manager) {
+void MapInstance::update_modifier_sums_incremental(Date today, StaticModifierCache const& static_modifier_cache) {
+	std::vector<ModifierSum::modifier_entry_t> scratch;
+
 	for (ProvinceInstance& province : province_instances.get_items()) {
-		province.update_gamestate(today, define_manager);
+		province.update_modifier_sum_incremental(today, static_modifier_cache, scratch);
 	}
+}
+
+void MapInstance::build_modifier_sums(
+	Date today, StaticModifierCache const& static_modifier_cache, std::vector<ModifierSum>& sums
+) {
+	std::vector<ProvinceInstance>& provinces = province_instances.get_items();
+	std::vector<ModifierSum::modifier_entry_t> scratch;
+
+	sums.resize(provinces.size());
+	for (size_t index = 0; index < sums.size(); ++index) {
+		provinces[index].build_modifier_sum(today, static_modifier_cache, sums[index], scratch);
+	}
+}
+
+void MapInstance::update_gamestate(Date today, DefineManager const& define_manager, ThreadPool& thread_pool) {
+	std::vector<ProvinceInstance>& provinces = province_instances.get_items();
+
+	province_chunk_totals.resize(ThreadPool::get_chunk_count(provinces.size(), PROVINCE_UPDATE_CHUNK_SIZE));
+
+	// Provinces only write to their own state during this phase, so chunks can be processed in any order on any thread
+	thread_pool.parallel_for(
+		provinces.size(), PROVINCE_UPDATE_CHUNK_SIZE,
+		[this, &provinces, today, &define_manager](size_t chunk_index, size_t begin, size_t end) {
+			province_chunk_totals_t& chunk_totals = province_chunk_totals[chunk_index];
+			chunk_totals = { 0, 0 };
+
+			for (size_t index = begin; index < end; ++index) {
+				ProvinceInstance& province = provinces[index];
+
+				province.update_gamestate(today, define_manager);
+
+				const Pop::pop_size_t province_population = province.get_total_population();
+
+				if (chunk_totals.highest_population < province_population) {
+					chunk_totals.highest_population = province_population;
+				}
+
+				chunk_totals.total_population += province_population;
+			}
+		}
+	);
+
 	state_manager.update_gamestate();
 
-	// Update population stats
+	// Update population stats, reducing chunks in index order to match a serial pass over all provinces
 	highest_province_population = 0;
 	total_map_population = 0;
 
-	for (ProvinceInstance const& province : province_instances.get_items()) {
-		const Pop::pop_size_t province_population = province.get_total_population();
-
-		if (highest_province_population < province_population) {
-			highest_province_population = province_population;
+	for (province_chunk_totals_t const& chunk_totals : province_chunk_totals) {
+		if (highest_province_population < chunk_totals.highest_population) {
+			highest_province_population = chunk_totals.highest_population;
 		}
 
-		total_map_population += province_population;
+		total_map_population += chunk_totals.total_population;
+	}
+}
+
+void MapInstance::tick(
+	Date today, CountryInstanceManager const& country_instance_manager, MarketInstance& market_instance,
+	ModifierEffectCache const& modifier_effect_cache, ProductionTypeManager const& production_type_manager,
+	DefineManager const& define_manager
+) {
+	for (ProvinceInstance& province : province_instances.get_items()) {
+		province.tick(today, market_instance, modifier_effect_cache);
+	}
+	// Artisans reserve the cash for their inputs first, so pops' needs are only budgeted from what they have left
+	state_manager.tick(
+		today, *this, country_instance_manager, market_instance, modifier_effect_cache, production_type_manager,
+		define_manager.get_economy_defines()
+	);
+	pop_needs_kernel.update_costs(market_instance);
+	for (ProvinceInstance& province : province_instances.get_items()) {
+		pop_needs_kernel.place_orders(province, pop_store, market_instance, modifier_effect_cache);
 	}
 }
 
-void MapInstance::tick(Date today) {
+void MapInstance::after_orders_executed(ModifierEffectCache const& modifier_effect_cache, DefineManager const& define_manager) {
 	for (ProvinceInstance& province : province_instances.get_items()) {
-		province.tick(today);
+		province.after_orders_executed();
+		pop_needs_kernel.apply_results(province, pop_store, modifier_effect_cache);
 	}
+	state_manager.after_orders_executed(define_manager.get_economy_defines());
+	pop_store.release_reserved_cash();
 }
 
-void MapInstance::initialise_for_new_game(ModifierEffectCache const& modifier_effect_cache){
+void MapInstance::update_pops_monthly(
+	Date today, CountryInstanceManager const& country_instance_manager, PopsDefines const& pops_defines,
+	ModifierEffectCache const& modifier_effect_cache, EventScheduler& event_scheduler
+) {
+	pop_transition_engine.compute_transfers(*this, country_instance_manager, pops_defines, today);
+
+	std::vector<ProvinceInstance>& provinces = province_instances.get_items();
+
+	for (size_t index = 0; index < provinces.size(); ++index) {
+		provinces[index]._apply_outgoing_pop_transfers(pop_transition_engine.get_outgoing_transfers(index));
+	}
+	// Growth only applies to pops which stayed, arrivals start growing next month
+	for (ProvinceInstance& province : provinces) {
+		province._grow_pops(today, pops_defines, modifier_effect_cache);
+	}
+	for (size_t index = 0; index < provinces.size(); ++index) {
+		provinces[index]._merge_pops(pop_transition_engine.get_incoming_transfers(index));
+	}
+	for (ProvinceInstance& province : provinces) {
+		province._remove_empty_pops();
+		event_scheduler.mark_scope_dirty(&province);
+	}
+}
+
+bool MapInstance::initialise_for_new_game(MarketInstance const& market_instance, ModifierEffectCache const& modifier_effect_cache){
 	for (ProvinceInstance& province : province_instances.get_items()) {
-		province.initialise_for_new_game(modifier_effect_cache);
+		province.initialise_for_new_game(market_instance, modifier_effect_cache);
 	}
+
+	return state_manager.initialise_for_new_game();
 }
\ No newline at end of file
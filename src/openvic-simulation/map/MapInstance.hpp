@@ -1,8 +1,13 @@
 #pragma once
 
+#include "openvic-simulation/map/PathCache.hpp"
+#include "openvic-simulation/map/Pathfinding.hpp"
 #include "openvic-simulation/map/ProvinceDefinition.hpp"
 #include "openvic-simulation/map/ProvinceInstance.hpp"
 #include "openvic-simulation/map/State.hpp"
+#include "openvic-simulation/pop/PopNeedsKernel.hpp"
+#include "openvic-simulation/pop/PopStore.hpp"
+#include "openvic-simulation/pop/PopTransitions.hpp"
 #include "openvic-simulation/types/Date.hpp"
 #include "openvic-simulation/types/IdentifierRegistry.hpp"
 
@@ -11,6 +16,10 @@ namespace OpenVic {
 	struct BuildingTypeManager;
 	struct ProvinceHistoryManager;
 	struct IssueManager;
+	struct ThreadPool;
+	struct MarketInstance;
+	struct PopsDefines;
+	struct EventScheduler;
 
 	/* REQUIREMENTS:
 	 * MAP-4
@@ -18,6 +27,14 @@ namespace OpenVic {
 	struct MapInstance {
 		MapDefinition const& PROPERTY(map_definition);
 
+		/* Shared by all provinces, which refer to their pops by handle. */
+		PopStore PROPERTY_REF(pop_store);
+		/* Runs the pops in pop_store through their daily needs consumption, one province at a time. */
+		PopNeedsKernel PROPERTY_REF(pop_needs_kernel);
+		PopTransitionEngine PROPERTY_REF(pop_transition_engine);
+		/* Long-haul army routes over the map definition's land graph. */
+		PathCache PROPERTY_REF(land_path_cache);
+
 		IdentifierRegistry<ProvinceInstance> IDENTIFIER_REGISTRY_CUSTOM_INDEX_OFFSET(province_instance, 1);
 
 		ProvinceInstance* PROPERTY(selected_province); // is it right for this to be mutable? how about using an index instead?
@@ -26,6 +43,37 @@ namespace OpenVic {
 
 		StateManager PROPERTY_REF(state_manager);
 
+		/* Provinces are updated in fixed-size chunks so that per-chunk results, and therefore their reduction,
+		 * do not depend on the number of threads or on which thread processed which chunk. */
+		static constexpr size_t PROVINCE_UPDATE_CHUNK_SIZE = 64;
+
+		struct province_chunk_totals_t {
+			Pop::pop_size_t highest_population;
+			Pop::pop_size_t total_population;
+		};
+
+		std::vector<province_chunk_totals_t> province_chunk_totals;
+
+		struct controller_change_t {
+			ProvinceInstance* province;
+			CountryInstance* new_controller;
+		};
+
+		/* Controller changes queued during the tick, e.g. by sieges, waiting to be applied together. */
+		std::vector<controller_change_t> pending_controller_changes;
+
+		struct country_passability_t {
+			passability_mask_t mask;
+			uint32_t country_version = 0;
+			uint32_t map_version = 0;
+			bool built = false;
+		};
+
+		/* Indexed by country index, for army movement orders. */
+		std::vector<country_passability_t> passability_masks;
+		/* Incremented by invalidate_province_passability, so masks know to pick up owner and controller changes. */
+		uint32_t passability_map_version;
+
 	public:
 		MapInstance(MapDefinition const& new_map_definition);
 
@@ -42,10 +90,30 @@ namespace OpenVic {
 		ProvinceInstance* get_selected_province();
 		ProvinceDefinition::index_t get_selected_province_index() const;
 
+		/* Lets the country's units through water, unowned land, land it owns or controls, land owned by countries granting
+		 * it military access, land owned or controlled by its war enemies, and canals whose land province is passable. */
+		void build_passability_mask(CountryInstance const& country, passability_mask_t& mask) const;
+		/* The country's mask, kept between calls and only rebuilt when a province's passability or the country's
+		 * passability version has changed. A change of version, i.e. of the country's wars or military access, also
+		 * drops the land path cache's routes for the country, whose key is its index. */
+		passability_mask_t const& get_passability_mask(CountryInstance const& country);
+		/* Must be called when a change, e.g. of owner or controller, may have made the province passable or impassable to
+		 * some country, so that cached routes through it are recalculated. */
+		void invalidate_province_passability(ProvinceInstance const& province);
+
+		void queue_controller_change(ProvinceInstance& province, CountryInstance* new_controller);
+		/* Applies every queued controller change, the last queued winning if a province has several. Each country's
+		 * controlled provinces and each state's occupation are updated once however many of their provinces changed
+		 * hands, and the provinces' cached routes are invalidated. Modifier contributions follow the new controllers
+		 * at the next modifier sum update. The changed provinces and the countries which gained or lost them are marked
+		 * dirty in event_scheduler, so their MTTHs are re-evaluated. */
+		void apply_controller_changes(EventScheduler& event_scheduler);
+
 		bool setup(
 			BuildingTypeManager const& building_type_manager,
 			decltype(ProvinceInstance::pop_type_distribution)::keys_t const& pop_type_keys,
-			decltype(ProvinceInstance::ideology_distribution)::keys_t const& ideology_keys
+			decltype(ProvinceInstance::ideology_distribution)::keys_t const& ideology_keys,
+			IssueManager const& issue_manager
 		);
 		bool apply_history_to_provinces(
 			ProvinceHistoryManager const& history_manager, Date date, CountryInstanceManager& country_manager,
@@ -53,8 +121,27 @@ namespace OpenVic {
 		);
 
 		void update_modifier_sums(Date today, StaticModifierCache const& static_modifier_cache);
-		void update_gamestate(Date today, DefineManager const& define_manager);
-		void tick(Date today);
-		void initialise_for_new_game(ModifierEffectCache const& modifier_effect_cache);
+		void update_modifier_sums_incremental(Date today, StaticModifierCache const& static_modifier_cache);
+		// Builds every province's local sum into sums, in province instance order, see ProvinceInstance::build_modifier_sum.
+		void build_modifier_sums(
+			Date today, StaticModifierCache const& static_modifier_cache, std::vector<ModifierSum>& sums
+		);
+		void update_gamestate(Date today, DefineManager const& define_manager, ThreadPool& thread_pool);
+		/* Daily production, which places market orders. */
+		void tick(
+			Date today, CountryInstanceManager const& country_instance_manager, MarketInstance& market_instance,
+			ModifierEffectCache const& modifier_effect_cache, ProductionTypeManager const& production_type_manager,
+			DefineManager const& define_manager
+		);
+		/* Pays out what was earned from the day's orders once the market has executed them. */
+		void after_orders_executed(ModifierEffectCache const& modifier_effect_cache, DefineManager const& define_manager);
+		/* Monthly promotion, demotion, assimilation, conversion, migration and growth of every pop, after which each
+		 * province's pops are merged so there is at most one per type, culture, religion and rebel type. Every province
+		 * is then marked dirty in event_scheduler, as its pops' sizes and makeup have changed. */
+		void update_pops_monthly(
+			Date today, CountryInstanceManager const& country_instance_manager, PopsDefines const& pops_defines,
+			ModifierEffectCache const& modifier_effect_cache, EventScheduler& event_scheduler
+		);
+		bool initialise_for_new_game(MarketInstance const& market_instance, ModifierEffectCache const& modifier_effect_cache);
 	};
 }
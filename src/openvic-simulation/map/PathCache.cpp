@@ -0,0 +1,425 @@
+#include "PathCache.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/map/MapDefinition.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
+
+using namespace OpenVic;
+
+namespace {
+	template<typename State>
+	uint32_t next_search(std::vector<State>& states, uint32_t& search) {
+		/* Search 0 marks states never written, so on wrapping around every stamp must be reset */
+		if (++search == 0) {
+			for (State& state : states) {
+				state.search = 0;
+			}
+			search = 1;
+		}
+		return search;
+	}
+
+	constexpr bool open_entry_greater(auto const& lhs, auto const& rhs) {
+		return lhs.estimate > rhs.estimate || (lhs.estimate == rhs.estimate && lhs.id > rhs.id);
+	}
+}
+
+size_t PathCache::route_key_hash_t::operator()(route_key_t const& key) const {
+	size_t hash = 0;
+	utility::hash_combine(hash, key.mask_key);
+	utility::hash_combine(hash, key.start);
+	utility::hash_combine(hash, key.target);
+	return hash;
+}
+
+PathCache::PathCache(MapDefinition const& new_map_definition, ProvinceGraph const& new_graph)
+  : map_definition { new_map_definition }, graph { new_graph }, local_search { 0 }, abstract_search { 0 }, route_hits { 0 },
+	route_misses { 0 }, cluster_entry_hits { 0 }, cluster_entry_misses { 0 } {}
+
+bool PathCache::setup() {
+	if (!graph.is_built()) {
+		Logger::error("Cannot set up path cache - province graph has not been built!");
+		return false;
+	}
+
+	const size_t node_count = graph.get_node_count();
+
+	ordered_map<Region const*, cluster_t> region_clusters;
+	cluster_t cluster_count = 0;
+
+	node_clusters.resize(node_count);
+	for (node_t node = 0; node < node_count; ++node) {
+		Region const* region = map_definition.get_province_definition_by_index(node + 1)->get_region();
+		if (region != nullptr) {
+			const auto [it, inserted] = region_clusters.emplace(region, cluster_count);
+			if (inserted) {
+				++cluster_count;
+			}
+			node_clusters[node] = it->second;
+		} else {
+			node_clusters[node] = cluster_count++;
+		}
+	}
+
+	/* Portals are counted per cluster, then placed in cluster order so each cluster's portals are contiguous */
+	node_portals.assign(node_count, NO_PORTAL);
+	portal_offsets.assign(cluster_count + 1, 0);
+	for (node_t node = 0; node < node_count; ++node) {
+		for (ProvinceGraph::edge_t const& edge : graph.get_edges(node)) {
+			if (node_clusters[edge.to] != node_clusters[node]) {
+				node_portals[node] = 0;
+				++portal_offsets[node_clusters[node] + 1];
+				break;
+			}
+		}
+	}
+	for (cluster_t cluster = 0; cluster < cluster_count; ++cluster) {
+		portal_offsets[cluster + 1] += portal_offsets[cluster];
+	}
+
+	portals.resize(portal_offsets.back());
+	std::vector<uint32_t> next_portal { portal_offsets.begin(), portal_offsets.end() - 1 };
+	for (node_t node = 0; node < node_count; ++node) {
+		if (node_portals[node] != NO_PORTAL) {
+			const portal_t portal = next_portal[node_clusters[node]]++;
+			node_portals[node] = portal;
+			portals[portal] = node;
+		}
+	}
+
+	cluster_generations.assign(cluster_count, 0);
+	local_states.assign(node_count, { fixed_point_t::_0(), NO_PARENT, 0, false });
+	abstract_states.assign(portals.size() + 1, { fixed_point_t::_0(), NO_PARENT, 0, false });
+
+	clear();
+
+	Logger::info("Set up path cache with ", cluster_count, " clusters and ", portals.size(), " portals");
+
+	return true;
+}
+
+uint32_t PathCache::_get_mask_generation(mask_key_t mask_key) const {
+	const decltype(mask_generations)::const_iterator it = mask_generations.find(mask_key);
+	return it != mask_generations.end() ? it->second : 0;
+}
+
+bool PathCache::_is_route_valid(route_t const& route, mask_key_t mask_key) const {
+	return route.mask_generation == _get_mask_generation(mask_key) && std::all_of(
+		route.cluster_generations.begin(), route.cluster_generations.end(),
+		[this](std::pair<cluster_t, uint32_t> const& cluster_generation) -> bool {
+			return cluster_generations[cluster_generation.first] == cluster_generation.second;
+		}
+	);
+}
+
+bool PathCache::_search_cluster(cluster_t cluster, node_t from, passability_mask_t const* mask, node_t stop) {
+	const uint32_t search = next_search(local_states, local_search);
+
+	local_open_list.clear();
+	local_states[from] = { fixed_point_t::_0(), NO_PARENT, search, false };
+	local_open_list.push_back({ fixed_point_t::_0(), from });
+
+	while (!local_open_list.empty()) {
+		std::pop_heap(local_open_list.begin(), local_open_list.end(), open_entry_greater<open_entry_t, open_entry_t>);
+		const node_t node = local_open_list.back().id;
+		local_open_list.pop_back();
+
+		search_state_t& state = local_states[node];
+		if (state.closed) {
+			continue;
+		}
+		state.closed = true;
+
+		if (node == stop) {
+			return true;
+		}
+
+		for (ProvinceGraph::edge_t const& edge : graph.get_edges(node)) {
+			if (node_clusters[edge.to] != cluster || (mask != nullptr && !mask->can_traverse(edge))) {
+				continue;
+			}
+
+			const fixed_point_t distance = state.distance + edge.distance;
+			search_state_t& next_state = local_states[edge.to];
+			if (next_state.search == search && (next_state.closed || distance >= next_state.distance)) {
+				continue;
+			}
+
+			next_state = { distance, node, search, false };
+			local_open_list.push_back({ distance, edge.to });
+			std::push_heap(local_open_list.begin(), local_open_list.end(), open_entry_greater<open_entry_t, open_entry_t>);
+		}
+	}
+
+	return stop == ProvinceGraph::NO_NODE;
+}
+
+fixed_point_t PathCache::_get_local_distance(node_t node) const {
+	search_state_t const& state = local_states[node];
+	return state.search == local_search && state.closed ? state.distance : -fixed_point_t::_1();
+}
+
+PathCache::cluster_entry_t const& PathCache::_get_cluster_entry(
+	mask_key_t mask_key, passability_mask_t const* mask, cluster_t cluster
+) {
+	const uint64_t key = (static_cast<uint64_t>(mask_key) << 32) | cluster;
+	const uint32_t mask_generation = _get_mask_generation(mask_key);
+
+	cluster_entry_t& entry = cluster_entries[key];
+	if (!entry.distances.empty() && entry.cluster_generation == cluster_generations[cluster]
+		&& entry.mask_generation == mask_generation) {
+		++cluster_entry_hits;
+		return entry;
+	}
+	++cluster_entry_misses;
+
+	const uint32_t offset = portal_offsets[cluster];
+	const uint32_t count = portal_offsets[cluster + 1] - offset;
+
+	entry.cluster_generation = cluster_generations[cluster];
+	entry.mask_generation = mask_generation;
+	entry.distances.resize(count * count);
+
+	for (uint32_t from = 0; from < count; ++from) {
+		_search_cluster(cluster, portals[offset + from], mask, ProvinceGraph::NO_NODE);
+		for (uint32_t to = 0; to < count; ++to) {
+			entry.distances[from * count + to] = _get_local_distance(portals[offset + to]);
+		}
+	}
+
+	return entry;
+}
+
+bool PathCache::_find_route(
+	mask_key_t mask_key, passability_mask_t const* mask, node_t start, node_t target, route_t& route
+) {
+	const cluster_t start_cluster = node_clusters[start];
+	const cluster_t target_cluster = node_clusters[target];
+
+	route.waypoints.clear();
+	route.cluster_generations.clear();
+
+	if (mask != nullptr && !mask->is_province_passable(target)) {
+		return false;
+	}
+
+	/* Routes within one cluster skip the abstract search, only falling back to it if the cluster is split */
+	if (start_cluster == target_cluster && _search_cluster(start_cluster, start, mask, target)) {
+		route.waypoints = { start, target };
+		route.cluster_generations.emplace_back(start_cluster, cluster_generations[start_cluster]);
+		return true;
+	}
+
+	const uint32_t start_offset = portal_offsets[start_cluster];
+	const uint32_t target_offset = portal_offsets[target_cluster];
+
+	/* Adjacencies go both ways, so searching out from the target gives each portal's distance to it */
+	_search_cluster(target_cluster, target, mask, ProvinceGraph::NO_NODE);
+	target_distances.clear();
+	for (uint32_t portal = target_offset; portal < portal_offsets[target_cluster + 1]; ++portal) {
+		target_distances.push_back(_get_local_distance(portals[portal]));
+	}
+
+	_search_cluster(start_cluster, start, mask, ProvinceGraph::NO_NODE);
+	start_distances.clear();
+	for (uint32_t portal = start_offset; portal < portal_offsets[start_cluster + 1]; ++portal) {
+		start_distances.push_back(_get_local_distance(portals[portal]));
+	}
+
+	const uint32_t search = next_search(abstract_states, abstract_search);
+	const uint32_t target_id = portals.size();
+	ProvinceDefinition const& target_province = *map_definition.get_province_definition_by_index(target + 1);
+
+	abstract_open_list.clear();
+
+	const auto relax = [this, search, target_id, &target_province](
+		uint32_t id, fixed_point_t distance, uint32_t parent
+	) -> void {
+		search_state_t& state = abstract_states[id];
+		if (state.search == search && (state.closed || distance >= state.distance)) {
+			return;
+		}
+
+		state = { distance, parent, search, false };
+		abstract_open_list.push_back({
+			id == target_id ? distance : distance + map_definition.calculate_distance_between(
+				*map_definition.get_province_definition_by_index(portals[id] + 1), target_province
+			),
+			id
+		});
+		std::push_heap(abstract_open_list.begin(), abstract_open_list.end(), open_entry_greater<open_entry_t, open_entry_t>);
+	};
+
+	for (uint32_t index = 0; index < start_distances.size(); ++index) {
+		if (start_distances[index] >= fixed_point_t::_0()) {
+			relax(start_offset + index, start_distances[index], NO_PARENT);
+		}
+	}
+
+	bool found = false;
+
+	while (!abstract_open_list.empty()) {
+		std::pop_heap(abstract_open_list.begin(), abstract_open_list.end(), open_entry_greater<open_entry_t, open_entry_t>);
+		const uint32_t id = abstract_open_list.back().id;
+		abstract_open_list.pop_back();
+
+		search_state_t& state = abstract_states[id];
+		if (state.closed) {
+			continue;
+		}
+		state.closed = true;
+
+		if (id == target_id) {
+			found = true;
+			break;
+		}
+
+		const fixed_point_t distance = state.distance;
+		const node_t node = portals[id];
+		const cluster_t cluster = node_clusters[node];
+		const uint32_t offset = portal_offsets[cluster];
+
+		if (cluster == target_cluster && target_distances[id - offset] >= fixed_point_t::_0()) {
+			relax(target_id, distance + target_distances[id - offset], id);
+		}
+
+		cluster_entry_t const& entry = _get_cluster_entry(mask_key, mask, cluster);
+		const uint32_t count = portal_offsets[cluster + 1] - offset;
+		const uint32_t from = id - offset;
+		for (uint32_t to = 0; to < count; ++to) {
+			const fixed_point_t through_distance = entry.distances[from * count + to];
+			if (to != from && through_distance >= fixed_point_t::_0()) {
+				relax(offset + to, distance + through_distance, id);
+			}
+		}
+
+		for (ProvinceGraph::edge_t const& edge : graph.get_edges(node)) {
+			if (
+				node_clusters[edge.to] != cluster && node_portals[edge.to] != NO_PORTAL
+				&& (mask == nullptr || mask->can_traverse(edge))
+			) {
+				relax(node_portals[edge.to], distance + edge.distance, id);
+			}
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	route.waypoints.push_back(target);
+	for (uint32_t id = abstract_states[target_id].parent; id != NO_PARENT; id = abstract_states[id].parent) {
+		route.waypoints.push_back(portals[id]);
+	}
+	route.waypoints.push_back(start);
+	std::reverse(route.waypoints.begin(), route.waypoints.end());
+	route.waypoints.erase(std::unique(route.waypoints.begin(), route.waypoints.end()), route.waypoints.end());
+
+	for (const node_t waypoint : route.waypoints) {
+		const cluster_t cluster = node_clusters[waypoint];
+		if (route.cluster_generations.empty() || route.cluster_generations.back().first != cluster) {
+			route.cluster_generations.emplace_back(cluster, cluster_generations[cluster]);
+		}
+	}
+
+	return true;
+}
+
+bool PathCache::_refine_route(
+	route_t const& route, passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path
+) {
+	path.clear();
+	path.push_back(map_definition.get_province_definition_by_index(route.waypoints.front() + 1));
+
+	for (size_t index = 1; index < route.waypoints.size(); ++index) {
+		const node_t from = route.waypoints[index - 1];
+		const node_t to = route.waypoints[index];
+
+		/* Consecutive waypoints in different clusters are joined by a single edge */
+		if (node_clusters[from] != node_clusters[to]) {
+			path.push_back(map_definition.get_province_definition_by_index(to + 1));
+			continue;
+		}
+
+		if (!_search_cluster(node_clusters[from], from, mask, to)) {
+			path.clear();
+			return false;
+		}
+
+		const size_t segment_start = path.size();
+		for (node_t node = to; node != from; node = local_states[node].parent) {
+			path.push_back(map_definition.get_province_definition_by_index(node + 1));
+		}
+		std::reverse(path.begin() + segment_start, path.end());
+	}
+
+	return true;
+}
+
+bool PathCache::find_path(
+	ProvinceDefinition const& start, ProvinceDefinition const& target, mask_key_t mask_key,
+	passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path
+) {
+	path.clear();
+
+	const node_t start_node = ProvinceGraph::get_node(start);
+	const node_t target_node = ProvinceGraph::get_node(target);
+
+	if (start_node >= node_clusters.size() || target_node >= node_clusters.size()) {
+		Logger::error("Cannot find cached path from ", start, " to ", target, " - province not in path cache!");
+		return false;
+	}
+
+	if (start_node == target_node) {
+		path.push_back(&start);
+		return true;
+	}
+
+	const route_key_t key { mask_key, start_node, target_node };
+
+	const decltype(routes)::const_iterator it = routes.find(key);
+	if (it != routes.end() && _is_route_valid(it->second, mask_key)) {
+		++route_hits;
+		if (_refine_route(it->second, mask, path)) {
+			return true;
+		}
+	} else {
+		++route_misses;
+	}
+
+	route_t route;
+	route.mask_generation = _get_mask_generation(mask_key);
+	if (!_find_route(mask_key, mask, start_node, target_node, route)) {
+		return false;
+	}
+
+	if (routes.size() >= MAX_CACHED_ROUTES) {
+		routes.clear();
+	}
+	return _refine_route(routes.insert_or_assign(key, std::move(route)).first->second, mask, path);
+}
+
+void PathCache::invalidate_province(ProvinceDefinition const& province) {
+	const node_t node = ProvinceGraph::get_node(province);
+	if (node < node_clusters.size()) {
+		++cluster_generations[node_clusters[node]];
+	}
+}
+
+void PathCache::invalidate_mask(mask_key_t mask_key) {
+	++mask_generations[mask_key];
+}
+
+void PathCache::clear() {
+	cluster_entries.clear();
+	routes.clear();
+}
+
+void PathCache::reset_counters() {
+	route_hits = 0;
+	route_misses = 0;
+	cluster_entry_hits = 0;
+	cluster_entry_misses = 0;
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "openvic-simulation/map/Pathfinding.hpp"
+#include "openvic-simulation/map/ProvinceGraph.hpp"
+#include "openvic-simulation/types/OrderedContainers.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct MapDefinition;
+
+	/* Hierarchical pathfinding over a ProvinceGraph, for the long routes AI units keep asking for.
+	 *
+	 * Provinces are clustered by region (the templates states are made from), with provinces outside any region each
+	 * forming their own cluster. Portals, provinces with an edge into another cluster, are found once at setup. A query
+	 * searches the much smaller abstract graph of portals, whose edges are the graph edges between clusters plus the
+	 * distances between each cluster's portals through that cluster. The resulting abstract route, a list of waypoints,
+	 * is cached and only refined into provinces when asked for, one cluster at a time.
+	 *
+	 * Per-cluster portal distances and routes are cached per mask key, an id chosen by the caller for the passability
+	 * mask used (e.g. the country's index). A change to a province's passability invalidates only its own cluster's
+	 * entries (and the routes through it), while invalidate_mask drops everything for one mask key, e.g. when the
+	 * country's wars or military access change. Routes found this way are near-shortest, not always shortest. */
+	struct PathCache {
+		using cluster_t = uint32_t;
+		using mask_key_t = uint32_t;
+
+		/* Reserved for queries without a mask, so they never share cached entries with a masked key. */
+		static constexpr mask_key_t UNMASKED_KEY = std::numeric_limits<mask_key_t>::max();
+
+		/* The route cache is simply emptied when it grows past this. */
+		static constexpr size_t MAX_CACHED_ROUTES = 1 << 16;
+
+	private:
+		using node_t = ProvinceGraph::node_t;
+		using portal_t = uint32_t;
+
+		static constexpr portal_t NO_PORTAL = std::numeric_limits<portal_t>::max();
+
+		struct cluster_entry_t {
+			uint32_t cluster_generation;
+			uint32_t mask_generation;
+			/* [from portal][to portal] within the cluster, negative where unreachable. */
+			std::vector<fixed_point_t> distances;
+		};
+
+		struct route_key_t {
+			mask_key_t mask_key;
+			node_t start;
+			node_t target;
+
+			bool operator==(route_key_t const&) const = default;
+		};
+
+		struct route_key_hash_t {
+			size_t operator()(route_key_t const& key) const;
+		};
+
+		struct route_t {
+			uint32_t mask_generation;
+			/* Start, portals and target, each consecutive pair either in the same cluster or joined by a graph edge. */
+			std::vector<node_t> waypoints;
+			std::vector<std::pair<cluster_t, uint32_t>> cluster_generations;
+		};
+
+		struct search_state_t {
+			fixed_point_t distance;
+			uint32_t parent;
+			uint32_t search;
+			bool closed;
+		};
+
+		struct open_entry_t {
+			fixed_point_t estimate;
+			uint32_t id;
+		};
+
+		static constexpr uint32_t NO_PARENT = std::numeric_limits<uint32_t>::max();
+
+		MapDefinition const& map_definition;
+		ProvinceGraph const& graph;
+
+		std::vector<cluster_t> node_clusters;
+		std::vector<portal_t> node_portals;
+		/* Portal nodes grouped by cluster, cluster c's being portals[portal_offsets[c]] to portals[portal_offsets[c + 1]]. */
+		std::vector<node_t> portals;
+		std::vector<uint32_t> portal_offsets;
+		std::vector<uint32_t> cluster_generations;
+
+		ordered_map<uint64_t, cluster_entry_t> cluster_entries;
+		ordered_map<route_key_t, route_t, route_key_hash_t> routes;
+		ordered_map<mask_key_t, uint32_t> mask_generations;
+
+		/* Scratch for searches within a cluster (indexed by node) and over portals (indexed by portal, then target). */
+		std::vector<search_state_t> local_states;
+		std::vector<search_state_t> abstract_states;
+		std::vector<open_entry_t> local_open_list;
+		std::vector<open_entry_t> abstract_open_list;
+		std::vector<fixed_point_t> start_distances;
+		std::vector<fixed_point_t> target_distances;
+		uint32_t local_search;
+		uint32_t abstract_search;
+
+		size_t PROPERTY(route_hits);
+		size_t PROPERTY(route_misses);
+		size_t PROPERTY(cluster_entry_hits);
+		size_t PROPERTY(cluster_entry_misses);
+
+		uint32_t _get_mask_generation(mask_key_t mask_key) const;
+		bool _is_route_valid(route_t const& route, mask_key_t mask_key) const;
+
+		/* Dijkstra from one node over the nodes of a single cluster, stopping early once stop is reached if given. */
+		bool _search_cluster(cluster_t cluster, node_t from, passability_mask_t const* mask, node_t stop);
+		fixed_point_t _get_local_distance(node_t node) const;
+
+		cluster_entry_t const& _get_cluster_entry(mask_key_t mask_key, passability_mask_t const* mask, cluster_t cluster);
+
+		bool _find_route(
+			mask_key_t mask_key, passability_mask_t const* mask, node_t start, node_t target, route_t& route
+		);
+		bool _refine_route(
+			route_t const& route, passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path
+		);
+
+	public:
+		PathCache(MapDefinition const& new_map_definition, ProvinceGraph const& new_graph);
+
+		/* The graph must have been built. */
+		bool setup();
+
+		constexpr size_t get_cluster_count() const {
+			return cluster_generations.size();
+		}
+		constexpr size_t get_portal_count() const {
+			return portals.size();
+		}
+
+		/* Fills path with the provinces from start to target inclusive, returning false and leaving path empty if there
+		 * is no route. The same mask key must always be used with the same mask, until it is invalidated, and a null mask
+		 * must always use UNMASKED_KEY. */
+		bool find_path(
+			ProvinceDefinition const& start, ProvinceDefinition const& target, mask_key_t mask_key,
+			passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path
+		);
+
+		void invalidate_province(ProvinceDefinition const& province);
+		void invalidate_mask(mask_key_t mask_key);
+		void clear();
+		void reset_counters();
+	};
+}
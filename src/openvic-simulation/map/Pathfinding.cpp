@@ -0,0 +1,146 @@
+#include "Pathfinding.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/map/MapDefinition.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+PathfindingScratch::PathfindingScratch() : search { 0 } {}
+
+void PathfindingScratch::_begin_search(size_t node_count) {
+	if (node_states.size() < node_count) {
+		node_states.resize(node_count, { fixed_point_t::_0(), ProvinceGraph::NO_NODE, 0, false });
+	}
+	open_list.clear();
+
+	/* Search 0 marks states never written, so on wrapping around every stamp must be reset */
+	if (++search == 0) {
+		for (node_state_t& state : node_states) {
+			state.search = 0;
+		}
+		search = 1;
+	}
+}
+
+PathfindingScratch::node_state_t& PathfindingScratch::_get_node_state(ProvinceGraph::node_t node) {
+	node_state_t& state = node_states[node];
+	if (state.search != search) {
+		state = { fixed_point_t::_0(), ProvinceGraph::NO_NODE, search, false };
+	}
+	return state;
+}
+
+Pathfinder::Pathfinder(MapDefinition const& new_map_definition) : map_definition { new_map_definition } {}
+
+bool Pathfinder::find_path(
+	ProvinceGraph const& graph, ProvinceDefinition const& start, ProvinceDefinition const& target,
+	passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path, PathfindingScratch& scratch
+) const {
+	using node_state_t = PathfindingScratch::node_state_t;
+	using open_entry_t = PathfindingScratch::open_entry_t;
+
+	path.clear();
+
+	if (!graph.is_built()) {
+		Logger::error("Cannot find path from ", start, " to ", target, " - province graph has not been built!");
+		return false;
+	}
+
+	const ProvinceGraph::node_t start_node = ProvinceGraph::get_node(start);
+	const ProvinceGraph::node_t target_node = ProvinceGraph::get_node(target);
+
+	if (start_node >= graph.get_node_count() || target_node >= graph.get_node_count()) {
+		Logger::error("Cannot find path from ", start, " to ", target, " - province not in graph!");
+		return false;
+	}
+
+	if (start_node == target_node) {
+		path.push_back(&start);
+		return true;
+	}
+
+	if (mask != nullptr && !mask->is_province_passable(target_node)) {
+		return false;
+	}
+
+	scratch._begin_search(graph.get_node_count());
+
+	/* Min-heap on estimated total distance, ties broken by node so results never depend on heap internals */
+	static constexpr auto open_entry_greater = [](open_entry_t const& lhs, open_entry_t const& rhs) -> bool {
+		return lhs.estimate > rhs.estimate || (lhs.estimate == rhs.estimate && lhs.node > rhs.node);
+	};
+
+	const auto heuristic = [this, &target](ProvinceGraph::node_t node) -> fixed_point_t {
+		return map_definition.calculate_distance_between(
+			*map_definition.get_province_definition_by_index(node + 1), target
+		);
+	};
+
+	scratch._get_node_state(start_node);
+	scratch.open_list.push_back({ heuristic(start_node), start_node });
+
+	bool found = false;
+
+	while (!scratch.open_list.empty()) {
+		std::pop_heap(scratch.open_list.begin(), scratch.open_list.end(), open_entry_greater);
+		const ProvinceGraph::node_t node = scratch.open_list.back().node;
+		scratch.open_list.pop_back();
+
+		node_state_t& state = scratch._get_node_state(node);
+		/* Nodes may be queued several times as shorter routes are found, only the first pop counts */
+		if (state.closed) {
+			continue;
+		}
+		state.closed = true;
+
+		if (node == target_node) {
+			found = true;
+			break;
+		}
+
+		const fixed_point_t cost = state.cost;
+
+		for (ProvinceGraph::edge_t const& edge : graph.get_edges(node)) {
+			if (mask != nullptr && !mask->can_traverse(edge)) {
+				continue;
+			}
+
+			node_state_t& next_state = scratch._get_node_state(edge.to);
+			if (next_state.closed) {
+				continue;
+			}
+
+			const fixed_point_t next_cost = cost + edge.distance;
+			if (next_state.parent != ProvinceGraph::NO_NODE && next_cost >= next_state.cost) {
+				continue;
+			}
+
+			next_state.cost = next_cost;
+			next_state.parent = node;
+
+			scratch.open_list.push_back({ next_cost + heuristic(edge.to), edge.to });
+			std::push_heap(scratch.open_list.begin(), scratch.open_list.end(), open_entry_greater);
+		}
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	for (ProvinceGraph::node_t node = target_node; node != ProvinceGraph::NO_NODE; node = scratch.node_states[node].parent) {
+		path.push_back(map_definition.get_province_definition_by_index(node + 1));
+	}
+	std::reverse(path.begin(), path.end());
+
+	return true;
+}
+
+bool Pathfinder::find_path(
+	ProvinceGraph const& graph, ProvinceDefinition const& start, ProvinceDefinition const& target,
+	passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path
+) const {
+	static thread_local PathfindingScratch scratch;
+	return find_path(graph, start, target, mask, path, scratch);
+}
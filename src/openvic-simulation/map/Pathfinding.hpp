@@ -0,0 +1,87 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "openvic-simulation/map/ProvinceGraph.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct MapDefinition;
+
+	/* Which provinces and canals a country's units may currently move through. Built per country, e.g. by
+	 * MapInstance::build_passability_mask, and reused across all of that country's path queries. */
+	struct passability_mask_t {
+		/* Indexed by graph node. */
+		std::vector<bool> provinces;
+		/* Indexed by canal adjacency data, canal 0 being ProvinceDefinition::adjacency_t::NO_CANAL. */
+		std::bitset<std::numeric_limits<ProvinceDefinition::adjacency_t::data_t>::max() + 1> canals;
+
+		constexpr bool is_province_passable(ProvinceGraph::node_t node) const {
+			return node < provinces.size() && provinces[node];
+		}
+
+		/* Whether the edge's destination can be entered, and for canals whether the canal can be used. */
+		constexpr bool can_traverse(ProvinceGraph::edge_t const& edge) const {
+			return is_province_passable(edge.to) && (
+				edge.type != ProvinceDefinition::adjacency_t::type_t::CANAL
+					|| (canals[edge.data] && is_province_passable(edge.through))
+			);
+		}
+	};
+
+	/* Per-search state, kept between searches so that repeated queries don't allocate. Node states are stamped with the
+	 * search they were written in rather than being cleared, so starting a search costs nothing however large the graph.
+	 * A scratch must only be used by one search at a time, Pathfinder::find_path without one uses a thread_local. */
+	struct PathfindingScratch {
+		friend struct Pathfinder;
+
+	private:
+		struct node_state_t {
+			fixed_point_t cost;
+			ProvinceGraph::node_t parent;
+			uint32_t search;
+			bool closed;
+		};
+
+		struct open_entry_t {
+			fixed_point_t estimate;
+			ProvinceGraph::node_t node;
+		};
+
+		std::vector<node_state_t> node_states;
+		std::vector<open_entry_t> open_list;
+		uint32_t search;
+
+		void _begin_search(size_t node_count);
+		node_state_t& _get_node_state(ProvinceGraph::node_t node);
+
+	public:
+		PathfindingScratch();
+	};
+
+	/* A* over a ProvinceGraph, using MapDefinition::calculate_distance_between to the target as the heuristic. As the
+	 * graph's edge distances are calculated the same way the heuristic never overestimates, so paths are shortest. */
+	struct Pathfinder {
+	private:
+		MapDefinition const& PROPERTY(map_definition);
+
+	public:
+		Pathfinder(MapDefinition const& new_map_definition);
+
+		/* Fills path with the provinces from start to target inclusive, returning false and leaving path empty if there
+		 * is no route. A null mask lets every province and canal be passed through. The start province is always
+		 * allowed, so units can leave provinces they no longer have access to. */
+		bool find_path(
+			ProvinceGraph const& graph, ProvinceDefinition const& start, ProvinceDefinition const& target,
+			passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path, PathfindingScratch& scratch
+		) const;
+		bool find_path(
+			ProvinceGraph const& graph, ProvinceDefinition const& start, ProvinceDefinition const& target,
+			passability_mask_t const* mask, std::vector<ProvinceDefinition const*>& path
+		) const;
+	};
+}
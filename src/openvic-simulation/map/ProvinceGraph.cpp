@@ -0,0 +1,74 @@
+#include "ProvinceGraph.hpp"
+
+#include "openvic-simulation/map/MapDefinition.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+using adjacency_t = ProvinceDefinition::adjacency_t;
+
+ProvinceGraph::ProvinceGraph(kind_t new_kind) : kind { new_kind } {}
+
+bool ProvinceGraph::_includes_adjacency(ProvinceDefinition const& from, adjacency_t const& adjacency) const {
+	using enum adjacency_t::type_t;
+
+	switch (adjacency.get_type()) {
+	case LAND:
+	case STRAIT:
+		return kind == kind_t::LAND;
+	case WATER:
+	case CANAL:
+		return kind == kind_t::NAVAL;
+	case COASTAL: {
+		if (kind != kind_t::NAVAL) {
+			return false;
+		}
+		/* Navies can only enter a land province through its port, and leave it the same way */
+		ProvinceDefinition const& land = from.is_water() ? *adjacency.get_to() : from;
+		ProvinceDefinition const& water = from.is_water() ? from : *adjacency.get_to();
+		return land.has_port() && land.get_port_adjacent_province() == &water;
+	}
+	default:
+		return false;
+	}
+}
+
+bool ProvinceGraph::build(MapDefinition const& map_definition) {
+	if (is_built()) {
+		Logger::error("Cannot build province graph - already built!");
+		return false;
+	}
+
+	std::vector<ProvinceDefinition> const& provinces = map_definition.get_province_definitions();
+
+	offsets.reserve(provinces.size() + 1);
+	offsets.push_back(0);
+
+	for (ProvinceDefinition const& province : provinces) {
+		for (adjacency_t const& adjacency : province.get_adjacencies()) {
+			if (!_includes_adjacency(province, adjacency)) {
+				continue;
+			}
+
+			edges.push_back({
+				get_node(*adjacency.get_to()),
+				adjacency.get_through() != nullptr ? get_node(*adjacency.get_through()) : NO_NODE,
+				map_definition.calculate_distance_between(province, *adjacency.get_to()),
+				adjacency.get_type(),
+				adjacency.get_data()
+			});
+		}
+		offsets.push_back(edges.size());
+	}
+
+	edges.shrink_to_fit();
+
+	return true;
+}
+
+std::span<const ProvinceGraph::edge_t> ProvinceGraph::get_edges(node_t node) const {
+	if (static_cast<size_t>(node) + 1 >= offsets.size()) {
+		return {};
+	}
+	return { edges.data() + offsets[node], edges.data() + offsets[node + 1] };
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "openvic-simulation/map/ProvinceDefinition.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct MapDefinition;
+
+	/* An immutable compressed sparse row copy of the provinces' adjacencies, holding only the links one kind of unit can
+	 * travel along. Nodes are province indices minus one (matching province instance indices), and each node's edges
+	 * are stored contiguously, so walking a province's neighbours is a scan of one small array rather than chasing
+	 * ProvinceDefinition pointers. */
+	struct ProvinceGraph {
+		using node_t = ProvinceDefinition::index_t;
+		static constexpr node_t NO_NODE = std::numeric_limits<node_t>::max();
+
+		enum struct kind_t : uint8_t {
+			LAND,  /* LAND and STRAIT adjacencies between land provinces */
+			NAVAL  /* WATER and CANAL adjacencies, plus COASTAL adjacencies between ports and their sea provinces */
+		};
+
+		struct edge_t {
+			node_t to;
+			/* The strait's sea province or the canal's land province, otherwise NO_NODE. */
+			node_t through;
+			ProvinceDefinition::distance_t distance;
+			ProvinceDefinition::adjacency_t::type_t type;
+			ProvinceDefinition::adjacency_t::data_t data;
+		};
+
+	private:
+		kind_t PROPERTY(kind);
+		/* Node n's edges are edges[offsets[n]] to edges[offsets[n + 1]]. */
+		std::vector<uint32_t> offsets;
+		std::vector<edge_t> edges;
+
+		bool _includes_adjacency(
+			ProvinceDefinition const& from, ProvinceDefinition::adjacency_t const& adjacency
+		) const;
+
+	public:
+		ProvinceGraph(kind_t new_kind);
+		ProvinceGraph(ProvinceGraph&&) = default;
+
+		/* Edge distances are recalculated from province unit positions, so this must be called after those are loaded,
+		 * which also keeps them consistent with the distance heuristic used when pathfinding. */
+		bool build(MapDefinition const& map_definition);
+
+		constexpr bool is_built() const {
+			return !offsets.empty();
+		}
+		constexpr size_t get_node_count() const {
+			return offsets.empty() ? 0 : offsets.size() - 1;
+		}
+		constexpr size_t get_edge_count() const {
+			return edges.size();
+		}
+
+		std::span<const edge_t> get_edges(node_t node) const;
+
+		static constexpr node_t get_node(ProvinceDefinition const& province) {
+			return province.get_index() - 1;
+		}
+	};
+}
@@ -1,5 +1,7 @@
 #include "ProvinceInstance.hpp"
 
+#include <algorithm>
+
 #include "openvic-simulation/country/CountryInstance.hpp"
 #include "openvic-simulation/defines/Define.hpp"
 #include "openvic-simulation/economy/production/ProductionType.hpp"
@@ -8,18 +10,23 @@
 #include "openvic-simulation/map/Crime.hpp"
 #include "openvic-simulation/map/ProvinceDefinition.hpp"
 #include "openvic-simulation/map/Region.hpp"
+#include "openvic-simulation/map/State.hpp"
 #include "openvic-simulation/map/TerrainType.hpp"
 #include "openvic-simulation/military/UnitInstanceGroup.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
 #include "openvic-simulation/modifier/StaticModifierCache.hpp"
 #include "openvic-simulation/politics/Ideology.hpp"
 #include "openvic-simulation/pop/Pop.hpp"
+#include "openvic-simulation/pop/PopStore.hpp"
+#include "openvic-simulation/pop/PopTransitions.hpp"
 #include "openvic-simulation/utility/Logger.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
 
 using namespace OpenVic;
 
 ProvinceInstance::ProvinceInstance(
 	ProvinceDefinition const& new_province_definition, decltype(pop_type_distribution)::keys_t const& pop_type_keys,
-	decltype(ideology_distribution)::keys_t const& ideology_keys
+	decltype(ideology_distribution)::keys_t const& ideology_keys, PopStore& new_pop_store
 ) : HasIdentifierAndColour { new_province_definition },
 	province_definition { new_province_definition },
 	terrain_type { new_province_definition.get_default_terrain_type() },
@@ -31,19 +38,30 @@ ProvinceInstance::ProvinceInstance(
 	cores {},
 	modifier_sum {},
 	event_modifiers {},
+	modifier_groups {},
+	// Every group starts dirty, so the first update gathers them all
+	dirty_modifier_groups { (1 << static_cast<uint8_t>(modifier_group_t::MODIFIER_GROUP_COUNT)) - 1 },
+	earliest_event_modifier_expiry {},
+	modifier_contribution_country { nullptr },
 	slave { false },
 	crime { nullptr },
 	rgo { pop_type_keys },
 	buildings { "buildings", false },
+	buildings_version { 0 },
 	armies {},
 	navies {},
-	pops {},
+	pop_store { &new_pop_store },
+	pop_handles {},
 	total_population { 0 },
 	pop_type_distribution { &pop_type_keys },
+	pops_by_type { &pop_type_keys },
+	state_building_history {},
 	ideology_distribution { &ideology_keys },
 	culture_distribution {},
 	religion_distribution {},
-	max_supported_regiments { 0 } {}
+	max_supported_regiments { 0 },
+	pop_count_before_merge { 0 },
+	pop_count_after_merge { 0 } {}
 
 GoodDefinition const* ProvinceInstance::get_rgo_good() const {
 	if (!rgo.is_valid()) { return nullptr; }
@@ -64,6 +82,13 @@ bool ProvinceInstance::set_rgo_production_type_nullable(ProductionType const* rg
 	return is_valid_operation;
 }
 
+void ProvinceInstance::set_crime(Crime const* new_crime) {
+	if (crime != new_crime) {
+		crime = new_crime;
+		_mark_modifier_group_dirty(modifier_group_t::STATIC);
+	}
+}
+
 bool ProvinceInstance::set_owner(CountryInstance* new_owner) {
 	bool ret = true;
 
@@ -73,6 +98,8 @@ bool ProvinceInstance::set_owner(CountryInstance* new_owner) {
 		}
 
 		owner = new_owner;
+		// Whether the province is a core of its owner may have changed
+		_mark_modifier_group_dirty(modifier_group_t::STATIC);
 
 		if (owner != nullptr) {
 			ret &= owner->add_owned_province(*this);
@@ -102,6 +129,7 @@ bool ProvinceInstance::set_controller(CountryInstance* new_controller) {
 
 bool ProvinceInstance::add_core(CountryInstance& new_core) {
 	if (cores.emplace(&new_core).second) {
+		_mark_modifier_group_dirty(modifier_group_t::STATIC);
 		return new_core.add_core_province(*this);
 	} else {
 		Logger::error(
@@ -113,6 +141,7 @@ bool ProvinceInstance::add_core(CountryInstance& new_core) {
 
 bool ProvinceInstance::remove_core(CountryInstance& core_to_remove) {
 	if (cores.erase(&core_to_remove) > 0) {
+		_mark_modifier_group_dirty(modifier_group_t::STATIC);
 		return core_to_remove.remove_core_province(*this);
 	} else {
 		Logger::error(
@@ -136,14 +165,39 @@ bool ProvinceInstance::expand_building(size_t building_index) {
 	return building->expand();
 }
 
-void ProvinceInstance::_add_pop(Pop&& pop) {
-	pop.set_location(*this);
-	pops.insert(std::move(pop));
+void ProvinceInstance::_add_pop(PopBase const& pop) {
+	const PopStore::handle_t handle = pop_store->add_pop(pop);
+	Pop& new_pop = pop_store->get_pop(handle);
+	new_pop.set_location(*this);
+	pop_handles.push_back(handle);
+	_index_pop(new_pop);
+	if (state != nullptr) {
+		state->add_pop(new_pop);
+	}
 }
 
-bool ProvinceInstance::add_pop(Pop&& pop) {
+void ProvinceInstance::_index_pop(Pop& pop) {
+	std::vector<Pop*>& pops = pops_by_type[*pop.get_type()];
+	pop.province_type_slot = pops.size();
+	pops.push_back(&pop);
+}
+
+void ProvinceInstance::_unindex_pop(Pop& pop, PopType const& type) {
+	std::vector<Pop*>& pops = pops_by_type[type];
+	const size_t slot = pop.province_type_slot;
+	if (slot >= pops.size() || pops[slot] != &pop) {
+		Logger::error("Trying to remove pop of type ", type.get_identifier(), " not indexed in province ", get_identifier());
+		return;
+	}
+	// Order doesn't matter, so the last entry fills the gap
+	pops[slot] = pops.back();
+	pops[slot]->province_type_slot = slot;
+	pops.pop_back();
+}
+
+bool ProvinceInstance::add_pop(PopBase const& pop) {
 	if (!province_definition.is_water()) {
-		_add_pop(std::move(pop));
+		_add_pop(pop);
 		return true;
 	} else {
 		Logger::error("Trying to add pop to water province ", get_identifier());
@@ -153,9 +207,10 @@ bool ProvinceInstance::add_pop(Pop&& pop) {
 
 bool ProvinceInstance::add_pop_vec(std::vector<PopBase> const& pop_vec) {
 	if (!province_definition.is_water()) {
-		reserve_more(pops, pop_vec.size());
+		reserve_more(pop_handles, pop_vec.size());
+		pop_store->reserve(pop_store->get_slot_count() + pop_vec.size());
 		for (PopBase const& pop : pop_vec) {
-			_add_pop(Pop { pop, *ideology_distribution.get_keys() });
+			_add_pop(pop);
 		}
 		return true;
 	} else {
@@ -165,7 +220,230 @@ bool ProvinceInstance::add_pop_vec(std::vector<PopBase> const& pop_vec) {
 }
 
 size_t ProvinceInstance::get_pop_count() const {
-	return pops.size();
+	return pop_handles.size();
+}
+
+PopStore::const_pop_view_t ProvinceInstance::get_pops() const {
+	return std::as_const(*pop_store).get_pops(pop_handles);
+}
+
+PopStore::mutable_pop_view_t ProvinceInstance::get_mutable_pops() {
+	return pop_store->get_pops(pop_handles);
+}
+
+void ProvinceInstance::_apply_outgoing_pop_transfers(std::span<const pop_transfer_t> transfers) {
+	for (Pop& pop : get_mutable_pops()) {
+		pop.num_promoted = 0;
+		pop.num_demoted = 0;
+		pop.num_migrated_internal = 0;
+		pop.num_migrated_external = 0;
+		pop.num_migrated_colonial = 0;
+	}
+
+	for (pop_transfer_t const& transfer : transfers) {
+		Pop& pop = pop_store->get_pop(transfer.source);
+		pop_store->get_size(transfer.source) -= transfer.size;
+		pop_store->get_cash(transfer.source) -= transfer.cash;
+
+		using enum pop_transfer_t::kind_t;
+
+		switch (transfer.kind) {
+		case PROMOTION:
+			pop.num_promoted += transfer.size;
+			break;
+		case DEMOTION:
+			pop.num_demoted += transfer.size;
+			break;
+		case INTERNAL_MIGRATION:
+			pop.num_migrated_internal += transfer.size;
+			break;
+		case COLONIAL_MIGRATION:
+			pop.num_migrated_colonial += transfer.size;
+			break;
+		case EMIGRATION:
+			pop.num_migrated_external += transfer.size;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+/* Size-weighted blend of size people from source into target, which keeps source untouched. */
+static void merge_pop_into(
+	PopStore& pop_store, PopStore::handle_t target, PopStore::handle_t source, Pop::pop_size_t size, fixed_point_t cash
+) {
+	const Pop::pop_size_t target_size = pop_store.get_size(target);
+	const Pop::pop_size_t total_size = target_size + size;
+	if (total_size <= 0) {
+		return;
+	}
+
+	const auto blend = [target_size, size, total_size](fixed_point_t& target_value, fixed_point_t source_value) -> void {
+		target_value = (target_value * target_size + source_value * size) / total_size;
+	};
+
+	blend(pop_store.get_militancy(target), pop_store.get_militancy(source));
+	blend(pop_store.get_consciousness(target), pop_store.get_consciousness(source));
+	blend(pop_store.get_literacy(target), pop_store.get_literacy(source));
+
+	const std::span<fixed_point_t> target_ideologies = pop_store.get_ideologies(target);
+	const std::span<const fixed_point_t> source_ideologies = std::as_const(pop_store).get_ideologies(source);
+	for (size_t index = 0; index < target_ideologies.size(); ++index) {
+		blend(target_ideologies[index], source_ideologies[index]);
+	}
+
+	const std::span<fixed_point_t> target_issues = pop_store.get_issues(target);
+	const std::span<const fixed_point_t> source_issues = std::as_const(pop_store).get_issues(source);
+	for (size_t index = 0; index < target_issues.size(); ++index) {
+		blend(target_issues[index], source_issues[index]);
+	}
+
+	pop_store.get_cash(target) += cash;
+	pop_store.get_size(target) = total_size;
+}
+
+namespace {
+	struct pop_key_t {
+		PopType const* type;
+		Culture const* culture;
+		Religion const* religion;
+		RebelType const* rebel_type;
+
+		bool operator==(pop_key_t const&) const = default;
+	};
+
+	struct pop_key_hash_t {
+		size_t operator()(pop_key_t const& key) const {
+			size_t hash = 0;
+			utility::hash_combine(hash, key.type);
+			utility::hash_combine(hash, key.culture);
+			utility::hash_combine(hash, key.religion);
+			utility::hash_combine(hash, key.rebel_type);
+			return hash;
+		}
+	};
+}
+
+void ProvinceInstance::_grow_pops(
+	Date today, PopsDefines const& pops_defines, ModifierEffectCache const& modifier_effect_cache
+) {
+	const fixed_point_t growth_rate = pops_defines.get_base_popgrowth()
+		+ fixed_point_t::parse(std::max(life_rating - pops_defines.get_min_life_rating_for_growth(), 0))
+			* pops_defines.get_life_rating_growth_bonus()
+		+ get_modifier_effect_value_nullcheck(modifier_effect_cache.get_pop_growth())
+		+ get_modifier_effect_value_nullcheck(modifier_effect_cache.get_global_population_growth())
+		+ get_modifier_effect_value_nullcheck(modifier_effect_cache.get_population_growth());
+	const fixed_point_t starvation_limit = pops_defines.get_life_need_starvation_limit();
+	const uint64_t day = (today - Date {}).to_int();
+
+	for (const PopStore::handle_t handle : pop_handles) {
+		Pop& pop = pop_store->get_pop(handle);
+		const fixed_point_t life_needs = pop_store->get_life_needs_fulfilled(handle);
+
+		// Full growth with life needs met, slowing to none at the starvation limit and shrinking below it
+		fixed_point_t rate;
+		if (life_needs < starvation_limit) {
+			rate = -pops_defines.get_base_popgrowth() * (starvation_limit - life_needs) / starvation_limit;
+		} else if (starvation_limit < fixed_point_t::_1()) {
+			rate = growth_rate * (life_needs - starvation_limit) / (fixed_point_t::_1() - starvation_limit);
+		} else {
+			rate = growth_rate;
+		}
+
+		if (pop.get_type()->get_is_slave() && rate > fixed_point_t::_0() && pops_defines.get_slave_growth_divisor() > 0) {
+			rate /= pops_defines.get_slave_growth_divisor();
+		}
+
+		// Rounded up with probability equal to the fractional part, so pops too small to change by a whole person each
+		// month still grow or shrink at the right rate on average rather than never changing
+		Pop::pop_size_t& size = pop_store->get_size(handle);
+		const fixed_point_t exact_change = fixed_point_t::parse(size) * rate;
+		const int64_t random = static_cast<int64_t>(utility::mix_bits((day << 32) ^ handle) & fixed_point_t::FRAC_MASK);
+		const Pop::pop_size_t change = std::max(
+			static_cast<Pop::pop_size_t>(
+				exact_change.floor().to_int64_t() + (random < (exact_change.get_raw_value() & fixed_point_t::FRAC_MASK) ? 1 : 0)
+			),
+			-size
+		);
+		size += change;
+		pop.num_grown = change;
+	}
+}
+
+/* A single compaction pass: the province's pops are hashed by type, culture, religion and rebel type, pops sharing
+ * a key are merged into the first of them, then each arrival joins the pop with its key, only founding a new pop if
+ * there is none. Emptied pops are left for _remove_empty_pops, as they may still be the source of arrivals in other
+ * provinces. */
+void ProvinceInstance::_merge_pops(std::span<const pop_transfer_t> incoming_transfers) {
+	pop_count_before_merge = pop_handles.size() + incoming_transfers.size();
+
+	ordered_map<pop_key_t, PopStore::handle_t, pop_key_hash_t> pops_by_key;
+	pops_by_key.reserve(pop_handles.size() + incoming_transfers.size());
+
+	for (const PopStore::handle_t handle : pop_handles) {
+		if (pop_store->get_size(handle) <= 0) {
+			continue;
+		}
+
+		Pop const& pop = pop_store->get_pop(handle);
+		const auto [it, inserted] = pops_by_key.emplace(
+			pop_key_t { pop.get_type(), &pop.get_culture(), &pop.get_religion(), pop.get_rebel_type() }, handle
+		);
+		if (!inserted) {
+			merge_pop_into(*pop_store, it->second, handle, pop_store->get_size(handle), pop_store->get_cash(handle));
+			pop_store->get_size(handle) = 0;
+			pop_store->get_cash(handle) = 0;
+		}
+	}
+
+	for (pop_transfer_t const& transfer : incoming_transfers) {
+		if (transfer.size <= 0) {
+			continue;
+		}
+
+		Pop const& source = pop_store->get_pop(transfer.source);
+		const pop_key_t key { transfer.type, transfer.culture, transfer.religion, source.get_rebel_type() };
+
+		const decltype(pops_by_key)::const_iterator it = pops_by_key.find(key);
+		if (it != pops_by_key.end()) {
+			merge_pop_into(*pop_store, it->second, transfer.source, transfer.size, transfer.cash);
+			continue;
+		}
+
+		_add_pop({
+			*transfer.type, *transfer.culture, *transfer.religion, transfer.size, source.get_militancy(),
+			source.get_consciousness(), source.get_rebel_type()
+		});
+
+		const PopStore::handle_t handle = pop_handles.back();
+		pop_store->get_literacy(handle) = pop_store->get_literacy(transfer.source);
+		pop_store->get_cash(handle) = transfer.cash;
+		std::ranges::copy(std::as_const(*pop_store).get_ideologies(transfer.source), pop_store->get_ideologies(handle).begin());
+		std::ranges::copy(std::as_const(*pop_store).get_issues(transfer.source), pop_store->get_issues(handle).begin());
+
+		pops_by_key.emplace(key, handle);
+	}
+}
+
+void ProvinceInstance::_remove_empty_pops() {
+	size_t kept_count = 0;
+	for (const PopStore::handle_t handle : pop_handles) {
+		if (pop_store->get_size(handle) > 0) {
+			pop_handles[kept_count++] = handle;
+			continue;
+		}
+
+		Pop& pop = pop_store->get_pop(handle);
+		_unindex_pop(pop, *pop.get_type());
+		if (state != nullptr) {
+			state->remove_pop(pop);
+		}
+		pop_store->remove_pop(handle);
+	}
+	pop_handles.resize(kept_count);
+
+	pop_count_after_merge = pop_handles.size();
 }
 
 /* REQUIREMENTS:
@@ -193,20 +471,37 @@ void ProvinceInstance::_update_pops(DefineManager const& define_manager) {
 		: colony_status == COLONY ? military_defines.get_pop_size_per_regiment_colony_multiplier()
 		: is_owner_core() ? fixed_point_t::_1() : military_defines.get_pop_size_per_regiment_non_core_multiplier();
 
-	for (Pop& pop : pops) {
+	for (Pop& pop : get_mutable_pops()) {
 		pop.update_gamestate(define_manager, owner, pop_size_per_regiment_multiplier);
+	}
+
+	// Aggregate straight from the pop store's columns rather than going through each Pop
+	PopStore const& store = *pop_store;
+	std::vector<Pop::pop_size_t> const& sizes = store.get_sizes();
+	std::vector<fixed_point_t> const& literacies = store.get_literacies();
+	std::vector<fixed_point_t> const& consciousnesses = store.get_consciousnesses();
+	std::vector<fixed_point_t> const& militancies = store.get_militancies();
+	std::vector<size_t> const& regiment_counts = store.get_max_supported_regiment_counts();
+
+	for (const PopStore::handle_t handle : pop_handles) {
+		const Pop::pop_size_t size = sizes[handle];
 
-		total_population += pop.get_size();
-		average_literacy += pop.get_literacy();
-		average_consciousness += pop.get_consciousness();
-		average_militancy += pop.get_militancy();
+		total_population += size;
+		average_literacy += literacies[handle];
+		average_consciousness += consciousnesses[handle];
+		average_militancy += militancies[handle];
 
-		pop_type_distribution[*pop.get_type()] += pop.get_size();
-		ideology_distribution += pop.get_ideologies();
-		culture_distribution[&pop.get_culture()] += pop.get_size();
-		religion_distribution[&pop.get_religion()] += pop.get_size();
+		Pop const& pop = store.get_pop(handle);
+
+		pop_type_distribution[*pop.get_type()] += size;
+		const std::span<const fixed_point_t> ideologies = store.get_ideologies(handle);
+		for (size_t index = 0; index < ideologies.size(); ++index) {
+			ideology_distribution[index] += ideologies[index];
+		}
+		culture_distribution[&pop.get_culture()] += size;
+		religion_distribution[&pop.get_religion()] += size;
 
-		max_supported_regiments += pop.get_max_supported_regiments();
+		max_supported_regiments += regiment_counts[handle];
 	}
 
 	if (total_population > 0) {
@@ -216,81 +511,191 @@ void ProvinceInstance::_update_pops(DefineManager const& define_manager) {
 	}
 }
 
-void ProvinceInstance::update_modifier_sum(Date today, StaticModifierCache const& static_modifier_cache) {
-	// Update sum of direct province modifiers
-	modifier_sum.clear();
+void ProvinceInstance::_mark_modifier_group_dirty(modifier_group_t group) {
+	dirty_modifier_groups |= 1 << static_cast<uint8_t>(group);
+}
+
+void ProvinceInstance::_gather_modifier_group(
+	modifier_group_t group, Date today, StaticModifierCache const& static_modifier_cache,
+	std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+) {
+	using enum ModifierEffect::target_t;
 
 	const ModifierSum::modifier_source_t province_source { this };
 
-	// Erase expired event modifiers and add non-expired ones to the sum
-	std::erase_if(event_modifiers, [this, today, &province_source](ModifierInstance const& modifier) -> bool {
-		if (today <= modifier.get_expiry_date()) {
-			modifier_sum.add_modifier(*modifier.get_modifier(), province_source);
-			return false;
-		} else {
-			return true;
+	const auto add_modifier = [&modifier_entries, &province_source](Modifier const* modifier) -> void {
+		if (modifier != nullptr) {
+			modifier_entries.emplace_back(modifier, fixed_point_t::_1(), province_source, NO_TARGETS);
 		}
-	});
+	};
 
-	// Add static modifiers
-	if (is_owner_core()) {
-		modifier_sum.add_modifier(static_modifier_cache.get_core(), province_source);
-	}
-	if (province_definition.is_water()) {
-		modifier_sum.add_modifier(static_modifier_cache.get_sea_zone(), province_source);
-	} else {
-		modifier_sum.add_modifier(static_modifier_cache.get_land_province(), province_source);
+	switch (group) {
+	case modifier_group_t::EVENT:
+		// Erase expired event modifiers and add non-expired ones to the list
+		std::erase_if(event_modifiers, [today, &add_modifier](ModifierInstance const& modifier) -> bool {
+			if (today <= modifier.get_expiry_date()) {
+				add_modifier(modifier.get_modifier());
+				return false;
+			} else {
+				return true;
+			}
+		});
 
-		if (province_definition.is_coastal()) {
-			modifier_sum.add_modifier(static_modifier_cache.get_coastal(), province_source);
+		if (!event_modifiers.empty()) {
+			earliest_event_modifier_expiry = std::min_element(
+				event_modifiers.begin(), event_modifiers.end(),
+				[](ModifierInstance const& lhs, ModifierInstance const& rhs) -> bool {
+					return lhs.get_expiry_date() < rhs.get_expiry_date();
+				}
+			)->get_expiry_date();
+		}
+		break;
+
+	case modifier_group_t::STATIC:
+		if (is_owner_core()) {
+			add_modifier(&static_modifier_cache.get_core());
+		}
+		if (province_definition.is_water()) {
+			add_modifier(&static_modifier_cache.get_sea_zone());
 		} else {
-			modifier_sum.add_modifier(static_modifier_cache.get_non_coastal(), province_source);
+			add_modifier(&static_modifier_cache.get_land_province());
+
+			if (province_definition.is_coastal()) {
+				add_modifier(&static_modifier_cache.get_coastal());
+			} else {
+				add_modifier(&static_modifier_cache.get_non_coastal());
+			}
+
+			// TODO - overseas, blockaded, no_adjacent_controlled, has_siege, occupied, nationalism, infrastructure
+		}
+
+		add_modifier(crime);
+
+		add_modifier(province_definition.get_continent());
+
+		add_modifier(province_definition.get_climate());
+
+		add_modifier(terrain_type);
+		break;
+
+	case modifier_group_t::BUILDINGS:
+		for (BuildingInstance const& building : buildings.get_items()) {
+			add_modifier(&building.get_building_type());
 		}
+		break;
+
+	default:
+		break;
+	}
+}
+
+void ProvinceInstance::_gather_local_modifiers(
+	Date today, StaticModifierCache const& static_modifier_cache,
+	std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+) {
+	modifier_entries.clear();
+
+	for (uint8_t group = 0; group < static_cast<uint8_t>(modifier_group_t::MODIFIER_GROUP_COUNT); ++group) {
+		_gather_modifier_group(static_cast<modifier_group_t>(group), today, static_modifier_cache, modifier_entries);
+	}
+}
+
+void ProvinceInstance::_update_modifier_sum_parent() {
+	using enum ModifierEffect::target_t;
 
-		// TODO - overseas, blockaded, no_adjacent_controlled, has_siege, occupied, nationalism, infrastructure
+	// If this province's contribution went to its owner rather than to an occupying controller, the owner's values for
+	// non-province targeted effects already include this province's modifiers.
+	modifier_sum.set_parent(
+		owner != nullptr ? &owner->get_modifier_sum() : nullptr, owner != nullptr && modifier_contribution_country == owner,
+		PROVINCE
+	);
+}
+
+void ProvinceInstance::update_modifier_sum(Date today, StaticModifierCache const& static_modifier_cache) {
+	// Update sum of direct province modifiers
+	modifier_sum.clear();
+
+	for (uint8_t group = 0; group < static_cast<uint8_t>(modifier_group_t::MODIFIER_GROUP_COUNT); ++group) {
+		std::vector<ModifierSum::modifier_entry_t>& group_entries = modifier_groups[group];
+		group_entries.clear();
+		_gather_modifier_group(static_cast<modifier_group_t>(group), today, static_modifier_cache, group_entries);
+		modifier_sum.add_modifiers(group_entries);
 	}
+	dirty_modifier_groups = 0;
 
-	for (BuildingInstance const& building : buildings.get_items()) {
-		modifier_sum.add_modifier(building.get_building_type(), province_source);
+	// The controller adds this province's contribution when rebuilding its own sum
+	modifier_contribution_country = controller;
+
+	_update_modifier_sum_parent();
+}
+
+void ProvinceInstance::update_modifier_sum_incremental(
+	Date today, StaticModifierCache const& static_modifier_cache, std::vector<ModifierSum::modifier_entry_t>& scratch
+) {
+	if (!event_modifiers.empty() && today > earliest_event_modifier_expiry) {
+		_mark_modifier_group_dirty(modifier_group_t::EVENT);
 	}
 
-	modifier_sum.add_modifier_nullcheck(crime, province_source);
+	/* A new controller is given the whole up to date contribution once the groups have been updated, so only a
+	 * controller which is keeping the province needs the groups' changes applied to its sum. */
+	const bool controller_changed = modifier_contribution_country != controller;
+	CountryInstance* const changes_country = controller_changed ? nullptr : controller;
+
+	for (uint8_t group = 0; dirty_modifier_groups != 0; ++group) {
+		const uint8_t group_bit = 1 << group;
+		if ((dirty_modifier_groups & group_bit) == 0) {
+			continue;
+		}
+		dirty_modifier_groups &= ~group_bit;
+
+		std::vector<ModifierSum::modifier_entry_t>& group_entries = modifier_groups[group];
+
+		scratch.clear();
+		_gather_modifier_group(static_cast<modifier_group_t>(group), today, static_modifier_cache, scratch);
+
+		std::span<const ModifierSum::modifier_entry_t> removed_entries = group_entries;
+		std::span<const ModifierSum::modifier_entry_t> added_entries = scratch;
+		ModifierSum::trim_unchanged_modifiers(removed_entries, added_entries);
 
-	modifier_sum.add_modifier_nullcheck(province_definition.get_continent(), province_source);
+		if (!removed_entries.empty() || !added_entries.empty()) {
+			modifier_sum.remove_modifiers(removed_entries);
+			modifier_sum.add_modifiers(added_entries);
 
-	modifier_sum.add_modifier_nullcheck(province_definition.get_climate(), province_source);
+			if (changes_country != nullptr) {
+				changes_country->update_province_modifier_contribution(removed_entries, added_entries);
+			}
+		}
 
-	modifier_sum.add_modifier_nullcheck(terrain_type, province_source);
+		group_entries.swap(scratch);
+	}
+
+	if (controller_changed) {
+		if (modifier_contribution_country != nullptr) {
+			modifier_contribution_country->remove_province_modifier_contribution(*this);
+		}
+
+		modifier_contribution_country = controller;
 
-	if constexpr (!ADD_OWNER_CONTRIBUTION) {
 		if (controller != nullptr) {
-			controller->contribute_province_modifier_sum(modifier_sum);
+			controller->contribute_province_modifier_sum(*this);
 		}
 	}
+
+	_update_modifier_sum_parent();
 }
 
-void ProvinceInstance::contribute_country_modifier_sum(ModifierSum const& owner_modifier_sum) {
-	modifier_sum.add_modifier_sum_exclude_source(owner_modifier_sum, this);
+void ProvinceInstance::build_modifier_sum(
+	Date today, StaticModifierCache const& static_modifier_cache, ModifierSum& sum,
+	std::vector<ModifierSum::modifier_entry_t>& scratch
+) {
+	sum.clear();
+
+	_gather_local_modifiers(today, static_modifier_cache, scratch);
+	sum.add_modifiers(scratch);
 }
 
 fixed_point_t ProvinceInstance::get_modifier_effect_value(ModifierEffect const& effect) const {
-	if constexpr (ADD_OWNER_CONTRIBUTION) {
-		return modifier_sum.get_effect(effect);
-	} else {
-		using enum ModifierEffect::target_t;
-
-		if (owner != nullptr) {
-			if (ModifierEffect::excludes_targets(effect.get_targets(), PROVINCE)) {
-				// Non-province targeted effects are already added to the country modifier sum
-				return owner->get_modifier_effect_value(effect);
-			} else {
-				// Province-targeted effects aren't passed to the country modifier sum
-				return owner->get_modifier_effect_value(effect) + modifier_sum.get_effect(effect);
-			}
-		} else {
-			return modifier_sum.get_effect(effect);
-		}
-	}
+	return modifier_sum.get_effect(effect);
 }
 
 fixed_point_t ProvinceInstance::get_modifier_effect_value_nullcheck(ModifierEffect const* effect) const {
@@ -304,49 +709,32 @@ fixed_point_t ProvinceInstance::get_modifier_effect_value_nullcheck(ModifierEffe
 void ProvinceInstance::push_contributing_modifiers(
 	ModifierEffect const& effect, std::vector<ModifierSum::modifier_entry_t>& contributions
 ) const {
-	if constexpr (ADD_OWNER_CONTRIBUTION) {
-		modifier_sum.push_contributing_modifiers(effect, contributions);
-	} else {
-		using enum ModifierEffect::target_t;
-
-		if (owner != nullptr) {
-			if (ModifierEffect::excludes_targets(effect.get_targets(), PROVINCE)) {
-				// Non-province targeted effects are already added to the country modifier sum
-				owner->push_contributing_modifiers(effect, contributions);
-			} else {
-				// Province-targeted effects aren't passed to the country modifier sum
-				modifier_sum.push_contributing_modifiers(effect, contributions);
-				owner->push_contributing_modifiers(effect, contributions);
-			}
-		} else {
-			modifier_sum.push_contributing_modifiers(effect, contributions);
-		}
-	}
+	modifier_sum.push_contributing_modifiers(effect, contributions);
 }
 
 std::vector<ModifierSum::modifier_entry_t> ProvinceInstance::get_contributing_modifiers(ModifierEffect const& effect) const {
-	if constexpr (ADD_OWNER_CONTRIBUTION) {
-		return modifier_sum.get_contributing_modifiers(effect);
-	} else {
-		std::vector<ModifierSum::modifier_entry_t> contributions;
-
-		push_contributing_modifiers(effect, contributions);
-
-		return contributions;
-	}
+	return modifier_sum.get_contributing_modifiers(effect);
 }
 
 bool ProvinceInstance::convert_rgo_worker_pops_to_equivalent(ProductionType const& production_type) {
 	bool is_valid_operation = true;
 	std::vector<Job> const& jobs = production_type.get_jobs();
-	for(Pop& pop : pops) {
+	for(Pop& pop : get_mutable_pops()) {
 		for(Job const& job : jobs) {
 			PopType const* const job_pop_type = job.get_pop_type();
 			PopType const* old_pop_type = pop.get_type();
 			if (job_pop_type != old_pop_type) {
 				PopType const* const equivalent = old_pop_type->get_equivalent();
 				if (job_pop_type == equivalent) {
-					is_valid_operation&=pop.convert_to_equivalent();
+					const bool converted = pop.convert_to_equivalent();
+					if (converted) {
+						_unindex_pop(pop, *old_pop_type);
+						_index_pop(pop);
+						if (state != nullptr) {
+							state->change_pop_type(pop, *old_pop_type);
+						}
+					}
+					is_valid_operation&=converted;
 				}
 			}
 		}
@@ -361,10 +749,19 @@ void ProvinceInstance::update_gamestate(Date today, DefineManager const& define_
 	_update_pops(define_manager);
 }
 
-void ProvinceInstance::tick(Date today) {
+void ProvinceInstance::tick(Date today, MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache) {
 	for (BuildingInstance& building : buildings.get_items()) {
+		const BuildingInstance::level_t old_level = building.get_level();
 		building.tick(today);
+		if (building.get_level() != old_level) {
+			buildings_version++;
+		}
 	}
+	rgo.tick(*this, market_instance, modifier_effect_cache);
+}
+
+void ProvinceInstance::after_orders_executed() {
+	rgo.after_orders_executed(*this);
 }
 
 template<UnitType::branch_t Branch>
@@ -393,6 +790,45 @@ bool ProvinceInstance::remove_unit_instance_group(UnitInstanceGroup<Branch>& gro
 	}
 }
 
+template<UnitType::branch_t Branch>
+void ProvinceInstance::_remove_unit_instance_groups(std::span<UnitInstanceGroupBranched<Branch>* const> departures) {
+	if (departures.empty()) {
+		return;
+	}
+
+	ordered_set<UnitInstanceGroupBranched<Branch>*>& groups = get_unit_instance_groups<Branch>();
+
+	if (departures.size() == 1) {
+		groups.erase(departures.front());
+		return;
+	}
+
+	/* Rebuilt in one pass rather than erasing one at a time, as each erase shifts every later group */
+	ordered_set<UnitInstanceGroupBranched<Branch>*> remaining_groups;
+	remaining_groups.reserve(groups.size() > departures.size() ? groups.size() - departures.size() : 0);
+	for (UnitInstanceGroupBranched<Branch>* group : groups) {
+		if (!std::binary_search(departures.begin(), departures.end(), group, std::less<> {})) {
+			remaining_groups.insert(group);
+		}
+	}
+	groups = std::move(remaining_groups);
+}
+
+template<UnitType::branch_t Branch>
+void ProvinceInstance::_add_unit_instance_groups(std::span<UnitInstanceGroupBranched<Branch>* const> arrivals) {
+	ordered_set<UnitInstanceGroupBranched<Branch>*>& groups = get_unit_instance_groups<Branch>();
+
+	groups.reserve(groups.size() + arrivals.size());
+	for (UnitInstanceGroupBranched<Branch>* group : arrivals) {
+		groups.insert(group);
+	}
+}
+
+template void ProvinceInstance::_remove_unit_instance_groups(std::span<ArmyInstance* const>);
+template void ProvinceInstance::_remove_unit_instance_groups(std::span<NavyInstance* const>);
+template void ProvinceInstance::_add_unit_instance_groups(std::span<ArmyInstance* const>);
+template void ProvinceInstance::_add_unit_instance_groups(std::span<NavyInstance* const>);
+
 template bool ProvinceInstance::add_unit_instance_group(UnitInstanceGroup<UnitType::branch_t::LAND>&);
 template bool ProvinceInstance::add_unit_instance_group(UnitInstanceGroup<UnitType::branch_t::NAVAL>&);
 template bool ProvinceInstance::remove_unit_instance_group(UnitInstanceGroup<UnitType::branch_t::LAND>&);
@@ -420,6 +856,7 @@ bool ProvinceInstance::setup(BuildingTypeManager const& building_type_manager) {
 	}
 
 	lock_buildings();
+	_mark_modifier_group_dirty(modifier_group_t::BUILDINGS);
 
 	return ret;
 }
@@ -450,11 +887,15 @@ bool ProvinceInstance::apply_history_to_province(ProvinceHistoryEntry const& ent
 	}
 
 	set_optional(life_rating, entry.get_life_rating());
-	set_optional(terrain_type, entry.get_terrain_type());
+	if (entry.get_terrain_type()) {
+		terrain_type = *entry.get_terrain_type();
+		_mark_modifier_group_dirty(modifier_group_t::STATIC);
+	}
 	for (auto const& [building, level] : entry.get_province_buildings()) {
 		BuildingInstance* existing_entry = buildings.get_item_by_identifier(building->get_identifier());
 		if (existing_entry != nullptr) {
 			existing_entry->set_level(level);
+			buildings_version++;
 		} else {
 			Logger::error(
 				"Trying to set level of non-existent province building ", building->get_identifier(), " to ", level,
@@ -463,21 +904,19 @@ bool ProvinceInstance::apply_history_to_province(ProvinceHistoryEntry const& ent
 			ret = false;
 		}
 	}
-	// TODO: load state buildings - entry.get_state_buildings()
+	for (auto const& [building, level] : entry.get_state_buildings()) {
+		state_building_history[building] = level;
+	}
 	// TODO: party loyalties for each POP when implemented on POP side - entry.get_party_loyalties()
 	return ret;
 }
 
-void ProvinceInstance::initialise_for_new_game(ModifierEffectCache const& modifier_effect_cache) {
-	rgo.initialise_for_new_game(*this, modifier_effect_cache);
+void ProvinceInstance::initialise_for_new_game(MarketInstance const& market_instance, ModifierEffectCache const& modifier_effect_cache) {
+	rgo.initialise_for_new_game(*this, market_instance, modifier_effect_cache);
 }
 
 void ProvinceInstance::setup_pop_test_values(IssueManager const& issue_manager) {
-	for (Pop& pop : pops) {
+	for (Pop& pop : get_mutable_pops()) {
 		pop.setup_pop_test_values(issue_manager);
 	}
-}
-
-plf::colony<Pop>& ProvinceInstance::get_mutable_pops() {
-	return pops;
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
-#include <plf_colony.h>
+#include <array>
+#include <cstdint>
 
 #include "openvic-simulation/economy/BuildingInstance.hpp"
 #include "openvic-simulation/economy/production/ProductionType.hpp"
@@ -9,6 +10,8 @@
 #include "openvic-simulation/military/UnitType.hpp"
 #include "openvic-simulation/modifier/ModifierSum.hpp"
 #include "openvic-simulation/pop/Pop.hpp"
+#include "openvic-simulation/pop/PopStore.hpp"
+#include "openvic-simulation/types/Date.hpp"
 #include "openvic-simulation/types/HasIdentifier.hpp"
 #include "openvic-simulation/types/OrderedContainers.hpp"
 
@@ -28,6 +31,8 @@ namespace OpenVic {
 	struct ProvinceHistoryEntry;
 	struct IssueManager;
 	struct CountryInstanceManager;
+	struct pop_transfer_t;
+	struct PopsDefines;
 
 	template<UnitType::branch_t>
 	struct UnitInstanceGroup;
@@ -40,6 +45,7 @@ namespace OpenVic {
 
 	struct ProvinceInstance : HasIdentifierAndColour {
 		friend struct MapInstance;
+		friend struct UnitInstanceManager;
 
 		using life_rating_t = int8_t;
 
@@ -71,43 +77,91 @@ namespace OpenVic {
 		CountryInstance* PROPERTY(controller);
 		ordered_set<CountryInstance*> PROPERTY(cores);
 
-	public:
-		static constexpr bool ADD_OWNER_CONTRIBUTION = true;
-
-	private:
-		// The total/resultant modifier affecting this province, including owner country contributions if
-		// ADD_OWNER_CONTRIBUTION is true.
+		// The modifiers applied directly to this province, layered on top of the owner country's modifier sum so that
+		// effect lookups return the total/resultant value without the owner's entries being copied into every province.
 		ModifierSum PROPERTY(modifier_sum);
 		std::vector<ModifierInstance> PROPERTY(event_modifiers);
 
+		/* Incremental modifier sum bookkeeping. The local modifiers currently in modifier_sum are kept in groups by what
+		 * they depend on, and whatever changes a group's inputs marks it dirty, so an update only regathers dirty groups
+		 * and swaps just their changed entries in modifier_sum and in the sum of the country holding this province's
+		 * contribution. Event modifier expiry is tracked by the earliest expiry date rather than by checking each one. */
+		enum struct modifier_group_t : uint8_t {
+			EVENT, // Event modifiers, until they expire
+			STATIC, // Static modifiers, crime, continent, climate and terrain; changes with owner, cores, crime or terrain
+			BUILDINGS, // Building types present in the province
+			MODIFIER_GROUP_COUNT
+		};
+		std::array<
+			std::vector<ModifierSum::modifier_entry_t>, static_cast<size_t>(modifier_group_t::MODIFIER_GROUP_COUNT)
+		> modifier_groups;
+		uint8_t dirty_modifier_groups; // One bit per modifier_group_t
+		Date earliest_event_modifier_expiry; // Only meaningful while there are event modifiers
+		CountryInstance* modifier_contribution_country;
+
 		bool PROPERTY(slave);
-		Crime const* PROPERTY_RW(crime);
+		Crime const* PROPERTY(crime);
 		ResourceGatheringOperation PROPERTY(rgo);
 		IdentifierRegistry<BuildingInstance> IDENTIFIER_REGISTRY(building);
+		/* Incremented whenever a building's level changes, so values derived from building levels can be cached. */
+		uint32_t PROPERTY(buildings_version);
 		ordered_set<ArmyInstance*> PROPERTY(armies);
 		ordered_set<NavyInstance*> PROPERTY(navies);
 
 		UNIT_BRANCHED_GETTER(get_unit_instance_groups, armies, navies);
 
-		plf::colony<Pop> PROPERTY(pops); // TODO - replace with a more easily vectorisable container?
+		PopStore* pop_store;
+		std::vector<PopStore::handle_t> PROPERTY(pop_handles);
 		Pop::pop_size_t PROPERTY(total_population);
 		// TODO - population change (growth + migration), monthly totals + breakdown by source/destination
 		fixed_point_t PROPERTY(average_literacy);
 		fixed_point_t PROPERTY(average_consciousness);
 		fixed_point_t PROPERTY(average_militancy);
 		IndexedMap<PopType, Pop::pop_size_t> PROPERTY(pop_type_distribution);
+		/* This province's pops grouped by type, kept up to date alongside its state's, for jobs such as RGOs which only
+		 * hire locally. */
+		IndexedMap<PopType, std::vector<Pop*>> PROPERTY(pops_by_type);
+		/* Factory levels set in this province's history, for its state to create factories from when a new game
+		 * starts, as states don't exist yet when history is applied. */
+		ordered_map<BuildingType const*, BuildingType::level_t> PROPERTY(state_building_history);
 		IndexedMap<Ideology, fixed_point_t> PROPERTY(ideology_distribution);
 		fixed_point_map_t<Culture const*> PROPERTY(culture_distribution);
 		fixed_point_map_t<Religion const*> PROPERTY(religion_distribution);
 		size_t PROPERTY(max_supported_regiments);
+		/* Last month's pop count going into the merge pass, counting each arrival as a pop of its own, and after it. */
+		size_t PROPERTY(pop_count_before_merge);
+		size_t PROPERTY(pop_count_after_merge);
 
 		ProvinceInstance(
 			ProvinceDefinition const& new_province_definition, decltype(pop_type_distribution)::keys_t const& pop_type_keys,
-			decltype(ideology_distribution)::keys_t const& ideology_keys
+			decltype(ideology_distribution)::keys_t const& ideology_keys, PopStore& new_pop_store
 		);
 
-		void _add_pop(Pop&& pop);
+		void _add_pop(PopBase const& pop);
 		void _update_pops(DefineManager const& define_manager);
+		/* Monthly pop update, applied by MapInstance in this order across all provinces. */
+		void _apply_outgoing_pop_transfers(std::span<const pop_transfer_t> transfers);
+		void _grow_pops(Date today, PopsDefines const& pops_defines, ModifierEffectCache const& modifier_effect_cache);
+		void _merge_pops(std::span<const pop_transfer_t> incoming_transfers);
+		void _index_pop(Pop& pop);
+		void _unindex_pop(Pop& pop, PopType const& type);
+		void _remove_empty_pops();
+		/* Batched army or navy set changes for a day's movement. Departures must be sorted by address. */
+		template<UnitType::branch_t Branch>
+		void _remove_unit_instance_groups(std::span<UnitInstanceGroupBranched<Branch>* const> departures);
+		template<UnitType::branch_t Branch>
+		void _add_unit_instance_groups(std::span<UnitInstanceGroupBranched<Branch>* const> arrivals);
+		void _mark_modifier_group_dirty(modifier_group_t group);
+		// Appends the group's current entries to modifier_entries.
+		void _gather_modifier_group(
+			modifier_group_t group, Date today, StaticModifierCache const& static_modifier_cache,
+			std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+		);
+		void _gather_local_modifiers(
+			Date today, StaticModifierCache const& static_modifier_cache,
+			std::vector<ModifierSum::modifier_entry_t>& modifier_entries
+		);
+		void _update_modifier_sum_parent();
 		bool convert_rgo_worker_pops_to_equivalent(ProductionType const& production_type);
 
 	public:
@@ -127,6 +181,7 @@ namespace OpenVic {
 		GoodDefinition const* get_rgo_good() const;
 		bool set_rgo_production_type_nullable(ProductionType const* rgo_production_type_nullable);
 
+		void set_crime(Crime const* new_crime);
 		bool set_owner(CountryInstance* new_owner);
 		bool set_controller(CountryInstance* new_controller);
 		bool add_core(CountryInstance& new_core);
@@ -135,12 +190,27 @@ namespace OpenVic {
 
 		bool expand_building(size_t building_index);
 
-		bool add_pop(Pop&& pop);
+		bool add_pop(PopBase const& pop);
 		bool add_pop_vec(std::vector<PopBase> const& pop_vec);
 		size_t get_pop_count() const;
+		PopStore::const_pop_view_t get_pops() const;
+		PopStore::mutable_pop_view_t get_mutable_pops();
 
 		void update_modifier_sum(Date today, StaticModifierCache const& static_modifier_cache);
-		void contribute_country_modifier_sum(ModifierSum const& owner_modifier_sum);
+		/* Only regathers the modifier groups marked dirty since the last update, swapping their changed entries in this
+		 * province's sum and its controller's, and moves this province's contribution to a new controller if it has
+		 * changed. A province with nothing dirty costs a few comparisons. scratch is used as temporary storage to avoid
+		 * reallocating it for every province. */
+		void update_modifier_sum_incremental(
+			Date today, StaticModifierCache const& static_modifier_cache,
+			std::vector<ModifierSum::modifier_entry_t>& scratch
+		);
+		/* Builds the local modifier sum a full update would produce into sum, without a parent layer, leaving this
+		 * province's own sum untouched. */
+		void build_modifier_sum(
+			Date today, StaticModifierCache const& static_modifier_cache, ModifierSum& sum,
+			std::vector<ModifierSum::modifier_entry_t>& scratch
+		);
 		fixed_point_t get_modifier_effect_value(ModifierEffect const& effect) const;
 		fixed_point_t get_modifier_effect_value_nullcheck(ModifierEffect const* effect) const;
 		void push_contributing_modifiers(
@@ -149,7 +219,8 @@ namespace OpenVic {
 		std::vector<ModifierSum::modifier_entry_t> get_contributing_modifiers(ModifierEffect const& effect) const;
 
 		void update_gamestate(Date today, DefineManager const& define_manager);
-		void tick(Date today);
+		void tick(Date today, MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache);
+		void after_orders_executed();
 
 		template<UnitType::branch_t Branch>
 		bool add_unit_instance_group(UnitInstanceGroup<Branch>& group);
@@ -159,9 +230,8 @@ namespace OpenVic {
 		bool setup(BuildingTypeManager const& building_type_manager);
 		bool apply_history_to_province(ProvinceHistoryEntry const& entry, CountryInstanceManager& country_manager);
 
-		void initialise_for_new_game(ModifierEffectCache const& modifier_effect_cache);
+		void initialise_for_new_game(MarketInstance const& market_instance, ModifierEffectCache const& modifier_effect_cache);
 
 		void setup_pop_test_values(IssueManager const& issue_manager);
-		plf::colony<Pop>& get_mutable_pops();
 	};
 }
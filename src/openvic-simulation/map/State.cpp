@@ -1,12 +1,17 @@
 #include "State.hpp"
 
+#include <algorithm>
+
 #include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/economy/production/ProductionType.hpp"
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
 #include "openvic-simulation/map/MapDefinition.hpp"
 #include "openvic-simulation/map/MapInstance.hpp"
 #include "openvic-simulation/map/ProvinceInstance.hpp"
 #include "openvic-simulation/map/Region.hpp"
 #include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
 #include "openvic-simulation/utility/StringUtils.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
 
 using namespace OpenVic;
 
@@ -23,8 +28,15 @@ State::State(
 	provinces { std::move(new_provinces) },
 	colony_status { new_colony_status },
 	pop_type_distribution { &pop_type_keys },
+	pops_by_type { &pop_type_keys },
 	industrial_power { 0 },
-	max_supported_regiments { 0 } {}
+	max_supported_regiments { 0 },
+	occupied_province_count { 0 },
+	factory_worker_demand { &pop_type_keys },
+	factory_worker_supply { &pop_type_keys },
+	artisanal_best_profitability { 0 } {
+	update_occupation();
+}
 
 std::string State::get_identifier() const {
 	return StringUtils::append_string_views(
@@ -33,6 +45,317 @@ std::string State::get_identifier() const {
 	);
 }
 
+void State::_rebuild_pops_by_type() {
+	for (std::vector<Pop*>& pops : pops_by_type) {
+		pops.clear();
+	}
+
+	for (ProvinceInstance* province : provinces) {
+		for (Pop& pop : province->get_mutable_pops()) {
+			add_pop(pop);
+		}
+	}
+}
+
+void State::add_pop(Pop& pop) {
+	std::vector<Pop*>& pops = pops_by_type[*pop.get_type()];
+	pop.state_type_slot = pops.size();
+	pops.push_back(&pop);
+}
+
+void State::_remove_pop_of_type(Pop& pop, PopType const& type) {
+	std::vector<Pop*>& pops = pops_by_type[type];
+	const size_t slot = pop.state_type_slot;
+	if (slot >= pops.size() || pops[slot] != &pop) {
+		Logger::error("Trying to remove pop of type ", type.get_identifier(), " not indexed in state ", get_identifier());
+		return;
+	}
+	// Order doesn't matter, so the last entry fills the gap rather than shifting everything after it
+	pops[slot] = pops.back();
+	pops[slot]->state_type_slot = slot;
+	pops.pop_back();
+}
+
+void State::remove_pop(Pop& pop) {
+	_remove_pop_of_type(pop, *pop.get_type());
+}
+
+void State::change_pop_type(Pop& pop, PopType const& old_type) {
+	_remove_pop_of_type(pop, old_type);
+	add_pop(pop);
+}
+
+bool State::initialise_for_new_game() {
+	ordered_map<BuildingType const*, BuildingType::level_t> levels;
+	for (ProvinceInstance const* province : provinces) {
+		for (auto const& [building, level] : province->get_state_building_history()) {
+			BuildingType::level_t& state_level = levels[building];
+			state_level = std::max(state_level, level);
+		}
+	}
+
+	bool ret = true;
+
+	for (auto const& [building, level] : levels) {
+		if (level <= 0) {
+			continue;
+		}
+		ProductionType const* production_type = building->get_production_type();
+		if (production_type == nullptr) {
+			Logger::error(
+				"Cannot create state building ", building->get_identifier(), " in state ", get_identifier(),
+				" - it has no production type!"
+			);
+			ret = false;
+			continue;
+		}
+		ret &= add_factory(*production_type, fixed_point_t::parse(level));
+	}
+
+	_update_industrial_power();
+
+	return ret;
+}
+
+bool State::add_factory(ProductionType const& production_type, fixed_point_t size_multiplier) {
+	if (production_type.get_template_type() != ProductionType::template_type_t::FACTORY) {
+		Logger::error(
+			"Cannot add ", production_type.get_identifier(), " to state ", get_identifier(), " - not a factory production type!"
+		);
+		return false;
+	}
+	if (size_multiplier <= fixed_point_t::_0()) {
+		Logger::error(
+			"Cannot add ", production_type.get_identifier(), " to state ", get_identifier(), " - invalid size ", size_multiplier
+		);
+		return false;
+	}
+	factories.emplace_back(production_type, size_multiplier);
+	return true;
+}
+
+/* Factories compete for the state's pops: when the factories together want more workers of a type than there are,
+ * each gets the same fraction of what it wants. Each factory's share is then drawn evenly from every pop of the
+ * type, so a pop may work for several factories. */
+void State::_hire_factory_workers() {
+	factory_worker_demand.clear();
+	factory_worker_supply.clear();
+
+	for (FactoryProducer& factory : factories) {
+		factory._clear_employees();
+
+		const Pop::pop_size_t max_employee_count = factory.get_max_employee_count();
+		for (Job const& job : factory.get_production_type().get_jobs()) {
+			if (job.get_pop_type() != nullptr) {
+				factory_worker_demand[*job.get_pop_type()] +=
+					static_cast<Pop::pop_size_t>((job.get_amount() * max_employee_count).floor());
+			}
+		}
+	}
+
+	for (PopType const& pop_type : *factory_worker_demand.get_keys()) {
+		if (factory_worker_demand[pop_type] > 0) {
+			for (Pop const* pop : pops_by_type[pop_type]) {
+				factory_worker_supply[pop_type] += pop->get_size();
+			}
+		}
+	}
+
+	for (FactoryProducer& factory : factories) {
+		const Pop::pop_size_t max_employee_count = factory.get_max_employee_count();
+		std::vector<Job> const& jobs = factory.get_production_type().get_jobs();
+
+		for (size_t job_index = 0; job_index < jobs.size(); ++job_index) {
+			Job const& job = jobs[job_index];
+			if (job.get_pop_type() == nullptr) {
+				continue;
+			}
+			PopType const& pop_type = *job.get_pop_type();
+
+			const Pop::pop_size_t supply = factory_worker_supply[pop_type];
+			const Pop::pop_size_t demand = factory_worker_demand[pop_type];
+			if (supply <= 0 || demand <= 0) {
+				continue;
+			}
+
+			// The fraction of every pop of this type that works for this job
+			const fixed_point_t wanted = (job.get_amount() * max_employee_count).floor();
+			const fixed_point_t hired = demand > supply ? wanted * supply / demand : wanted;
+			const fixed_point_t proportion = hired / supply;
+
+			for (Pop* pop : pops_by_type[pop_type]) {
+				factory._add_employee(job_index, *pop, static_cast<Pop::pop_size_t>((proportion * pop->get_size()).floor()));
+			}
+		}
+	}
+}
+
+void State::_update_artisanal_profitability(
+	ProductionTypeManager const& production_type_manager, MarketInstance const& market_instance,
+	ModifierEffectCache const& modifier_effect_cache
+) {
+	IndexedMap<GoodDefinition, ProductionType const*> const& artisan_production_types =
+		production_type_manager.get_good_to_artisan_production_type();
+	const size_t good_count = artisan_production_types.size();
+
+	artisanal_efficiencies.resize(good_count);
+	artisanal_profitability.resize(good_count);
+	artisanal_cumulative_profitability.resize(good_count);
+	artisanal_best_profitability = fixed_point_t::_0();
+
+	fixed_point_t total_profitability = fixed_point_t::_0();
+
+	for (size_t index = 0; index < good_count; ++index) {
+		ProductionType const* production_type = artisan_production_types[index];
+		fixed_point_t& profitability = artisanal_profitability[index];
+		profitability = fixed_point_t::_0();
+
+		if (
+			production_type != nullptr && capital != nullptr && production_type->get_base_workforce_size() > 0 &&
+			market_instance.is_good_available(production_type->get_output_good())
+		) {
+			GoodDefinition const& output_good = production_type->get_output_good();
+			auto const& good_effects = modifier_effect_cache.get_good_effects()[output_good];
+
+			// The capital's modifier sum is layered on the owner's, so this picks up both national and local effects
+			ArtisanalProducer::efficiency_t& efficiency = artisanal_efficiencies[index];
+			efficiency.throughput = fixed_point_t::_1()
+				+ capital->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_artisan_throughput())
+				+ capital->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_local_artisan_throughput())
+				+ capital->get_modifier_effect_value_nullcheck(good_effects.get_artisan_goods_throughput());
+			efficiency.output = fixed_point_t::_1()
+				+ capital->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_artisan_output())
+				+ capital->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_local_artisan_output())
+				+ capital->get_modifier_effect_value_nullcheck(good_effects.get_artisan_goods_output());
+			efficiency.input = fixed_point_t::_1()
+				+ capital->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_artisan_input())
+				+ capital->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_local_artisan_input())
+				+ capital->get_modifier_effect_value_nullcheck(good_effects.get_artisan_goods_input());
+
+			fixed_point_t margin = production_type->get_base_output_quantity() * efficiency.output
+				* market_instance.get_price(output_good);
+			bool inputs_available = true;
+			for (auto const& [input_good, quantity] : production_type->get_input_goods()) {
+				if (!market_instance.is_good_available(*input_good)) {
+					inputs_available = false;
+					break;
+				}
+				margin -= quantity * efficiency.input * market_instance.get_price(*input_good);
+			}
+
+			if (inputs_available) {
+				profitability = margin * efficiency.throughput / production_type->get_base_workforce_size();
+			}
+		}
+
+		if (profitability > fixed_point_t::_0()) {
+			total_profitability += profitability;
+		}
+		artisanal_cumulative_profitability[index] = total_profitability;
+		artisanal_best_profitability = std::max(artisanal_best_profitability, profitability);
+	}
+}
+
+ProductionType const* State::_pick_artisanal_production_type(
+	ProductionTypeManager const& production_type_manager, uint64_t random
+) const {
+	if (artisanal_cumulative_profitability.empty() || artisanal_cumulative_profitability.back() <= fixed_point_t::_0()) {
+		return nullptr;
+	}
+
+	const fixed_point_t target {
+		static_cast<int64_t>(random % static_cast<uint64_t>(artisanal_cumulative_profitability.back().get_raw_value()))
+	};
+	const size_t index = std::upper_bound(
+		artisanal_cumulative_profitability.begin(), artisanal_cumulative_profitability.end(), target
+	) - artisanal_cumulative_profitability.begin();
+
+	return production_type_manager.get_good_to_artisan_production_type()[index];
+}
+
+/* Artisans keep working on their current production while it stays reasonably profitable, as switching throws away
+ * their stockpile. Those making a loss, or less than half of what the best production would make, switch to a
+ * production picked at random weighted by profitability, so a state's artisans spread over the good options rather
+ * than all piling into the single best one. The pick is seeded by pop handle and date so it's deterministic. */
+void State::_tick_artisans(
+	Date today, ProductionTypeManager const& production_type_manager, MarketInstance& market_instance,
+	ModifierEffectCache const& modifier_effect_cache
+) {
+	_update_artisanal_profitability(production_type_manager, market_instance, modifier_effect_cache);
+
+	const uint64_t day = (today - Date {}).to_int();
+
+	for (PopType const& pop_type : *pops_by_type.get_keys()) {
+		if (!pop_type.get_is_artisan()) {
+			continue;
+		}
+
+		for (Pop* pop : pops_by_type[pop_type]) {
+			ArtisanalProducer* producer = pop->get_artisanal_producer();
+			if (producer == nullptr) {
+				continue;
+			}
+
+			ProductionType const* production_type = producer->get_production_type_nullable();
+			const fixed_point_t profitability = production_type != nullptr
+				? artisanal_profitability[production_type->get_output_good().get_index()] : fixed_point_t::_0();
+
+			if (profitability <= fixed_point_t::_0() || profitability * 2 < artisanal_best_profitability) {
+				production_type = _pick_artisanal_production_type(
+					production_type_manager, utility::mix_bits((day << 32) ^ pop->get_handle())
+				);
+				producer->set_production_type(production_type);
+			}
+
+			if (production_type != nullptr) {
+				producer->tick(*pop, market_instance, artisanal_efficiencies[production_type->get_output_good().get_index()]);
+			}
+		}
+	}
+}
+
+void State::tick(
+	Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager,
+	MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+	ProductionTypeManager const& production_type_manager, EconomyDefines const& economy_defines
+) {
+	if (!factories.empty()) {
+		_hire_factory_workers();
+
+		const ConditionContext context { map_instance, country_instance_manager, today, this, {} };
+		for (FactoryProducer& factory : factories) {
+			factory.tick(*this, market_instance, modifier_effect_cache, economy_defines, context);
+		}
+	}
+
+	_tick_artisans(today, production_type_manager, market_instance, modifier_effect_cache);
+}
+
+void State::after_orders_executed(EconomyDefines const& economy_defines) {
+	for (FactoryProducer& factory : factories) {
+		factory.after_orders_executed(economy_defines);
+	}
+
+	for (PopType const& pop_type : *pops_by_type.get_keys()) {
+		if (pop_type.get_is_artisan()) {
+			for (Pop* pop : pops_by_type[pop_type]) {
+				ArtisanalProducer* producer = pop->get_artisanal_producer();
+				if (producer != nullptr) {
+					producer->after_orders_executed(*pop);
+				}
+			}
+		}
+	}
+}
+
+void State::update_occupation() {
+	occupied_province_count = std::count_if(
+		provinces.begin(), provinces.end(), [this](ProvinceInstance const* province) -> bool {
+			return province->get_controller() != owner;
+		}
+	);
+}
+
 void State::update_gamestate() {
 	total_population = 0;
 	average_literacy = 0;
@@ -61,10 +384,25 @@ void State::update_gamestate() {
 		average_militancy /= total_population;
 	}
 
-	// TODO - use actual values when State has factory data
-	const int32_t total_factory_levels_in_state = 0;
-	const int32_t potential_workforce_in_state = 0; // sum of worker pops, regardless of employment
-	const int32_t potential_employment_in_state = 0; // sum of (factory level * production method base_workforce_size)
+	_update_industrial_power();
+}
+
+void State::_update_industrial_power() {
+	fixed_point_t total_factory_levels_in_state = 0;
+	// sum of (factory level * production method base_workforce_size)
+	Pop::pop_size_t potential_employment_in_state = 0;
+	for (FactoryProducer const& factory : factories) {
+		total_factory_levels_in_state += factory.get_size_multiplier();
+		potential_employment_in_state += factory.get_max_employee_count();
+	}
+
+	// sum of worker pops, regardless of employment
+	Pop::pop_size_t potential_workforce_in_state = 0;
+	for (PopType const& pop_type : *pop_type_distribution.get_keys()) {
+		if (pop_type.get_can_work_factory()) {
+			potential_workforce_in_state += pop_type_distribution[pop_type];
+		}
+	}
 
 	fixed_point_t workforce_scalar;
 	constexpr fixed_point_t min_workforce_scalar = fixed_point_t::_0_20();
@@ -93,12 +431,39 @@ size_t StateSet::get_state_count() const {
 	return states.size();
 }
 
+bool StateSet::initialise_for_new_game() {
+	bool ret = true;
+	for (State& state : states) {
+		ret &= state.initialise_for_new_game();
+	}
+	return ret;
+}
+
 void StateSet::update_gamestate() {
 	for (State& state : states) {
 		state.update_gamestate();
 	}
 }
 
+void StateSet::tick(
+	Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager,
+	MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+	ProductionTypeManager const& production_type_manager, EconomyDefines const& economy_defines
+) {
+	for (State& state : states) {
+		state.tick(
+			today, map_instance, country_instance_manager, market_instance, modifier_effect_cache, production_type_manager,
+			economy_defines
+		);
+	}
+}
+
+void StateSet::after_orders_executed(EconomyDefines const& economy_defines) {
+	for (State& state : states) {
+		state.after_orders_executed(economy_defines);
+	}
+}
+
 bool StateManager::add_state_set(
 	MapInstance& map_instance, Region const& region, decltype(State::pop_type_distribution)::keys_t const& pop_type_keys
 ) {
@@ -156,6 +521,8 @@ bool StateManager::add_state_set(
 			province->set_state(&state);
 		}
 
+		state._rebuild_pops_by_type();
+
 		if (owner != nullptr) {
 			owner->add_state(state);
 		}
@@ -194,8 +561,35 @@ void StateManager::reset() {
 	state_sets.clear();
 }
 
+bool StateManager::initialise_for_new_game() {
+	bool ret = true;
+	for (StateSet& state_set : state_sets) {
+		ret &= state_set.initialise_for_new_game();
+	}
+	return ret;
+}
+
 void StateManager::update_gamestate() {
 	for (StateSet& state_set : state_sets) {
 		state_set.update_gamestate();
 	}
 }
+
+void StateManager::tick(
+	Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager,
+	MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+	ProductionTypeManager const& production_type_manager, EconomyDefines const& economy_defines
+) {
+	for (StateSet& state_set : state_sets) {
+		state_set.tick(
+			today, map_instance, country_instance_manager, market_instance, modifier_effect_cache, production_type_manager,
+			economy_defines
+		);
+	}
+}
+
+void StateManager::after_orders_executed(EconomyDefines const& economy_defines) {
+	for (StateSet& state_set : state_sets) {
+		state_set.after_orders_executed(economy_defines);
+	}
+}
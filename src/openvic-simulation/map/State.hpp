@@ -5,6 +5,8 @@
 
 #include <plf_colony.h>
 
+#include "openvic-simulation/economy/production/ArtisanalProducer.hpp"
+#include "openvic-simulation/economy/production/FactoryProducer.hpp"
 #include "openvic-simulation/map/ProvinceInstance.hpp"
 #include "openvic-simulation/pop/Pop.hpp"
 #include "openvic-simulation/utility/Getters.hpp"
@@ -14,6 +16,11 @@ namespace OpenVic {
 	struct StateSet;
 	struct CountryInstance;
 	struct ProvinceInstance;
+	struct MapInstance;
+	struct CountryInstanceManager;
+	struct MarketInstance;
+	struct EconomyDefines;
+	struct ProductionTypeManager;
 
 	struct State {
 		friend struct StateManager;
@@ -30,10 +37,30 @@ namespace OpenVic {
 		fixed_point_t PROPERTY(average_consciousness);
 		fixed_point_t PROPERTY(average_militancy);
 		IndexedMap<PopType, Pop::pop_size_t> PROPERTY(pop_type_distribution);
+		/* Every pop in the state's provinces, grouped by type. Kept up to date as pops are added, removed or change
+		 * type, so finding e.g. an RGO's owner pops doesn't need a scan over the whole state. */
+		IndexedMap<PopType, std::vector<Pop*>> PROPERTY(pops_by_type);
 
 		fixed_point_t PROPERTY(industrial_power);
 
 		size_t PROPERTY(max_supported_regiments);
+		/* Provinces controlled by someone other than the state's owner, e.g. after a siege. */
+		size_t PROPERTY(occupied_province_count);
+
+		std::vector<FactoryProducer> PROPERTY(factories);
+		/* Hiring scratch space: the workers of each type wanted by all factories, and how many pops of that type there
+		 * are to hire from. */
+		IndexedMap<PopType, Pop::pop_size_t> factory_worker_demand;
+		IndexedMap<PopType, Pop::pop_size_t> factory_worker_supply;
+
+		/* Artisan scratch space, indexed by output good: the efficiency artisans work at and their profit per worker
+		 * at today's prices. Refreshed once a day, so an artisan's choice of production is a lookup rather than a
+		 * search over every artisanal production type. */
+		std::vector<ArtisanalProducer::efficiency_t> artisanal_efficiencies;
+		std::vector<fixed_point_t> artisanal_profitability;
+		/* Running total of the positive entries of artisanal_profitability, for profit-weighted picks. */
+		std::vector<fixed_point_t> artisanal_cumulative_profitability;
+		fixed_point_t artisanal_best_profitability;
 
 		State(
 			StateSet const& new_state_set,
@@ -44,10 +71,44 @@ namespace OpenVic {
 			decltype(pop_type_distribution)::keys_t const& pop_type_keys
 		);
 
+		void _rebuild_pops_by_type();
+		void _update_industrial_power();
+		void _remove_pop_of_type(Pop& pop, PopType const& type);
+		void _hire_factory_workers();
+
+		void _update_artisanal_profitability(
+			ProductionTypeManager const& production_type_manager, MarketInstance const& market_instance,
+			ModifierEffectCache const& modifier_effect_cache
+		);
+		ProductionType const* _pick_artisanal_production_type(
+			ProductionTypeManager const& production_type_manager, uint64_t random
+		) const;
+		void _tick_artisans(
+			Date today, ProductionTypeManager const& production_type_manager, MarketInstance& market_instance,
+			ModifierEffectCache const& modifier_effect_cache
+		);
+
 	public:
 		std::string get_identifier() const;
 
+		void add_pop(Pop& pop);
+		void remove_pop(Pop& pop);
+		void change_pop_type(Pop& pop, PopType const& old_type);
+
+		bool add_factory(ProductionType const& production_type, fixed_point_t size_multiplier);
+		/* Creates a factory for each state building in the history of the state's provinces, at the highest level
+		 * any of them sets for it. */
+		bool initialise_for_new_game();
+
+		/* Recounts occupied provinces, called once per tick for each state whose provinces changed controller. */
+		void update_occupation();
 		void update_gamestate();
+		void tick(
+			Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager,
+			MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+			ProductionTypeManager const& production_type_manager, EconomyDefines const& economy_defines
+		);
+		void after_orders_executed(EconomyDefines const& economy_defines);
 	};
 
 	struct Region;
@@ -66,11 +127,16 @@ namespace OpenVic {
 	public:
 		size_t get_state_count() const;
 
+		bool initialise_for_new_game();
 		void update_gamestate();
+		void tick(
+			Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager,
+			MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+			ProductionTypeManager const& production_type_manager, EconomyDefines const& economy_defines
+		);
+		void after_orders_executed(EconomyDefines const& economy_defines);
 	};
 
-	struct MapInstance;
-
 	/* Contains all current states.*/
 	struct StateManager {
 	private:
@@ -89,6 +155,16 @@ namespace OpenVic {
 
 		void reset();
 
+		bool initialise_for_new_game();
 		void update_gamestate();
+
+		/* Runs every state's factories and artisans as one batch, hiring and placing orders for all factories in a state
+		 * together and choosing every artisan's production from one profitability table per state. */
+		void tick(
+			Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager,
+			MarketInstance& market_instance, ModifierEffectCache const& modifier_effect_cache,
+			ProductionTypeManager const& production_type_manager, EconomyDefines const& economy_defines
+		);
+		void after_orders_executed(EconomyDefines const& economy_defines);
 	};
 }
@@ -0,0 +1,217 @@
+#include "Attrition.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/defines/MilitaryDefines.hpp"
+#include "openvic-simulation/economy/BuildingInstance.hpp"
+#include "openvic-simulation/map/ProvinceDefinition.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/military/LandCombat.hpp"
+#include "openvic-simulation/military/Leader.hpp"
+#include "openvic-simulation/military/Siege.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
+
+using namespace OpenVic;
+
+AttritionEngine::AttritionEngine() : supply_limit_recalculations { 0 } {}
+
+AttritionEngine::supply_inputs_t AttritionEngine::_get_supply_inputs(
+	ProvinceInstance const& province, ModifierEffectCache const& modifier_effect_cache
+) {
+	/* Province modifier sums include their owner's, so the global effects are read from the province too */
+	supply_inputs_t inputs {
+		province.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_supply_limit_local_base()),
+		province.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_supply_limit_global_base()),
+		province.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_supply_limit_global_percentage_change()),
+		fixed_point_t::_0(),
+		province.get_total_population()
+	};
+
+	for (BuildingInstance const& building : province.get_buildings()) {
+		inputs.infrastructure += building.get_building_type().get_infrastructure() * building.get_level();
+	}
+
+	return inputs;
+}
+
+size_t AttritionEngine::_calculate_supply_limit(supply_inputs_t const& inputs) {
+	const fixed_point_t supply_limit = (
+		inputs.local_base + inputs.global_base + fixed_point_t::parse(inputs.population / POPULATION_PER_SUPPLY)
+	) * (fixed_point_t::_1() + inputs.infrastructure) * (fixed_point_t::_1() + inputs.percentage_change);
+
+	return std::max<int64_t>(supply_limit.to_int64_t(), 0);
+}
+
+size_t AttritionEngine::get_supply_limit(ProvinceInstance const& province, ModifierEffectCache const& modifier_effect_cache) {
+	const size_t index = province.get_province_definition().get_index() - 1;
+	if (index >= supply_entries.size()) {
+		supply_entries.resize(index + 1, { 0, 0, 0, 0, false });
+	}
+
+	supply_entry_t& entry = supply_entries[index];
+	const uint64_t modifier_generation = province.get_modifier_sum().get_generation();
+
+	if (
+		!entry.valid || entry.modifier_generation != modifier_generation
+			|| entry.buildings_version != province.get_buildings_version()
+			|| entry.population != province.get_total_population()
+	) {
+		entry.modifier_generation = modifier_generation;
+		entry.buildings_version = province.get_buildings_version();
+		entry.population = province.get_total_population();
+		entry.supply_limit = _calculate_supply_limit(_get_supply_inputs(province, modifier_effect_cache));
+		entry.valid = true;
+		supply_limit_recalculations++;
+	}
+
+	return entry.supply_limit;
+}
+
+size_t AttritionEngine::regiment_count_key_hash_t::operator()(regiment_count_key_t const& key) const {
+	size_t hash = 0;
+	utility::hash_combine(hash, key.province);
+	utility::hash_combine(hash, key.country);
+	return hash;
+}
+
+fixed_point_t AttritionEngine::_get_attrition(
+	ArmyInstance const& army, ProvinceInstance const& province, size_t regiment_count, SiegeEngine const& siege_engine,
+	ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+) {
+	CountryInstance const* country = army.get_country();
+	fixed_point_t attrition = 0;
+
+	const size_t supply_limit = get_supply_limit(province, modifier_effect_cache);
+	if (regiment_count > supply_limit) {
+		const fixed_point_t oversupply = fixed_point_t::parse(static_cast<int64_t>(regiment_count - supply_limit))
+			/ fixed_point_t::parse(static_cast<int64_t>(std::max<size_t>(supply_limit, 1)));
+
+		attrition += oversupply * OVERSUPPLY_ATTRITION
+			+ province.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_attrition_local());
+	}
+
+	const auto siege = siege_engine.get_sieges().find(&province);
+	if (siege != siege_engine.get_sieges().end() && siege->second.get_besieger() == country) {
+		attrition += military_defines.get_siege_attrition();
+	}
+
+	const fixed_point_t max_attrition =
+		province.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_max_attrition());
+	if (max_attrition > 0) {
+		attrition = std::min(attrition, max_attrition);
+	}
+
+	return std::max(attrition, fixed_point_t::_0());
+}
+
+void AttritionEngine::_apply_attrition(
+	ArmyInstance const& army, fixed_point_t attrition, ModifierEffectCache const& modifier_effect_cache
+) {
+	CountryInstance const* country = army.get_country();
+
+	if (country != nullptr) {
+		attrition *= fixed_point_t::_1()
+			+ country->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_land_attrition());
+	}
+
+	LeaderBranched<UnitType::branch_t::LAND> const* leader = army.get_leader();
+	if (leader != nullptr) {
+		fixed_point_t leader_attrition = 0;
+		if (leader->get_personality() != nullptr) {
+			leader_attrition += leader->get_personality()->get_effect_nullcheck(modifier_effect_cache.get_attrition_leader());
+		}
+		if (leader->get_background() != nullptr) {
+			leader_attrition += leader->get_background()->get_effect_nullcheck(modifier_effect_cache.get_attrition_leader());
+		}
+		attrition *= fixed_point_t::_1() - leader_attrition;
+	}
+
+	if (attrition <= 0) {
+		return;
+	}
+
+	const fixed_point_t daily_fraction = attrition / (fixed_point_t::_100() * DAYS_PER_MONTH);
+
+	for (RegimentInstance* regiment : army.get_units()) {
+		const fixed_point_t max_strength = regiment->get_unit_type().get_max_strength();
+
+		regiment->set_strength(std::max(regiment->get_strength() - max_strength * daily_fraction, fixed_point_t::_0()));
+		regiment->set_organisation(std::max(
+			regiment->get_organisation()
+				- LandCombatEngine::get_max_organisation(*regiment, country, modifier_effect_cache) * daily_fraction,
+			fixed_point_t::_0()
+		));
+	}
+}
+
+void AttritionEngine::_reinforce(
+	ArmyInstance const& army, ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+) {
+	CountryInstance const* country = army.get_country();
+
+	fixed_point_t reinforce_speed = military_defines.get_reinforce_speed();
+	if (country != nullptr) {
+		reinforce_speed *= fixed_point_t::_1()
+			+ country->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_reinforce_speed());
+	}
+
+	for (RegimentInstance* regiment : army.get_units()) {
+		const fixed_point_t max_strength = regiment->get_unit_type().get_max_strength();
+		if (regiment->get_strength() < max_strength) {
+			regiment->set_strength(std::min(
+				regiment->get_strength() + max_strength * reinforce_speed / DAYS_PER_MONTH, max_strength
+			));
+		}
+
+		const fixed_point_t max_organisation =
+			LandCombatEngine::get_max_organisation(*regiment, country, modifier_effect_cache);
+		if (regiment->get_organisation() < max_organisation) {
+			regiment->set_organisation(std::min(
+				regiment->get_organisation() + max_organisation / DAYS_PER_MONTH, max_organisation
+			));
+		}
+	}
+}
+
+void AttritionEngine::tick(
+	UnitInstanceManager const& unit_instance_manager, SiegeEngine const& siege_engine,
+	ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+) {
+	/* Counted once up front, as all of a country's regiments in a province draw on the same supply */
+	regiment_counts.clear();
+	for (ArmyInstance const& army : unit_instance_manager.get_armies()) {
+		ProvinceInstance const* position = army.get_position();
+		if (position == nullptr || position->get_province_definition().is_water()) {
+			continue;
+		}
+
+		size_t& regiment_count = regiment_counts[{ position, army.get_country() }];
+		for (RegimentInstance const* regiment : army.get_units()) {
+			if (regiment->get_strength() > 0) {
+				regiment_count++;
+			}
+		}
+	}
+
+	for (ArmyInstance const& army : unit_instance_manager.get_armies()) {
+		ProvinceInstance const* position = army.get_position();
+		if (position == nullptr) {
+			continue;
+		}
+
+		const fixed_point_t attrition = position->get_province_definition().is_water()
+			? fixed_point_t::_0()
+			: _get_attrition(
+				army, *position, regiment_counts[{ position, army.get_country() }], siege_engine, modifier_effect_cache,
+				military_defines
+			);
+
+		if (attrition > 0) {
+			_apply_attrition(army, attrition, modifier_effect_cache);
+		} else if (!army.is_in_combat()) {
+			_reinforce(army, modifier_effect_cache, military_defines);
+		}
+	}
+}
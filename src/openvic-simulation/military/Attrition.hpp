@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "openvic-simulation/military/UnitInstanceGroup.hpp"
+#include "openvic-simulation/pop/Pop.hpp"
+#include "openvic-simulation/types/OrderedContainers.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+
+namespace OpenVic {
+	struct CountryInstance;
+	struct ModifierEffectCache;
+	struct MilitaryDefines;
+	struct SiegeEngine;
+
+	/* Daily supply, attrition and reinforcement of armies.
+	 *
+	 * A province supports as many regiments as its supply limit: the supply limit modifiers of the province and its
+	 * owner, plus a share of its population, raised by its infrastructure buildings. Limits are cached per province and
+	 * only recalculated when one of those inputs has changed since they were last asked for. A country's regiments
+	 * beyond the limit of the province they're in suffer attrition, as do besiegers, losing strength and organisation.
+	 * Armies out of combat reinforce and recover organisation. Regiments aren't yet bound to the pops they're raised
+	 * from, so losses aren't taken from pops and reinforcement isn't limited by the regiments pops can support. */
+	struct AttritionEngine {
+	private:
+		/* Each this many people in a province supply one more regiment. */
+		static constexpr Pop::pop_size_t POPULATION_PER_SUPPLY = 20000;
+		/* Monthly attrition, in percent, for every 100% a province's supply limit is exceeded by. */
+		static constexpr int32_t OVERSUPPLY_ATTRITION = 10;
+		static constexpr int32_t DAYS_PER_MONTH = 30;
+
+		struct supply_inputs_t {
+			fixed_point_t local_base;
+			fixed_point_t global_base;
+			fixed_point_t percentage_change;
+			fixed_point_t infrastructure;
+			Pop::pop_size_t population;
+		};
+
+		/* A limit is reused for as long as the province's modifier sum generation (which follows its owner's too),
+		 * buildings version and population stay the same, without gathering its inputs again. */
+		struct supply_entry_t {
+			uint64_t modifier_generation;
+			uint32_t buildings_version;
+			Pop::pop_size_t population;
+			size_t supply_limit;
+			bool valid;
+		};
+
+		struct regiment_count_key_t {
+			ProvinceInstance const* province;
+			CountryInstance const* country;
+
+			bool operator==(regiment_count_key_t const&) const = default;
+		};
+
+		struct regiment_count_key_hash_t {
+			size_t operator()(regiment_count_key_t const& key) const;
+		};
+
+		/* Indexed by province instance index. */
+		std::vector<supply_entry_t> supply_entries;
+		size_t PROPERTY(supply_limit_recalculations);
+
+		/* Scratch, rebuilt each day: each country's regiments with strength left in each land province. */
+		ordered_map<regiment_count_key_t, size_t, regiment_count_key_hash_t> regiment_counts;
+
+		static supply_inputs_t _get_supply_inputs(
+			ProvinceInstance const& province, ModifierEffectCache const& modifier_effect_cache
+		);
+		static size_t _calculate_supply_limit(supply_inputs_t const& inputs);
+
+		/* Monthly attrition in percent for the army, before its country's and leader's modifiers. regiment_count is the
+		 * number of the army's country's regiments in the province, which all draw on the same supply. */
+		fixed_point_t _get_attrition(
+			ArmyInstance const& army, ProvinceInstance const& province, size_t regiment_count,
+			SiegeEngine const& siege_engine, ModifierEffectCache const& modifier_effect_cache,
+			MilitaryDefines const& military_defines
+		);
+		static void _apply_attrition(
+			ArmyInstance const& army, fixed_point_t attrition, ModifierEffectCache const& modifier_effect_cache
+		);
+		static void _reinforce(
+			ArmyInstance const& army, ModifierEffectCache const& modifier_effect_cache,
+			MilitaryDefines const& military_defines
+		);
+
+	public:
+		AttritionEngine();
+
+		/* The number of regiments the province can supply, recalculated only if its modifiers, buildings or population
+		 * have changed. */
+		size_t get_supply_limit(ProvinceInstance const& province, ModifierEffectCache const& modifier_effect_cache);
+
+		void tick(
+			UnitInstanceManager const& unit_instance_manager, SiegeEngine const& siege_engine,
+			ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+		);
+	};
+}
@@ -0,0 +1,457 @@
+#include "LandCombat.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/defines/MilitaryDefines.hpp"
+#include "openvic-simulation/map/MapInstance.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/map/TerrainType.hpp"
+#include "openvic-simulation/military/Leader.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
+
+using namespace OpenVic;
+
+using side_t = LandBattle::side_t;
+
+LandBattle::LandBattle(
+	ProvinceInstance& new_province, CountryInstance const& new_attacker_country,
+	CountryInstance const& new_defender_country, Date new_start_date
+) : province { &new_province },
+	attacker_country { &new_attacker_country },
+	defender_country { &new_defender_country },
+	attacker_armies {},
+	defender_armies {},
+	start_date { new_start_date },
+	days { 0 },
+	combat_width { 1 },
+	attacker_losses { 0 },
+	defender_losses { 0 },
+	attacker_roll { 0 },
+	defender_roll { 0 } {}
+
+std::vector<ArmyInstance*>& LandBattle::_get_armies(side_t side) {
+	return side == side_t::ATTACKER ? attacker_armies : defender_armies;
+}
+
+std::vector<ArmyInstance*> const& LandBattle::get_armies(side_t side) const {
+	return side == side_t::ATTACKER ? attacker_armies : defender_armies;
+}
+
+fixed_point_t LandBattle::get_losses(side_t side) const {
+	return side == side_t::ATTACKER ? attacker_losses : defender_losses;
+}
+
+LandCombatEngine::LandCombatEngine() {}
+
+LandBattle* LandCombatEngine::_get_battle(ProvinceInstance const& province) {
+	for (LandBattle& battle : battles) {
+		if (battle.province == &province) {
+			return &battle;
+		}
+	}
+	return nullptr;
+}
+
+bool LandCombatEngine::_join_battle(LandBattle& battle, ArmyInstance& army) {
+	CountryInstance const* country = army.get_country();
+	if (country == nullptr || army.is_in_combat()) {
+		return false;
+	}
+
+	side_t side;
+	if (country == battle.attacker_country || country->is_at_war_with(*battle.defender_country)) {
+		side = side_t::ATTACKER;
+	} else if (country == battle.defender_country || country->is_at_war_with(*battle.attacker_country)) {
+		side = side_t::DEFENDER;
+	} else {
+		return false;
+	}
+
+	battle._get_armies(side).push_back(&army);
+	army.in_combat = true;
+	army.get_movement_info().clear();
+	return true;
+}
+
+void LandCombatEngine::_start_battles(Date today, UnitInstanceManager const& unit_instance_manager) {
+	for (UnitInstanceManager::encounter_t const& encounter : unit_instance_manager.get_encounters()) {
+		if (encounter.branch != UnitType::branch_t::LAND) {
+			continue;
+		}
+
+		ProvinceInstance& province = *encounter.province;
+		ordered_set<ArmyInstance*> const& armies = province.get_armies();
+
+		LandBattle* battle = _get_battle(province);
+
+		if (battle == nullptr) {
+			/* The controller defends if it has an army here, otherwise whoever has been here longest does */
+			CountryInstance const* defender = nullptr;
+			for (ArmyInstance const* army : armies) {
+				if (army->get_country() != nullptr && army->get_country() == province.get_controller()) {
+					defender = army->get_country();
+					break;
+				}
+			}
+			if (defender == nullptr) {
+				for (ArmyInstance const* army : armies) {
+					if (army->get_country() != nullptr) {
+						defender = army->get_country();
+						break;
+					}
+				}
+			}
+			if (defender == nullptr) {
+				continue;
+			}
+
+			CountryInstance const* attacker = nullptr;
+			for (ArmyInstance const* army : armies) {
+				CountryInstance const* country = army->get_country();
+				if (country != nullptr && !army->is_in_combat() && country->is_at_war_with(*defender)) {
+					attacker = country;
+					break;
+				}
+			}
+			if (attacker == nullptr) {
+				continue;
+			}
+
+			battle = &battles.emplace_back(province, *attacker, *defender, today);
+		}
+
+		for (ArmyInstance* army : armies) {
+			_join_battle(*battle, *army);
+		}
+	}
+}
+
+fixed_point_t LandCombatEngine::_get_leader_effect(std::vector<ArmyInstance*> const& armies, ModifierEffect const* effect) {
+	/* Only the best leader on a side commands it */
+	fixed_point_t best_effect = 0;
+
+	for (ArmyInstance const* army : armies) {
+		LeaderBranched<UnitType::branch_t::LAND> const* leader = army->get_leader();
+		if (leader == nullptr) {
+			continue;
+		}
+
+		fixed_point_t leader_effect = 0;
+		if (leader->get_personality() != nullptr) {
+			leader_effect += leader->get_personality()->get_effect_nullcheck(effect);
+		}
+		if (leader->get_background() != nullptr) {
+			leader_effect += leader->get_background()->get_effect_nullcheck(effect);
+		}
+		best_effect = std::max(best_effect, leader_effect);
+	}
+
+	return best_effect;
+}
+
+fixed_point_t LandCombatEngine::get_max_organisation(
+	RegimentInstance const& regiment, CountryInstance const* country, ModifierEffectCache const& modifier_effect_cache
+) {
+	RegimentType const& regiment_type = regiment.get_unit_type();
+	fixed_point_t max_organisation = regiment_type.get_default_organisation();
+
+	if (country != nullptr) {
+		max_organisation += country->get_modifier_effect_value_nullcheck(
+			modifier_effect_cache.get_army_base_effects().get_default_organisation()
+		) + country->get_modifier_effect_value_nullcheck(
+			modifier_effect_cache.get_regiment_type_effects()[regiment_type].get_default_organisation()
+		);
+		max_organisation *= fixed_point_t::_1()
+			+ country->get_modifier_effect_value_nullcheck(modifier_effect_cache.get_land_organisation());
+	}
+
+	return std::max(max_organisation, fixed_point_t::_0());
+}
+
+LandCombatEngine::combatant_t LandCombatEngine::_make_combatant(
+	RegimentInstance& regiment, CountryInstance const* country, ProvinceInstance const& province,
+	ModifierEffectCache const& modifier_effect_cache
+) {
+	RegimentType const& regiment_type = regiment.get_unit_type();
+
+	combatant_t combatant {
+		&regiment,
+		regiment_type.get_attack(),
+		regiment_type.get_defence(),
+		regiment_type.get_discipline(),
+		regiment_type.get_support(),
+		get_max_organisation(regiment, country, modifier_effect_cache),
+		fixed_point_t::_0(),
+		fixed_point_t::_0()
+	};
+
+	if (country != nullptr) {
+		ModifierEffectCache::regiment_type_effects_t const& base_effects = modifier_effect_cache.get_army_base_effects();
+		ModifierEffectCache::regiment_type_effects_t const& type_effects =
+			modifier_effect_cache.get_regiment_type_effects()[regiment_type];
+
+		combatant.attack += country->get_modifier_effect_value_nullcheck(base_effects.get_attack())
+			+ country->get_modifier_effect_value_nullcheck(type_effects.get_attack());
+		combatant.defence += country->get_modifier_effect_value_nullcheck(base_effects.get_defence())
+			+ country->get_modifier_effect_value_nullcheck(type_effects.get_defence());
+		combatant.discipline += country->get_modifier_effect_value_nullcheck(base_effects.get_discipline())
+			+ country->get_modifier_effect_value_nullcheck(type_effects.get_discipline());
+		combatant.support += country->get_modifier_effect_value_nullcheck(base_effects.get_support())
+			+ country->get_modifier_effect_value_nullcheck(type_effects.get_support());
+	}
+
+	TerrainType const* terrain_type = province.get_terrain_type();
+	if (terrain_type != nullptr) {
+		const UnitType::terrain_modifiers_t::const_iterator it = regiment_type.get_terrain_modifiers().find(terrain_type);
+		if (it != regiment_type.get_terrain_modifiers().end()) {
+			ModifierEffectCache::unit_terrain_effects_t const& terrain_effects =
+				modifier_effect_cache.get_unit_terrain_effects()[*terrain_type];
+
+			combatant.attack += it->second.get_effect_nullcheck(terrain_effects.get_attack());
+			combatant.defence += it->second.get_effect_nullcheck(terrain_effects.get_defence());
+		}
+	}
+
+	combatant.attack = std::max(combatant.attack, fixed_point_t::_0());
+	combatant.defence = std::max(combatant.defence, fixed_point_t::_0());
+	combatant.discipline = std::max(combatant.discipline, fixed_point_t::_0());
+	combatant.support = std::max(combatant.support, fixed_point_t::_0());
+
+	return combatant;
+}
+
+void LandCombatEngine::_lay_out_side(
+	LandBattle const& battle, side_t side, ModifierEffectCache const& modifier_effect_cache
+) {
+	side_layout_t& layout = side_layouts.emplace_back(side_layout_t {
+		static_cast<uint32_t>(combatants.size()), 0, 0, 0
+	});
+
+	/* Fighting regiments go straight into the array, support regiments wait for the back row */
+	back_row_scratch.clear();
+
+	for (ArmyInstance* army : battle.get_armies(side)) {
+		for (RegimentInstance* regiment : army->get_units()) {
+			if (regiment->get_strength() <= 0 || regiment->get_organisation() <= 0) {
+				continue;
+			}
+
+			combatant_t combatant = _make_combatant(*regiment, army->get_country(), *battle.province, modifier_effect_cache);
+
+			if (regiment->get_unit_type().get_unit_category() == UnitType::unit_category_t::SUPPORT) {
+				back_row_scratch.push_back(combatant);
+			} else {
+				combatants.push_back(combatant);
+			}
+		}
+	}
+
+	const std::vector<combatant_t>::iterator front_begin = combatants.begin() + layout.front_begin;
+	const auto stronger = [](combatant_t const& lhs, combatant_t const& rhs) -> bool {
+		return lhs.regiment->get_strength() > rhs.regiment->get_strength();
+	};
+
+	/* Stable sorts keep army and regiment order between equals, so the rows never depend on addresses */
+	std::stable_sort(front_begin, combatants.end(), stronger);
+	std::stable_sort(back_row_scratch.begin(), back_row_scratch.end(), stronger);
+
+	const size_t fighting_count = combatants.size() - layout.front_begin;
+	const size_t width = battle.combat_width;
+
+	if (fighting_count > width) {
+		combatants.resize(layout.front_begin + width);
+	}
+
+	/* Support regiments only fill the front row when there aren't enough fighting ones */
+	std::vector<combatant_t>::const_iterator support_it = back_row_scratch.begin();
+	while (combatants.size() - layout.front_begin < width && support_it != back_row_scratch.end()) {
+		combatants.push_back(*support_it++);
+	}
+	layout.front_count = combatants.size() - layout.front_begin;
+
+	while (combatants.size() - layout.front_begin - layout.front_count < width && support_it != back_row_scratch.end()) {
+		combatants.push_back(*support_it++);
+	}
+	layout.back_count = combatants.size() - layout.front_begin - layout.front_count;
+}
+
+void LandCombatEngine::_deal_damage(side_layout_t const& attacker, side_layout_t const& target) {
+	if (attacker.front_count == 0 || target.front_count == 0) {
+		return;
+	}
+
+	combatant_t const* attackers = combatants.data() + attacker.front_begin;
+	combatant_t const* back_row = attackers + attacker.front_count;
+	combatant_t* targets = combatants.data() + target.front_begin;
+
+	const fixed_point_t roll_factor = (attacker.roll + fixed_point_t::_1()) / DIE_SIDES;
+
+	for (uint32_t index = 0; index < attacker.front_count; ++index) {
+		combatant_t const& combatant = attackers[index];
+		combatant_t& target_combatant = targets[index % target.front_count];
+
+		/* Each back row regiment supports the front row regiment in its slot */
+		fixed_point_t attack = combatant.attack;
+		if (index < attacker.back_count) {
+			attack += back_row[index].attack * back_row[index].support;
+		}
+
+		const fixed_point_t damage = attack * roll_factor * combatant.discipline
+			/ std::max(target_combatant.defence, fixed_point_t::_1());
+
+		target_combatant.strength_damage += damage * STRENGTH_DAMAGE_FACTOR;
+		target_combatant.organisation_damage += damage * ORGANISATION_DAMAGE_FACTOR;
+	}
+}
+
+fixed_point_t LandCombatEngine::_apply_damage(side_layout_t const& side) {
+	fixed_point_t total_strength_lost = 0;
+
+	const std::span<combatant_t> front_row { combatants.data() + side.front_begin, side.front_count };
+
+	for (combatant_t const& combatant : front_row) {
+		RegimentInstance& regiment = *combatant.regiment;
+
+		const fixed_point_t old_strength = regiment.get_strength();
+		const fixed_point_t new_strength = std::max(old_strength - combatant.strength_damage, fixed_point_t::_0());
+		regiment.set_strength(new_strength);
+		regiment.set_organisation(
+			std::max(regiment.get_organisation() - combatant.organisation_damage, fixed_point_t::_0())
+		);
+
+		total_strength_lost += old_strength - new_strength;
+	}
+
+	return total_strength_lost;
+}
+
+bool LandCombatEngine::_is_defeated(std::vector<ArmyInstance*> const& armies) {
+	for (ArmyInstance const* army : armies) {
+		for (RegimentInstance const* regiment : army->get_units()) {
+			if (regiment->get_strength() > 0 && regiment->get_organisation() > 0) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void LandCombatEngine::_end_battle(LandBattle& battle, MapInstance& map_instance) {
+	const bool attacker_defeated = _is_defeated(battle.attacker_armies);
+	const bool defender_defeated = _is_defeated(battle.defender_armies);
+
+	for (side_t side : { side_t::ATTACKER, side_t::DEFENDER }) {
+		const bool defeated = side == side_t::ATTACKER ? attacker_defeated : defender_defeated;
+
+		for (ArmyInstance* army : battle._get_armies(side)) {
+			army->in_combat = false;
+
+			if (!defeated) {
+				continue;
+			}
+
+			CountryInstance const* country = army->get_country();
+			ProvinceInstance const* capital = country != nullptr ? country->get_capital() : nullptr;
+			if (capital == nullptr || capital == battle.province) {
+				continue;
+			}
+
+			if (!army->set_movement_target(map_instance, *capital)) {
+				Logger::warning(
+					"Defeated army ", army->get_name(), " has no path from ", *battle.province, " to its capital ", *capital
+				);
+			}
+		}
+	}
+}
+
+void LandCombatEngine::tick(
+	Date today, MapInstance& map_instance, UnitInstanceManager const& unit_instance_manager,
+	ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+) {
+	_start_battles(today, unit_instance_manager);
+
+	combatants.clear();
+	side_layouts.clear();
+
+	const uint64_t day = (today - Date {}).to_int();
+
+	for (LandBattle& battle : battles) {
+		ProvinceInstance const& province = *battle.province;
+
+		/* Width is set by the wider side's tactics and narrowed or widened by the terrain */
+		int64_t width_additive = 0;
+		for (side_t side : { side_t::ATTACKER, side_t::DEFENDER }) {
+			for (ArmyInstance const* army : battle.get_armies(side)) {
+				if (army->get_country() != nullptr) {
+					width_additive = std::max(
+						width_additive,
+						army->get_country()->get_modifier_effect_value_nullcheck(
+							modifier_effect_cache.get_combat_width_additive()
+						).to_int64_t()
+					);
+				}
+			}
+		}
+		const fixed_point_t width = fixed_point_t::parse(
+			static_cast<int64_t>(military_defines.get_base_combat_width()) + width_additive
+		) * (
+			fixed_point_t::_1()
+				+ province.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_combat_width_percentage_change())
+		);
+		battle.combat_width = std::max<int64_t>(width.to_int64_t(), 1);
+
+		const uint64_t seed = utility::mix_bits(
+			(day << 32) ^ (static_cast<uint64_t>(province.get_province_definition().get_index()) << 16) ^ battle.days
+		);
+		battle.attacker_roll = seed % DIE_SIDES;
+		battle.defender_roll = (seed >> 32) % DIE_SIDES;
+
+		_lay_out_side(battle, side_t::ATTACKER, modifier_effect_cache);
+		_lay_out_side(battle, side_t::DEFENDER, modifier_effect_cache);
+
+		side_layout_t& attacker_layout = side_layouts[side_layouts.size() - 2];
+		side_layout_t& defender_layout = side_layouts.back();
+
+		const fixed_point_t attacker_leader_attack =
+			_get_leader_effect(battle.attacker_armies, modifier_effect_cache.get_attack_leader());
+		const fixed_point_t attacker_leader_defence =
+			_get_leader_effect(battle.attacker_armies, modifier_effect_cache.get_defence_leader());
+		const fixed_point_t defender_leader_attack =
+			_get_leader_effect(battle.defender_armies, modifier_effect_cache.get_attack_leader());
+		const fixed_point_t defender_leader_defence =
+			_get_leader_effect(battle.defender_armies, modifier_effect_cache.get_defence_leader());
+
+		attacker_layout.roll = std::max(
+			fixed_point_t::parse(battle.attacker_roll) + attacker_leader_attack - defender_leader_defence, fixed_point_t::_0()
+		);
+		defender_layout.roll = std::max(
+			fixed_point_t::parse(battle.defender_roll) + defender_leader_attack - attacker_leader_defence, fixed_point_t::_0()
+		);
+	}
+
+	/* Both sides strike before any damage is applied, so neither gets the first blow */
+	for (size_t index = 0; index < battles.size(); ++index) {
+		_deal_damage(side_layouts[2 * index], side_layouts[2 * index + 1]);
+		_deal_damage(side_layouts[2 * index + 1], side_layouts[2 * index]);
+	}
+
+	for (size_t index = 0; index < battles.size(); ++index) {
+		LandBattle& battle = battles[index];
+
+		battle.attacker_losses += _apply_damage(side_layouts[2 * index]);
+		battle.defender_losses += _apply_damage(side_layouts[2 * index + 1]);
+		battle.days++;
+
+		if (_is_defeated(battle.attacker_armies) || _is_defeated(battle.defender_armies)) {
+			_end_battle(battle, map_instance);
+		}
+	}
+
+	std::erase_if(battles, [](LandBattle const& battle) -> bool {
+		return _is_defeated(battle.attacker_armies) || _is_defeated(battle.defender_armies);
+	});
+}
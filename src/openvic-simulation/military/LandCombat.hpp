@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "openvic-simulation/military/UnitInstanceGroup.hpp"
+#include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct MapInstance;
+	struct ModifierEffectCache;
+	struct ModifierEffect;
+	struct MilitaryDefines;
+
+	/* An ongoing land battle in one province, between the armies of the attacking and defending countries. */
+	struct LandBattle {
+		friend struct LandCombatEngine;
+
+		enum struct side_t : uint8_t { ATTACKER, DEFENDER };
+
+	private:
+		ProvinceInstance* PROPERTY(province);
+		CountryInstance const* PROPERTY(attacker_country);
+		CountryInstance const* PROPERTY(defender_country);
+		std::vector<ArmyInstance*> PROPERTY(attacker_armies);
+		std::vector<ArmyInstance*> PROPERTY(defender_armies);
+		Date PROPERTY(start_date);
+		uint32_t PROPERTY(days);
+		size_t PROPERTY(combat_width);
+
+		/* Strength lost by each side over the whole battle. */
+		fixed_point_t PROPERTY(attacker_losses);
+		fixed_point_t PROPERTY(defender_losses);
+		/* The last day's dice, before leader bonuses. */
+		uint32_t PROPERTY(attacker_roll);
+		uint32_t PROPERTY(defender_roll);
+
+		std::vector<ArmyInstance*>& _get_armies(side_t side);
+
+	public:
+		LandBattle(
+			ProvinceInstance& new_province, CountryInstance const& new_attacker_country,
+			CountryInstance const& new_defender_country, Date new_start_date
+		);
+		LandBattle(LandBattle&&) = default;
+		LandBattle& operator=(LandBattle&&) = default;
+
+		std::vector<ArmyInstance*> const& get_armies(side_t side) const;
+		fixed_point_t get_losses(side_t side) const;
+	};
+
+	/* Fights every land battle once a day, after movement.
+	 *
+	 * Battles start where the day's movement left armies of countries at war in the same province. Each day every
+	 * battle's regiments are laid out in one contiguous array, each side as a front row of up to the combat width's
+	 * fighting regiments followed by a back row of up to as many support regiments, so that the damage pass is a
+	 * straight walk over memory. Each side rolls a die seeded from the date, province and day of battle, so the same
+	 * game always fights out the same way. A side with no regiment left with both strength and organisation loses,
+	 * its armies retreating towards their capital. */
+	struct LandCombatEngine {
+	private:
+		struct combatant_t {
+			RegimentInstance* regiment;
+			fixed_point_t attack;
+			fixed_point_t defence;
+			fixed_point_t discipline;
+			fixed_point_t support;
+			fixed_point_t max_organisation;
+			fixed_point_t strength_damage;
+			fixed_point_t organisation_damage;
+		};
+
+		/* Where a side's rows lie in combatants, its back row directly following its front row. */
+		struct side_layout_t {
+			uint32_t front_begin;
+			uint32_t front_count;
+			uint32_t back_count;
+			/* The die roll plus the leaders' attack and defence difference, kept fractional as leader effects can be. */
+			fixed_point_t roll;
+		};
+
+		/* Fractions of a regiment's attack dealt as strength and organisation damage on a roll of 9. */
+		static constexpr fixed_point_t STRENGTH_DAMAGE_FACTOR = fixed_point_t::_1() / 20;
+		static constexpr fixed_point_t ORGANISATION_DAMAGE_FACTOR = fixed_point_t::_2();
+		static constexpr int32_t DIE_SIDES = 10;
+
+		std::vector<LandBattle> PROPERTY(battles);
+
+		/* Rebuilt each day, two layouts per battle in battle order. */
+		std::vector<combatant_t> combatants;
+		std::vector<side_layout_t> side_layouts;
+		std::vector<combatant_t> back_row_scratch;
+
+		LandBattle* _get_battle(ProvinceInstance const& province);
+		static bool _join_battle(LandBattle& battle, ArmyInstance& army);
+		void _start_battles(Date today, UnitInstanceManager const& unit_instance_manager);
+
+		static fixed_point_t _get_leader_effect(
+			std::vector<ArmyInstance*> const& armies, ModifierEffect const* effect
+		);
+		static combatant_t _make_combatant(
+			RegimentInstance& regiment, CountryInstance const* country, ProvinceInstance const& province,
+			ModifierEffectCache const& modifier_effect_cache
+		);
+
+		void _lay_out_side(
+			LandBattle const& battle, LandBattle::side_t side, ModifierEffectCache const& modifier_effect_cache
+		);
+		void _deal_damage(side_layout_t const& attacker, side_layout_t const& target);
+		/* Returns the strength lost by the side. */
+		fixed_point_t _apply_damage(side_layout_t const& side);
+		static bool _is_defeated(std::vector<ArmyInstance*> const& armies);
+		void _end_battle(LandBattle& battle, MapInstance& map_instance);
+
+	public:
+		LandCombatEngine();
+
+		/* The organisation a regiment has when fully recovered, with its country's modifiers. */
+		static fixed_point_t get_max_organisation(
+			RegimentInstance const& regiment, CountryInstance const* country, ModifierEffectCache const& modifier_effect_cache
+		);
+
+		void tick(
+			Date today, MapInstance& map_instance, UnitInstanceManager const& unit_instance_manager,
+			ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+		);
+	};
+}
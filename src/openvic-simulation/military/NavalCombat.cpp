@@ -0,0 +1,429 @@
+#include "NavalCombat.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/defines/MilitaryDefines.hpp"
+#include "openvic-simulation/map/MapInstance.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
+#include "openvic-simulation/utility/ThreadPool.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
+
+using namespace OpenVic;
+
+using side_t = NavalBattle::side_t;
+using ship_state_t = NavalBattle::ship_state_t;
+
+NavalBattle::NavalBattle(
+	ProvinceInstance& new_province, CountryInstance const& new_attacker_country,
+	CountryInstance const& new_defender_country, Date new_start_date
+) : province { &new_province },
+	attacker_country { &new_attacker_country },
+	defender_country { &new_defender_country },
+	attacker_navies {},
+	defender_navies {},
+	start_date { new_start_date },
+	days { 0 },
+	attacker_losses { 0 },
+	defender_losses { 0 },
+	random_state {
+		(static_cast<uint64_t>((new_start_date - Date {}).to_int()) << 32)
+			^ new_province.get_province_definition().get_index()
+	} {}
+
+std::vector<NavyInstance*>& NavalBattle::_get_navies(side_t side) {
+	return side == side_t::ATTACKER ? attacker_navies : defender_navies;
+}
+
+std::vector<NavyInstance*> const& NavalBattle::get_navies(side_t side) const {
+	return side == side_t::ATTACKER ? attacker_navies : defender_navies;
+}
+
+fixed_point_t NavalBattle::get_losses(side_t side) const {
+	return side == side_t::ATTACKER ? attacker_losses : defender_losses;
+}
+
+size_t NavalBattle::get_ship_count() const {
+	return ships.size();
+}
+
+uint64_t NavalBattle::_next_random() {
+	/* SplitMix64, stepping the state by the same constant the mixer adds */
+	const uint64_t value = utility::mix_bits(random_state);
+	random_state += 0x9E3779B97F4A7C15;
+	return value;
+}
+
+fixed_point_t NavalBattle::_next_chance() {
+	return fixed_point_t::parse_raw(static_cast<int64_t>(_next_random() >> (64 - fixed_point_t::PRECISION)));
+}
+
+bool NavalBattle::_is_active(uint32_t row) const {
+	return ship_states[row] == ship_state_t::ENGAGED || ship_states[row] == ship_state_t::RETREATING;
+}
+
+bool NavalBattle::_has_engaged_ships(side_t side) const {
+	for (size_t row = 0; row < ships.size(); ++row) {
+		if (sides[row] == side && ship_states[row] == ship_state_t::ENGAGED) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool NavalBattle::is_over() const {
+	return !_has_engaged_ships(side_t::ATTACKER) || !_has_engaged_ships(side_t::DEFENDER);
+}
+
+void NavalBattle::_add_ships(NavyInstance& navy, side_t side, ModifierEffectCache const& modifier_effect_cache) {
+	CountryInstance const* country = navy.get_country();
+	ModifierEffectCache::ship_type_effects_t const& base_effects = modifier_effect_cache.get_navy_base_effects();
+
+	const auto get_country_effect = [country](ModifierEffect const* effect) -> fixed_point_t {
+		return country != nullptr ? country->get_modifier_effect_value_nullcheck(effect) : fixed_point_t::_0();
+	};
+
+	for (ShipInstance* ship : navy.get_units()) {
+		ShipType const& ship_type = ship->get_unit_type();
+		ModifierEffectCache::ship_type_effects_t const& type_effects = modifier_effect_cache.get_ship_type_effects()[ship_type];
+
+		const auto get_stat = [&get_country_effect, &base_effects, &type_effects](
+			fixed_point_t value, ModifierEffect const* (ModifierEffectCache::ship_type_effects_t::*effect)() const
+		) -> fixed_point_t {
+			return std::max(
+				value + get_country_effect((base_effects.*effect)()) + get_country_effect((type_effects.*effect)()),
+				fixed_point_t::_0()
+			);
+		};
+
+		ships.push_back(ship);
+		sides.push_back(side);
+		ship_states.push_back(ship->get_strength() > 0 ? ship_state_t::ENGAGED : ship_state_t::SUNK);
+		hulls.push_back(get_stat(ship_type.get_hull(), &ModifierEffectCache::ship_type_effects_t::get_hull));
+		gun_powers.push_back(get_stat(ship_type.get_gun_power(), &ModifierEffectCache::ship_type_effects_t::get_gun_power));
+		torpedo_attacks.push_back(
+			get_stat(ship_type.get_torpedo_attack(), &ModifierEffectCache::ship_type_effects_t::get_torpedo_attack)
+		);
+		fire_ranges.push_back(get_stat(ship_type.get_fire_range(), &ModifierEffectCache::ship_type_effects_t::get_fire_range));
+		evasions.push_back(get_stat(ship_type.get_evasion(), &ModifierEffectCache::ship_type_effects_t::get_evasion));
+		speeds.push_back(
+			get_stat(ship_type.get_maximum_speed(), &ModifierEffectCache::ship_type_effects_t::get_maximum_speed)
+		);
+		max_organisations.push_back(
+			get_stat(ship_type.get_default_organisation(), &ModifierEffectCache::ship_type_effects_t::get_default_organisation)
+				* (fixed_point_t::_1() + get_country_effect(modifier_effect_cache.get_naval_organisation()))
+		);
+		distances.push_back(STARTING_DISTANCE);
+		targets.push_back(NO_TARGET);
+		targeted_counts.push_back(0);
+		strength_damage.push_back(0);
+		organisation_damage.push_back(0);
+	}
+}
+
+void NavalBattle::_update_retreats(MilitaryDefines const& military_defines) {
+	const fixed_point_t retreat_step = military_defines.get_naval_combat_speed_to_distance_factor()
+		* military_defines.get_naval_combat_retreat_speed_mod();
+	const fixed_point_t retreat_level = military_defines.get_naval_combat_retreat_str_org_level();
+
+	for (uint32_t row = 0; row < ships.size(); ++row) {
+		switch (ship_states[row]) {
+		case ship_state_t::ENGAGED: {
+			/* Badly damaged or disorganised ships may break off */
+			ShipInstance const& ship = *ships[row];
+			if (
+				(
+					ship.get_strength() < retreat_level * ship.get_unit_type().get_max_strength()
+						|| ship.get_organisation() < retreat_level * max_organisations[row]
+				) && _next_chance() < military_defines.get_naval_combat_retreat_chance()
+			) {
+				ship_states[row] = ship_state_t::RETREATING;
+			}
+			break;
+		}
+		case ship_state_t::RETREATING:
+			distances[row] += speeds[row] * retreat_step;
+			if (distances[row] >= military_defines.get_naval_combat_retreat_min_distance()) {
+				ship_states[row] = ship_state_t::RETREATED;
+			}
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+void NavalBattle::_update_distances(MilitaryDefines const& military_defines) {
+	const fixed_point_t step = military_defines.get_naval_combat_speed_to_distance_factor();
+
+	for (uint32_t row = 0; row < ships.size(); ++row) {
+		if (ship_states[row] == ship_state_t::ENGAGED && distances[row] > fire_ranges[row]) {
+			distances[row] = std::max(distances[row] - speeds[row] * step, fixed_point_t::_0());
+		}
+	}
+}
+
+uint32_t NavalBattle::_choose_target(uint32_t row, MilitaryDefines const& military_defines) {
+	const side_t side = sides[row];
+	const uint32_t row_count = ships.size();
+
+	const auto is_candidate = [this, side](uint32_t candidate) -> bool {
+		return sides[candidate] != side && _is_active(candidate);
+	};
+
+	/* Lower is better: ships prefer damaged targets and spread out over ones already under fire */
+	const auto get_score = [this, &military_defines](uint32_t candidate) -> fixed_point_t {
+		const fixed_point_t max_strength = ships[candidate]->get_unit_type().get_max_strength();
+		const fixed_point_t damage = max_strength > 0
+			? fixed_point_t::_1() - ships[candidate]->get_strength() / max_strength
+			: fixed_point_t::_0();
+		return military_defines.get_naval_combat_stacking_target_select() * static_cast<int32_t>(targeted_counts[candidate])
+			- military_defines.get_naval_combat_damaged_target_selection() * damage;
+	};
+
+	/* Only a few random candidates are weighed each time, as a captain can only watch so much of the enemy line */
+	const size_t candidate_count = std::max<size_t>(military_defines.get_naval_combat_max_targets(), 1);
+
+	uint32_t best_target = NO_TARGET;
+	fixed_point_t best_score = 0;
+
+	for (size_t draw = 0; draw < candidate_count; ++draw) {
+		const uint32_t candidate = _next_random() % row_count;
+		if (!is_candidate(candidate)) {
+			continue;
+		}
+		const fixed_point_t score = get_score(candidate);
+		if (best_target == NO_TARGET || score < best_score || (score == best_score && candidate < best_target)) {
+			best_target = candidate;
+			best_score = score;
+		}
+	}
+
+	if (best_target == NO_TARGET) {
+		for (uint32_t candidate = 0; candidate < row_count; ++candidate) {
+			if (is_candidate(candidate)) {
+				return candidate;
+			}
+		}
+	}
+
+	return best_target;
+}
+
+void NavalBattle::_update_targets(MilitaryDefines const& military_defines) {
+	for (uint32_t row = 0; row < ships.size(); ++row) {
+		uint32_t& target = targets[row];
+
+		if (ship_states[row] != ship_state_t::ENGAGED) {
+			if (target != NO_TARGET) {
+				targeted_counts[target]--;
+				target = NO_TARGET;
+			}
+			continue;
+		}
+
+		if (
+			target != NO_TARGET && _is_active(target)
+				&& _next_chance() >= military_defines.get_naval_combat_change_target_chance()
+		) {
+			continue;
+		}
+
+		if (target != NO_TARGET) {
+			targeted_counts[target]--;
+		}
+		target = _choose_target(row, military_defines);
+		if (target != NO_TARGET) {
+			targeted_counts[target]++;
+		}
+	}
+}
+
+void NavalBattle::_fire(MilitaryDefines const& military_defines) {
+	std::fill(strength_damage.begin(), strength_damage.end(), fixed_point_t::_0());
+	std::fill(organisation_damage.begin(), organisation_damage.end(), fixed_point_t::_0());
+
+	for (uint32_t row = 0; row < ships.size(); ++row) {
+		const uint32_t target = targets[row];
+		if (
+			ship_states[row] != ship_state_t::ENGAGED || target == NO_TARGET || distances[row] > fire_ranges[row]
+				|| _next_chance() < evasions[target]
+		) {
+			continue;
+		}
+
+		const fixed_point_t damage = (gun_powers[row] + torpedo_attacks[row]) * (fixed_point_t::_0_50() + _next_chance())
+			/ std::max(hulls[target], fixed_point_t::_1());
+
+		fixed_point_t target_strength_damage = damage * military_defines.get_naval_combat_damage_str_mult();
+		if (ships[target]->get_organisation() <= 0) {
+			target_strength_damage *= military_defines.get_naval_combat_damage_mult_no_org();
+		}
+
+		strength_damage[target] += target_strength_damage;
+		organisation_damage[target] += damage * military_defines.get_naval_combat_damage_org_mult();
+	}
+}
+
+void NavalBattle::_apply_damage() {
+	for (uint32_t row = 0; row < ships.size(); ++row) {
+		if (!_is_active(row)) {
+			continue;
+		}
+
+		ShipInstance& ship = *ships[row];
+
+		const fixed_point_t old_strength = ship.get_strength();
+		const fixed_point_t new_strength = std::max(old_strength - strength_damage[row], fixed_point_t::_0());
+		ship.set_strength(new_strength);
+		ship.set_organisation(std::max(ship.get_organisation() - organisation_damage[row], fixed_point_t::_0()));
+
+		(sides[row] == side_t::ATTACKER ? attacker_losses : defender_losses) += old_strength - new_strength;
+
+		if (new_strength <= 0) {
+			ship_states[row] = ship_state_t::SUNK;
+		}
+	}
+}
+
+void NavalBattle::_resolve_day(MilitaryDefines const& military_defines) {
+	_update_retreats(military_defines);
+	_update_distances(military_defines);
+	_update_targets(military_defines);
+	/* Every ship fires before any damage is applied, so row order gives no ship the first shot */
+	_fire(military_defines);
+	_apply_damage();
+	days++;
+}
+
+NavalCombatEngine::NavalCombatEngine() {}
+
+NavalBattle* NavalCombatEngine::_get_battle(ProvinceInstance const& province) {
+	for (NavalBattle& battle : battles) {
+		if (battle.province == &province) {
+			return &battle;
+		}
+	}
+	return nullptr;
+}
+
+bool NavalCombatEngine::_join_battle(
+	NavalBattle& battle, NavyInstance& navy, ModifierEffectCache const& modifier_effect_cache
+) {
+	CountryInstance const* country = navy.get_country();
+	if (country == nullptr || navy.is_in_combat()) {
+		return false;
+	}
+
+	side_t side;
+	if (country == battle.attacker_country || country->is_at_war_with(*battle.defender_country)) {
+		side = side_t::ATTACKER;
+	} else if (country == battle.defender_country || country->is_at_war_with(*battle.attacker_country)) {
+		side = side_t::DEFENDER;
+	} else {
+		return false;
+	}
+
+	battle._get_navies(side).push_back(&navy);
+	battle._add_ships(navy, side, modifier_effect_cache);
+	navy.in_combat = true;
+	navy.get_movement_info().clear();
+	return true;
+}
+
+void NavalCombatEngine::_start_battles(
+	Date today, UnitInstanceManager const& unit_instance_manager, ModifierEffectCache const& modifier_effect_cache
+) {
+	for (UnitInstanceManager::encounter_t const& encounter : unit_instance_manager.get_encounters()) {
+		if (encounter.branch != UnitType::branch_t::NAVAL) {
+			continue;
+		}
+
+		ProvinceInstance& province = *encounter.province;
+		ordered_set<NavyInstance*> const& navies = province.get_navies();
+
+		NavalBattle* battle = _get_battle(province);
+
+		if (battle == nullptr) {
+			/* Whoever has been here longest defends, or the controller if it's a port with its navy in */
+			CountryInstance const* defender = nullptr;
+			for (NavyInstance const* navy : navies) {
+				CountryInstance const* country = navy->get_country();
+				if (country != nullptr && (defender == nullptr || country == province.get_controller())) {
+					defender = country;
+				}
+			}
+			if (defender == nullptr) {
+				continue;
+			}
+
+			CountryInstance const* attacker = nullptr;
+			for (NavyInstance const* navy : navies) {
+				CountryInstance const* country = navy->get_country();
+				if (country != nullptr && !navy->is_in_combat() && country->is_at_war_with(*defender)) {
+					attacker = country;
+					break;
+				}
+			}
+			if (attacker == nullptr) {
+				continue;
+			}
+
+			battle = &battles.emplace_back(province, *attacker, *defender, today);
+		}
+
+		for (NavyInstance* navy : navies) {
+			_join_battle(*battle, *navy, modifier_effect_cache);
+		}
+	}
+}
+
+void NavalCombatEngine::_end_battle(NavalBattle& battle, MapInstance& map_instance) {
+	for (side_t side : { side_t::ATTACKER, side_t::DEFENDER }) {
+		const bool defeated = !battle._has_engaged_ships(side);
+
+		for (NavyInstance* navy : battle._get_navies(side)) {
+			navy->in_combat = false;
+
+			if (!defeated) {
+				continue;
+			}
+
+			/* Defeated navies make for their capital, if it's a port they can reach */
+			CountryInstance const* country = navy->get_country();
+			ProvinceInstance const* capital = country != nullptr ? country->get_capital() : nullptr;
+			if (capital != nullptr && capital != battle.province) {
+				navy->set_movement_target(map_instance, *capital);
+			}
+		}
+	}
+}
+
+void NavalCombatEngine::tick(
+	Date today, MapInstance& map_instance, UnitInstanceManager const& unit_instance_manager,
+	ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines,
+	ThreadPool& thread_pool
+) {
+	_start_battles(today, unit_instance_manager, modifier_effect_cache);
+
+	/* Battles share no ships and each has its own random stream, so they can be fought in any order on any thread */
+	thread_pool.parallel_for(
+		battles.size(), BATTLE_CHUNK_SIZE,
+		[this, &military_defines](size_t, size_t begin, size_t end) {
+			for (size_t index = begin; index < end; ++index) {
+				battles[index]._resolve_day(military_defines);
+			}
+		}
+	);
+
+	for (NavalBattle& battle : battles) {
+		if (battle.is_over()) {
+			_end_battle(battle, map_instance);
+		}
+	}
+
+	std::erase_if(battles, [](NavalBattle const& battle) -> bool {
+		return battle.is_over();
+	});
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "openvic-simulation/military/UnitInstanceGroup.hpp"
+#include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct MapInstance;
+	struct ModifierEffectCache;
+	struct MilitaryDefines;
+	struct ThreadPool;
+
+	/* An ongoing naval battle in one sea zone (or port), between the navies of the attacking and defending countries.
+	 *
+	 * Ships are held as columns, one row per ship in the order their navies joined, so the daily pass over a battle
+	 * walks each stat in turn rather than hopping between ship objects. Every battle draws from its own random
+	 * stream, seeded when it starts, so battles give the same results whichever thread fights them and in whatever
+	 * order. */
+	struct NavalBattle {
+		friend struct NavalCombatEngine;
+
+		enum struct side_t : uint8_t { ATTACKER, DEFENDER };
+		enum struct ship_state_t : uint8_t { ENGAGED, RETREATING, RETREATED, SUNK };
+
+		static constexpr uint32_t NO_TARGET = std::numeric_limits<uint32_t>::max();
+		/* Where ships joining the battle start from the enemy line. */
+		static constexpr fixed_point_t STARTING_DISTANCE = fixed_point_t::_1();
+
+	private:
+		ProvinceInstance* PROPERTY(province);
+		CountryInstance const* PROPERTY(attacker_country);
+		CountryInstance const* PROPERTY(defender_country);
+		std::vector<NavyInstance*> PROPERTY(attacker_navies);
+		std::vector<NavyInstance*> PROPERTY(defender_navies);
+		Date PROPERTY(start_date);
+		uint32_t PROPERTY(days);
+
+		/* Strength lost by each side over the whole battle. */
+		fixed_point_t PROPERTY(attacker_losses);
+		fixed_point_t PROPERTY(defender_losses);
+
+		uint64_t random_state;
+
+		/* Ship columns, all indexed by row. */
+		std::vector<ShipInstance*> ships;
+		std::vector<side_t> sides;
+		std::vector<ship_state_t> PROPERTY(ship_states);
+		std::vector<fixed_point_t> hulls;
+		std::vector<fixed_point_t> gun_powers;
+		std::vector<fixed_point_t> torpedo_attacks;
+		std::vector<fixed_point_t> fire_ranges;
+		std::vector<fixed_point_t> evasions;
+		std::vector<fixed_point_t> speeds;
+		std::vector<fixed_point_t> max_organisations;
+		/* How far each ship is from the enemy line, closed each day until the ship is within its fire range. */
+		std::vector<fixed_point_t> distances;
+		std::vector<uint32_t> targets;
+		/* How many ships are firing on each row, to spread fire across the enemy line. */
+		std::vector<uint32_t> targeted_counts;
+		std::vector<fixed_point_t> strength_damage;
+		std::vector<fixed_point_t> organisation_damage;
+
+		std::vector<NavyInstance*>& _get_navies(side_t side);
+
+		uint64_t _next_random();
+		/* A random fraction in [0, 1). */
+		fixed_point_t _next_chance();
+
+		bool _is_active(uint32_t row) const;
+		bool _has_engaged_ships(side_t side) const;
+
+		void _add_ships(
+			NavyInstance& navy, side_t side, ModifierEffectCache const& modifier_effect_cache
+		);
+		void _update_retreats(MilitaryDefines const& military_defines);
+		void _update_distances(MilitaryDefines const& military_defines);
+		uint32_t _choose_target(uint32_t row, MilitaryDefines const& military_defines);
+		void _update_targets(MilitaryDefines const& military_defines);
+		void _fire(MilitaryDefines const& military_defines);
+		void _apply_damage();
+
+		/* Fights one day of the battle, touching only the battle and its own ships. */
+		void _resolve_day(MilitaryDefines const& military_defines);
+
+	public:
+		NavalBattle(
+			ProvinceInstance& new_province, CountryInstance const& new_attacker_country,
+			CountryInstance const& new_defender_country, Date new_start_date
+		);
+		NavalBattle(NavalBattle&&) = default;
+		NavalBattle& operator=(NavalBattle&&) = default;
+
+		std::vector<NavyInstance*> const& get_navies(side_t side) const;
+		fixed_point_t get_losses(side_t side) const;
+		size_t get_ship_count() const;
+		bool is_over() const;
+	};
+
+	/* Fights every naval battle once a day, after movement. Battles start where the day's movement brought navies of
+	 * countries at war into the same province, are then resolved in parallel, and once one side has no ship left
+	 * engaged its navies are sent back towards their capital. */
+	struct NavalCombatEngine {
+	private:
+		/* Battles are few but each is a fair amount of work, so they are handed out one at a time. */
+		static constexpr size_t BATTLE_CHUNK_SIZE = 1;
+
+		std::vector<NavalBattle> PROPERTY(battles);
+
+		NavalBattle* _get_battle(ProvinceInstance const& province);
+		static bool _join_battle(
+			NavalBattle& battle, NavyInstance& navy, ModifierEffectCache const& modifier_effect_cache
+		);
+		void _start_battles(
+			Date today, UnitInstanceManager const& unit_instance_manager, ModifierEffectCache const& modifier_effect_cache
+		);
+		static void _end_battle(NavalBattle& battle, MapInstance& map_instance);
+
+	public:
+		NavalCombatEngine();
+
+		void tick(
+			Date today, MapInstance& map_instance, UnitInstanceManager const& unit_instance_manager,
+			ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines,
+			ThreadPool& thread_pool
+		);
+	};
+}
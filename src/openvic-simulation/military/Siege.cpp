@@ -0,0 +1,189 @@
+#include "Siege.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/country/CountryDefinition.hpp"
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/defines/MilitaryDefines.hpp"
+#include "openvic-simulation/economy/BuildingInstance.hpp"
+#include "openvic-simulation/map/MapInstance.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/military/Leader.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
+
+using namespace OpenVic;
+
+using besieging_army_t = std::pair<ProvinceInstance*, ArmyInstance const*>;
+
+Siege::Siege(ProvinceInstance& new_province, CountryInstance& new_besieger, Date new_start_date)
+  : province { &new_province },
+	besieger { &new_besieger },
+	start_date { new_start_date },
+	days { 0 },
+	fort_level { 0 },
+	progress { 0 },
+	daily_progress { 0 } {}
+
+SiegeEngine::SiegeEngine() {}
+
+BuildingType::level_t SiegeEngine::_get_fort_level(ProvinceInstance const& province) {
+	BuildingType::level_t fort_level = 0;
+	for (BuildingInstance const& building : province.get_buildings()) {
+		fort_level += building.get_level() * building.get_building_type().get_fort_level();
+	}
+	return fort_level;
+}
+
+bool SiegeEngine::_is_defended(ProvinceInstance const& province, CountryInstance const& besieger) {
+	for (ArmyInstance const* army : province.get_armies()) {
+		CountryInstance const* country = army->get_country();
+		if (country != nullptr && (country == province.get_controller() || country->is_at_war_with(besieger))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+fixed_point_t SiegeEngine::_get_daily_progress(
+	BuildingType::level_t fort_level, std::span<const besieging_army_t> armies,
+	ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+) {
+	ModifierEffectCache::regiment_type_effects_t const& base_effects = modifier_effect_cache.get_army_base_effects();
+
+	size_t brigades = 0;
+	fixed_point_t siege = 0;
+	fixed_point_t reconnaissance = 0;
+	fixed_point_t leader_reconnaissance = 0;
+
+	for (auto const& [province, army] : armies) {
+		CountryInstance const* country = army->get_country();
+
+		for (RegimentInstance const* regiment : army->get_units()) {
+			if (regiment->get_strength() <= 0) {
+				continue;
+			}
+
+			RegimentType const& regiment_type = regiment->get_unit_type();
+			ModifierEffectCache::regiment_type_effects_t const& type_effects =
+				modifier_effect_cache.get_regiment_type_effects()[regiment_type];
+
+			/* Only the best brigade's engineering and scouting count, so more brigades only help through the
+			 * siege_brigades_bonus, which stops at siege_brigades_max */
+			brigades++;
+			siege = std::max(
+				siege, regiment_type.get_siege() + country->get_modifier_effect_value_nullcheck(base_effects.get_siege())
+					+ country->get_modifier_effect_value_nullcheck(type_effects.get_siege())
+			);
+			reconnaissance = std::max(
+				reconnaissance, regiment_type.get_reconnaissance()
+					+ country->get_modifier_effect_value_nullcheck(base_effects.get_reconnaissance())
+					+ country->get_modifier_effect_value_nullcheck(type_effects.get_reconnaissance())
+			);
+		}
+
+		/* Only the best scout among the besieging leaders counts */
+		LeaderBranched<UnitType::branch_t::LAND> const* leader = army->get_leader();
+		if (leader != nullptr) {
+			fixed_point_t leader_effect = 0;
+			if (leader->get_personality() != nullptr) {
+				leader_effect += leader->get_personality()->get_effect_nullcheck(modifier_effect_cache.get_reconnaissance());
+			}
+			if (leader->get_background() != nullptr) {
+				leader_effect += leader->get_background()->get_effect_nullcheck(modifier_effect_cache.get_reconnaissance());
+			}
+			leader_reconnaissance = std::max(leader_reconnaissance, leader_effect);
+		}
+	}
+
+	if (brigades == 0) {
+		return 0;
+	}
+
+	/* Engineers knock whole levels off the fort */
+	const int64_t effective_fort_level = std::max<int64_t>(fort_level - std::max(siege, fixed_point_t::_0()).to_int64_t(), 0);
+
+	fixed_point_t speed = fixed_point_t::_1();
+
+	const size_t brigades_min = military_defines.get_siege_brigades_min();
+	const size_t brigades_max = std::max(military_defines.get_siege_brigades_max(), brigades_min);
+	if (brigades > brigades_min) {
+		speed += military_defines.get_siege_brigades_bonus()
+			* static_cast<int32_t>(std::min(brigades, brigades_max) - brigades_min);
+	}
+
+	speed += (reconnaissance + leader_reconnaissance) * military_defines.get_recon_siege_effect();
+
+	return std::max(speed, fixed_point_t::_0()) / (BASE_SIEGE_DAYS * static_cast<int32_t>(1 + effective_fort_level));
+}
+
+void SiegeEngine::tick(
+	Date today, MapInstance& map_instance, UnitInstanceManager const& unit_instance_manager,
+	CountryInstanceManager& country_instance_manager, ModifierEffectCache const& modifier_effect_cache,
+	MilitaryDefines const& military_defines
+) {
+	besieging_armies.clear();
+
+	for (ArmyInstance const& army : unit_instance_manager.get_armies()) {
+		ProvinceInstance const* position = army.get_position();
+		CountryInstance const* country = army.get_country();
+
+		if (
+			position == nullptr || country == nullptr || army.is_in_combat() || army.get_movement_info().is_moving()
+				|| position->get_province_definition().is_water() || position->get_controller() == nullptr
+				|| !country->is_at_war_with(*position->get_controller())
+		) {
+			continue;
+		}
+
+		besieging_armies.emplace_back(
+			&map_instance.get_province_instance_from_definition(position->get_province_definition()), &army
+		);
+	}
+
+	/* Grouped by province, armies keeping their order within each so the besieger doesn't depend on sort internals */
+	std::stable_sort(
+		besieging_armies.begin(), besieging_armies.end(), [](besieging_army_t const& lhs, besieging_army_t const& rhs) -> bool {
+			return lhs.first->get_province_definition().get_index() < rhs.first->get_province_definition().get_index();
+		}
+	);
+
+	next_sieges.clear();
+
+	for (auto begin = besieging_armies.begin(); begin != besieging_armies.end();) {
+		ProvinceInstance& province = *begin->first;
+		const auto end = std::find_if(begin, besieging_armies.end(), [&province](besieging_army_t const& entry) {
+			return entry.first != &province;
+		});
+		const std::span<const besieging_army_t> armies { begin, end };
+		begin = end;
+
+		/* The first besieging army's country takes control, retaking the province if it's the owner */
+		CountryInstance& besieger = country_instance_manager.get_country_instance_from_definition(
+			*armies.front().second->get_country()->get_country_definition()
+		);
+
+		if (_is_defended(province, besieger)) {
+			continue;
+		}
+
+		Siege siege { province, besieger, today };
+		const decltype(sieges)::iterator it = sieges.find(&province);
+		if (it != sieges.end() && it->second.besieger == &besieger) {
+			siege = std::move(it.value());
+		}
+
+		siege.fort_level = _get_fort_level(province);
+		siege.daily_progress = _get_daily_progress(siege.fort_level, armies, modifier_effect_cache, military_defines);
+		siege.progress += siege.daily_progress;
+		siege.days++;
+
+		if (siege.progress >= fixed_point_t::_1()) {
+			map_instance.queue_controller_change(province, &besieger);
+		} else {
+			next_sieges.emplace(&province, std::move(siege));
+		}
+	}
+
+	/* Sieges with no besiegers left today are lifted, losing their progress */
+	std::swap(sieges, next_sieges);
+}
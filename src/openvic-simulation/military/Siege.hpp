@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "openvic-simulation/economy/BuildingType.hpp"
+#include "openvic-simulation/military/UnitInstanceGroup.hpp"
+#include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/types/OrderedContainers.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct MapInstance;
+	struct CountryInstanceManager;
+	struct ModifierEffectCache;
+	struct MilitaryDefines;
+
+	/* A province being besieged by the armies of a country at war with its controller. */
+	struct Siege {
+		friend struct SiegeEngine;
+
+	private:
+		ProvinceInstance* PROPERTY(province);
+		CountryInstance* PROPERTY(besieger);
+		Date PROPERTY(start_date);
+		uint32_t PROPERTY(days);
+		BuildingType::level_t PROPERTY(fort_level);
+		/* The province falls once this reaches 1. */
+		fixed_point_t PROPERTY(progress);
+		fixed_point_t PROPERTY(daily_progress);
+
+	public:
+		Siege(ProvinceInstance& new_province, CountryInstance& new_besieger, Date new_start_date);
+		Siege(Siege&&) = default;
+		Siege& operator=(Siege&&) = default;
+	};
+
+	/* Advances every siege once a day, after combat.
+	 *
+	 * Armies standing still outside of combat in a land province whose controller their country is at war with
+	 * besiege it, unless the controller or another country at war with the besieger has an army there. How fast depends
+	 * on the province's fort level, lowered by the besiegers' best siege (engineering) strength, on how many brigades
+	 * are besieging, and on the besiegers' best reconnaissance, including their leaders'. Fallen provinces are queued
+	 * as controller changes on the MapInstance, to be applied together at the end of the tick. */
+	struct SiegeEngine {
+	private:
+		/* How long an unfortified province holds out against the smallest siege. */
+		static constexpr int32_t BASE_SIEGE_DAYS = 30;
+
+		ordered_map<ProvinceInstance const*, Siege> PROPERTY(sieges);
+
+		/* Scratch, rebuilt each day. */
+		std::vector<std::pair<ProvinceInstance*, ArmyInstance const*>> besieging_armies;
+		ordered_map<ProvinceInstance const*, Siege> next_sieges;
+
+		static BuildingType::level_t _get_fort_level(ProvinceInstance const& province);
+		static bool _is_defended(ProvinceInstance const& province, CountryInstance const& besieger);
+		static fixed_point_t _get_daily_progress(
+			BuildingType::level_t fort_level, std::span<const std::pair<ProvinceInstance*, ArmyInstance const*>> armies,
+			ModifierEffectCache const& modifier_effect_cache, MilitaryDefines const& military_defines
+		);
+
+	public:
+		SiegeEngine();
+
+		void tick(
+			Date today, MapInstance& map_instance, UnitInstanceManager const& unit_instance_manager,
+			CountryInstanceManager& country_instance_manager, ModifierEffectCache const& modifier_effect_cache,
+			MilitaryDefines const& military_defines
+		);
+	};
+}
@@ -1,19 +1,59 @@
 #include "UnitInstanceGroup.hpp"
 
+#include <algorithm>
 #include <vector>
 
+#include "openvic-simulation/country/CountryDefinition.hpp"
 #include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/map/MapDefinition.hpp"
 #include "openvic-simulation/map/MapInstance.hpp"
 #include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/map/TerrainType.hpp"
 #include "openvic-simulation/military/Deployment.hpp"
+#include "openvic-simulation/military/LeaderTrait.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
 
 using namespace OpenVic;
 
-MovementInfo::MovementInfo() : path {}, movement_progress {} {}
+MovementInfo::MovementInfo() : path {}, next_path_index { 0 }, movement_progress { 0 } {}
 
-//TODO: pathfinding logic
-MovementInfo::MovementInfo(ProvinceInstance const* starting_province, ProvinceInstance const* target_province)
-	: path { starting_province, target_province }, movement_progress { 0 } {}
+bool MovementInfo::is_moving() const {
+	return next_path_index < path.size();
+}
+
+ProvinceInstance const* MovementInfo::get_next_province() const {
+	return is_moving() ? path[next_path_index] : nullptr;
+}
+
+ProvinceInstance const* MovementInfo::get_destination() const {
+	return is_moving() ? path.back() : nullptr;
+}
+
+void MovementInfo::set_path(std::vector<ProvinceInstance const*>&& new_path) {
+	path = std::move(new_path);
+	next_path_index = 0;
+	movement_progress = 0;
+}
+
+void MovementInfo::clear() {
+	path.clear();
+	next_path_index = 0;
+	movement_progress = 0;
+}
+
+bool MovementInfo::add_progress(fixed_point_t distance, fixed_point_t distance_to_next_province) {
+	movement_progress += distance;
+	return movement_progress >= distance_to_next_province;
+}
+
+bool MovementInfo::advance() {
+	movement_progress = 0;
+	if (++next_path_index >= path.size()) {
+		clear();
+		return true;
+	}
+	return false;
+}
 
 template<UnitType::branch_t Branch>
 UnitInstanceGroup<Branch>::UnitInstanceGroup(
@@ -21,6 +61,7 @@ UnitInstanceGroup<Branch>::UnitInstanceGroup(
 ) : name { new_name },
 	units { std::move(new_units) },
 	leader { nullptr },
+	in_combat { false },
 	position { nullptr },
 	country { nullptr } {}
 
@@ -142,6 +183,45 @@ bool UnitInstanceGroup<Branch>::set_leader(_Leader* new_leader) {
 	return ret;
 }
 
+template<UnitType::branch_t Branch>
+bool UnitInstanceGroup<Branch>::set_movement_target(MapInstance& map_instance, ProvinceInstance const& target) {
+	if (position == nullptr) {
+		Logger::error("Cannot move unit group ", name, " - it has no position!");
+		return false;
+	}
+
+	MapDefinition const& map_definition = map_instance.get_map_definition();
+	std::vector<ProvinceDefinition const*> province_path;
+	bool found;
+
+	if constexpr (Branch == UnitType::branch_t::LAND) {
+		/* Armies ask for the same long routes over and over, so theirs go through the cache, keyed by country */
+		found = map_instance.get_land_path_cache().find_path(
+			position->get_province_definition(), target.get_province_definition(),
+			country != nullptr ? country->get_country_definition()->get_index() : PathCache::UNMASKED_KEY,
+			country != nullptr ? &map_instance.get_passability_mask(*country) : nullptr, province_path
+		);
+	} else {
+		found = Pathfinder { map_definition }.find_path(
+			map_definition.get_naval_graph(), position->get_province_definition(), target.get_province_definition(),
+			nullptr, province_path
+		);
+	}
+
+	if (!found) {
+		return false;
+	}
+
+	std::vector<ProvinceInstance const*> new_path;
+	new_path.reserve(province_path.size() - 1);
+	for (auto it = province_path.begin() + 1; it != province_path.end(); ++it) {
+		new_path.push_back(&map_instance.get_province_instance_from_definition(**it));
+	}
+	movement_info.set_path(std::move(new_path));
+
+	return true;
+}
+
 template struct OpenVic::UnitInstanceGroup<UnitType::branch_t::LAND>;
 template struct OpenVic::UnitInstanceGroup<UnitType::branch_t::NAVAL>;
 
@@ -280,3 +360,199 @@ bool UnitInstanceManager::generate_deployment(
 
 	return ret;
 }
+
+template<UnitType::branch_t Branch>
+fixed_point_t UnitInstanceManager::_get_daily_movement(
+	UnitInstanceGroupBranched<Branch> const& group, ProvinceInstance const& destination,
+	ModifierEffectCache const& modifier_effect_cache
+) {
+	CountryInstance const* country = group.get_country();
+	TerrainType const* terrain_type = destination.get_terrain_type();
+
+	ModifierEffectCache::unit_type_effects_t const* base_effects;
+	if constexpr (Branch == UnitType::branch_t::LAND) {
+		base_effects = &modifier_effect_cache.get_army_base_effects();
+	} else {
+		base_effects = &modifier_effect_cache.get_navy_base_effects();
+	}
+
+	/* A group moves at the speed of its slowest unit */
+	fixed_point_t speed = 0;
+	bool first_unit = true;
+
+	for (UnitInstanceBranched<Branch> const* unit : group.get_units()) {
+		UnitTypeBranched<Branch> const& unit_type = unit->get_unit_type();
+
+		fixed_point_t unit_speed = unit_type.get_maximum_speed();
+
+		if (country != nullptr) {
+			ModifierEffectCache::unit_type_effects_t const* type_effects;
+			if constexpr (Branch == UnitType::branch_t::LAND) {
+				type_effects = &modifier_effect_cache.get_regiment_type_effects()[unit_type];
+			} else {
+				type_effects = &modifier_effect_cache.get_ship_type_effects()[unit_type];
+			}
+
+			unit_speed += country->get_modifier_effect_value_nullcheck(base_effects->get_maximum_speed())
+				+ country->get_modifier_effect_value_nullcheck(type_effects->get_maximum_speed());
+		}
+
+		if (terrain_type != nullptr) {
+			const UnitType::terrain_modifiers_t::const_iterator it = unit_type.get_terrain_modifiers().find(terrain_type);
+			if (it != unit_type.get_terrain_modifiers().end()) {
+				unit_speed *= fixed_point_t::_1() + it->second.get_effect_nullcheck(
+					modifier_effect_cache.get_unit_terrain_effects()[*terrain_type].get_movement()
+				);
+			}
+		}
+
+		if (first_unit || unit_speed < speed) {
+			speed = unit_speed;
+			first_unit = false;
+		}
+	}
+
+	if (group.get_leader() != nullptr) {
+		fixed_point_t leader_speed = 0;
+		if (group.get_leader()->get_personality() != nullptr) {
+			leader_speed += group.get_leader()->get_personality()->get_effect_nullcheck(modifier_effect_cache.get_speed());
+		}
+		if (group.get_leader()->get_background() != nullptr) {
+			leader_speed += group.get_leader()->get_background()->get_effect_nullcheck(modifier_effect_cache.get_speed());
+		}
+		speed *= fixed_point_t::_1() + leader_speed;
+	}
+
+	/* Terrain movement costs are multipliers, 1 where the province has none */
+	fixed_point_t movement_cost =
+		destination.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_movement_cost_base());
+	if (movement_cost <= 0) {
+		movement_cost = fixed_point_t::_1();
+	}
+	movement_cost *= fixed_point_t::_1()
+		+ destination.get_modifier_effect_value_nullcheck(modifier_effect_cache.get_movement_cost_percentage_change());
+
+	if (movement_cost <= 0) {
+		return std::max(speed, fixed_point_t::_0());
+	}
+	return std::max(speed / movement_cost, fixed_point_t::_0());
+}
+
+template<UnitType::branch_t Branch>
+void UnitInstanceManager::_tick_movement(MapInstance& map_instance, ModifierEffectCache const& modifier_effect_cache) {
+	MapDefinition const& map_definition = map_instance.get_map_definition();
+	std::vector<movement_t<Branch>>& movements = get_movements<Branch>();
+	std::vector<UnitInstanceGroupBranched<Branch>*>& arrived_groups = [this]() -> auto& {
+		if constexpr (Branch == UnitType::branch_t::LAND) {
+			return arrived_armies;
+		} else {
+			return arrived_navies;
+		}
+	}();
+
+	movements.clear();
+	arrived_groups.clear();
+
+	for (UnitInstanceGroupBranched<Branch>& group : get_unit_instance_groups<Branch>()) {
+		MovementInfo& movement_info = group.get_movement_info();
+		if (!movement_info.is_moving() || group.position == nullptr || group.is_in_combat()) {
+			continue;
+		}
+
+		ProvinceInstance const& next_province = *movement_info.get_next_province();
+
+		if (!movement_info.add_progress(
+			_get_daily_movement(group, next_province, modifier_effect_cache),
+			map_definition.calculate_distance_between(
+				group.position->get_province_definition(), next_province.get_province_definition()
+			)
+		)) {
+			continue;
+		}
+
+		/* Groups enter at most one province a day, starting on the next one from scratch */
+		movements.push_back({
+			&group, group.position, &map_instance.get_province_instance_from_definition(
+				next_province.get_province_definition()
+			), movements.size()
+		});
+
+		if (movement_info.advance()) {
+			arrived_groups.push_back(&group);
+		}
+	}
+
+	_apply_movements<Branch>();
+}
+
+template<UnitType::branch_t Branch>
+void UnitInstanceManager::_apply_movements() {
+	std::vector<movement_t<Branch>>& movements = get_movements<Branch>();
+	if (movements.empty()) {
+		return;
+	}
+
+	std::vector<UnitInstanceGroupBranched<Branch>*> groups;
+	groups.reserve(movements.size());
+
+	const auto apply_grouped = [&movements, &groups](
+		ProvinceInstance* movement_t<Branch>::*province, auto&& apply
+	) -> void {
+		std::sort(movements.begin(), movements.end(), [province](movement_t<Branch> const& lhs, movement_t<Branch> const& rhs) {
+			ProvinceInstance const* lhs_province = lhs.*province;
+			ProvinceInstance const* rhs_province = rhs.*province;
+			return lhs_province != rhs_province
+				? lhs_province->get_province_definition().get_index() < rhs_province->get_province_definition().get_index()
+				: lhs.order < rhs.order;
+		});
+
+		for (auto begin = movements.begin(); begin != movements.end();) {
+			auto end = std::find_if(begin, movements.end(), [province, begin](movement_t<Branch> const& movement) {
+				return movement.*province != (*begin).*province;
+			});
+
+			groups.clear();
+			for (auto it = begin; it != end; ++it) {
+				groups.push_back(it->group);
+			}
+			apply(*((*begin).*province), groups);
+
+			begin = end;
+		}
+	};
+
+	apply_grouped(&movement_t<Branch>::from, [](ProvinceInstance& province, auto& departures) -> void {
+		/* Only membership matters for departures, so they can be sorted by address for the province's binary search */
+		std::sort(departures.begin(), departures.end(), std::less<> {});
+		province.template _remove_unit_instance_groups<Branch>(departures);
+	});
+	apply_grouped(&movement_t<Branch>::to, [](ProvinceInstance& province, auto const& arrivals) -> void {
+		province.template _add_unit_instance_groups<Branch>(arrivals);
+	});
+
+	/* Sorted by destination now, so each province's encounter is only recorded once */
+	ProvinceInstance const* last_province = nullptr;
+	for (movement_t<Branch> const& movement : movements) {
+		movement.group->position = movement.to;
+
+		if (movement.to == last_province) {
+			continue;
+		}
+		last_province = movement.to;
+
+		CountryInstance const* country = movement.group->get_country();
+		for (UnitInstanceGroupBranched<Branch> const* other_group : movement.to->template get_unit_instance_groups<Branch>()) {
+			if (other_group->get_country() != country) {
+				encounters.push_back({ movement.to, Branch });
+				break;
+			}
+		}
+	}
+}
+
+void UnitInstanceManager::tick(MapInstance& map_instance, ModifierEffectCache const& modifier_effect_cache) {
+	encounters.clear();
+
+	_tick_movement<UnitType::branch_t::LAND>(map_instance, modifier_effect_cache);
+	_tick_movement<UnitType::branch_t::NAVAL>(map_instance, modifier_effect_cache);
+}
@@ -13,16 +13,31 @@
 
 namespace OpenVic {
 	struct ProvinceInstance;
+	struct MapInstance;
+	struct ModifierEffectCache;
 
 	struct MovementInfo {
 	private:
+		/* The provinces to be entered in turn, not including the one the group starts from. */
 		std::vector<ProvinceInstance const*> PROPERTY(path);
+		size_t PROPERTY(next_path_index);
+		/* Distance covered towards the next province. */
 		fixed_point_t PROPERTY(movement_progress);
 
 	public:
 		MovementInfo();
-		// contains/calls pathfinding logic
-		MovementInfo(ProvinceInstance const* starting_province, ProvinceInstance const* target_province);
+
+		bool is_moving() const;
+		ProvinceInstance const* get_next_province() const;
+		ProvinceInstance const* get_destination() const;
+
+		void set_path(std::vector<ProvinceInstance const*>&& new_path);
+		void clear();
+
+		/* Adds a day's movement, returning whether the next province has been reached. */
+		bool add_progress(fixed_point_t distance, fixed_point_t distance_to_next_province);
+		/* Moves on to the next province once it has been entered, returning whether that was the destination. */
+		bool advance();
 	};
 
 	template<UnitType::branch_t>
@@ -32,6 +47,9 @@ namespace OpenVic {
 
 	template<UnitType::branch_t Branch>
 	struct UnitInstanceGroup {
+		friend struct LandCombatEngine;
+		friend struct NavalCombatEngine;
+
 		using _UnitInstance = UnitInstanceBranched<Branch>;
 		using _Leader = LeaderBranched<Branch>;
 
@@ -41,6 +59,8 @@ namespace OpenVic {
 		_Leader* PROPERTY(leader);
 
 		MovementInfo PROPERTY_REF(movement_info);
+		/* Set by the combat engines while the group is fighting, which stops it moving. */
+		bool PROPERTY_CUSTOM_PREFIX(in_combat, is);
 
 	protected:
 		ProvinceInstance* PROPERTY_ACCESS(position, protected);
@@ -64,6 +84,11 @@ namespace OpenVic {
 		bool set_position(ProvinceInstance* new_position);
 		bool set_country(CountryInstance* new_country);
 		bool set_leader(_Leader* new_leader);
+
+		/* Paths the group to the target province, armies over the land graph through only the provinces their country's
+		 * passability mask allows, and navies over the naval graph. Returns false, leaving the group where it is, if
+		 * there's no such path. */
+		bool set_movement_target(MapInstance& map_instance, ProvinceInstance const& target);
 	};
 
 	template<UnitType::branch_t>
@@ -111,11 +136,26 @@ namespace OpenVic {
 	template<UnitType::branch_t>
 	struct UnitDeploymentGroup;
 
-	struct MapInstance;
 	struct Deployment;
 
 	struct UnitInstanceManager {
+		/* A province where arriving units met units of another country. */
+		struct encounter_t {
+			ProvinceInstance* province;
+			UnitType::branch_t branch;
+		};
+
 	private:
+		template<UnitType::branch_t Branch>
+		struct movement_t {
+			UnitInstanceGroupBranched<Branch>* group;
+			ProvinceInstance* from;
+			ProvinceInstance* to;
+			/* The movement's position in the order groups were ticked in, breaking ties when sorting by province so
+			 * that arrival order never depends on addresses. */
+			size_t order;
+		};
+
 		plf::colony<RegimentInstance> PROPERTY(regiments);
 		plf::colony<ShipInstance> PROPERTY(ships);
 
@@ -126,6 +166,17 @@ namespace OpenVic {
 
 		UNIT_BRANCHED_GETTER(get_unit_instance_groups, armies, navies);
 
+		/* Today's province changes, applied together so each province's army or navy set is rebuilt at most once. */
+		std::vector<movement_t<UnitType::branch_t::LAND>> army_movements;
+		std::vector<movement_t<UnitType::branch_t::NAVAL>> navy_movements;
+
+		UNIT_BRANCHED_GETTER(get_movements, army_movements, navy_movements);
+
+		/* Filled by each day's movement, for combat and the UI to pick up. */
+		std::vector<ArmyInstance*> PROPERTY(arrived_armies);
+		std::vector<NavyInstance*> PROPERTY(arrived_navies);
+		std::vector<encounter_t> PROPERTY(encounters);
+
 		template<UnitType::branch_t Branch>
 		bool generate_unit_instance(
 			UnitDeployment<Branch> const& unit_deployment, UnitInstanceBranched<Branch>*& unit_instance
@@ -135,7 +186,23 @@ namespace OpenVic {
 			MapInstance& map_instance, CountryInstance& country, UnitDeploymentGroup<Branch> const& unit_deployment_group
 		);
 
+		/* Distance per day the group covers moving into the destination province. */
+		template<UnitType::branch_t Branch>
+		static fixed_point_t _get_daily_movement(
+			UnitInstanceGroupBranched<Branch> const& group, ProvinceInstance const& destination,
+			ModifierEffectCache const& modifier_effect_cache
+		);
+		template<UnitType::branch_t Branch>
+		void _tick_movement(MapInstance& map_instance, ModifierEffectCache const& modifier_effect_cache);
+		template<UnitType::branch_t Branch>
+		void _apply_movements();
+
 	public:
+		UNIT_BRANCHED_GETTER_CONST(get_arrived_unit_instance_groups, arrived_armies, arrived_navies);
+
 		bool generate_deployment(MapInstance& map_instance, CountryInstance& country, Deployment const* deployment);
+
+		/* Moves every army and navy along its path, then records arrivals and encounters. */
+		void tick(MapInstance& map_instance, ModifierEffectCache const& modifier_effect_cache);
 	};
 }
@@ -0,0 +1,313 @@
+#include "EventScheduler.hpp"
+
+#include <algorithm>
+#include <bit>
+
+#include "openvic-simulation/country/CountryDefinition.hpp"
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/map/MapInstance.hpp"
+#include "openvic-simulation/misc/Event.hpp"
+#include "openvic-simulation/utility/Utility.hpp"
+
+using namespace OpenVic;
+
+/* Default seed, replaced by the session's seed once there is one. */
+static constexpr uint64_t DEFAULT_SEED = 0x4F70656E56696321;
+
+/* Mean time to happen is capped so candidate dates stay well within the range of Date. */
+static constexpr Timespan::day_t MAX_CANDIDATE_DELAY_DAYS = 100 * Date::DAYS_IN_YEAR;
+
+/* -ln(numerator / 2^16) for numerator in [1, 2^16], i.e. a sample from the exponential distribution with mean 1 when
+ * numerator is uniformly distributed. Uses integer-only binary logarithm digit extraction so results are identical on
+ * every platform. */
+static fixed_point_t negative_log(uint32_t numerator) {
+	static constexpr int64_t ONE = fixed_point_t::ONE;
+	static constexpr fixed_point_t LN_2 = fixed_point_t { static_cast<int64_t>(45426) }; // ln(2) * 2^16
+
+	const int64_t integer_part = std::bit_width(numerator) - 1;
+
+	// Normalise to y in [1, 2), then each squaring of y yields the next binary digit of log2(y)
+	uint64_t y = (static_cast<uint64_t>(numerator) << fixed_point_t::PRECISION) >> integer_part;
+	int64_t fractional_part = 0;
+	for (int64_t bit = fixed_point_t::PRECISION - 1; bit >= 0; --bit) {
+		y = (y * y) >> fixed_point_t::PRECISION;
+		if (y >= static_cast<uint64_t>(2 * ONE)) {
+			y >>= 1;
+			fractional_part |= int64_t { 1 } << bit;
+		}
+	}
+
+	const int64_t log2_numerator = (integer_part << fixed_point_t::PRECISION) | fractional_part;
+	return fixed_point_t { fixed_point_t::PRECISION * ONE - log2_numerator } * LN_2;
+}
+
+/* Scales the remaining delay of a candidate drawn with an MTTH of old_mean_days to the delay it would have had if drawn
+ * with new_mean_days. The exponential distribution is memoryless, so this is distributed exactly like a fresh draw with
+ * the new MTTH, and a candidate that is due stays due. Both means must be positive. */
+static constexpr Timespan::day_t rescale_delay(
+	Timespan::day_t remaining_days, fixed_point_t old_mean_days, fixed_point_t new_mean_days
+) {
+	return std::clamp<Timespan::day_t>(
+		(fixed_point_t::parse(remaining_days) * (new_mean_days / old_mean_days) + fixed_point_t::_0_50()).to_int64_t(),
+		0, MAX_CANDIDATE_DELAY_DAYS
+	);
+}
+
+/* An event with an MTTH of a day must still come due when its scope's sums change daily, so neither an unchanged
+ * nor a shortened MTTH may push a candidate back. */
+static_assert(rescale_delay(0, fixed_point_t::_1(), fixed_point_t::_1()) == 0);
+static_assert(rescale_delay(1, fixed_point_t::_1(), fixed_point_t::_1()) == 1);
+static_assert(rescale_delay(1, fixed_point_t::_2(), fixed_point_t::_1()) <= 1);
+static_assert(rescale_delay(30, fixed_point_t::_4(), fixed_point_t::_2()) == 15);
+
+EventScheduler::EventScheduler() : tick_statistics {}, seed { DEFAULT_SEED } {}
+
+bool EventScheduler::setup(
+	EventManager const& event_manager, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager
+) {
+	country_events.clear();
+	province_events.clear();
+	country_queues.clear();
+	province_queues.clear();
+	fired_once_events.clear();
+	fired_events.clear();
+
+	size_t unsupported_trigger_count = 0;
+
+	for (Event const& event : event_manager.get_events()) {
+		if (event.is_triggered_only()) {
+			continue;
+		}
+		if (event.get_trigger().get_bytecode().get_unsupported_condition_count() > 0) {
+			++unsupported_trigger_count;
+			continue;
+		}
+		if (event.get_type() == Event::event_type_t::COUNTRY) {
+			country_events.push_back(&event);
+		} else {
+			province_events.push_back(&event);
+		}
+	}
+
+	// Queues start dirty, so candidates are drawn on the first tick once history has been applied
+	static constexpr uint64_t NO_GENERATION = std::numeric_limits<uint64_t>::max();
+
+	country_queues.reserve(country_instance_manager.get_country_instance_count());
+	for (CountryInstance const& country : country_instance_manager.get_country_instances()) {
+		country_queues.push_back({ &country, {}, NO_GENERATION, true, true });
+	}
+
+	province_queues.reserve(map_instance.get_province_instance_count());
+	for (ProvinceInstance const& province : map_instance.get_province_instances()) {
+		province_queues.push_back({ &province, {}, NO_GENERATION, true, true });
+	}
+
+	Logger::info(
+		"Event scheduler set up with ", country_events.size(), " country events over ", country_queues.size(),
+		" countries and ", province_events.size(), " province events over ", province_queues.size(), " provinces"
+	);
+
+	if (unsupported_trigger_count > 0) {
+		Logger::warning(
+			unsupported_trigger_count, " events will never fire as their triggers contain unsupported conditions!"
+		);
+	}
+
+	return true;
+}
+
+void EventScheduler::mark_scope_dirty(ConditionScope scope) {
+	// Queues are in the same order as the country and province instances
+	if (scope.get_type() == scope_type_t::COUNTRY) {
+		const size_t index = scope.get_country()->get_country_definition()->get_index();
+		if (index < country_queues.size()) {
+			country_queues[index].dirty = true;
+		}
+	} else {
+		const size_t index = scope.get_province()->get_province_definition().get_index() - 1;
+		if (index < province_queues.size()) {
+			province_queues[index].dirty = true;
+		}
+	}
+}
+
+bool EventScheduler::_is_scope_active(ConditionScope scope) {
+	if (scope.get_type() == scope_type_t::COUNTRY) {
+		return scope.get_country()->exists();
+	}
+	// Only owned land provinces get province events
+	return scope.get_country() != nullptr;
+}
+
+uint64_t EventScheduler::_get_scope_modifier_generation(ConditionScope scope) {
+	if (scope.get_type() == scope_type_t::COUNTRY) {
+		return scope.get_country()->get_modifier_sum().get_generation();
+	}
+	return scope.get_province()->get_modifier_sum().get_generation();
+}
+
+fixed_point_t EventScheduler::_evaluate_mean_days(Event const& event, ConditionContext const& context) {
+	++tick_statistics.mtth_evaluations;
+
+	return event.get_mean_time_to_happen().evaluate(context.this_scope, context);
+}
+
+Date EventScheduler::_draw_candidate_date(
+	fixed_point_t mean_days, uint32_t event_index, size_t queue_index, bool is_province, uint32_t draw, Date today
+) const {
+	const uint64_t random = utility::mix_bits(
+		seed ^ utility::mix_bits(
+			(static_cast<uint64_t>(event_index) << 32) ^ (static_cast<uint64_t>(queue_index) << 1) ^ is_province
+		) ^ utility::mix_bits(draw)
+	);
+	// Top 16 bits mapped to [1, 2^16], so the logarithm is always finite
+	const uint32_t numerator = static_cast<uint32_t>(random >> 48) + 1;
+
+	const Timespan::day_t delay = std::clamp<Timespan::day_t>(
+		(mean_days * negative_log(numerator)).to_int64_t(), 1, MAX_CANDIDATE_DELAY_DAYS
+	);
+
+	return today + Timespan { delay };
+}
+
+/* Orders candidates for a min-heap, earliest first, with ties broken by event index so firing order is stable. */
+static constexpr auto candidate_later = [](auto const& lhs, auto const& rhs) -> bool {
+	return lhs.date != rhs.date ? rhs.date < lhs.date : lhs.event_index > rhs.event_index;
+};
+
+void EventScheduler::_redraw(
+	scope_queue_t& queue, std::vector<Event const*> const& events, size_t queue_index, bool is_province,
+	ConditionContext const& context
+) {
+	++tick_statistics.scopes_rescheduled;
+
+	// Each event keeps counting its draws, so redrawn dates differ from the ones they replace
+	draws.assign(events.size(), 0);
+	for (candidate_t const& candidate : queue.candidates) {
+		draws[candidate.event_index] = candidate.draw + 1;
+	}
+
+	queue.candidates.clear();
+
+	for (uint32_t event_index = 0; event_index < events.size(); ++event_index) {
+		Event const& event = *events[event_index];
+		if (event.get_fire_only_once() && fired_once_events.contains(&event)) {
+			continue;
+		}
+		const uint32_t draw = draws[event_index];
+		const fixed_point_t mean_days = _evaluate_mean_days(event, context);
+		queue.candidates.push_back({
+			_draw_candidate_date(mean_days, event_index, queue_index, is_province, draw, context.today), event_index, draw,
+			mean_days
+		});
+	}
+
+	std::make_heap(queue.candidates.begin(), queue.candidates.end(), candidate_later);
+
+	queue.modifier_generation = _get_scope_modifier_generation(queue.scope);
+	queue.dirty = false;
+	queue.needs_redraw = false;
+}
+
+void EventScheduler::_update_mean_days(
+	scope_queue_t& queue, std::vector<Event const*> const& events, size_t queue_index, bool is_province,
+	ConditionContext const& context
+) {
+	++tick_statistics.scopes_rescheduled;
+
+	for (candidate_t& candidate : queue.candidates) {
+		const fixed_point_t mean_days = _evaluate_mean_days(*events[candidate.event_index], context);
+		if (mean_days == candidate.mean_days) {
+			continue;
+		}
+
+		if (mean_days > 0 && candidate.mean_days > 0) {
+			candidate.date = context.today + Timespan {
+				rescale_delay((candidate.date - context.today).to_int(), candidate.mean_days, mean_days)
+			};
+		} else {
+			// There's no delay to scale from or to, so draw afresh
+			++candidate.draw;
+			candidate.date = _draw_candidate_date(
+				mean_days, candidate.event_index, queue_index, is_province, candidate.draw, context.today
+			);
+		}
+		candidate.mean_days = mean_days;
+	}
+
+	std::make_heap(queue.candidates.begin(), queue.candidates.end(), candidate_later);
+
+	queue.modifier_generation = _get_scope_modifier_generation(queue.scope);
+	queue.dirty = false;
+}
+
+void EventScheduler::_tick_queue(
+	scope_queue_t& queue, std::vector<Event const*> const& events, size_t queue_index, bool is_province,
+	ConditionContext const& context
+) {
+	if (events.empty() || !_is_scope_active(queue.scope)) {
+		// Redraw everything if the scope becomes active again, as its candidates will be long out of date by then
+		queue.needs_redraw = true;
+		return;
+	}
+
+	if (queue.needs_redraw) {
+		_redraw(queue, events, queue_index, is_province, context);
+	} else if (queue.dirty || queue.modifier_generation != _get_scope_modifier_generation(queue.scope)) {
+		_update_mean_days(queue, events, queue_index, is_province, context);
+	}
+
+	while (!queue.candidates.empty() && queue.candidates.front().date <= context.today) {
+		std::pop_heap(queue.candidates.begin(), queue.candidates.end(), candidate_later);
+		candidate_t& candidate = queue.candidates.back();
+		Event const& event = *events[candidate.event_index];
+
+		++tick_statistics.candidates_due;
+
+		if (event.get_fire_only_once() && fired_once_events.contains(&event)) {
+			queue.candidates.pop_back();
+			continue;
+		}
+
+		++tick_statistics.triggers_evaluated;
+
+		if (event.get_trigger().evaluate(queue.scope, context)) {
+			++tick_statistics.events_fired;
+			fired_events.push_back({ &event, queue.scope });
+
+			if (event.get_fire_only_once()) {
+				fired_once_events.emplace(&event);
+				queue.candidates.pop_back();
+				continue;
+			}
+		}
+
+		++candidate.draw;
+		candidate.mean_days = _evaluate_mean_days(event, context);
+		candidate.date = _draw_candidate_date(
+			candidate.mean_days, candidate.event_index, queue_index, is_province, candidate.draw, context.today
+		);
+		std::push_heap(queue.candidates.begin(), queue.candidates.end(), candidate_later);
+	}
+}
+
+void EventScheduler::tick(
+	Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager
+) {
+	tick_statistics = {};
+	fired_events.clear();
+
+	for (size_t index = 0; index < country_queues.size(); ++index) {
+		scope_queue_t& queue = country_queues[index];
+		_tick_queue(
+			queue, country_events, index, false, { map_instance, country_instance_manager, today, queue.scope, {} }
+		);
+	}
+
+	for (size_t index = 0; index < province_queues.size(); ++index) {
+		scope_queue_t& queue = province_queues[index];
+		_tick_queue(
+			queue, province_events, index, true, { map_instance, country_instance_manager, today, queue.scope, {} }
+		);
+	}
+}
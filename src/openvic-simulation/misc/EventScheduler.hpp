@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "openvic-simulation/scripts/ConditionBytecode.hpp"
+#include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/types/OrderedContainers.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct Event;
+	struct EventManager;
+	struct MapInstance;
+	struct CountryInstanceManager;
+
+	/* Schedules mean-time-to-happen events. Rather than polling every event for every scope each day, each country and
+	 * province keeps a min-heap of the next candidate date for each of its events, drawn from an exponential distribution
+	 * with the event's current MTTH as its mean. Only candidates whose date has arrived have their trigger evaluated,
+	 * after which a new date is drawn. A scope's MTTHs are re-evaluated when its modifier sum generation changes (or it
+	 * is explicitly marked dirty), as that is when its MTTH modifiers are likely to have changed. Candidates whose MTTH
+	 * is unchanged keep their date, and the others have their remaining delay scaled by the ratio of the new MTTH to the
+	 * old one; as the distribution is memoryless, that is distributed just like a fresh draw, without pushing back
+	 * candidates which are almost due. Only scopes becoming active again have all their candidates redrawn.
+	 *
+	 * Draws come from a hash of the seed, event, scope and draw count, so schedules don't depend on update order. */
+	struct EventScheduler {
+		struct tick_statistics_t {
+			size_t scopes_rescheduled;
+			size_t mtth_evaluations;
+			size_t candidates_due;
+			size_t triggers_evaluated;
+			size_t events_fired;
+		};
+
+		struct fired_event_t {
+			Event const* event;
+			ConditionScope scope;
+		};
+
+	private:
+		struct candidate_t {
+			Date date;
+			uint32_t event_index;
+			uint32_t draw;
+			fixed_point_t mean_days; // The MTTH the date was drawn or last scaled with
+		};
+
+		struct scope_queue_t {
+			ConditionScope scope;
+			std::vector<candidate_t> candidates; // Min-heap on date, ties broken by event index
+			uint64_t modifier_generation;
+			bool dirty; // MTTHs need to be re-evaluated
+			bool needs_redraw; // Candidates need to be drawn from scratch
+		};
+
+		/* Events which can fire on their own, i.e. aren't triggered_only, by scope type. Events with unsupported
+		 * conditions in their triggers are left out, so they fail closed whatever the polarity of those conditions. */
+		std::vector<Event const*> country_events;
+		std::vector<Event const*> province_events;
+		std::vector<scope_queue_t> country_queues;
+		std::vector<scope_queue_t> province_queues;
+
+		ordered_set<Event const*> fired_once_events;
+		/* Scratch, reused by every full redraw. */
+		std::vector<uint32_t> draws;
+		std::vector<fired_event_t> PROPERTY(fired_events);
+		tick_statistics_t PROPERTY(tick_statistics);
+		uint64_t PROPERTY_RW(seed);
+
+		static bool _is_scope_active(ConditionScope scope);
+		static uint64_t _get_scope_modifier_generation(ConditionScope scope);
+
+		fixed_point_t _evaluate_mean_days(Event const& event, ConditionContext const& context);
+		Date _draw_candidate_date(
+			fixed_point_t mean_days, uint32_t event_index, size_t queue_index, bool is_province, uint32_t draw, Date today
+		) const;
+		void _redraw(
+			scope_queue_t& queue, std::vector<Event const*> const& events, size_t queue_index, bool is_province,
+			ConditionContext const& context
+		);
+		void _update_mean_days(
+			scope_queue_t& queue, std::vector<Event const*> const& events, size_t queue_index, bool is_province,
+			ConditionContext const& context
+		);
+		void _tick_queue(
+			scope_queue_t& queue, std::vector<Event const*> const& events, size_t queue_index, bool is_province,
+			ConditionContext const& context
+		);
+
+	public:
+		EventScheduler();
+
+		bool setup(
+			EventManager const& event_manager, MapInstance const& map_instance,
+			CountryInstanceManager const& country_instance_manager
+		);
+
+		/* Forces the scope's MTTHs to be re-evaluated on the next tick, for changes not reflected in its modifiers. */
+		void mark_scope_dirty(ConditionScope scope);
+
+		/* Fires every event whose candidate date has arrived and whose trigger holds. Fired events can be read with
+		 * get_fired_events until the next tick. */
+		void tick(Date today, MapInstance const& map_instance, CountryInstanceManager const& country_instance_manager);
+	};
+}
@@ -9,7 +9,8 @@
 namespace OpenVic {
 	struct ModifierManager;
 
-	struct ModifierEffect : HasIdentifier {
+	/* The index is unique across all modifier effect registries, allowing effects to key dense arrays. */
+	struct ModifierEffect : HasIdentifier, HasIndex<> {
 		friend struct ModifierManager;
 
 		enum class format_t : uint8_t {
@@ -46,8 +47,8 @@ namespace OpenVic {
 		// TODO - format/precision, e.g. 80% vs 0.8 vs 0.800, 2 vs 2.0 vs 200%
 
 		ModifierEffect(
-			std::string_view new_identifier, bool new_is_positive_good, format_t new_format, target_t new_targets,
-			std::string_view new_localisation_key, bool new_has_no_effect
+			std::string_view new_identifier, index_t new_index, bool new_is_positive_good, format_t new_format,
+			target_t new_targets, std::string_view new_localisation_key, bool new_has_no_effect
 		);
 
 	public:
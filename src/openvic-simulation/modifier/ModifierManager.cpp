@@ -12,6 +12,8 @@ using namespace OpenVic::StringUtils;
 
 using enum ModifierEffect::target_t;
 
+ModifierManager::ModifierManager() : modifier_effect_count { 0 } {}
+
 void ModifierManager::lock_all_modifier_except_base_country_effects() {
 	lock_leader_modifier_effects();
 	lock_unit_terrain_modifier_effects();
@@ -59,10 +61,13 @@ bool ModifierManager::_register_modifier_effect(
 		return false;
 	}
 
-	const bool ret = registry.add_item({ std::move(identifier), is_positive_good, format, targets, localisation_key, has_no_effect });
+	const bool ret = registry.add_item({
+		std::move(identifier), modifier_effect_count, is_positive_good, format, targets, localisation_key, has_no_effect
+	});
 
 	if (ret) {
 		effect_cache = &registry.get_items().back();
+		modifier_effect_count++;
 	}
 
 	return ret;
@@ -695,7 +700,14 @@ bool ModifierManager::_add_modifier_cb(
 	if (effect->has_no_effect()) {
 		Logger::warning("This modifier does nothing: ", effect->get_identifier());
 	}
-	return expect_fixed_point(map_callback(modifier_value.values, effect))(value);
+	return expect_fixed_point([&modifier_value, effect](fixed_point_t effect_value) -> bool {
+		if (modifier_value.has_effect(*effect)) {
+			Logger::error("Duplicate modifier effect: \"", effect->get_identifier(), "\"");
+			return false;
+		}
+		modifier_value.set_effect(*effect, effect_value);
+		return true;
+	})(value);
 }
 
 NodeTools::key_value_callback_t ModifierManager::_expect_modifier_effect(
@@ -32,6 +32,8 @@ namespace OpenVic {
 		modifier_effect_registry_t IDENTIFIER_REGISTRY(base_country_modifier_effect);
 		modifier_effect_registry_t IDENTIFIER_REGISTRY(base_province_modifier_effect);
 		modifier_effect_registry_t IDENTIFIER_REGISTRY(terrain_modifier_effect);
+		/* Total number of effects across all registries, and the index given to the next registered effect. */
+		size_t PROPERTY(modifier_effect_count);
 		case_insensitive_string_set_t complex_modifiers;
 
 		IdentifierRegistry<IconModifier> IDENTIFIER_REGISTRY(event_modifier);
@@ -97,6 +99,8 @@ namespace OpenVic {
 
 		NodeTools::key_value_callback_t _expect_shared_tech_country_modifier_effect(ModifierValue& modifier_value) const;
 	public:
+		ModifierManager();
+
 		bool register_complex_modifier(const std::string_view identifier);
 		static std::string get_flat_identifier(const std::string_view complex_modifier_identifier, const std::string_view variant_identifier);
 
@@ -1,9 +1,13 @@
 #include "ModifierSum.hpp"
 
+#include <algorithm>
+#include <atomic>
+
 #include "openvic-simulation/modifier/Modifier.hpp"
 
 #include "openvic-simulation/country/CountryInstance.hpp"
 #include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
 
 using namespace OpenVic;
 
@@ -23,25 +27,100 @@ std::string ModifierSum::modifier_entry_t::to_string() const {
 	);
 }
 
+ModifierSum::ModifierSum() : parent { nullptr },
+	contributing_to_parent { false },
+	parent_contribution_excluded_targets { ModifierEffect::target_t::NO_TARGETS },
+	local_generation { 0 } {
+	value_sum.enable_dense_lookup();
+}
+
 void ModifierSum::clear() {
 	modifiers.clear();
 	value_sum.clear();
+	_stamp_generation();
 }
 
 bool ModifierSum::empty() {
 	return modifiers.empty();
 }
 
+void ModifierSum::set_parent(
+	ModifierSum const* new_parent, bool new_contributing_to_parent,
+	ModifierEffect::target_t new_parent_contribution_excluded_targets
+) {
+	if (new_parent == this) {
+		Logger::error("Cannot set modifier sum as its own parent!");
+		return;
+	}
+
+	// Without a parent there's nothing to have contributed to
+	new_contributing_to_parent &= new_parent != nullptr;
+
+	if (
+		parent != new_parent || contributing_to_parent != new_contributing_to_parent ||
+		parent_contribution_excluded_targets != new_parent_contribution_excluded_targets
+	) {
+		parent = new_parent;
+		contributing_to_parent = new_contributing_to_parent;
+		parent_contribution_excluded_targets = new_parent_contribution_excluded_targets;
+		_stamp_generation();
+	}
+}
+
+void ModifierSum::_stamp_generation() {
+	// Shared so that a stamp is never reused, e.g. by a sum that had its parent changed; relaxed as only uniqueness matters
+	static std::atomic<uint64_t> next_generation { 1 };
+
+	local_generation = next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t ModifierSum::get_generation() const {
+	/* Every stamp is greater than all earlier ones, so the largest stamp in the chain changes to a value never returned
+	 * before whenever this sum or any of its parents changes. */
+	return parent != nullptr ? std::max(local_generation, parent->get_generation()) : local_generation;
+}
+
+bool ModifierSum::_is_effect_included_in_parent(ModifierEffect const& effect) const {
+	return contributing_to_parent
+		&& ModifierEffect::excludes_targets(effect.get_targets(), parent_contribution_excluded_targets);
+}
+
 fixed_point_t ModifierSum::get_effect(ModifierEffect const& effect, bool* effect_found) const {
-	return value_sum.get_effect(effect, effect_found);
+	if (parent == nullptr) {
+		return value_sum.get_effect(effect, effect_found);
+	}
+
+	if (_is_effect_included_in_parent(effect)) {
+		// The parent's value already includes this sum's contribution
+		return parent->get_effect(effect, effect_found);
+	}
+
+	bool local_found = false, parent_found = false;
+	const fixed_point_t value = value_sum.get_effect(effect, &local_found) + parent->get_effect(effect, &parent_found);
+
+	if (effect_found != nullptr) {
+		*effect_found = local_found || parent_found;
+	}
+	return value;
 }
 
 fixed_point_t ModifierSum::get_effect_nullcheck(ModifierEffect const* effect, bool* effect_found) const {
-	return value_sum.get_effect_nullcheck(effect, effect_found);
+	if (effect != nullptr) {
+		return get_effect(*effect, effect_found);
+	}
+
+	if (effect_found != nullptr) {
+		*effect_found = false;
+	}
+	return fixed_point_t::_0();
 }
 
 bool ModifierSum::has_effect(ModifierEffect const& effect) const {
-	return value_sum.has_effect(effect);
+	return value_sum.has_effect(effect) || (parent != nullptr && parent->has_effect(effect));
+}
+
+fixed_point_t ModifierSum::get_local_effect(ModifierEffect const& effect, bool* effect_found) const {
+	return value_sum.get_effect(effect, effect_found);
 }
 
 void ModifierSum::add_modifier(
@@ -55,6 +134,7 @@ void ModifierSum::add_modifier(
 	if (multiplier != fixed_point_t::_0()) {
 		modifiers.emplace_back(&modifier, multiplier, source, excluded_targets);
 		value_sum.multiply_add_exclude_targets(modifier, multiplier, excluded_targets);
+		_stamp_generation();
 	}
 }
 
@@ -67,9 +147,21 @@ void ModifierSum::add_modifier_nullcheck(
 	}
 }
 
+void ModifierSum::add_modifiers(
+	std::span<const modifier_entry_t> modifier_entries, ModifierEffect::target_t extra_excluded_targets
+) {
+	for (modifier_entry_t const& modifier_entry : modifier_entries) {
+		add_modifier(
+			*modifier_entry.modifier, modifier_entry.source, modifier_entry.multiplier,
+			modifier_entry.excluded_targets | extra_excluded_targets
+		);
+	}
+}
+
 void ModifierSum::add_modifier_sum(ModifierSum const& modifier_sum) {
 	modifiers.insert(modifiers.end(), modifier_sum.modifiers.begin(), modifier_sum.modifiers.end());
 	value_sum += modifier_sum.value_sum;
+	_stamp_generation();
 }
 
 void ModifierSum::add_modifier_sum_exclude_targets(
@@ -95,6 +187,78 @@ void ModifierSum::add_modifier_sum_exclude_source(ModifierSum const& modifier_su
 	}
 }
 
+void ModifierSum::remove_modifiers_by_source(modifier_source_t const& source) {
+	std::erase_if(modifiers, [this, &source](modifier_entry_t const& modifier_entry) -> bool {
+		if (modifier_entry.source == source) {
+			value_sum.multiply_subtract_exclude_targets(
+				*modifier_entry.modifier, modifier_entry.multiplier, modifier_entry.excluded_targets
+			);
+			return true;
+		}
+		return false;
+	});
+	_stamp_generation();
+}
+
+void ModifierSum::remove_modifiers(
+	std::span<const modifier_entry_t> modifier_entries, ModifierEffect::target_t extra_excluded_targets
+) {
+	if (modifier_entries.empty()) {
+		return;
+	}
+
+	for (modifier_entry_t const& modifier_entry : modifier_entries) {
+		const modifier_entry_t removed_entry {
+			modifier_entry.modifier, modifier_entry.multiplier, modifier_entry.source,
+			modifier_entry.excluded_targets | extra_excluded_targets
+		};
+
+		// Entries which change are usually the most recently added, so are found near the back
+		const auto it = std::find(modifiers.rbegin(), modifiers.rend(), removed_entry);
+		if (it == modifiers.rend()) {
+			Logger::error("Cannot remove modifier entry ", removed_entry.to_string(), " - not in modifier sum!");
+			continue;
+		}
+
+		value_sum.multiply_subtract_exclude_targets(
+			*removed_entry.modifier, removed_entry.multiplier, removed_entry.excluded_targets
+		);
+		modifiers.erase(std::next(it).base());
+	}
+
+	_stamp_generation();
+}
+
+void ModifierSum::trim_unchanged_modifiers(
+	std::span<const modifier_entry_t>& old_entries, std::span<const modifier_entry_t>& new_entries
+) {
+	const size_t prefix = std::mismatch(
+		old_entries.begin(), old_entries.end(), new_entries.begin(), new_entries.end()
+	).first - old_entries.begin();
+	old_entries = old_entries.subspan(prefix);
+	new_entries = new_entries.subspan(prefix);
+
+	const size_t suffix = std::mismatch(
+		old_entries.rbegin(), old_entries.rend(), new_entries.rbegin(), new_entries.rend()
+	).first - old_entries.rbegin();
+	old_entries = old_entries.first(old_entries.size() - suffix);
+	new_entries = new_entries.first(new_entries.size() - suffix);
+}
+
+bool ModifierSum::has_equal_effect_values(ModifierSum const& other) const {
+	for (ModifierValue::effect_entry_t const& entry : value_sum.get_values()) {
+		if (entry.value != other.value_sum.get_effect(*entry.effect)) {
+			return false;
+		}
+	}
+	for (ModifierValue::effect_entry_t const& entry : other.value_sum.get_values()) {
+		if (entry.value != value_sum.get_effect(*entry.effect)) {
+			return false;
+		}
+	}
+	return true;
+}
+
 // TODO - include value_sum[effect] in result? Early return if lookup in value_sum fails?
 
 void ModifierSum::push_contributing_modifiers(
@@ -102,16 +266,23 @@ void ModifierSum::push_contributing_modifiers(
 ) const {
 	using enum ModifierEffect::target_t;
 
-	for (modifier_entry_t const& modifier_entry : modifiers) {
-		if (ModifierEffect::excludes_targets(effect.get_targets(), modifier_entry.excluded_targets)) {
-			bool effect_found = false;
-			const fixed_point_t value = modifier_entry.modifier->get_effect(effect, &effect_found);
+	// Entries already contributed to the parent are pushed by the parent
+	if (!_is_effect_included_in_parent(effect)) {
+		for (modifier_entry_t const& modifier_entry : modifiers) {
+			if (ModifierEffect::excludes_targets(effect.get_targets(), modifier_entry.excluded_targets)) {
+				bool effect_found = false;
+				const fixed_point_t value = modifier_entry.modifier->get_effect(effect, &effect_found);
 
-			if (effect_found) {
-				contributions.push_back(modifier_entry);
+				if (effect_found) {
+					contributions.push_back(modifier_entry);
+				}
 			}
 		}
 	}
+
+	if (parent != nullptr) {
+		parent->push_contributing_modifiers(effect, contributions);
+	}
 }
 
 std::vector<ModifierSum::modifier_entry_t> ModifierSum::get_contributing_modifiers(ModifierEffect const& effect) const {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <span>
 #include <variant>
 
 #include "openvic-simulation/modifier/ModifierValue.hpp"
@@ -34,7 +36,7 @@ namespace OpenVic {
 			constexpr bool operator==(modifier_entry_t const& other) const {
 				return modifier == other.modifier
 					&& multiplier == other.multiplier
-					&& source_to_string(source) == source_to_string(other.source)
+					&& source == other.source
 					&& excluded_targets == other.excluded_targets;
 			}
 
@@ -42,22 +44,53 @@ namespace OpenVic {
 		};
 
 	private:
+		// This sum's own entries, not including those of the parent layer
 		std::vector<modifier_entry_t> PROPERTY(modifiers);
+		// Dense lookup is enabled, so effect lookups and modifier adds are array accesses
 		ModifierValue PROPERTY(value_sum);
 
+		/* Optional parent layer, e.g. a province's owner country's sum. Its effect values are resolved on lookup
+		 * and added to this sum's own, rather than its entries being copied into every child sum. */
+		ModifierSum const* PROPERTY(parent);
+		/* If true, this sum's own entries have also been added to the parent with parent_contribution_excluded_targets
+		 * excluded, so for effects not targeting any of those the parent's value already includes this sum's. */
+		bool PROPERTY_CUSTOM_PREFIX(contributing_to_parent, is);
+		ModifierEffect::target_t PROPERTY(parent_contribution_excluded_targets);
+		/* Restamped from a counter shared by all sums whenever this sum's own entries or its parent link change, so it is
+		 * always greater than any generation any sum has returned before. */
+		uint64_t local_generation;
+
+		bool _is_effect_included_in_parent(ModifierEffect const& effect) const;
+		void _stamp_generation();
+
 	public:
-		ModifierSum() = default;
+		ModifierSum();
 		ModifierSum(ModifierSum const&) = default;
 		ModifierSum(ModifierSum&&) = default;
 		ModifierSum& operator=(ModifierSum const&) = default;
 		ModifierSum& operator=(ModifierSum&&) = default;
 
+		// Clears this sum's own entries, the parent link is kept.
 		void clear();
 		bool empty();
 
+		/* The parent must outlive this sum or be unset first. Does nothing if the link is unchanged, so can be
+		 * called every update. */
+		void set_parent(
+			ModifierSum const* new_parent, bool new_contributing_to_parent = false,
+			ModifierEffect::target_t new_parent_contribution_excluded_targets = ModifierEffect::target_t::NO_TARGETS
+		);
+
+		/* Changes whenever an effect value visible through this sum may have changed, including changes to the parent
+		 * layer, so callers can cache values derived from effect lookups and compare generations to invalidate them. */
+		uint64_t get_generation() const;
+
+		// Effect lookups include the parent layer, if there is one.
 		fixed_point_t get_effect(ModifierEffect const& effect, bool* effect_found = nullptr) const;
 		fixed_point_t get_effect_nullcheck(ModifierEffect const* effect, bool* effect_found = nullptr) const;
 		bool has_effect(ModifierEffect const& effect) const;
+		// Only looks up this sum's own entries, ignoring the parent layer.
+		fixed_point_t get_local_effect(ModifierEffect const& effect, bool* effect_found = nullptr) const;
 
 		void add_modifier(
 			Modifier const& modifier, modifier_source_t const& source, fixed_point_t multiplier = fixed_point_t::_1(),
@@ -67,10 +100,35 @@ namespace OpenVic {
 			Modifier const* modifier, modifier_source_t const& source, fixed_point_t multiplier = fixed_point_t::_1(),
 			ModifierEffect::target_t excluded_targets = ModifierEffect::target_t::NO_TARGETS
 		);
+		void add_modifiers(
+			std::span<const modifier_entry_t> modifier_entries,
+			ModifierEffect::target_t extra_excluded_targets = ModifierEffect::target_t::NO_TARGETS
+		);
 		void add_modifier_sum(ModifierSum const& modifier_sum);
 		void add_modifier_sum_exclude_targets(ModifierSum const& modifier_sum, ModifierEffect::target_t excluded_targets);
 		void add_modifier_sum_exclude_source(ModifierSum const& modifier_sum, modifier_source_t const& excluded_source);
 
+		/* Removing modifiers subtracts their contributions from the value sum, allowing sums to be updated
+		 * incrementally. Effects whose value drops to zero keep a zero-valued entry in the value sum. */
+		void remove_modifiers_by_source(modifier_source_t const& source);
+		/* Removes one entry matching each of modifier_entries, with extra_excluded_targets added to their excluded
+		 * targets as when they were added. Each is searched for from the most recently added entry back. */
+		void remove_modifiers(
+			std::span<const modifier_entry_t> modifier_entries,
+			ModifierEffect::target_t extra_excluded_targets = ModifierEffect::target_t::NO_TARGETS
+		);
+		/* Narrows old_entries and new_entries down to where they differ by dropping their common prefix and suffix, so
+		 * that removing what's left of old_entries from a sum and adding what's left of new_entries has the same effect
+		 * as swapping the whole lists. A group of entries which gained or lost one entry is left with just that one. */
+		static void trim_unchanged_modifiers(
+			std::span<const modifier_entry_t>& old_entries, std::span<const modifier_entry_t>& new_entries
+		);
+
+		/* Compares this sum's own effect values only, treating missing effects as zero, so ignores modifier order,
+		 * zero-valued entries and parent layers. */
+		bool has_equal_effect_values(ModifierSum const& other) const;
+
+		// Includes the parent layer's contributing modifiers, without repeating any already contributed to it by this sum.
 		void push_contributing_modifiers(ModifierEffect const& effect, std::vector<modifier_entry_t>& contributions) const;
 		std::vector<modifier_entry_t> get_contributing_modifiers(ModifierEffect const& effect) const;
 	};
@@ -1,21 +1,94 @@
 #include "ModifierValue.hpp"
 
-#include "openvic-simulation/utility/TslHelper.hpp"
+#include <algorithm>
 
 using namespace OpenVic;
 
-ModifierValue::ModifierValue() = default;
-ModifierValue::ModifierValue(effect_map_t&& new_values) : values { std::move(new_values) } {}
+static constexpr bool entry_index_less(ModifierValue::effect_entry_t const& entry, ModifierEffect::index_t index) {
+	return entry.effect->get_index() < index;
+}
+
+ModifierValue::ModifierValue() : dense_lookup_enabled { false } {}
+ModifierValue::ModifierValue(effect_list_t&& new_values) : values { std::move(new_values) }, dense_lookup_enabled { false } {
+	std::sort(values.begin(), values.end(), [](effect_entry_t const& lhs, effect_entry_t const& rhs) -> bool {
+		return lhs.effect->get_index() < rhs.effect->get_index();
+	});
+}
 ModifierValue::ModifierValue(ModifierValue const&) = default;
 ModifierValue::ModifierValue(ModifierValue&&) = default;
 
 ModifierValue& ModifierValue::operator=(ModifierValue const&) = default;
 ModifierValue& ModifierValue::operator=(ModifierValue&&) = default;
 
+ModifierValue::effect_entry_t const* ModifierValue::_find_entry(ModifierEffect const& effect) const {
+	const ModifierEffect::index_t index = effect.get_index();
+
+	if (dense_lookup_enabled) {
+		if (index < dense_positions.size()) {
+			const uint32_t position = dense_positions[index];
+			if (position != 0) {
+				return &values[position - 1];
+			}
+		}
+		return nullptr;
+	}
+
+	const effect_list_t::const_iterator it = std::lower_bound(values.begin(), values.end(), index, entry_index_less);
+	if (it != values.end() && it->effect == &effect) {
+		return &*it;
+	}
+	return nullptr;
+}
+
+fixed_point_t& ModifierValue::_get_or_insert(ModifierEffect const& effect) {
+	const ModifierEffect::index_t index = effect.get_index();
+
+	if (dense_lookup_enabled) {
+		if (index >= dense_positions.size()) {
+			dense_positions.resize(index + 1, 0);
+		}
+		uint32_t& position = dense_positions[index];
+		if (position == 0) {
+			values.push_back({ &effect, fixed_point_t::_0() });
+			position = values.size();
+		}
+		return values[position - 1].value;
+	}
+
+	effect_list_t::iterator it = std::lower_bound(values.begin(), values.end(), index, entry_index_less);
+	if (it == values.end() || it->effect != &effect) {
+		it = values.insert(it, { &effect, fixed_point_t::_0() });
+	}
+	return it->value;
+}
+
+void ModifierValue::_rebuild_dense_positions() {
+	std::fill(dense_positions.begin(), dense_positions.end(), 0);
+
+	for (size_t position = 0; position < values.size(); ++position) {
+		const ModifierEffect::index_t index = values[position].effect->get_index();
+		if (index >= dense_positions.size()) {
+			dense_positions.resize(index + 1, 0);
+		}
+		dense_positions[index] = position + 1;
+	}
+}
+
+void ModifierValue::enable_dense_lookup() {
+	if (!dense_lookup_enabled) {
+		dense_lookup_enabled = true;
+		_rebuild_dense_positions();
+	}
+}
+
 void ModifierValue::trim() {
-	erase_if(values, [](effect_map_t::value_type const& value) -> bool {
-		return value.second == fixed_point_t::_0();
+	std::erase_if(values, [](effect_entry_t const& entry) -> bool {
+		return entry.value == fixed_point_t::_0();
 	});
+
+	if (dense_lookup_enabled) {
+		_rebuild_dense_positions();
+	}
 }
 
 size_t ModifierValue::get_effect_count() const {
@@ -23,6 +96,13 @@ size_t ModifierValue::get_effect_count() const {
 }
 
 void ModifierValue::clear() {
+	if (dense_lookup_enabled) {
+		// Only reset the positions in use rather than the whole table
+		for (effect_entry_t const& entry : values) {
+			dense_positions[entry.effect->get_index()] = 0;
+		}
+	}
+
 	values.clear();
 }
 
@@ -31,12 +111,12 @@ bool ModifierValue::empty() const {
 }
 
 fixed_point_t ModifierValue::get_effect(ModifierEffect const& effect, bool* effect_found) const {
-	const effect_map_t::const_iterator it = values.find(&effect);
-	if (it != values.end()) {
+	effect_entry_t const* entry = _find_entry(effect);
+	if (entry != nullptr) {
 		if (effect_found != nullptr) {
 			*effect_found = true;
 		}
-		return it->second;
+		return entry->value;
 	}
 
 	if (effect_found != nullptr) {
@@ -57,17 +137,15 @@ fixed_point_t ModifierValue::get_effect_nullcheck(ModifierEffect const* effect,
 }
 
 bool ModifierValue::has_effect(ModifierEffect const& effect) const {
-	return values.contains(&effect);
+	return _find_entry(effect) != nullptr;
 }
 
 void ModifierValue::set_effect(ModifierEffect const& effect, fixed_point_t value) {
-	values[&effect] = value;
+	_get_or_insert(effect) = value;
 }
 
 ModifierValue& ModifierValue::operator+=(ModifierValue const& right) {
-	for (effect_map_t::value_type const& value : right.values) {
-		values[value.first] += value.second;
-	}
+	multiply_add_exclude_targets(right, fixed_point_t::_1(), ModifierEffect::target_t::NO_TARGETS);
 	return *this;
 }
 
@@ -78,16 +156,14 @@ ModifierValue ModifierValue::operator+(ModifierValue const& right) const {
 
 ModifierValue ModifierValue::operator-() const {
 	ModifierValue copy = *this;
-	for (auto value : mutable_iterator(copy.values)) {
-		value.second = -value.second;
+	for (effect_entry_t& entry : copy.values) {
+		entry.value = -entry.value;
 	}
 	return copy;
 }
 
 ModifierValue& ModifierValue::operator-=(ModifierValue const& right) {
-	for (effect_map_t::value_type const& value : right.values) {
-		values[value.first] -= value.second;
-	}
+	multiply_subtract_exclude_targets(right, fixed_point_t::_1(), ModifierEffect::target_t::NO_TARGETS);
 	return *this;
 }
 
@@ -97,8 +173,8 @@ ModifierValue ModifierValue::operator-(ModifierValue const& right) const {
 }
 
 ModifierValue& ModifierValue::operator*=(const fixed_point_t right) {
-	for (auto value : mutable_iterator(values)) {
-		value.second *= right;
+	for (effect_entry_t& entry : values) {
+		entry.value *= right;
 	}
 	return *this;
 }
@@ -113,36 +189,99 @@ void ModifierValue::apply_exclude_targets(ModifierEffect::target_t excluded_targ
 
 	// We could test if excluded_targets is NO_TARGETS (and so we do nothing) or ALL_TARGETS (and so we clear everything),
 	// but so long as this is always called with an explicit/hardcoded value then we'll never have either of those cases.
-	erase_if(
+	std::erase_if(
 		values,
-		[excluded_targets](effect_map_t::value_type const& value) -> bool {
-			return !ModifierEffect::excludes_targets(value.first->get_targets(), excluded_targets);
+		[excluded_targets](effect_entry_t const& entry) -> bool {
+			return !ModifierEffect::excludes_targets(entry.effect->get_targets(), excluded_targets);
 		}
 	);
+
+	if (dense_lookup_enabled) {
+		_rebuild_dense_positions();
+	}
 }
 
 void ModifierValue::multiply_add_exclude_targets(
 	ModifierValue const& other, fixed_point_t multiplier, ModifierEffect::target_t excluded_targets
+) {
+	_multiply_add_exclude_targets(other, multiplier, excluded_targets, false);
+}
+
+void ModifierValue::multiply_subtract_exclude_targets(
+	ModifierValue const& other, fixed_point_t multiplier, ModifierEffect::target_t excluded_targets
+) {
+	_multiply_add_exclude_targets(other, multiplier, excluded_targets, true);
+}
+
+void ModifierValue::_multiply_add_exclude_targets(
+	ModifierValue const& other, fixed_point_t multiplier, ModifierEffect::target_t excluded_targets, bool subtract
 ) {
 	using enum ModifierEffect::target_t;
 
-	if (multiplier == fixed_point_t::_1() && excluded_targets == NO_TARGETS) {
-		*this += other;
-	} else if (multiplier != fixed_point_t::_0()) {
-		// We could test that excluded_targets != ALL_TARGETS, but in practice it's always
-		// called with an explcit/hardcoded value and so won't ever exclude everything.
-		for (effect_map_t::value_type const& value : other.values) {
-			if (ModifierEffect::excludes_targets(value.first->get_targets(), excluded_targets)) {
-				values[value.first] += value.second * multiplier;
+	if (multiplier == fixed_point_t::_0()) {
+		return;
+	}
+
+	// We could test that excluded_targets != ALL_TARGETS, but in practice it's always
+	// called with an explcit/hardcoded value and so won't ever exclude everything.
+	const auto is_included = [excluded_targets](effect_entry_t const& entry) -> bool {
+		return excluded_targets == NO_TARGETS || ModifierEffect::excludes_targets(entry.effect->get_targets(), excluded_targets);
+	};
+	const auto product = [multiplier, subtract](effect_entry_t const& entry) -> fixed_point_t {
+		const fixed_point_t value = entry.value * multiplier;
+		return subtract ? -value : value;
+	};
+
+	if (dense_lookup_enabled) {
+		for (effect_entry_t const& entry : other.values) {
+			if (is_included(entry)) {
+				_get_or_insert(*entry.effect) += product(entry);
+			}
+		}
+		return;
+	}
+
+	if (other.is_dense_lookup_enabled()) {
+		// Other's entries aren't in index order, so fall back to individual sorted inserts
+		for (effect_entry_t const& entry : other.values) {
+			if (is_included(entry)) {
+				_get_or_insert(*entry.effect) += product(entry);
 			}
 		}
+		return;
 	}
+
+	// Both lists are sorted by effect index, so merge them in a single pass
+	effect_list_t merged;
+	merged.reserve(values.size() + other.values.size());
+
+	effect_list_t::const_iterator it = values.begin();
+	for (effect_entry_t const& entry : other.values) {
+		if (!is_included(entry)) {
+			continue;
+		}
+
+		const ModifierEffect::index_t index = entry.effect->get_index();
+		while (it != values.end() && it->effect->get_index() < index) {
+			merged.push_back(*it++);
+		}
+
+		if (it != values.end() && it->effect == entry.effect) {
+			merged.push_back({ entry.effect, it->value + product(entry) });
+			++it;
+		} else {
+			merged.push_back({ entry.effect, product(entry) });
+		}
+	}
+	merged.insert(merged.end(), it, values.cend());
+
+	values = std::move(merged);
 }
 
 namespace OpenVic { // so the compiler shuts up
 	std::ostream& operator<<(std::ostream& stream, ModifierValue const& value) {
-		for (ModifierValue::effect_map_t::value_type const& effect : value.values) {
-			stream << effect.first << ": " << effect.second << "\n";
+		for (ModifierValue::effect_entry_t const& entry : value.values) {
+			stream << entry.effect << ": " << entry.value << "\n";
 		}
 		return stream;
 	}
@@ -1,26 +1,49 @@
 #pragma once
 
+#include <vector>
+
 #include "openvic-simulation/modifier/ModifierEffect.hpp"
 #include "openvic-simulation/types/fixed_point/FixedPointMap.hpp"
 
 namespace OpenVic {
+	/* Effect values are stored as a list of entries sorted by ModifierEffect index, so lookups are binary searches and
+	 * adding one value to another is a linear merge. Values which are looked up and added to repeatedly, such as
+	 * ModifierSum totals, can enable dense lookup, which keeps entries in insertion order and maps each effect index
+	 * directly to its entry's position, turning lookups and adds into array accesses. */
 	struct ModifierValue {
-		friend struct ModifierManager;
+		struct effect_entry_t {
+			ModifierEffect const* effect;
+			fixed_point_t value;
+		};
 
-		using effect_map_t = fixed_point_map_t<ModifierEffect const*>;
+		using effect_list_t = std::vector<effect_entry_t>;
 
 	private:
-		effect_map_t PROPERTY(values);
+		effect_list_t PROPERTY(values);
+		/* Indexed by ModifierEffect index, holding 1 + the position of the effect's entry in values, or 0 if the effect
+		 * has no entry. Empty unless dense lookup is enabled. */
+		std::vector<uint32_t> dense_positions;
+		bool PROPERTY_CUSTOM_PREFIX(dense_lookup_enabled, is);
+
+		effect_entry_t const* _find_entry(ModifierEffect const& effect) const;
+		fixed_point_t& _get_or_insert(ModifierEffect const& effect);
+		void _rebuild_dense_positions();
+		void _multiply_add_exclude_targets(
+			ModifierValue const& other, fixed_point_t multiplier, ModifierEffect::target_t excluded_targets, bool subtract
+		);
 
 	public:
 		ModifierValue();
-		ModifierValue(effect_map_t&& new_values);
+		ModifierValue(effect_list_t&& new_values);
 		ModifierValue(ModifierValue const&);
 		ModifierValue(ModifierValue&&);
 
 		ModifierValue& operator=(ModifierValue const&);
 		ModifierValue& operator=(ModifierValue&&);
 
+		/* Dense lookup memory grows with the highest effect index added, not with the number of effects. */
+		void enable_dense_lookup();
+
 		/* Removes effect entries with a value of zero. */
 		void trim();
 		size_t get_effect_count() const;
@@ -44,6 +67,11 @@ namespace OpenVic {
 		void multiply_add_exclude_targets(
 			ModifierValue const& other, fixed_point_t multiplier, ModifierEffect::target_t excluded_targets
 		);
+		/* Exactly undoes multiply_add_exclude_targets with the same arguments, as each product is negated after
+		 * multiplying rather than multiplying by the negated multiplier, which could round differently. */
+		void multiply_subtract_exclude_targets(
+			ModifierValue const& other, fixed_point_t multiplier, ModifierEffect::target_t excluded_targets
+		);
 
 		friend std::ostream& operator<<(std::ostream& stream, ModifierValue const& value);
 	};
@@ -9,6 +9,7 @@
 #include "openvic-simulation/politics/Ideology.hpp"
 #include "openvic-simulation/politics/Issue.hpp"
 #include "openvic-simulation/politics/Rebel.hpp"
+#include "openvic-simulation/pop/PopStore.hpp"
 #include "openvic-simulation/utility/Logger.hpp"
 #include "openvic-simulation/utility/TslHelper.hpp"
 
@@ -23,9 +24,16 @@ PopBase::PopBase(
 ) : type { &new_type }, culture { new_culture }, religion { new_religion }, size { new_size }, militancy { new_militancy },
 	consciousness { new_consciousness }, rebel_type { new_rebel_type } {}
 
-Pop::Pop(PopBase const& pop_base, decltype(ideologies)::keys_t const& ideology_keys)
-  : PopBase { pop_base },
+Pop::Pop(PopBase const& pop_base, PopStore& new_store, handle_t new_handle)
+  : store { &new_store },
+	handle { new_handle },
+	type { pop_base.get_type() },
+	culture { pop_base.get_culture() },
+	religion { pop_base.get_religion() },
+	rebel_type { pop_base.get_rebel_type() },
 	location { nullptr },
+	province_type_slot { 0 },
+	state_type_slot { 0 },
 	total_change { 0 },
 	num_grown { 0 },
 	num_promoted { 0 },
@@ -33,22 +41,91 @@ Pop::Pop(PopBase const& pop_base, decltype(ideologies)::keys_t const& ideology_k
 	num_migrated_internal { 0 },
 	num_migrated_external { 0 },
 	num_migrated_colonial { 0 },
-	ideologies { &ideology_keys },
-	issues {},
 	votes { nullptr },
 	unemployment { 0 },
-	cash { 0 },
 	income { 0 },
 	expenses { 0 },
 	savings { 0 },
-	life_needs_fulfilled { 0 },
-	everyday_needs_fulfilled { 0 },
-	luxury_needs_fulfilled { 0 },
-	max_supported_regiments { 0 } {}
+	artisanal_producer { type->get_is_artisan() ? std::optional<ArtisanalProducer> { std::in_place } : std::nullopt } {}
+
+Pop::pop_size_t Pop::get_size() const {
+	return store->get_sizes()[handle];
+}
+
+fixed_point_t Pop::get_militancy() const {
+	return store->get_militancies()[handle];
+}
+
+fixed_point_t Pop::get_consciousness() const {
+	return store->get_consciousnesses()[handle];
+}
+
+fixed_point_t Pop::get_literacy() const {
+	return store->get_literacies()[handle];
+}
+
+fixed_point_t Pop::get_cash() const {
+	return store->get_cash_amounts()[handle];
+}
+
+fixed_point_t Pop::get_unreserved_cash() const {
+	return store->get_unreserved_cash(handle);
+}
+
+void Pop::reserve_cash(const fixed_point_t amount) {
+	store->get_reserved_cash(handle) += amount;
+}
+
+fixed_point_t Pop::get_life_needs_fulfilled() const {
+	return store->get_life_needs_fulfilments()[handle];
+}
+
+fixed_point_t Pop::get_everyday_needs_fulfilled() const {
+	return store->get_everyday_needs_fulfilments()[handle];
+}
+
+fixed_point_t Pop::get_luxury_needs_fulfilled() const {
+	return store->get_luxury_needs_fulfilments()[handle];
+}
+
+size_t Pop::get_max_supported_regiments() const {
+	return store->get_max_supported_regiment_counts()[handle];
+}
+
+ArtisanalProducer* Pop::get_artisanal_producer() {
+	return artisanal_producer.has_value() ? &*artisanal_producer : nullptr;
+}
+
+ArtisanalProducer const* Pop::get_artisanal_producer() const {
+	return artisanal_producer.has_value() ? &*artisanal_producer : nullptr;
+}
+
+std::span<const fixed_point_t> Pop::get_ideologies() const {
+	return std::as_const(*store).get_ideologies(handle);
+}
+
+fixed_point_t Pop::get_ideology_support(Ideology const& ideology) const {
+	IndexedMap<Ideology, fixed_point_t>::keys_t const* ideology_keys = store->get_ideology_keys();
+	if (ideology_keys == nullptr || &ideology < ideology_keys->data() || &ideology > &ideology_keys->back()) {
+		return fixed_point_t::_0();
+	}
+	return get_ideologies()[std::distance(ideology_keys->data(), &ideology)];
+}
+
+std::span<const fixed_point_t> Pop::get_issues() const {
+	return std::as_const(*store).get_issues(handle);
+}
+
+fixed_point_t Pop::get_issue_support(Issue const& issue) const {
+	const size_t column = store->get_issue_column(issue);
+	return column < store->get_issue_count() ? get_issues()[column] : fixed_point_t::_0();
+}
 
 void Pop::setup_pop_test_values(IssueManager const& issue_manager) {
+	const pop_size_t size = get_size();
+
 	/* Returns +/- range% of size. */
-	const auto test_size = [this](int32_t range) -> pop_size_t {
+	const auto test_size = [size](int32_t range) -> pop_size_t {
 		return size * ((rand() % (2 * range + 1)) - range) / 100;
 	};
 
@@ -62,41 +139,54 @@ void Pop::setup_pop_test_values(IssueManager const& issue_manager) {
 	total_change =
 		num_grown + num_promoted + num_demoted + num_migrated_internal + num_migrated_external + num_migrated_colonial;
 
-	/* Generates a number between 0 and max (inclusive) and sets map[&key] to it if it's at least min. */
-	auto test_weight =
-		[]<typename T, typename U>(T& map, U const& key, int32_t min, int32_t max) -> void {
-			const int32_t value = rand() % (max + 1);
-			if (value >= min) {
-				if constexpr (utility::is_specialization_of_v<T, IndexedMap>) {
-					map[key] = value;
-				} else {
-					map.emplace(&key, value);
-				}
+	/* Generates a number between 0 and max (inclusive) and returns it if it's at least min, otherwise 0. */
+	const auto test_weight = [](int32_t min, int32_t max) -> fixed_point_t {
+		const int32_t value = rand() % (max + 1);
+		return value >= min ? fixed_point_t::parse(value) : fixed_point_t::_0();
+	};
+
+	/* Divides all values by their total, if it is positive. */
+	const auto normalise = [](std::span<fixed_point_t> values) -> void {
+		fixed_point_t total = 0;
+		for (fixed_point_t const& value : values) {
+			total += value;
+		}
+		if (total > 0) {
+			for (fixed_point_t& value : values) {
+				value /= total;
 			}
-		};
+		}
+	};
 
 	/* All entries equally weighted for testing. */
-	ideologies.clear();
-	for (Ideology const& ideology : *ideologies.get_keys()) {
-		test_weight(ideologies, ideology, 1, 5);
+	std::span<fixed_point_t> ideologies = store->get_ideologies(handle);
+	for (fixed_point_t& ideology_support : ideologies) {
+		ideology_support = test_weight(1, 5);
 	}
-	ideologies.normalise();
+	normalise(ideologies);
 
-	issues.clear();
+	std::span<fixed_point_t> issues = store->get_issues(handle);
+	std::fill(issues.begin(), issues.end(), fixed_point_t::_0());
 	for (Issue const& issue : issue_manager.get_issues()) {
-		test_weight(issues, issue, 3, 6);
+		const size_t column = store->get_issue_column(issue);
+		if (column < issues.size()) {
+			issues[column] = test_weight(3, 6);
+		}
 	}
 	for (Reform const& reform : issue_manager.get_reforms()) {
 		if (!reform.get_reform_group().get_type().is_uncivilised()) {
-			test_weight(issues, reform, 3, 6);
+			const size_t column = store->get_issue_column(reform);
+			if (column < issues.size()) {
+				issues[column] = test_weight(3, 6);
+			}
 		}
 	}
-	normalise_fixed_point_map(issues);
+	normalise(issues);
 
 	if (votes.has_keys()) {
 		votes.clear();
 		for (CountryParty const& party : *votes.get_keys()) {
-			test_weight(votes, party, 4, 10);
+			votes[party] = test_weight(4, 10);
 		}
 		votes.normalise();
 	}
@@ -107,13 +197,13 @@ void Pop::setup_pop_test_values(IssueManager const& issue_manager) {
 	};
 
 	unemployment = test_range();
-	cash = test_range(20);
+	store->get_cash(handle) = test_range(20);
 	income = test_range(5);
 	expenses = test_range(5);
 	savings = test_range(15);
-	life_needs_fulfilled = test_range();
-	everyday_needs_fulfilled = test_range();
-	luxury_needs_fulfilled = test_range();
+	store->get_life_needs_fulfilled(handle) = test_range();
+	store->get_everyday_needs_fulfilled(handle) = test_range();
+	store->get_luxury_needs_fulfilled(handle) = test_range();
 }
 
 bool Pop::convert_to_equivalent() {
@@ -124,6 +214,13 @@ bool Pop::convert_to_equivalent() {
 	}
 	
 	type = equivalent;
+
+	if (!type->get_is_artisan()) {
+		artisanal_producer.reset();
+	} else if (!artisanal_producer.has_value()) {
+		artisanal_producer.emplace();
+	}
+
 	return true;
 }
 
@@ -145,25 +242,36 @@ void Pop::update_gamestate(
 ) {
 	if (type->get_can_be_recruited()) {
 		MilitaryDefines const& military_defines = define_manager.get_military_defines();
+		const pop_size_t size = get_size();
 
 		if (
 			size < military_defines.get_min_pop_size_for_regiment() || owner == nullptr ||
 			!RegimentType::allowed_cultures_check_culture_in_country(owner->get_allowed_regiment_cultures(), culture, *owner)
 		) {
-			max_supported_regiments = 0;
+			store->get_max_supported_regiments(handle) = 0;
 		} else {
-			max_supported_regiments = (fixed_point_t::parse(size) / (
+			store->get_max_supported_regiments(handle) = (fixed_point_t::parse(size) / (
 				fixed_point_t::parse(military_defines.get_pop_size_per_regiment()) * pop_size_per_regiment_multiplier
 			)).to_int64_t() + 1;
 		}
 	}
 }
 
-//TODO store income
-void Pop::add_rgo_owner_income(const fixed_point_t income) {}
-void Pop::add_rgo_worker_income(const fixed_point_t income) {}
+//TODO store income by source
+void Pop::add_rgo_owner_income(const fixed_point_t income) {
+	store->get_cash(handle) += income;
+}
+void Pop::add_rgo_worker_income(const fixed_point_t income) {
+	store->get_cash(handle) += income;
+}
+void Pop::add_factory_worker_income(const fixed_point_t income) {
+	store->get_cash(handle) += income;
+}
+void Pop::add_artisanal_income(const fixed_point_t income) {
+	store->get_cash(handle) += income;
+}
 
-Strata::Strata(std::string_view new_identifier) : HasIdentifier { new_identifier } {}
+Strata::Strata(std::string_view new_identifier, rank_t new_rank) : HasIdentifier { new_identifier }, rank { new_rank } {}
 
 PopType::PopType(
 	std::string_view new_identifier,
@@ -267,7 +375,19 @@ bool PopManager::add_strata(std::string_view identifier) {
 		Logger::error("Invalid strata identifier - empty!");
 		return false;
 	}
-	return stratas.add_item({ identifier });
+
+	using enum Strata::rank_t;
+
+	Strata::rank_t rank = MIDDLE;
+	if (identifier == "poor") {
+		rank = POOR;
+	} else if (identifier == "rich") {
+		rank = RICH;
+	} else if (identifier != "middle") {
+		Logger::warning("Unknown strata \"", identifier, "\", ranking it as middle strata!");
+	}
+
+	return stratas.add_item({ identifier, rank });
 }
 
 bool PopManager::add_pop_type(
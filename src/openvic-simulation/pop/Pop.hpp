@@ -1,10 +1,13 @@
 #pragma once
 
 #include <limits>
+#include <optional>
 #include <ostream>
+#include <span>
 #include <tuple>
 
 #include "openvic-simulation/economy/GoodDefinition.hpp"
+#include "openvic-simulation/economy/production/ArtisanalProducer.hpp"
 #include "openvic-simulation/pop/Culture.hpp"
 #include "openvic-simulation/pop/Religion.hpp"
 #include "openvic-simulation/scripts/ConditionalWeight.hpp"
@@ -28,9 +31,11 @@ namespace OpenVic {
 	struct CountryParty;
 	struct DefineManager;
 	struct CountryInstance;
+	struct PopStore;
 
 	struct PopBase {
 		friend struct PopManager;
+		friend struct ProvinceInstance;
 
 		using pop_size_t = int32_t;
 
@@ -52,13 +57,32 @@ namespace OpenVic {
 	/* REQUIREMENTS:
 	 * POP-18, POP-19, POP-20, POP-21, POP-34, POP-35, POP-36, POP-37
 	 */
-	struct Pop : PopBase {
+	struct Pop {
 		friend struct ProvinceInstance;
+		friend struct PopStore;
+		friend struct State;
+
+		using pop_size_t = PopBase::pop_size_t;
+		using handle_t = uint32_t;
 
 		static constexpr pop_size_t MAX_SIZE = std::numeric_limits<pop_size_t>::max();
 
 	private:
+		/* Size, militancy, consciousness, literacy, cash, needs fulfilment, supported regiments and ideology/issue
+		 * support are stored in the PopStore's columns under this pop's handle. */
+		PopStore* store;
+		handle_t PROPERTY(handle);
+
+		PopType const* PROPERTY(type);
+		Culture const& PROPERTY(culture);
+		Religion const& PROPERTY(religion);
+		RebelType const* PROPERTY(rebel_type);
+
 		ProvinceInstance const* PROPERTY(location);
+		/* This pop's positions in its province's and state's lists of pops of its type, so it can be removed from them
+		 * by swapping with the last entry rather than searching. */
+		size_t province_type_slot;
+		size_t state_type_slot;
 
 		/* Last day's size change by source. */
 		pop_size_t PROPERTY(total_change);
@@ -69,24 +93,17 @@ namespace OpenVic {
 		pop_size_t PROPERTY(num_migrated_external);
 		pop_size_t PROPERTY(num_migrated_colonial);
 
-		fixed_point_t PROPERTY(literacy);
-
-		IndexedMap<Ideology, fixed_point_t> PROPERTY(ideologies);
-		fixed_point_map_t<Issue const*> PROPERTY(issues);
 		IndexedMap<CountryParty, fixed_point_t> PROPERTY(votes);
 
 		fixed_point_t PROPERTY(unemployment);
-		fixed_point_t PROPERTY(cash);
 		fixed_point_t PROPERTY(income);
 		fixed_point_t PROPERTY(expenses);
 		fixed_point_t PROPERTY(savings);
-		fixed_point_t PROPERTY(life_needs_fulfilled);
-		fixed_point_t PROPERTY(everyday_needs_fulfilled);
-		fixed_point_t PROPERTY(luxury_needs_fulfilled);
 
-		size_t PROPERTY(max_supported_regiments);
+		/* Only set for pops whose type is an artisan type. */
+		std::optional<ArtisanalProducer> artisanal_producer;
 
-		Pop(PopBase const& pop_base, decltype(ideologies)::keys_t const& ideology_keys);
+		Pop(PopBase const& pop_base, PopStore& new_store, handle_t new_handle);
 
 	public:
 		Pop(Pop const&) = delete;
@@ -94,6 +111,29 @@ namespace OpenVic {
 		Pop& operator=(Pop const&) = delete;
 		Pop& operator=(Pop&&) = delete;
 
+		pop_size_t get_size() const;
+		fixed_point_t get_militancy() const;
+		fixed_point_t get_consciousness() const;
+		fixed_point_t get_literacy() const;
+		fixed_point_t get_cash() const;
+		/* See PopStore::reserved_cash_amounts. */
+		fixed_point_t get_unreserved_cash() const;
+		void reserve_cash(const fixed_point_t amount);
+		fixed_point_t get_life_needs_fulfilled() const;
+		fixed_point_t get_everyday_needs_fulfilled() const;
+		fixed_point_t get_luxury_needs_fulfilled() const;
+		size_t get_max_supported_regiments() const;
+
+		ArtisanalProducer* get_artisanal_producer();
+		ArtisanalProducer const* get_artisanal_producer() const;
+
+		/* Support per ideology, in ideology registry order. */
+		std::span<const fixed_point_t> get_ideologies() const;
+		fixed_point_t get_ideology_support(Ideology const& ideology) const;
+		/* Support per issue and reform, in PopStore::get_issue_keys() order. */
+		std::span<const fixed_point_t> get_issues() const;
+		fixed_point_t get_issue_support(Issue const& issue) const;
+
 		void setup_pop_test_values(IssueManager const& issue_manager);
 		bool convert_to_equivalent();
 
@@ -106,13 +146,22 @@ namespace OpenVic {
 
 		void add_rgo_owner_income(const fixed_point_t income);
 		void add_rgo_worker_income(const fixed_point_t income);
+		void add_factory_worker_income(const fixed_point_t income);
+		/* Net of input purchases, so may be negative. */
+		void add_artisanal_income(const fixed_point_t income);
 	};
 
 	struct Strata : HasIdentifier {
 		friend struct PopManager;
 
+		/* Social rank, for telling promotions from demotions. Stratas are registered in the order pop type files first
+		 * use them, so their registry order says nothing about rank. */
+		enum struct rank_t : uint8_t { POOR, MIDDLE, RICH };
+
 	private:
-		Strata(std::string_view new_identifier);
+		const rank_t PROPERTY(rank);
+
+		Strata(std::string_view new_identifier, rank_t new_rank);
 
 	public:
 		Strata(Strata&&) = default;
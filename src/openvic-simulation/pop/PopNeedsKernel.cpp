@@ -0,0 +1,250 @@
+#include "PopNeedsKernel.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "openvic-simulation/defines/PopsDefines.hpp"
+#include "openvic-simulation/economy/GoodDefinition.hpp"
+#include "openvic-simulation/map/ProvinceDefinition.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/modifier/ModifierEffectCache.hpp"
+#include "openvic-simulation/pop/PopStore.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+PopNeedsKernel::PopNeedsKernel() : pop_types { nullptr }, goods { nullptr }, good_count { 0 }, needs_pop_size { 1 } {}
+
+bool PopNeedsKernel::setup(
+	std::vector<PopType> const& new_pop_types, GoodDefinitionManager const& good_definition_manager,
+	PopsDefines const& pops_defines, size_t province_count
+) {
+	if (!good_definition_manager.good_definitions_are_locked()) {
+		Logger::error("Cannot set up pop needs - good definitions are not locked!");
+		return false;
+	}
+
+	if (pops_defines.get_needs_pop_size() <= 0) {
+		Logger::error("Cannot set up pop needs - invalid needs pop size ", pops_defines.get_needs_pop_size());
+		return false;
+	}
+
+	pop_types = &new_pop_types;
+	goods = &good_definition_manager.get_good_definitions();
+	good_count = goods->size();
+	needs_pop_size = pops_defines.get_needs_pop_size();
+
+	const size_t row_count = pop_types->size() * TIER_COUNT;
+
+	needs.assign(row_count * good_count, fixed_point_t::_0());
+	for (size_t pop_type_index = 0; pop_type_index < pop_types->size(); ++pop_type_index) {
+		PopType const& pop_type = (*pop_types)[pop_type_index];
+		const std::array<GoodDefinition::good_definition_map_t const*, TIER_COUNT> tiers {
+			&pop_type.get_life_needs(), &pop_type.get_everyday_needs(), &pop_type.get_luxury_needs()
+		};
+
+		for (size_t tier = 0; tier < TIER_COUNT; ++tier) {
+			fixed_point_t* row = needs.data() + (pop_type_index * TIER_COUNT + tier) * good_count;
+			for (auto const& [good, quantity] : *tiers[tier]) {
+				row[good->get_index()] += quantity * pops_defines.get_base_goods_demand();
+			}
+		}
+	}
+
+	row_costs.assign(row_count, fixed_point_t::_0());
+	prices.assign(good_count, fixed_point_t::_0());
+
+	province_row_weights.assign(province_count * row_count, fixed_point_t::_0());
+	province_demand.assign(province_count * good_count, fixed_point_t::_0());
+	province_purchases.assign(province_count * good_count, { fixed_point_t::_0(), fixed_point_t::_0() });
+
+	affordable_fractions.clear();
+
+	need_factors.assign(pop_types->size(), {});
+	good_fill_ratios.assign(good_count, fixed_point_t::_0());
+	filled_row_costs.assign(row_count, fixed_point_t::_0());
+
+	return true;
+}
+
+size_t PopNeedsKernel::_get_pop_type_index(PopType const& pop_type) const {
+	return std::distance(pop_types->data(), &pop_type);
+}
+
+void PopNeedsKernel::_update_need_factors(
+	ProvinceInstance const& province, ModifierEffectCache const& modifier_effect_cache
+) {
+	for (size_t pop_type_index = 0; pop_type_index < pop_types->size(); ++pop_type_index) {
+		ModifierEffectCache::strata_effects_t const& strata_effects =
+			modifier_effect_cache.get_strata_effects()[(*pop_types)[pop_type_index].get_strata()];
+
+		need_factors[pop_type_index] = {
+			std::max(
+				fixed_point_t::_1() + province.get_modifier_effect_value_nullcheck(strata_effects.get_life_needs()),
+				fixed_point_t::_0()
+			),
+			std::max(
+				fixed_point_t::_1() + province.get_modifier_effect_value_nullcheck(strata_effects.get_everyday_needs()),
+				fixed_point_t::_0()
+			),
+			std::max(
+				fixed_point_t::_1() + province.get_modifier_effect_value_nullcheck(strata_effects.get_luxury_needs()),
+				fixed_point_t::_0()
+			)
+		};
+	}
+}
+
+void PopNeedsKernel::update_costs(MarketInstance const& market_instance) {
+	if (goods == nullptr) {
+		return;
+	}
+
+	for (size_t good_index = 0; good_index < good_count; ++good_index) {
+		prices[good_index] = market_instance.is_good_available((*goods)[good_index])
+			? market_instance.get_price((*goods)[good_index]) : fixed_point_t::_0();
+	}
+
+	for (size_t row = 0; row < row_costs.size(); ++row) {
+		fixed_point_t const* row_needs = needs.data() + row * good_count;
+		fixed_point_t cost = fixed_point_t::_0();
+		for (size_t good_index = 0; good_index < good_count; ++good_index) {
+			cost += row_needs[good_index] * prices[good_index];
+		}
+		row_costs[row] = cost;
+	}
+}
+
+void PopNeedsKernel::place_orders(
+	ProvinceInstance const& province, PopStore& pop_store, MarketInstance& market_instance,
+	ModifierEffectCache const& modifier_effect_cache
+) {
+	if (goods == nullptr) {
+		return;
+	}
+
+	const size_t row_count = row_costs.size();
+	const size_t province_index = province.get_province_definition().get_index() - 1;
+	if ((province_index + 1) * row_count > province_row_weights.size()) {
+		Logger::error("Cannot place pop needs orders for province ", province.get_identifier(), " - index out of range!");
+		return;
+	}
+
+	_update_need_factors(province, modifier_effect_cache);
+
+	fixed_point_t* row_weights = province_row_weights.data() + province_index * row_count;
+	fixed_point_t* demand = province_demand.data() + province_index * good_count;
+	MarketInstance::order_result_t* purchases = province_purchases.data() + province_index * good_count;
+
+	std::fill(row_weights, row_weights + row_count, fixed_point_t::_0());
+	std::fill(demand, demand + good_count, fixed_point_t::_0());
+
+	if (affordable_fractions.size() < pop_store.get_slot_count()) {
+		affordable_fractions.resize(pop_store.get_slot_count());
+	}
+
+	std::vector<Pop::pop_size_t> const& sizes = pop_store.get_sizes();
+
+	for (const PopStore::handle_t handle : province.get_pop_handles()) {
+		const size_t pop_type_index = _get_pop_type_index(*pop_store.get_pop(handle).get_type());
+		const fixed_point_t size = fixed_point_t::parse(sizes[handle]);
+		tier_values_t const& factors = need_factors[pop_type_index];
+		tier_values_t& fractions = affordable_fractions[handle];
+
+		/* Tiers are bought in order, so luxury needs only get what's left after life and everyday needs, all from the
+		 * cash not already reserved for other orders such as an artisan's inputs. */
+		const fixed_point_t available_cash = pop_store.get_unreserved_cash(handle);
+		fixed_point_t cash = available_cash;
+		for (size_t tier = 0; tier < TIER_COUNT; ++tier) {
+			const size_t row = pop_type_index * TIER_COUNT + tier;
+			const fixed_point_t scale = size * factors[tier] / needs_pop_size;
+			const fixed_point_t cost = row_costs[row] * scale;
+
+			fractions[tier] = cost > cash ? cash / cost : fixed_point_t::_1();
+			cash -= fractions[tier] * cost;
+			row_weights[row] += fractions[tier] * scale;
+		}
+		pop_store.get_reserved_cash(handle) += available_cash - cash;
+	}
+
+	for (size_t row = 0; row < row_count; ++row) {
+		const fixed_point_t weight = row_weights[row];
+		if (weight <= fixed_point_t::_0()) {
+			continue;
+		}
+		fixed_point_t const* row_needs = needs.data() + row * good_count;
+		for (size_t good_index = 0; good_index < good_count; ++good_index) {
+			demand[good_index] += row_needs[good_index] * weight;
+		}
+	}
+
+	for (size_t good_index = 0; good_index < good_count; ++good_index) {
+		market_instance.place_buy_order((*goods)[good_index], demand[good_index], &purchases[good_index]);
+	}
+}
+
+void PopNeedsKernel::apply_results(
+	ProvinceInstance const& province, PopStore& pop_store, ModifierEffectCache const& modifier_effect_cache
+) {
+	if (goods == nullptr) {
+		return;
+	}
+
+	const size_t row_count = row_costs.size();
+	const size_t province_index = province.get_province_definition().get_index() - 1;
+	if ((province_index + 1) * row_count > province_row_weights.size()) {
+		return;
+	}
+
+	_update_need_factors(province, modifier_effect_cache);
+
+	fixed_point_t const* row_weights = province_row_weights.data() + province_index * row_count;
+	fixed_point_t const* demand = province_demand.data() + province_index * good_count;
+	MarketInstance::order_result_t const* purchases = province_purchases.data() + province_index * good_count;
+
+	for (size_t good_index = 0; good_index < good_count; ++good_index) {
+		good_fill_ratios[good_index] = demand[good_index] > fixed_point_t::_0()
+			? purchases[good_index].quantity / demand[good_index] : fixed_point_t::_0();
+	}
+
+	// The cost of each row counting only the quantities actually bought, so pops pay exactly what the market charged
+	for (size_t row = 0; row < row_count; ++row) {
+		fixed_point_t filled_cost = fixed_point_t::_0();
+		if (row_weights[row] > fixed_point_t::_0()) {
+			fixed_point_t const* row_needs = needs.data() + row * good_count;
+			for (size_t good_index = 0; good_index < good_count; ++good_index) {
+				filled_cost += row_needs[good_index] * prices[good_index] * good_fill_ratios[good_index];
+			}
+		}
+		filled_row_costs[row] = filled_cost;
+	}
+
+	std::vector<Pop::pop_size_t> const& sizes = pop_store.get_sizes();
+
+	for (const PopStore::handle_t handle : province.get_pop_handles()) {
+		const size_t pop_type_index = _get_pop_type_index(*pop_store.get_pop(handle).get_type());
+		const fixed_point_t size = fixed_point_t::parse(sizes[handle]);
+		tier_values_t const& factors = need_factors[pop_type_index];
+		tier_values_t const& fractions = affordable_fractions[handle];
+
+		tier_values_t fulfilments;
+		fixed_point_t spent = fixed_point_t::_0();
+		for (size_t tier = 0; tier < TIER_COUNT; ++tier) {
+			const size_t row = pop_type_index * TIER_COUNT + tier;
+			// Same scale and order of operations as the amount reserved, so spent can never exceed it
+			const fixed_point_t scale = size * factors[tier] / needs_pop_size;
+			spent += fractions[tier] * (filled_row_costs[row] * scale);
+			fulfilments[tier] = row_costs[row] > fixed_point_t::_0()
+				? fractions[tier] * filled_row_costs[row] / row_costs[row] : fixed_point_t::_1();
+		}
+
+		/* place_orders only budgeted cash no other order had reserved, and filled quantities never cost more than
+		 * ordered ones, so this can't overdraw the pop. */
+		fixed_point_t& cash = pop_store.get_cash(handle);
+		assert(spent <= std::max(cash, fixed_point_t::_0()));
+		cash -= spent;
+		pop_store.get_life_needs_fulfilled(handle) = fulfilments[0];
+		pop_store.get_everyday_needs_fulfilled(handle) = fulfilments[1];
+		pop_store.get_luxury_needs_fulfilled(handle) = fulfilments[2];
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "openvic-simulation/economy/trading/MarketInstance.hpp"
+#include "openvic-simulation/pop/Pop.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct GoodDefinitionManager;
+	struct ModifierEffectCache;
+	struct PopsDefines;
+	struct PopStore;
+	struct ProvinceInstance;
+
+	/* Daily consumption of pops' life, everyday and luxury needs.
+	 *
+	 * At setup each PopType's three needs maps are flattened into dense rows indexed by good, so nothing in the daily
+	 * passes looks anything up in a map. Each day:
+	 *  - update_costs prices every row once at the market's current prices,
+	 *  - place_orders walks a province's pops, works out from the cash each pop hasn't already reserved for other
+	 *    orders how much of each tier it can afford (life needs first, then everyday, then luxury) and reserves it,
+	 *    sums what was afforded per pop type and tier, expands those sums into demand per good and places one buy
+	 *    order per good for the whole province,
+	 *  - apply_results turns the province's filled orders into a fill ratio per row and walks the pops again to charge
+	 *    their cash and write their needs fulfilment.
+	 * The per-pop work is a few multiplications per tier, all per-good work is done per province and pop type. */
+	struct PopNeedsKernel {
+		static constexpr size_t TIER_COUNT = 3;
+
+	private:
+		using tier_values_t = std::array<fixed_point_t, TIER_COUNT>;
+
+		std::vector<PopType> const* pop_types;
+		std::vector<GoodDefinition> const* goods;
+		size_t PROPERTY(good_count);
+		/* PopType needs are quantities for this many people, from PopsDefines. */
+		Pop::pop_size_t PROPERTY(needs_pop_size);
+
+		/* [pop type][tier][good] base quantities, with the base goods demand define applied. */
+		std::vector<fixed_point_t> needs;
+		/* [pop type][tier] cost of a row at today's prices. */
+		std::vector<fixed_point_t> row_costs;
+		std::vector<fixed_point_t> prices;
+
+		/* Kept from place_orders until apply_results, indexed by province instance index: the total need scale
+		 * afforded per pop type and tier, the quantity ordered of each good and how each order was filled. */
+		std::vector<fixed_point_t> province_row_weights;
+		std::vector<fixed_point_t> province_demand;
+		std::vector<MarketInstance::order_result_t> province_purchases;
+
+		/* Per pop handle, the fraction of each tier it could afford. */
+		std::vector<tier_values_t> affordable_fractions;
+
+		/* Scratch for the province being processed. */
+		std::vector<tier_values_t> need_factors;
+		std::vector<fixed_point_t> good_fill_ratios;
+		std::vector<fixed_point_t> filled_row_costs;
+
+		size_t _get_pop_type_index(PopType const& pop_type) const;
+		void _update_need_factors(ProvinceInstance const& province, ModifierEffectCache const& modifier_effect_cache);
+
+	public:
+		PopNeedsKernel();
+
+		bool setup(
+			std::vector<PopType> const& new_pop_types, GoodDefinitionManager const& good_definition_manager,
+			PopsDefines const& pops_defines, size_t province_count
+		);
+
+		void update_costs(MarketInstance const& market_instance);
+		void place_orders(
+			ProvinceInstance const& province, PopStore& pop_store, MarketInstance& market_instance,
+			ModifierEffectCache const& modifier_effect_cache
+		);
+		void apply_results(
+			ProvinceInstance const& province, PopStore& pop_store, ModifierEffectCache const& modifier_effect_cache
+		);
+	};
+}
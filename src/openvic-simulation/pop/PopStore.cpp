@@ -0,0 +1,175 @@
+#include "PopStore.hpp"
+
+#include <algorithm>
+#include <memory>
+
+#include "openvic-simulation/politics/Ideology.hpp"
+#include "openvic-simulation/politics/Issue.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+PopStore::PopStore() : ideology_keys { nullptr }, pop_count { 0 } {}
+
+bool PopStore::setup(
+	IndexedMap<Ideology, fixed_point_t>::keys_t const& new_ideology_keys, IssueManager const& issue_manager
+) {
+	if (!pops.empty()) {
+		Logger::error("Cannot setup pop store - it already contains ", pops.size(), " pop slots!");
+		return false;
+	}
+
+	ideology_keys = &new_ideology_keys;
+
+	issue_keys.clear();
+	issue_columns.clear();
+	issue_keys.reserve(issue_manager.get_issue_count() + issue_manager.get_reform_count());
+
+	for (Issue const& issue : issue_manager.get_issues()) {
+		issue_columns.emplace(&issue, issue_keys.size());
+		issue_keys.push_back(&issue);
+	}
+	for (Reform const& reform : issue_manager.get_reforms()) {
+		issue_columns.emplace(&reform, issue_keys.size());
+		issue_keys.push_back(&reform);
+	}
+
+	return true;
+}
+
+void PopStore::_resize_columns(size_t slot_count) {
+	slot_in_use.resize(slot_count, false);
+	sizes.resize(slot_count);
+	militancies.resize(slot_count);
+	consciousnesses.resize(slot_count);
+	literacies.resize(slot_count);
+	cash_amounts.resize(slot_count);
+	reserved_cash_amounts.resize(slot_count);
+	life_needs_fulfilments.resize(slot_count);
+	everyday_needs_fulfilments.resize(slot_count);
+	luxury_needs_fulfilments.resize(slot_count);
+	max_supported_regiment_counts.resize(slot_count);
+	ideology_matrix.resize(slot_count * get_ideology_count());
+	issue_matrix.resize(slot_count * get_issue_count());
+}
+
+void PopStore::_clear_slot(handle_t handle) {
+	sizes[handle] = 0;
+	militancies[handle] = 0;
+	consciousnesses[handle] = 0;
+	literacies[handle] = 0;
+	cash_amounts[handle] = 0;
+	reserved_cash_amounts[handle] = 0;
+	life_needs_fulfilments[handle] = 0;
+	everyday_needs_fulfilments[handle] = 0;
+	luxury_needs_fulfilments[handle] = 0;
+	max_supported_regiment_counts[handle] = 0;
+
+	std::span<fixed_point_t> ideologies = get_ideologies(handle);
+	std::fill(ideologies.begin(), ideologies.end(), fixed_point_t::_0());
+	std::span<fixed_point_t> issues = get_issues(handle);
+	std::fill(issues.begin(), issues.end(), fixed_point_t::_0());
+}
+
+void PopStore::reserve(size_t new_pop_count) {
+	if (new_pop_count <= sizes.capacity()) {
+		return;
+	}
+
+	slot_in_use.reserve(new_pop_count);
+	sizes.reserve(new_pop_count);
+	militancies.reserve(new_pop_count);
+	consciousnesses.reserve(new_pop_count);
+	literacies.reserve(new_pop_count);
+	cash_amounts.reserve(new_pop_count);
+	reserved_cash_amounts.reserve(new_pop_count);
+	life_needs_fulfilments.reserve(new_pop_count);
+	everyday_needs_fulfilments.reserve(new_pop_count);
+	luxury_needs_fulfilments.reserve(new_pop_count);
+	max_supported_regiment_counts.reserve(new_pop_count);
+	ideology_matrix.reserve(new_pop_count * get_ideology_count());
+	issue_matrix.reserve(new_pop_count * get_issue_count());
+}
+
+PopStore::handle_t PopStore::add_pop(PopBase const& pop_base) {
+	handle_t handle;
+
+	if (!free_handles.empty()) {
+		handle = free_handles.back();
+		free_handles.pop_back();
+		// Removed pops are only destroyed when their slot is reused, so the deque never holds destroyed objects
+		std::destroy_at(&pops[handle]);
+		std::construct_at(&pops[handle], Pop { pop_base, *this, handle });
+	} else {
+		handle = static_cast<handle_t>(pops.size());
+		pops.push_back(Pop { pop_base, *this, handle });
+		_resize_columns(pops.size());
+	}
+
+	_clear_slot(handle);
+	slot_in_use[handle] = true;
+
+	sizes[handle] = pop_base.get_size();
+	militancies[handle] = pop_base.get_militancy();
+	consciousnesses[handle] = pop_base.get_consciousness();
+
+	++pop_count;
+
+	return handle;
+}
+
+bool PopStore::remove_pop(handle_t handle) {
+	if (!is_valid_handle(handle)) {
+		Logger::error("Trying to remove pop with invalid handle ", handle, " (slot count is ", pops.size(), ")");
+		return false;
+	}
+
+	_clear_slot(handle);
+	slot_in_use[handle] = false;
+	free_handles.push_back(handle);
+
+	--pop_count;
+
+	return true;
+}
+
+bool PopStore::is_valid_handle(handle_t handle) const {
+	return handle < pops.size() && slot_in_use[handle];
+}
+
+fixed_point_t PopStore::get_unreserved_cash(handle_t handle) const {
+	return std::max(cash_amounts[handle] - reserved_cash_amounts[handle], fixed_point_t::_0());
+}
+
+void PopStore::release_reserved_cash() {
+	std::fill(reserved_cash_amounts.begin(), reserved_cash_amounts.end(), fixed_point_t::_0());
+}
+
+size_t PopStore::get_ideology_count() const {
+	return ideology_keys != nullptr ? ideology_keys->size() : 0;
+}
+
+std::span<fixed_point_t> PopStore::get_ideologies(handle_t handle) {
+	const size_t ideology_count = get_ideology_count();
+	return { ideology_matrix.data() + handle * ideology_count, ideology_count };
+}
+
+std::span<const fixed_point_t> PopStore::get_ideologies(handle_t handle) const {
+	const size_t ideology_count = get_ideology_count();
+	return { ideology_matrix.data() + handle * ideology_count, ideology_count };
+}
+
+std::span<fixed_point_t> PopStore::get_issues(handle_t handle) {
+	const size_t issue_count = get_issue_count();
+	return { issue_matrix.data() + handle * issue_count, issue_count };
+}
+
+std::span<const fixed_point_t> PopStore::get_issues(handle_t handle) const {
+	const size_t issue_count = get_issue_count();
+	return { issue_matrix.data() + handle * issue_count, issue_count };
+}
+
+size_t PopStore::get_issue_column(Issue const& issue) const {
+	const decltype(issue_columns)::const_iterator it = issue_columns.find(&issue);
+	return it != issue_columns.end() ? it->second : get_issue_count();
+}
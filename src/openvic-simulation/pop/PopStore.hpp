@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "openvic-simulation/pop/Pop.hpp"
+#include "openvic-simulation/types/IndexedMap.hpp"
+#include "openvic-simulation/types/OrderedContainers.hpp"
+
+namespace OpenVic {
+	struct Ideology;
+	struct Issue;
+	struct IssueManager;
+
+	/* World-wide pop storage. Values touched by every daily update (size, militancy, consciousness, literacy, cash,
+	 * needs fulfilment, supported regiments) are kept in contiguous columns indexed by pop handle, while ideology and
+	 * issue support live in flat handle-major matrices. Everything else stays in the Pop object, which acts as the
+	 * row's cold data and forwards its hot getters to the columns.
+	 *
+	 * Slots are never moved: removing a pop frees its handle for reuse by the next added pop, so handles and Pop
+	 * references stay valid for as long as the pop exists. */
+	struct PopStore {
+		using handle_t = Pop::handle_t;
+
+		static constexpr handle_t NULL_HANDLE = std::numeric_limits<handle_t>::max();
+
+		/* Range over a list of handles, yielding the Pops they refer to. */
+		template<bool IsConst>
+		struct pop_view_t {
+			using store_t = std::conditional_t<IsConst, PopStore const, PopStore>;
+			using pop_t = std::conditional_t<IsConst, Pop const, Pop>;
+
+			struct iterator {
+				store_t* store;
+				handle_t const* handle;
+
+				constexpr pop_t& operator*() const {
+					return store->get_pop(*handle);
+				}
+				constexpr pop_t* operator->() const {
+					return &**this;
+				}
+				constexpr iterator& operator++() {
+					++handle;
+					return *this;
+				}
+				constexpr bool operator==(iterator const& other) const {
+					return handle == other.handle;
+				}
+			};
+
+		private:
+			store_t* store;
+			std::span<const handle_t> handles;
+
+		public:
+			constexpr pop_view_t(store_t* new_store, std::span<const handle_t> new_handles)
+				: store { new_store }, handles { new_handles } {}
+
+			constexpr iterator begin() const {
+				return { store, handles.data() };
+			}
+			constexpr iterator end() const {
+				return { store, handles.data() + handles.size() };
+			}
+			constexpr size_t size() const {
+				return handles.size();
+			}
+			constexpr bool empty() const {
+				return handles.empty();
+			}
+		};
+
+		using const_pop_view_t = pop_view_t<true>;
+		using mutable_pop_view_t = pop_view_t<false>;
+
+	private:
+		IndexedMap<Ideology, fixed_point_t>::keys_t const* PROPERTY(ideology_keys);
+		/* Issues followed by reforms, in registry order. A pop's issue matrix row uses the same order. */
+		std::vector<Issue const*> PROPERTY(issue_keys);
+		ordered_map<Issue const*, size_t> issue_columns;
+
+		std::deque<Pop> pops;
+		std::vector<uint8_t> slot_in_use;
+		std::vector<handle_t> free_handles;
+		size_t PROPERTY(pop_count);
+
+		std::vector<Pop::pop_size_t> PROPERTY(sizes);
+		std::vector<fixed_point_t> PROPERTY(militancies);
+		std::vector<fixed_point_t> PROPERTY(consciousnesses);
+		std::vector<fixed_point_t> PROPERTY(literacies);
+		std::vector<fixed_point_t> PROPERTY(cash_amounts);
+		/* Cash already committed to today's buy orders, so that every buyer spending a pop's cash (its needs, an
+		 * artisan's inputs) sizes its orders against what the others have left rather than all spending the same cash.
+		 * Released once the day's orders have been settled. */
+		std::vector<fixed_point_t> PROPERTY(reserved_cash_amounts);
+		std::vector<fixed_point_t> PROPERTY(life_needs_fulfilments);
+		std::vector<fixed_point_t> PROPERTY(everyday_needs_fulfilments);
+		std::vector<fixed_point_t> PROPERTY(luxury_needs_fulfilments);
+		std::vector<size_t> PROPERTY(max_supported_regiment_counts);
+
+		std::vector<fixed_point_t> ideology_matrix;
+		std::vector<fixed_point_t> issue_matrix;
+
+		void _resize_columns(size_t slot_count);
+		void _clear_slot(handle_t handle);
+
+	public:
+		PopStore();
+		PopStore(PopStore const&) = delete;
+		PopStore& operator=(PopStore const&) = delete;
+
+		bool setup(
+			IndexedMap<Ideology, fixed_point_t>::keys_t const& new_ideology_keys, IssueManager const& issue_manager
+		);
+
+		void reserve(size_t pop_count);
+
+		/* Returns the handle of the new pop, whose location must then be set by the caller. */
+		handle_t add_pop(PopBase const& pop_base);
+		bool remove_pop(handle_t handle);
+
+		inline size_t get_slot_count() const {
+			return pops.size();
+		}
+		bool is_valid_handle(handle_t handle) const;
+
+		inline Pop& get_pop(handle_t handle) {
+			return pops[handle];
+		}
+		inline Pop const& get_pop(handle_t handle) const {
+			return pops[handle];
+		}
+
+		inline constexpr mutable_pop_view_t get_pops(std::span<const handle_t> handles) {
+			return { this, handles };
+		}
+		inline constexpr const_pop_view_t get_pops(std::span<const handle_t> handles) const {
+			return { this, handles };
+		}
+
+		inline Pop::pop_size_t& get_size(handle_t handle) {
+			return sizes[handle];
+		}
+		inline fixed_point_t& get_militancy(handle_t handle) {
+			return militancies[handle];
+		}
+		inline fixed_point_t& get_consciousness(handle_t handle) {
+			return consciousnesses[handle];
+		}
+		inline fixed_point_t& get_literacy(handle_t handle) {
+			return literacies[handle];
+		}
+		inline fixed_point_t& get_cash(handle_t handle) {
+			return cash_amounts[handle];
+		}
+		inline fixed_point_t& get_reserved_cash(handle_t handle) {
+			return reserved_cash_amounts[handle];
+		}
+		/* Cash not yet committed to today's buy orders, never negative. */
+		fixed_point_t get_unreserved_cash(handle_t handle) const;
+		void release_reserved_cash();
+		inline fixed_point_t& get_life_needs_fulfilled(handle_t handle) {
+			return life_needs_fulfilments[handle];
+		}
+		inline fixed_point_t& get_everyday_needs_fulfilled(handle_t handle) {
+			return everyday_needs_fulfilments[handle];
+		}
+		inline fixed_point_t& get_luxury_needs_fulfilled(handle_t handle) {
+			return luxury_needs_fulfilments[handle];
+		}
+		inline size_t& get_max_supported_regiments(handle_t handle) {
+			return max_supported_regiment_counts[handle];
+		}
+
+		size_t get_ideology_count() const;
+		constexpr size_t get_issue_count() const {
+			return issue_keys.size();
+		}
+
+		std::span<fixed_point_t> get_ideologies(handle_t handle);
+		std::span<const fixed_point_t> get_ideologies(handle_t handle) const;
+		std::span<fixed_point_t> get_issues(handle_t handle);
+		std::span<const fixed_point_t> get_issues(handle_t handle) const;
+
+		/* Column index of the issue or reform in issue matrix rows, or get_issue_count() if not present. */
+		size_t get_issue_column(Issue const& issue) const;
+	};
+}
@@ -0,0 +1,324 @@
+#include "PopTransitions.hpp"
+
+#include <algorithm>
+
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/defines/PopsDefines.hpp"
+#include "openvic-simulation/map/MapInstance.hpp"
+#include "openvic-simulation/map/ProvinceDefinition.hpp"
+#include "openvic-simulation/map/ProvinceInstance.hpp"
+#include "openvic-simulation/map/State.hpp"
+#include "openvic-simulation/pop/PopStore.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+
+using namespace OpenVic;
+
+PopTransitionEngine::PopTransitionEngine() : pop_manager { nullptr } {}
+
+bool PopTransitionEngine::setup(PopManager const& new_pop_manager, size_t province_count) {
+	if (!new_pop_manager.pop_types_are_locked()) {
+		Logger::error("Cannot set up pop transitions - pop types are not locked!");
+		return false;
+	}
+
+	pop_manager = &new_pop_manager;
+
+	outgoing_transfers.clear();
+	incoming_transfers.clear();
+	outgoing_offsets.assign(province_count + 1, 0);
+	incoming_offsets.assign(province_count + 1, 0);
+	emigration_destinations.assign(pop_manager->get_pop_type_count(), nullptr);
+
+	return true;
+}
+
+size_t PopTransitionEngine::_get_pop_type_index(PopType const& pop_type) const {
+	return std::distance(pop_manager->get_pop_types().data(), &pop_type);
+}
+
+/* Countries are compared once per pop type rather than per pop, so emigrants of a type all head for the same
+ * country this month. */
+void PopTransitionEngine::_update_emigration_destinations(
+	MapInstance& map_instance, CountryInstanceManager const& country_instance_manager, Date today
+) {
+	const ConditionContext context { map_instance, country_instance_manager, today, {}, {} };
+
+	for (PopType const& pop_type : pop_manager->get_pop_types()) {
+		ProvinceInstance* destination = nullptr;
+		fixed_point_t best_weight = fixed_point_t::_0();
+
+		for (CountryInstance const& country : country_instance_manager.get_country_instances()) {
+			if (!country.exists() || country.get_capital() == nullptr) {
+				continue;
+			}
+
+			const fixed_point_t weight = pop_type.get_country_migration_target().evaluate(&country, context);
+			if (weight > best_weight) {
+				best_weight = weight;
+				destination = &map_instance.get_province_instance_from_definition(
+					country.get_capital()->get_province_definition()
+				);
+			}
+		}
+
+		emigration_destinations[_get_pop_type_index(pop_type)] = destination;
+	}
+}
+
+void PopTransitionEngine::_compute_province_transfers(
+	MapInstance& map_instance, ProvinceInstance& province, CountryInstanceManager const& country_instance_manager,
+	PopsDefines const& pops_defines, Date today
+) {
+	CountryInstance const* owner = province.get_owner();
+	if (owner == nullptr || province.get_pop_handles().empty()) {
+		return;
+	}
+
+	PopStore const& pop_store = map_instance.get_pop_store();
+
+	grouped_handles = province.get_pop_handles();
+	std::sort(
+		grouped_handles.begin(), grouped_handles.end(),
+		[this, &pop_store](Pop::handle_t lhs, Pop::handle_t rhs) -> bool {
+			const size_t lhs_type = _get_pop_type_index(*pop_store.get_pop(lhs).get_type());
+			const size_t rhs_type = _get_pop_type_index(*pop_store.get_pop(rhs).get_type());
+			return lhs_type != rhs_type ? lhs_type < rhs_type : lhs < rhs;
+		}
+	);
+
+	const size_t pop_count = grouped_handles.size();
+	const ConditionContext context { map_instance, country_instance_manager, today, &province, {} };
+
+	const std::array<ConditionalWeight const*, CHANCE_COUNT> chances {
+		&pop_manager->get_promotion_chance(), &pop_manager->get_demotion_chance(), &pop_manager->get_migration_chance(),
+		&pop_manager->get_colonialmigration_chance(), &pop_manager->get_emigration_chance(),
+		&pop_manager->get_assimilation_chance(), &pop_manager->get_conversion_chance()
+	};
+	for (size_t chance = 0; chance < CHANCE_COUNT; ++chance) {
+		chance_weights[chance].resize(pop_count);
+		chances[chance]->evaluate_pops(pop_store, grouped_handles, context, chance_weights[chance]);
+	}
+
+	target_weights.resize(pop_count);
+	best_promotion_weights.assign(pop_count, fixed_point_t::_0());
+	best_demotion_weights.assign(pop_count, fixed_point_t::_0());
+	promotion_targets.assign(pop_count, nullptr);
+	demotion_targets.assign(pop_count, nullptr);
+
+	const bool is_colony = province.get_colony_status() != ProvinceInstance::colony_status_t::STATE;
+	State const* state = province.get_state();
+
+	for (size_t group_begin = 0; group_begin < pop_count;) {
+		PopType const& pop_type = *pop_store.get_pop(grouped_handles[group_begin]).get_type();
+		size_t group_end = group_begin + 1;
+		while (group_end < pop_count && pop_store.get_pop(grouped_handles[group_end]).get_type() == &pop_type) {
+			++group_end;
+		}
+
+		const std::span<const Pop::handle_t> group_handles {
+			grouped_handles.data() + group_begin, group_end - group_begin
+		};
+		const std::span<fixed_point_t> group_weights { target_weights.data() + group_begin, group_handles.size() };
+
+		// Promotion targets are in a higher strata than the pop's type, demotion targets in the same or a lower one
+		const Strata::rank_t strata_rank = pop_type.get_strata().get_rank();
+		for (auto const& [target_type, target_weight] : pop_type.get_promote_to()) {
+			if (target_type == &pop_type) {
+				continue;
+			}
+
+			target_weight.evaluate_pops(pop_store, group_handles, context, group_weights);
+
+			const bool is_promotion = target_type->get_strata().get_rank() > strata_rank;
+			std::vector<fixed_point_t>& best_weights = is_promotion ? best_promotion_weights : best_demotion_weights;
+			std::vector<PopType const*>& targets = is_promotion ? promotion_targets : demotion_targets;
+			for (size_t index = group_begin; index < group_end; ++index) {
+				if (target_weights[index] > best_weights[index]) {
+					best_weights[index] = target_weights[index];
+					targets[index] = target_type;
+				}
+			}
+		}
+
+		// Migration targets depend on the pop's type, so are picked once per type from the first pop's point of view
+		const ConditionContext group_context {
+			map_instance, country_instance_manager, today, &pop_store.get_pop(group_handles.front()), {}
+		};
+
+		ProvinceInstance* internal_destination = nullptr;
+		if (state != nullptr) {
+			fixed_point_t best_weight = fixed_point_t::_0();
+			for (ProvinceInstance* candidate : state->get_provinces()) {
+				if (candidate == &province) {
+					continue;
+				}
+				const fixed_point_t weight = pop_type.get_migration_target().evaluate(candidate, group_context);
+				if (weight > best_weight) {
+					best_weight = weight;
+					internal_destination = candidate;
+				}
+			}
+		}
+
+		ProvinceInstance* colonial_destination = nullptr;
+		if (!is_colony) {
+			fixed_point_t best_weight = fixed_point_t::_0();
+			for (State const* owner_state : owner->get_states()) {
+				if (
+					owner_state->get_colony_status() == ProvinceInstance::colony_status_t::STATE ||
+					owner_state->get_capital() == nullptr
+				) {
+					continue;
+				}
+				const fixed_point_t weight =
+					pop_type.get_migration_target().evaluate(owner_state->get_capital(), group_context);
+				if (weight > best_weight) {
+					best_weight = weight;
+					colonial_destination = &map_instance.get_province_instance_from_definition(
+						owner_state->get_capital()->get_province_definition()
+					);
+				}
+			}
+		}
+
+		ProvinceInstance* emigration_destination = emigration_destinations[_get_pop_type_index(pop_type)];
+		if (emigration_destination != nullptr && emigration_destination->get_owner() == owner) {
+			emigration_destination = nullptr;
+		}
+
+		for (size_t index = group_begin; index < group_end; ++index) {
+			const Pop::handle_t handle = grouped_handles[index];
+			Pop const& pop = pop_store.get_pop(handle);
+			const Pop::pop_size_t size = pop.get_size();
+			const fixed_point_t cash = std::max(pop.get_cash(), fixed_point_t::_0());
+			Pop::pop_size_t remaining = size;
+
+			const auto add_transfer = [&](
+				chance_t chance, fixed_point_t scale, pop_transfer_t::kind_t kind, ProvinceInstance* destination,
+				PopType const* type, Culture const* culture, Religion const* religion
+			) -> void {
+				const fixed_point_t fraction = std::clamp(
+					chance_weights[chance][index] * scale, fixed_point_t::_0(), fixed_point_t::_1()
+				);
+				const Pop::pop_size_t amount = std::min(
+					static_cast<Pop::pop_size_t>((fixed_point_t::parse(size) * fraction).to_int64_t()), remaining
+				);
+				if (amount < MIN_TRANSFER_SIZE) {
+					return;
+				}
+				remaining -= amount;
+				outgoing_transfers.push_back({
+					handle, destination, type, culture, religion, amount, cash * amount / size, kind
+				});
+			};
+
+			using enum pop_transfer_t::kind_t;
+
+			if (promotion_targets[index] != nullptr) {
+				add_transfer(
+					PROMOTION_CHANCE, pops_defines.get_promotion_scale(), PROMOTION, &province, promotion_targets[index],
+					&pop.get_culture(), &pop.get_religion()
+				);
+			}
+			if (demotion_targets[index] != nullptr) {
+				add_transfer(
+					DEMOTION_CHANCE, pops_defines.get_promotion_scale(), DEMOTION, &province, demotion_targets[index],
+					&pop.get_culture(), &pop.get_religion()
+				);
+			}
+			if (owner->get_primary_culture() != nullptr && !owner->is_primary_or_accepted_culture(pop.get_culture())) {
+				add_transfer(
+					ASSIMILATION_CHANCE, pops_defines.get_assimilation_scale(), ASSIMILATION, &province, &pop_type,
+					owner->get_primary_culture(), &pop.get_religion()
+				);
+			}
+			if (owner->get_religion() != nullptr && owner->get_religion() != &pop.get_religion()) {
+				add_transfer(
+					CONVERSION_CHANCE, pops_defines.get_conversion_scale(), CONVERSION, &province, &pop_type, &pop.get_culture(),
+					owner->get_religion()
+				);
+			}
+			if (internal_destination != nullptr) {
+				add_transfer(
+					MIGRATION_CHANCE, pops_defines.get_immigration_scale(), INTERNAL_MIGRATION, internal_destination, &pop_type,
+					&pop.get_culture(), &pop.get_religion()
+				);
+			}
+			if (colonial_destination != nullptr) {
+				add_transfer(
+					COLONIAL_MIGRATION_CHANCE, pops_defines.get_immigration_scale(), COLONIAL_MIGRATION, colonial_destination,
+					&pop_type, &pop.get_culture(), &pop.get_religion()
+				);
+			}
+			if (emigration_destination != nullptr) {
+				add_transfer(
+					EMIGRATION_CHANCE, pops_defines.get_immigration_scale(), EMIGRATION, emigration_destination, &pop_type,
+					&pop.get_culture(), &pop.get_religion()
+				);
+			}
+		}
+
+		group_begin = group_end;
+	}
+}
+
+void PopTransitionEngine::compute_transfers(
+	MapInstance& map_instance, CountryInstanceManager const& country_instance_manager, PopsDefines const& pops_defines,
+	Date today
+) {
+	outgoing_transfers.clear();
+	incoming_transfers.clear();
+
+	if (pop_manager == nullptr) {
+		return;
+	}
+
+	_update_emigration_destinations(map_instance, country_instance_manager, today);
+
+	std::vector<ProvinceInstance>& provinces = map_instance.get_province_instances();
+	const size_t province_count = std::min(provinces.size(), outgoing_offsets.size() - 1);
+
+	// Provinces are processed in index order, so the outgoing list comes out grouped by source province
+	for (size_t province_index = 0; province_index < province_count; ++province_index) {
+		outgoing_offsets[province_index] = outgoing_transfers.size();
+		_compute_province_transfers(
+			map_instance, provinces[province_index], country_instance_manager, pops_defines, today
+		);
+	}
+	std::fill(outgoing_offsets.begin() + province_count, outgoing_offsets.end(), outgoing_transfers.size());
+
+	// Counting sort by destination, which keeps each destination's arrivals in source order
+	std::fill(incoming_offsets.begin(), incoming_offsets.end(), 0);
+	for (pop_transfer_t const& transfer : outgoing_transfers) {
+		++incoming_offsets[transfer.destination->get_province_definition().get_index()];
+	}
+	for (size_t index = 1; index < incoming_offsets.size(); ++index) {
+		incoming_offsets[index] += incoming_offsets[index - 1];
+	}
+
+	incoming_transfers.resize(outgoing_transfers.size());
+	std::vector<size_t> insert_positions { incoming_offsets.begin(), incoming_offsets.end() - 1 };
+	for (pop_transfer_t const& transfer : outgoing_transfers) {
+		incoming_transfers[insert_positions[transfer.destination->get_province_definition().get_index() - 1]++] = transfer;
+	}
+}
+
+std::span<const pop_transfer_t> PopTransitionEngine::get_outgoing_transfers(size_t province_index) const {
+	if (province_index + 1 >= outgoing_offsets.size()) {
+		return {};
+	}
+	return {
+		outgoing_transfers.data() + outgoing_offsets[province_index],
+		outgoing_offsets[province_index + 1] - outgoing_offsets[province_index]
+	};
+}
+
+std::span<const pop_transfer_t> PopTransitionEngine::get_incoming_transfers(size_t province_index) const {
+	if (province_index + 1 >= incoming_offsets.size()) {
+		return {};
+	}
+	return {
+		incoming_transfers.data() + incoming_offsets[province_index],
+		incoming_offsets[province_index + 1] - incoming_offsets[province_index]
+	};
+}
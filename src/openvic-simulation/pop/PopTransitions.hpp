@@ -0,0 +1,96 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "openvic-simulation/pop/Pop.hpp"
+#include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct CountryInstance;
+	struct CountryInstanceManager;
+	struct MapInstance;
+	struct PopsDefines;
+	struct ProvinceInstance;
+
+	/* Part of a pop leaving it to join a pop of the given type, culture and religion in the destination province,
+	 * which may be the pop's own province when only its type, culture or religion changes. */
+	struct pop_transfer_t {
+		enum struct kind_t : uint8_t {
+			PROMOTION, DEMOTION, ASSIMILATION, CONVERSION, INTERNAL_MIGRATION, COLONIAL_MIGRATION, EMIGRATION
+		};
+
+		Pop::handle_t source;
+		ProvinceInstance* destination;
+		PopType const* type;
+		Culture const* culture;
+		Religion const* religion;
+		Pop::pop_size_t size;
+		/* The source pop's cash, in proportion to size. */
+		fixed_point_t cash;
+		kind_t kind;
+	};
+
+	/* Works out each month's promotions, demotions, assimilation, conversion and migration for every pop at once.
+	 * The transfers are only computed here, grouped both by source and by destination province, so that MapInstance
+	 * can apply them province by province: first taking every transfer out of its source pop, then merging the
+	 * arrivals into each province's pops in one compaction pass which leaves at most one pop per type, culture,
+	 * religion and rebel type, and finally removing the emptied pops. */
+	struct PopTransitionEngine {
+		/* Moves smaller than this are skipped, so trickles don't each found a new pop. */
+		static constexpr Pop::pop_size_t MIN_TRANSFER_SIZE = 100;
+
+	private:
+		enum chance_t : uint8_t {
+			PROMOTION_CHANCE, DEMOTION_CHANCE, MIGRATION_CHANCE, COLONIAL_MIGRATION_CHANCE, EMIGRATION_CHANCE,
+			ASSIMILATION_CHANCE, CONVERSION_CHANCE, CHANCE_COUNT
+		};
+
+		PopManager const* pop_manager;
+
+		std::vector<pop_transfer_t> outgoing_transfers;
+		std::vector<pop_transfer_t> incoming_transfers;
+		/* Per province instance index, where its transfers start in the lists above, plus a final end offset. */
+		std::vector<size_t> outgoing_offsets;
+		std::vector<size_t> incoming_offsets;
+
+		/* Per pop type, the capital of the country its pops emigrate to this month, if any. */
+		std::vector<ProvinceInstance*> emigration_destinations;
+
+		/* Scratch for the province being processed, with the province's pops grouped by type. */
+		std::vector<Pop::handle_t> grouped_handles;
+		std::array<std::vector<fixed_point_t>, CHANCE_COUNT> chance_weights;
+		std::vector<fixed_point_t> target_weights;
+		std::vector<fixed_point_t> best_promotion_weights;
+		std::vector<fixed_point_t> best_demotion_weights;
+		std::vector<PopType const*> promotion_targets;
+		std::vector<PopType const*> demotion_targets;
+
+		size_t _get_pop_type_index(PopType const& pop_type) const;
+
+		void _update_emigration_destinations(
+			MapInstance& map_instance, CountryInstanceManager const& country_instance_manager, Date today
+		);
+		void _compute_province_transfers(
+			MapInstance& map_instance, ProvinceInstance& province, CountryInstanceManager const& country_instance_manager,
+			PopsDefines const& pops_defines, Date today
+		);
+
+	public:
+		PopTransitionEngine();
+
+		bool setup(PopManager const& new_pop_manager, size_t province_count);
+
+		void compute_transfers(
+			MapInstance& map_instance, CountryInstanceManager const& country_instance_manager,
+			PopsDefines const& pops_defines, Date today
+		);
+
+		std::span<const pop_transfer_t> get_outgoing_transfers(size_t province_index) const;
+		std::span<const pop_transfer_t> get_incoming_transfers(size_t province_index) const;
+	};
+}
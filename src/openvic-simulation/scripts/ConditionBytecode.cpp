@@ -0,0 +1,1301 @@
+#include "ConditionBytecode.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+
+#include "openvic-simulation/country/CountryDefinition.hpp"
+#include "openvic-simulation/country/CountryInstance.hpp"
+#include "openvic-simulation/economy/BuildingType.hpp"
+#include "openvic-simulation/economy/GoodDefinition.hpp"
+#include "openvic-simulation/map/Crime.hpp"
+#include "openvic-simulation/map/MapInstance.hpp"
+#include "openvic-simulation/map/Region.hpp"
+#include "openvic-simulation/map/TerrainType.hpp"
+#include "openvic-simulation/politics/Government.hpp"
+#include "openvic-simulation/politics/Ideology.hpp"
+#include "openvic-simulation/politics/Issue.hpp"
+#include "openvic-simulation/politics/NationalValue.hpp"
+#include "openvic-simulation/pop/Culture.hpp"
+#include "openvic-simulation/pop/Religion.hpp"
+#include "openvic-simulation/research/Invention.hpp"
+#include "openvic-simulation/research/Technology.hpp"
+#include "openvic-simulation/utility/Logger.hpp"
+#include "openvic-simulation/utility/StringUtils.hpp"
+
+using namespace OpenVic;
+
+using opcode_t = ConditionBytecode::opcode_t;
+using value_function_t = ConditionBytecode::value_function_t;
+using test_function_t = ConditionBytecode::test_function_t;
+using scope_function_t = ConditionBytecode::scope_function_t;
+using iteration_function_t = ConditionBytecode::iteration_function_t;
+using argument_t = ConditionBytecode::argument_t;
+
+/* ConditionScope */
+
+ConditionScope::ConditionScope(Pop const* pop)
+	: type { pop != nullptr ? scope_type_t::POP : scope_type_t::NO_SCOPE }, target { pop } {}
+ConditionScope::ConditionScope(ProvinceInstance const* province)
+	: type { province != nullptr ? scope_type_t::PROVINCE : scope_type_t::NO_SCOPE }, target { province } {}
+ConditionScope::ConditionScope(State const* state)
+	: type { state != nullptr ? scope_type_t::STATE : scope_type_t::NO_SCOPE }, target { state } {}
+ConditionScope::ConditionScope(CountryInstance const* country)
+	: type { country != nullptr ? scope_type_t::COUNTRY : scope_type_t::NO_SCOPE }, target { country } {}
+
+Pop const* ConditionScope::get_pop() const {
+	return type == scope_type_t::POP ? static_cast<Pop const*>(target) : nullptr;
+}
+
+ProvinceInstance const* ConditionScope::get_province() const {
+	using enum scope_type_t;
+
+	switch (type) {
+	case POP:
+		return static_cast<Pop const*>(target)->get_location();
+	case PROVINCE:
+		return static_cast<ProvinceInstance const*>(target);
+	case STATE:
+		return static_cast<State const*>(target)->get_capital();
+	case COUNTRY:
+		return static_cast<CountryInstance const*>(target)->get_capital();
+	default:
+		return nullptr;
+	}
+}
+
+State const* ConditionScope::get_state() const {
+	using enum scope_type_t;
+
+	switch (type) {
+	case POP: {
+		ProvinceInstance const* location = static_cast<Pop const*>(target)->get_location();
+		return location != nullptr ? location->get_state() : nullptr;
+	}
+	case PROVINCE:
+		return static_cast<ProvinceInstance const*>(target)->get_state();
+	case STATE:
+		return static_cast<State const*>(target);
+	default:
+		return nullptr;
+	}
+}
+
+CountryInstance const* ConditionScope::get_country() const {
+	using enum scope_type_t;
+
+	switch (type) {
+	case POP: {
+		ProvinceInstance const* location = static_cast<Pop const*>(target)->get_location();
+		return location != nullptr ? location->get_owner() : nullptr;
+	}
+	case PROVINCE:
+		return static_cast<ProvinceInstance const*>(target)->get_owner();
+	case STATE:
+		return static_cast<State const*>(target)->get_owner();
+	case COUNTRY:
+		return static_cast<CountryInstance const*>(target);
+	default:
+		return nullptr;
+	}
+}
+
+/* Compilation */
+
+struct ConditionBytecode::compile_state_t {
+	size_t stack_depth = 0;
+	size_t max_stack_depth = 0;
+	size_t scope_depth = 0;
+	size_t max_scope_depth = 0;
+	bool reads_pop = false;
+
+	void push() {
+		max_stack_depth = std::max(max_stack_depth, ++stack_depth);
+	}
+	void pop() {
+		--stack_depth;
+	}
+	void enter_scope() {
+		max_scope_depth = std::max(max_scope_depth, ++scope_depth);
+	}
+	void leave_scope() {
+		--scope_depth;
+	}
+};
+
+ConditionBytecode::ConditionBytecode() : unsupported_condition_count { 0 }, pop_dependent { false } {}
+
+bool ConditionBytecode::empty() const {
+	return instructions.empty();
+}
+
+void ConditionBytecode::clear() {
+	instructions.clear();
+	constants.clear();
+	arguments.clear();
+	root_conditions.clear();
+	unsupported_condition_count = 0;
+	pop_dependent = false;
+}
+
+size_t ConditionBytecode::_emit(opcode_t opcode, uint16_t function, uint32_t operand, uint32_t jump) {
+	instructions.push_back({ opcode, function, operand, jump });
+	return instructions.size() - 1;
+}
+
+void ConditionBytecode::_patch_jump(size_t instruction_index) {
+	instructions[instruction_index].jump = instructions.size();
+}
+
+uint32_t ConditionBytecode::_add_constant(fixed_point_t constant) {
+	const std::vector<fixed_point_t>::const_iterator it = std::find(constants.begin(), constants.end(), constant);
+	if (it != constants.end()) {
+		return std::distance(constants.cbegin(), it);
+	}
+	constants.push_back(constant);
+	return constants.size() - 1;
+}
+
+uint32_t ConditionBytecode::_add_argument(argument_t const& argument) {
+	arguments.push_back(argument);
+	return arguments.size() - 1;
+}
+
+template<typename T>
+static constexpr uint16_t to_function(T function) {
+	return static_cast<uint16_t>(function);
+}
+
+/* Whether the function reads data belonging to a pop when run in a pop scope, rather than walking up to its location. */
+static constexpr bool reads_pop(value_function_t function) {
+	using enum value_function_t;
+
+	switch (function) {
+	case LITERACY:
+	case CONSCIOUSNESS:
+	case MILITANCY:
+	case LIFE_NEEDS:
+	case EVERYDAY_NEEDS:
+	case LUXURY_NEEDS:
+	case IDEOLOGY_SHARE:
+	case ISSUE_SUPPORT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static constexpr bool reads_pop(test_function_t function) {
+	using enum test_function_t;
+
+	switch (function) {
+	case CULTURE:
+	case RELIGION:
+	case POP_TYPE:
+	case STRATA:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool get_numeric_value(ConditionNode::value_t const& value, fixed_point_t& result) {
+	if (ConditionNode::real_t const* real = std::get_if<ConditionNode::real_t>(&value)) {
+		result = *real;
+		return true;
+	}
+	if (ConditionNode::integer_t const* integer = std::get_if<ConditionNode::integer_t>(&value)) {
+		result = fixed_point_t::parse(static_cast<int64_t>(*integer));
+		return true;
+	}
+	return false;
+}
+
+static bool get_boolean_value(ConditionNode::value_t const& value, bool& result) {
+	if (ConditionNode::boolean_t const* boolean = std::get_if<ConditionNode::boolean_t>(&value)) {
+		result = *boolean;
+		return true;
+	}
+	if (ConditionNode::integer_t const* integer = std::get_if<ConditionNode::integer_t>(&value)) {
+		result = *integer != 0;
+		return true;
+	}
+	return false;
+}
+
+bool ConditionBytecode::compile(ConditionNode const& root) {
+	clear();
+
+	ConditionNode::condition_list_t const* conditions = std::get_if<ConditionNode::condition_list_t>(&root.get_value());
+	if (conditions == nullptr) {
+		Logger::error("Cannot compile condition bytecode - root node is not a condition list!");
+		return false;
+	}
+
+	compile_state_t state;
+	bool ret = true;
+
+	if (conditions->empty()) {
+		ret &= _compile_list(*conditions, true, state);
+	} else {
+		/* Same as _compile_list, but recording where each root condition's instructions are. Every exit jump goes to
+		 * the very end, so the conditions can also be run separately. */
+		std::vector<size_t> exit_jumps;
+
+		for (size_t index = 0; index < conditions->size(); ++index) {
+			const uint32_t begin = instructions.size();
+			state.reads_pop = false;
+
+			ret &= _compile_node((*conditions)[index], state);
+
+			root_conditions.push_back({ begin, static_cast<uint32_t>(instructions.size()), state.reads_pop });
+			pop_dependent |= state.reads_pop;
+
+			if (index + 1 < conditions->size()) {
+				exit_jumps.push_back(_emit(opcode_t::JUMP_IF_FALSE));
+				state.pop();
+			}
+		}
+
+		for (const size_t jump : exit_jumps) {
+			_patch_jump(jump);
+		}
+	}
+
+	if (state.max_stack_depth > MAX_STACK_DEPTH || state.max_scope_depth > MAX_SCOPE_DEPTH) {
+		Logger::error(
+			"Cannot compile condition bytecode - stack depth ", state.max_stack_depth, " and scope depth ",
+			state.max_scope_depth, " exceed the limits of ", MAX_STACK_DEPTH, " and ", MAX_SCOPE_DEPTH
+		);
+		clear();
+		return false;
+	}
+
+	return ret;
+}
+
+bool ConditionBytecode::_compile_node(ConditionNode const& node, compile_state_t& state) {
+	Condition const* condition = node.get_condition();
+	if (condition == nullptr || !node.is_valid()) {
+		_compile_unsupported(node, state);
+		return true;
+	}
+
+	ConditionNode::condition_list_t const* children = std::get_if<ConditionNode::condition_list_t>(&node.get_value());
+	if (children == nullptr) {
+		return _compile_leaf(node, state);
+	}
+
+	if (condition->get_scope_change() != scope_type_t::NO_SCOPE) {
+		return _compile_scope(node, state);
+	}
+
+	const std::string_view identifier = condition->get_identifier();
+
+	if (identifier == "OR") {
+		return _compile_list(*children, false, state);
+	}
+
+	if (identifier == "NOT") {
+		// Paradox's NOT is a NOR, true only if none of its children are
+		const bool ret = _compile_list(*children, false, state);
+		_emit(opcode_t::NOT);
+		return ret;
+	}
+
+	if (identifier == "AND") {
+		return _compile_list(*children, true, state);
+	}
+
+	_compile_unsupported(node, state);
+	return true;
+}
+
+bool ConditionBytecode::_compile_list(std::span<const ConditionNode> nodes, bool is_and, compile_state_t& state) {
+	if (nodes.empty()) {
+		_emit(opcode_t::PUSH_CONSTANT, 0, _add_constant(is_and ? fixed_point_t::_1() : fixed_point_t::_0()));
+		state.push();
+		return true;
+	}
+
+	bool ret = true;
+	std::vector<size_t> exit_jumps;
+
+	for (size_t index = 0; index < nodes.size(); ++index) {
+		ret &= _compile_node(nodes[index], state);
+
+		if (index + 1 < nodes.size()) {
+			exit_jumps.push_back(_emit(is_and ? opcode_t::JUMP_IF_FALSE : opcode_t::JUMP_IF_TRUE));
+			state.pop();
+		}
+	}
+
+	for (const size_t jump : exit_jumps) {
+		_patch_jump(jump);
+	}
+
+	return ret;
+}
+
+bool ConditionBytecode::_compile_scope(ConditionNode const& node, compile_state_t& state) {
+	using enum identifier_type_t;
+
+	static const string_map_t<iteration_function_t> iteration_functions {
+		{ "any_owned_province", iteration_function_t::OWNED_PROVINCE },
+		{ "any_core", iteration_function_t::CORE },
+		{ "all_core", iteration_function_t::CORE },
+		{ "any_state", iteration_function_t::STATE },
+		{ "any_pop", iteration_function_t::POP }
+	};
+
+	static const string_map_t<scope_function_t> scope_functions {
+		{ "owner", scope_function_t::OWNER },
+		{ "controller", scope_function_t::CONTROLLER },
+		{ "location", scope_function_t::LOCATION },
+		{ "state_scope", scope_function_t::STATE },
+		{ "capital_scope", scope_function_t::CAPITAL },
+		{ "country", scope_function_t::COUNTRY }
+	};
+
+	Condition const& condition = *node.get_condition();
+	const std::string_view identifier = condition.get_identifier();
+	ConditionNode::condition_list_t const& children = std::get<ConditionNode::condition_list_t>(node.get_value());
+
+	const decltype(iteration_functions)::const_iterator iteration_it = iteration_functions.find(identifier);
+	if (iteration_it != iteration_functions.end()) {
+		const bool is_all = identifier.starts_with("all_");
+
+		const size_t begin = _emit(opcode_t::BEGIN_ITERATION, to_function(iteration_it->second), is_all);
+		state.enter_scope();
+
+		const size_t body = instructions.size();
+		const bool ret = _compile_list(children, true, state);
+		_emit(opcode_t::NEXT_ITERATION, to_function(iteration_it->second), is_all, body);
+
+		state.leave_scope();
+		_patch_jump(begin);
+
+		return ret;
+	}
+
+	scope_function_t function;
+	uint32_t argument = NO_ARGUMENT;
+
+	if (share_scope_type(condition.get_scope_change(), scope_type_t::THIS)) {
+		function = scope_function_t::THIS;
+	} else if (share_scope_type(condition.get_scope_change(), scope_type_t::FROM)) {
+		function = scope_function_t::FROM;
+	} else if (condition.get_key_identifier_type() == COUNTRY_TAG && node.get_condition_key_item() != nullptr) {
+		function = scope_function_t::ARGUMENT_COUNTRY;
+		argument = _add_argument({ node.get_condition_key_item(), COUNTRY_TAG, scope_type_t::NO_SCOPE });
+	} else if (condition.get_key_identifier_type() == PROVINCE_ID && node.get_condition_key_item() != nullptr) {
+		function = scope_function_t::ARGUMENT_PROVINCE;
+		argument = _add_argument({ node.get_condition_key_item(), PROVINCE_ID, scope_type_t::NO_SCOPE });
+	} else {
+		const decltype(scope_functions)::const_iterator scope_it = scope_functions.find(identifier);
+		if (scope_it == scope_functions.end()) {
+			_compile_unsupported(node, state);
+			return true;
+		}
+		function = scope_it->second;
+	}
+
+	const size_t enter = _emit(opcode_t::ENTER_SCOPE, to_function(function), argument);
+	state.enter_scope();
+
+	const bool ret = _compile_list(children, true, state);
+	_emit(opcode_t::LEAVE_SCOPE);
+
+	state.leave_scope();
+	_patch_jump(enter);
+
+	return ret;
+}
+
+bool ConditionBytecode::_compile_leaf(ConditionNode const& node, compile_state_t& state) {
+	using enum identifier_type_t;
+
+	static const string_map_t<value_function_t> value_functions {
+		{ "year", value_function_t::YEAR },
+		{ "month", value_function_t::MONTH },
+		{ "literacy", value_function_t::LITERACY },
+		{ "consciousness", value_function_t::CONSCIOUSNESS },
+		{ "average_consciousness", value_function_t::CONSCIOUSNESS },
+		{ "militancy", value_function_t::MILITANCY },
+		{ "average_militancy", value_function_t::MILITANCY },
+		{ "prestige", value_function_t::PRESTIGE },
+		{ "money", value_function_t::MONEY },
+		{ "treasury", value_function_t::MONEY },
+		{ "war_exhaustion", value_function_t::WAR_EXHAUSTION },
+		{ "plurality", value_function_t::PLURALITY },
+		{ "revanchism", value_function_t::REVANCHISM },
+		{ "total_pops", value_function_t::TOTAL_POPULATION },
+		{ "number_of_states", value_function_t::STATE_COUNT },
+		{ "rank", value_function_t::RANK },
+		{ "life_rating", value_function_t::LIFE_RATING },
+		{ "life_needs", value_function_t::LIFE_NEEDS },
+		{ "everyday_needs", value_function_t::EVERYDAY_NEEDS },
+		{ "luxury_needs", value_function_t::LUXURY_NEEDS }
+	};
+
+	static const string_map_t<test_function_t> test_functions {
+		{ "tag", test_function_t::TAG },
+		{ "exists", test_function_t::EXISTS },
+		{ "government", test_function_t::GOVERNMENT },
+		{ "primary_culture", test_function_t::PRIMARY_CULTURE },
+		{ "accepted_culture", test_function_t::ACCEPTED_CULTURE },
+		{ "culture", test_function_t::CULTURE },
+		{ "religion", test_function_t::RELIGION },
+		{ "ruling_party_ideology", test_function_t::RULING_PARTY_IDEOLOGY },
+		{ "tech_school", test_function_t::TECH_SCHOOL },
+		{ "nationalvalue", test_function_t::NATIONAL_VALUE },
+		{ "owns", test_function_t::OWNS },
+		{ "controls", test_function_t::CONTROLS },
+		{ "capital", test_function_t::CAPITAL },
+		{ "is_core", test_function_t::IS_CORE },
+		{ "invention", test_function_t::INVENTION },
+		{ "civilized", test_function_t::CIVILISED },
+		{ "is_greater_power", test_function_t::GREAT_POWER },
+		{ "is_secondary_power", test_function_t::SECONDARY_POWER },
+		{ "is_disarmed", test_function_t::DISARMED },
+		{ "is_mobilised", test_function_t::MOBILISED },
+		{ "has_country_modifier", test_function_t::HAS_COUNTRY_MODIFIER },
+		{ "owned_by", test_function_t::OWNED_BY },
+		{ "controlled_by", test_function_t::CONTROLLED_BY },
+		{ "province_id", test_function_t::PROVINCE_ID },
+		{ "region", test_function_t::REGION },
+		{ "continent", test_function_t::CONTINENT },
+		{ "terrain", test_function_t::TERRAIN },
+		{ "trade_goods", test_function_t::TRADE_GOODS },
+		{ "has_crime", test_function_t::HAS_CRIME },
+		{ "is_coastal", test_function_t::COASTAL },
+		{ "port", test_function_t::PORT },
+		{ "is_capital", test_function_t::IS_CAPITAL },
+		{ "has_building", test_function_t::HAS_BUILDING },
+		{ "has_province_modifier", test_function_t::HAS_PROVINCE_MODIFIER },
+		{ "is_slave", test_function_t::SLAVE },
+		{ "is_colonial", test_function_t::COLONIAL },
+		{ "pop_type", test_function_t::POP_TYPE },
+		{ "type", test_function_t::POP_TYPE },
+		{ "strata", test_function_t::STRATA }
+	};
+
+	Condition const& condition = *node.get_condition();
+	const std::string_view identifier = condition.get_identifier();
+	ConditionNode::value_t const& value = node.get_value();
+
+	if (identifier == "always") {
+		bool always = false;
+		if (get_boolean_value(value, always)) {
+			_emit(opcode_t::PUSH_CONSTANT, 0, _add_constant(always ? fixed_point_t::_1() : fixed_point_t::_0()));
+			state.push();
+			return true;
+		}
+	}
+
+	/* Conditions keyed by a registry item, e.g. conservative = 0.5 or some_technology = 1 */
+	HasIdentifier const* key_item = node.get_condition_key_item();
+	if (condition.get_key_identifier_type() != NO_IDENTIFIER) {
+		if (key_item != nullptr) {
+			const identifier_type_t key_type = condition.get_key_identifier_type();
+			const argument_t key_argument { key_item, key_type, scope_type_t::NO_SCOPE };
+			bool expected = false;
+
+			switch (key_type) {
+			case IDEOLOGY:
+				if (_compile_comparison(
+					value_function_t::IDEOLOGY_SHARE, _add_argument(key_argument), value, false, state
+				)) {
+					return true;
+				}
+				break;
+			case ISSUE:
+				if (_compile_comparison(value_function_t::ISSUE_SUPPORT, _add_argument(key_argument), value, false, state)) {
+					return true;
+				}
+				break;
+			case POP_TYPE:
+				if (_compile_comparison(
+					value_function_t::POP_TYPE_SHARE, _add_argument(key_argument), value, false, state
+				)) {
+					return true;
+				}
+				break;
+			case REFORM_GROUP:
+				if (node.get_condition_value_item() != nullptr) {
+					_compile_test(
+						test_function_t::REFORM,
+						_add_argument({ node.get_condition_value_item(), REFORM, scope_type_t::NO_SCOPE }),
+						true, state
+					);
+					return true;
+				}
+				break;
+			case TECHNOLOGY:
+				if (get_boolean_value(value, expected)) {
+					_compile_test(test_function_t::TECHNOLOGY, _add_argument(key_argument), expected, state);
+					return true;
+				}
+				break;
+			default:
+				break;
+			}
+		}
+
+		_compile_unsupported(node, state);
+		return true;
+	}
+
+	const decltype(value_functions)::const_iterator value_it = value_functions.find(identifier);
+	if (value_it != value_functions.end()) {
+		// A lower rank number is a better rank, so "rank = 8" means ranked 8th or higher
+		if (!_compile_comparison(value_it->second, NO_ARGUMENT, value, identifier == "rank", state)) {
+			_compile_unsupported(node, state);
+		}
+		return true;
+	}
+
+	const decltype(test_functions)::const_iterator test_it = test_functions.find(identifier);
+	if (test_it == test_functions.end()) {
+		_compile_unsupported(node, state);
+		return true;
+	}
+
+	bool expected = false;
+	if (get_boolean_value(value, expected)) {
+		_compile_test(test_it->second, NO_ARGUMENT, expected, state);
+		return true;
+	}
+
+	ConditionNode::string_t const* value_string = std::get_if<ConditionNode::string_t>(&value);
+	if (value_string == nullptr) {
+		_compile_unsupported(node, state);
+		return true;
+	}
+
+	const identifier_type_t value_type = condition.get_value_identifier_type();
+	const bool single_value_type = std::has_single_bit(static_cast<std::underlying_type_t<identifier_type_t>>(value_type));
+	argument_t argument { node.get_condition_value_item(), value_type, scope_type_t::NO_SCOPE };
+
+	if (argument.item != nullptr) {
+		if (!single_value_type) {
+			// Only is_core accepts multiple item types (a tag or a province ID), which can be told apart by their digits
+			argument.item_type = std::all_of(value_string->begin(), value_string->end(), [](char c) -> bool {
+				return '0' <= c && c <= '9';
+			}) ? PROVINCE_ID : COUNTRY_TAG;
+		}
+	} else if (StringUtils::strings_equal_case_insensitive(*value_string, "THIS")) {
+		argument.scope = scope_type_t::THIS;
+	} else if (StringUtils::strings_equal_case_insensitive(*value_string, "FROM")) {
+		argument.scope = scope_type_t::FROM;
+	} else {
+		_compile_unsupported(node, state);
+		return true;
+	}
+
+	if (argument.item == nullptr && !single_value_type) {
+		argument.item_type = NO_IDENTIFIER;
+	}
+
+	// exists = yes checks the current country, exists = TAG checks another country
+	const test_function_t function = test_it->second == test_function_t::EXISTS ? test_function_t::TAG_EXISTS : test_it->second;
+	_compile_test(function, _add_argument(argument), true, state);
+	return true;
+}
+
+bool ConditionBytecode::_compile_comparison(
+	value_function_t function, uint32_t argument, ConditionNode::value_t const& value, bool less_equal,
+	compile_state_t& state
+) {
+	fixed_point_t constant;
+	if (!get_numeric_value(value, constant)) {
+		return false;
+	}
+
+	_emit(opcode_t::LOAD_VALUE, to_function(function), argument);
+	state.push();
+	state.reads_pop |= state.scope_depth == 0 && reads_pop(function);
+	_emit(opcode_t::PUSH_CONSTANT, 0, _add_constant(constant));
+	state.push();
+	_emit(less_equal ? opcode_t::LESS_EQUAL : opcode_t::GREATER_EQUAL);
+	state.pop();
+
+	return true;
+}
+
+void ConditionBytecode::_compile_test(test_function_t function, uint32_t argument, bool expected, compile_state_t& state) {
+	_emit(opcode_t::TEST, to_function(function), argument);
+	state.push();
+	state.reads_pop |= state.scope_depth == 0 && reads_pop(function);
+	if (!expected) {
+		_emit(opcode_t::NOT);
+	}
+}
+
+void ConditionBytecode::_compile_unsupported(ConditionNode const& node, compile_state_t& state) {
+	_emit(opcode_t::TEST, to_function(test_function_t::UNSUPPORTED));
+	state.push();
+	++unsupported_condition_count;
+	++unsupported_condition_tally[node.get_condition()];
+}
+
+void ConditionBytecode::log_unsupported_conditions() {
+	for (auto const& [condition, count] : unsupported_condition_tally) {
+		Logger::warning(
+			"Condition \"", condition != nullptr ? condition->get_identifier() : std::string_view { "<invalid>" },
+			"\" is not supported by the condition bytecode and will evaluate to false, or to true inside a NOT, in ", count,
+			" places!"
+		);
+	}
+	unsupported_condition_tally.clear();
+}
+
+/* Evaluation */
+
+static ConditionScope const& get_argument_scope(argument_t const& argument, ConditionContext const& context) {
+	return argument.scope == scope_type_t::FROM ? context.from_scope : context.this_scope;
+}
+
+static CountryInstance const* get_argument_country(argument_t const& argument, ConditionContext const& context) {
+	if (argument.item != nullptr) {
+		return &context.country_instance_manager.get_country_instance_from_definition(
+			*static_cast<CountryDefinition const*>(argument.item)
+		);
+	}
+	return get_argument_scope(argument, context).get_country();
+}
+
+static ProvinceInstance const* get_argument_province(argument_t const& argument, ConditionContext const& context) {
+	if (argument.item != nullptr) {
+		return &context.map_instance.get_province_instance_from_definition(
+			*static_cast<ProvinceDefinition const*>(argument.item)
+		);
+	}
+	return get_argument_scope(argument, context).get_province();
+}
+
+static Culture const* get_scope_culture(ConditionScope scope) {
+	Pop const* pop = scope.get_pop();
+	if (pop != nullptr) {
+		return &pop->get_culture();
+	}
+	CountryInstance const* country = scope.get_country();
+	return country != nullptr ? country->get_primary_culture() : nullptr;
+}
+
+static Religion const* get_scope_religion(ConditionScope scope) {
+	Pop const* pop = scope.get_pop();
+	if (pop != nullptr) {
+		return &pop->get_religion();
+	}
+	CountryInstance const* country = scope.get_country();
+	return country != nullptr ? country->get_religion() : nullptr;
+}
+
+static bool is_argument_item(HasIdentifier const* item, argument_t const& argument) {
+	return item != nullptr && item == argument.item;
+}
+
+static bool has_event_modifier(std::vector<ModifierInstance> const& event_modifiers, argument_t const& argument) {
+	return std::any_of(
+		event_modifiers.begin(), event_modifiers.end(), [&argument](ModifierInstance const& modifier) -> bool {
+			return modifier.get_modifier() == argument.item;
+		}
+	);
+}
+
+static bool has_building(ProvinceInstance const* province, argument_t const& argument) {
+	return province != nullptr && std::any_of(
+		province->get_buildings().begin(), province->get_buildings().end(),
+		[&argument](BuildingInstance const& building) -> bool {
+			return &building.get_building_type() == argument.item && building.get_level() > 0;
+		}
+	);
+}
+
+static fixed_point_t get_share(Pop::pop_size_t part, Pop::pop_size_t total) {
+	return total > 0 ? fixed_point_t::parse(part) / fixed_point_t::parse(total) : fixed_point_t::_0();
+}
+
+static fixed_point_t load_value(
+	value_function_t function, ConditionScope scope, argument_t const& argument, ConditionContext const& context
+) {
+	using enum value_function_t;
+
+#define SCOPE_VALUE(pop_getter, province_getter, state_getter, country_getter) \
+	switch (scope.get_type()) { \
+	case scope_type_t::POP: \
+		return scope.get_pop()->pop_getter(); \
+	case scope_type_t::PROVINCE: \
+		return scope.get_province()->province_getter(); \
+	case scope_type_t::STATE: \
+		return scope.get_state()->state_getter(); \
+	case scope_type_t::COUNTRY: \
+		return scope.get_country()->country_getter(); \
+	default: \
+		return fixed_point_t::_0(); \
+	}
+
+#define COUNTRY_VALUE(value) { \
+		CountryInstance const* country = scope.get_country(); \
+		return country != nullptr ? (value) : fixed_point_t::_0(); \
+	}
+
+#define POP_VALUE(getter) { \
+		Pop const* pop = scope.get_pop(); \
+		return pop != nullptr ? pop->getter() : fixed_point_t::_0(); \
+	}
+
+	switch (function) {
+	case YEAR:
+		return fixed_point_t::parse(context.today.get_year());
+	case MONTH:
+		// Script months count from 0
+		return fixed_point_t::parse(context.today.get_month() - 1);
+	case LITERACY:
+		SCOPE_VALUE(get_literacy, get_average_literacy, get_average_literacy, get_national_literacy);
+	case CONSCIOUSNESS:
+		SCOPE_VALUE(get_consciousness, get_average_consciousness, get_average_consciousness, get_national_consciousness);
+	case MILITANCY:
+		SCOPE_VALUE(get_militancy, get_average_militancy, get_average_militancy, get_national_militancy);
+	case PRESTIGE:
+		COUNTRY_VALUE(country->get_prestige());
+	case MONEY:
+		COUNTRY_VALUE(country->get_cash_stockpile());
+	case WAR_EXHAUSTION:
+		COUNTRY_VALUE(country->get_war_exhaustion());
+	case PLURALITY:
+		COUNTRY_VALUE(country->get_plurality());
+	case REVANCHISM:
+		COUNTRY_VALUE(country->get_revanchism());
+	case TOTAL_POPULATION:
+		COUNTRY_VALUE(fixed_point_t::parse(country->get_total_population()));
+	case STATE_COUNT:
+		COUNTRY_VALUE(fixed_point_t::parse(static_cast<int64_t>(country->get_states().size())));
+	case RANK:
+		COUNTRY_VALUE(fixed_point_t::parse(static_cast<int64_t>(country->get_total_rank())));
+	case LIFE_RATING: {
+		ProvinceInstance const* province = scope.get_province();
+		return province != nullptr ? fixed_point_t::parse(province->get_life_rating()) : fixed_point_t::_0();
+	}
+	case LIFE_NEEDS:
+		POP_VALUE(get_life_needs_fulfilled);
+	case EVERYDAY_NEEDS:
+		POP_VALUE(get_everyday_needs_fulfilled);
+	case LUXURY_NEEDS:
+		POP_VALUE(get_luxury_needs_fulfilled);
+	case POP_TYPE_SHARE: {
+		PopType const& pop_type = *static_cast<PopType const*>(argument.item);
+		switch (scope.get_type()) {
+		case scope_type_t::POP:
+		case scope_type_t::PROVINCE: {
+			ProvinceInstance const* province = scope.get_province();
+			return province != nullptr
+				? get_share(province->get_pop_type_distribution()[pop_type], province->get_total_population())
+				: fixed_point_t::_0();
+		}
+		case scope_type_t::STATE: {
+			State const* state = scope.get_state();
+			return get_share(state->get_pop_type_distribution()[pop_type], state->get_total_population());
+		}
+		case scope_type_t::COUNTRY: {
+			CountryInstance const* country = scope.get_country();
+			return get_share(country->get_pop_type_distribution()[pop_type], country->get_total_population());
+		}
+		default:
+			return fixed_point_t::_0();
+		}
+	}
+	case IDEOLOGY_SHARE: {
+		Ideology const& ideology = *static_cast<Ideology const*>(argument.item);
+		Pop const* pop = scope.get_pop();
+		if (pop != nullptr) {
+			return pop->get_ideology_support(ideology);
+		}
+		// Only provinces track an ideology distribution, so larger scopes use their capital's
+		ProvinceInstance const* province = scope.get_province();
+		if (province != nullptr) {
+			const fixed_point_t total = province->get_ideology_distribution().get_total();
+			if (total > fixed_point_t::_0()) {
+				return province->get_ideology_distribution()[ideology] / total;
+			}
+		}
+		return fixed_point_t::_0();
+	}
+	case ISSUE_SUPPORT: {
+		Pop const* pop = scope.get_pop();
+		return pop != nullptr ? pop->get_issue_support(*static_cast<Issue const*>(argument.item)) : fixed_point_t::_0();
+	}
+	default:
+		return fixed_point_t::_0();
+	}
+
+#undef SCOPE_VALUE
+#undef COUNTRY_VALUE
+#undef POP_VALUE
+}
+
+static bool run_test(
+	test_function_t function, ConditionScope scope, argument_t const& argument, ConditionContext const& context
+) {
+	using enum test_function_t;
+
+	switch (function) {
+	case UNSUPPORTED:
+		return false;
+
+	/* Country tests */
+	case TAG: {
+		CountryInstance const* country = scope.get_country();
+		return country != nullptr && country == get_argument_country(argument, context);
+	}
+	case EXISTS: {
+		CountryInstance const* country = scope.get_country();
+		return country != nullptr && country->exists();
+	}
+	case TAG_EXISTS: {
+		CountryInstance const* country = get_argument_country(argument, context);
+		return country != nullptr && country->exists();
+	}
+	case PRIMARY_CULTURE:
+	case ACCEPTED_CULTURE:
+	case CULTURE: {
+		Culture const* culture = argument.item != nullptr
+			? static_cast<Culture const*>(argument.item) : get_scope_culture(get_argument_scope(argument, context));
+		if (culture == nullptr) {
+			return false;
+		}
+		if (function == CULTURE) {
+			return get_scope_culture(scope) == culture;
+		}
+		CountryInstance const* country = scope.get_country();
+		if (country == nullptr) {
+			return false;
+		}
+		return function == PRIMARY_CULTURE
+			? country->is_primary_culture(*culture) : country->is_primary_or_accepted_culture(*culture);
+	}
+	case RELIGION: {
+		Religion const* religion = argument.item != nullptr
+			? static_cast<Religion const*>(argument.item) : get_scope_religion(get_argument_scope(argument, context));
+		return religion != nullptr && get_scope_religion(scope) == religion;
+	}
+	case OWNS:
+	case CONTROLS:
+	case CAPITAL: {
+		CountryInstance const* country = scope.get_country();
+		ProvinceInstance const* province = get_argument_province(argument, context);
+		if (country == nullptr || province == nullptr) {
+			return false;
+		}
+		switch (function) {
+		case OWNS:
+			return province->get_owner() == country;
+		case CONTROLS:
+			return province->get_controller() == country;
+		default:
+			return country->get_capital() == province;
+		}
+	}
+	case IS_CORE: {
+		using enum identifier_type_t;
+
+		// is_core = TAG in province scope, is_core = PROVINCE_ID in country scope
+		const bool province_scope = argument.item_type == COUNTRY_TAG || (
+			argument.item_type == NO_IDENTIFIER && scope.get_type() <= scope_type_t::PROVINCE
+		);
+		ProvinceInstance const* province = province_scope
+			? scope.get_province() : get_argument_province(argument, context);
+		CountryInstance const* country = province_scope
+			? get_argument_country(argument, context) : scope.get_country();
+		if (province == nullptr || country == nullptr) {
+			return false;
+		}
+		return std::find(province->get_cores().begin(), province->get_cores().end(), country) != province->get_cores().end();
+	}
+	case OWNED_BY:
+	case CONTROLLED_BY: {
+		CountryInstance const* country = get_argument_country(argument, context);
+		if (country == nullptr) {
+			return false;
+		}
+		if (function == OWNED_BY && scope.get_type() == scope_type_t::STATE) {
+			return scope.get_state()->get_owner() == country;
+		}
+		ProvinceInstance const* province = scope.get_province();
+		return province != nullptr && (function == OWNED_BY ? province->get_owner() : province->get_controller()) == country;
+	}
+	case PROVINCE_ID: {
+		ProvinceInstance const* province = scope.get_province();
+		return province != nullptr && province == get_argument_province(argument, context);
+	}
+	default:
+		break;
+	}
+
+	/* Country tests comparing against a registry item */
+	switch (function) {
+	case GOVERNMENT:
+	case RULING_PARTY_IDEOLOGY:
+	case TECH_SCHOOL:
+	case NATIONAL_VALUE:
+	case TECHNOLOGY:
+	case INVENTION:
+	case REFORM:
+	case CIVILISED:
+	case GREAT_POWER:
+	case SECONDARY_POWER:
+	case DISARMED:
+	case MOBILISED:
+	case HAS_COUNTRY_MODIFIER: {
+		CountryInstance const* country = scope.get_country();
+		if (country == nullptr) {
+			return false;
+		}
+		switch (function) {
+		case GOVERNMENT:
+			return is_argument_item(country->get_government_type(), argument);
+		case RULING_PARTY_IDEOLOGY:
+			return country->get_ruling_party() != nullptr
+				&& is_argument_item(&country->get_ruling_party()->get_ideology(), argument);
+		case TECH_SCHOOL:
+			return is_argument_item(country->get_tech_school(), argument);
+		case NATIONAL_VALUE:
+			return is_argument_item(country->get_national_value(), argument);
+		case TECHNOLOGY:
+			return country->is_technology_unlocked(*static_cast<Technology const*>(argument.item));
+		case INVENTION:
+			return country->is_invention_unlocked(*static_cast<Invention const*>(argument.item));
+		case REFORM: {
+			Reform const& reform = *static_cast<Reform const*>(argument.item);
+			return country->get_reforms()[reform.get_reform_group()] == &reform;
+		}
+		case CIVILISED:
+			return country->is_civilised();
+		case GREAT_POWER:
+			return country->is_great_power();
+		case SECONDARY_POWER:
+			return country->is_secondary_power();
+		case DISARMED:
+			return country->is_disarmed();
+		case MOBILISED:
+			return country->is_mobilised();
+		default:
+			return has_event_modifier(country->get_event_modifiers(), argument);
+		}
+	}
+	default:
+		break;
+	}
+
+	/* State tests */
+	switch (function) {
+	case COLONIAL: {
+		State const* state = scope.get_state();
+		return state != nullptr && state->get_colony_status() != ProvinceInstance::colony_status_t::STATE;
+	}
+	case HAS_BUILDING:
+		if (scope.get_type() == scope_type_t::STATE) {
+			std::vector<ProvinceInstance*> const& provinces = scope.get_state()->get_provinces();
+			return std::any_of(provinces.begin(), provinces.end(), [&argument](ProvinceInstance const* province) -> bool {
+				return has_building(province, argument);
+			});
+		}
+		return has_building(scope.get_province(), argument);
+	default:
+		break;
+	}
+
+	/* Pop tests */
+	switch (function) {
+	case POP_TYPE:
+	case STRATA: {
+		Pop const* pop = scope.get_pop();
+		if (pop == nullptr || pop->get_type() == nullptr) {
+			return false;
+		}
+		return function == POP_TYPE
+			? is_argument_item(pop->get_type(), argument) : is_argument_item(&pop->get_type()->get_strata(), argument);
+	}
+	default:
+		break;
+	}
+
+	/* Province tests */
+	ProvinceInstance const* province = scope.get_province();
+	if (province == nullptr) {
+		return false;
+	}
+	ProvinceDefinition const& province_definition = province->get_province_definition();
+
+	switch (function) {
+	case REGION:
+		return static_cast<Region const*>(argument.item)->contains_province(&province_definition);
+	case CONTINENT:
+		return is_argument_item(province_definition.get_continent(), argument);
+	case TERRAIN:
+		return is_argument_item(province->get_terrain_type(), argument);
+	case TRADE_GOODS:
+		return is_argument_item(province->get_rgo_good(), argument);
+	case HAS_CRIME:
+		return is_argument_item(province->get_crime(), argument);
+	case COASTAL:
+		return province_definition.is_coastal();
+	case PORT:
+		return province_definition.has_port();
+	case IS_CAPITAL:
+		return province->get_owner() != nullptr && province->get_owner()->get_capital() == province;
+	case HAS_PROVINCE_MODIFIER:
+		return has_event_modifier(province->get_event_modifiers(), argument);
+	case SLAVE:
+		return province->get_slave();
+	default:
+		return false;
+	}
+}
+
+static ConditionScope switch_scope(
+	scope_function_t function, ConditionScope scope, argument_t const& argument, ConditionContext const& context
+) {
+	using enum scope_function_t;
+
+	switch (function) {
+	case THIS:
+		return context.this_scope;
+	case FROM:
+		return context.from_scope;
+	case OWNER:
+	case COUNTRY:
+		return scope.get_type() != scope_type_t::COUNTRY ? scope.get_country() : nullptr;
+	case CONTROLLER: {
+		ProvinceInstance const* province = scope.get_province();
+		return province != nullptr ? province->get_controller() : nullptr;
+	}
+	case LOCATION: {
+		Pop const* pop = scope.get_pop();
+		return pop != nullptr ? pop->get_location() : nullptr;
+	}
+	case STATE:
+		return scope.get_state();
+	case CAPITAL: {
+		CountryInstance const* country = scope.get_country();
+		return country != nullptr ? country->get_capital() : nullptr;
+	}
+	case ARGUMENT_COUNTRY: {
+		CountryInstance const* country = get_argument_country(argument, context);
+		return country != nullptr && country->exists() ? country : nullptr;
+	}
+	case ARGUMENT_PROVINCE:
+		return get_argument_province(argument, context);
+	default:
+		return {};
+	}
+}
+
+namespace {
+	/* Position in an iteration, inner indexes the collection while outer indexes the province whose pops are being
+	 * iterated over by any_pop. */
+	struct iteration_state_t {
+		uint32_t outer;
+		uint32_t inner;
+	};
+}
+
+static ProvinceInstance const* get_pop_iteration_province(ConditionScope parent, uint32_t index) {
+	switch (parent.get_type()) {
+	case scope_type_t::PROVINCE:
+		return index == 0 ? parent.get_province() : nullptr;
+	case scope_type_t::STATE: {
+		std::vector<ProvinceInstance*> const& provinces = parent.get_state()->get_provinces();
+		return index < provinces.size() ? provinces[index] : nullptr;
+	}
+	case scope_type_t::COUNTRY: {
+		ordered_set<ProvinceInstance*> const& provinces = parent.get_country()->get_owned_provinces();
+		return index < provinces.size() ? *provinces.nth(index) : nullptr;
+	}
+	default:
+		return nullptr;
+	}
+}
+
+/* Returns the element at or after iteration's position, moving the position onto it, or an invalid scope if there
+ * are no elements left. */
+static ConditionScope get_iteration_element(
+	iteration_function_t function, ConditionScope parent, iteration_state_t& iteration, ConditionContext const& context
+) {
+	using enum iteration_function_t;
+
+	CountryInstance const* country = parent.get_type() == scope_type_t::COUNTRY ? parent.get_country() : nullptr;
+
+	switch (function) {
+	case OWNED_PROVINCE:
+		if (country != nullptr && iteration.inner < country->get_owned_provinces().size()) {
+			return *country->get_owned_provinces().nth(iteration.inner);
+		}
+		return {};
+	case CORE:
+		if (country != nullptr && iteration.inner < country->get_core_provinces().size()) {
+			return *country->get_core_provinces().nth(iteration.inner);
+		}
+		return {};
+	case STATE:
+		if (country != nullptr && iteration.inner < country->get_states().size()) {
+			return *country->get_states().nth(iteration.inner);
+		}
+		return {};
+	case POP: {
+		PopStore const& pop_store = context.map_instance.get_pop_store();
+		for (
+			ProvinceInstance const* province = get_pop_iteration_province(parent, iteration.outer);
+			province != nullptr;
+			province = get_pop_iteration_province(parent, ++iteration.outer)
+		) {
+			if (iteration.inner < province->get_pop_handles().size()) {
+				return &pop_store.get_pop(province->get_pop_handles()[iteration.inner]);
+			}
+			iteration.inner = 0;
+		}
+		return {};
+	}
+	default:
+		return {};
+	}
+}
+
+bool ConditionBytecode::_execute(size_t begin, size_t end, ConditionScope scope, ConditionContext const& context) const {
+	using enum opcode_t;
+
+	static const argument_t no_argument { nullptr, identifier_type_t::NO_IDENTIFIER, scope_type_t::NO_SCOPE };
+
+	std::array<fixed_point_t, MAX_STACK_DEPTH> stack;
+	std::array<ConditionScope, MAX_SCOPE_DEPTH + 1> scopes;
+	std::array<iteration_state_t, MAX_SCOPE_DEPTH> iterations;
+	size_t stack_size = 0, scope_index = 0, iteration_count = 0;
+
+	scopes[0] = scope;
+
+	const auto get_argument = [this](uint32_t index) -> argument_t const& {
+		return index < arguments.size() ? arguments[index] : no_argument;
+	};
+	const auto push_bool = [&stack, &stack_size](bool value) -> void {
+		stack[stack_size++] = value ? fixed_point_t::_1() : fixed_point_t::_0();
+	};
+
+	size_t position = begin;
+	while (position < end) {
+		instruction_t const& instruction = instructions[position++];
+
+		switch (instruction.opcode) {
+		case PUSH_CONSTANT:
+			stack[stack_size++] = constants[instruction.operand];
+			break;
+		case LOAD_VALUE:
+			stack[stack_size++] = load_value(
+				static_cast<value_function_t>(instruction.function), scopes[scope_index],
+				get_argument(instruction.operand), context
+			);
+			break;
+		case TEST:
+			push_bool(run_test(
+				static_cast<test_function_t>(instruction.function), scopes[scope_index],
+				get_argument(instruction.operand), context
+			));
+			break;
+		case GREATER_EQUAL:
+		case LESS_EQUAL: {
+			const fixed_point_t rhs = stack[--stack_size];
+			const fixed_point_t lhs = stack[--stack_size];
+			push_bool(instruction.opcode == GREATER_EQUAL ? lhs >= rhs : lhs <= rhs);
+			break;
+		}
+		case NOT:
+			push_bool(stack[--stack_size] == fixed_point_t::_0());
+			break;
+		case JUMP_IF_FALSE:
+		case JUMP_IF_TRUE:
+			if ((stack[stack_size - 1] != fixed_point_t::_0()) == (instruction.opcode == JUMP_IF_TRUE)) {
+				position = instruction.jump;
+			} else {
+				--stack_size;
+			}
+			break;
+		case ENTER_SCOPE: {
+			const ConditionScope new_scope = switch_scope(
+				static_cast<scope_function_t>(instruction.function), scopes[scope_index],
+				get_argument(instruction.operand), context
+			);
+			if (new_scope.is_valid()) {
+				scopes[++scope_index] = new_scope;
+			} else {
+				push_bool(false);
+				position = instruction.jump;
+			}
+			break;
+		}
+		case LEAVE_SCOPE:
+			--scope_index;
+			break;
+		case BEGIN_ITERATION: {
+			iteration_state_t& iteration = iterations[iteration_count];
+			iteration = { 0, 0 };
+			const ConditionScope element = get_iteration_element(
+				static_cast<iteration_function_t>(instruction.function), scopes[scope_index], iteration, context
+			);
+			if (element.is_valid()) {
+				++iteration_count;
+				scopes[++scope_index] = element;
+			} else {
+				// "any" over nothing is false, "all" over nothing is true
+				push_bool(instruction.operand != 0);
+				position = instruction.jump;
+			}
+			break;
+		}
+		case NEXT_ITERATION: {
+			// Keep going while "any" keeps failing or "all" keeps succeeding
+			const bool is_all = instruction.operand != 0;
+			if ((stack[stack_size - 1] != fixed_point_t::_0()) == is_all) {
+				iteration_state_t& iteration = iterations[iteration_count - 1];
+				++iteration.inner;
+				const ConditionScope element = get_iteration_element(
+					static_cast<iteration_function_t>(instruction.function), scopes[scope_index - 1], iteration, context
+				);
+				if (element.is_valid()) {
+					scopes[scope_index] = element;
+					--stack_size;
+					position = instruction.jump;
+					break;
+				}
+			}
+			--iteration_count;
+			--scope_index;
+			break;
+		}
+		}
+	}
+
+	return stack_size > 0 && stack[stack_size - 1] != fixed_point_t::_0();
+}
+
+bool ConditionBytecode::evaluate(ConditionScope scope, ConditionContext const& context) const {
+	return instructions.empty() || _execute(0, instructions.size(), scope, context);
+}
+
+bool ConditionBytecode::_evaluate_root_conditions(
+	bool pop_dependent, ConditionScope scope, ConditionContext const& context
+) const {
+	for (root_condition_t const& condition : root_conditions) {
+		if (condition.pop_dependent == pop_dependent && !_execute(condition.begin, condition.end, scope, context)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ConditionBytecode::evaluate_pop_independent(ConditionScope scope, ConditionContext const& context) const {
+	return _evaluate_root_conditions(false, scope, context);
+}
+
+bool ConditionBytecode::evaluate_pop_dependent(ConditionScope scope, ConditionContext const& context) const {
+	return _evaluate_root_conditions(true, scope, context);
+}
@@ -0,0 +1,186 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include "openvic-simulation/scripts/Condition.hpp"
+#include "openvic-simulation/types/Date.hpp"
+#include "openvic-simulation/types/OrderedContainers.hpp"
+#include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
+#include "openvic-simulation/utility/Getters.hpp"
+
+namespace OpenVic {
+	struct Pop;
+	struct ProvinceInstance;
+	struct State;
+	struct CountryInstance;
+	struct MapInstance;
+	struct CountryInstanceManager;
+
+	/* The instance a condition is evaluated against, tagged with its scope type. The getters walk up the scope
+	 * hierarchy when the scope isn't of the requested type (e.g. get_country on a pop returns its location's owner),
+	 * returning nullptr if there is nothing to walk up to. */
+	struct ConditionScope {
+	private:
+		scope_type_t PROPERTY(type);
+		void const* target;
+
+	public:
+		constexpr ConditionScope() : type { scope_type_t::NO_SCOPE }, target { nullptr } {}
+		ConditionScope(Pop const* pop);
+		ConditionScope(ProvinceInstance const* province);
+		ConditionScope(State const* state);
+		ConditionScope(CountryInstance const* country);
+
+		constexpr bool is_valid() const {
+			return target != nullptr;
+		}
+
+		Pop const* get_pop() const;
+		ProvinceInstance const* get_province() const;
+		State const* get_state() const;
+		CountryInstance const* get_country() const;
+	};
+
+	/* Everything outside of the current scope that a condition may need to look at. */
+	struct ConditionContext {
+		MapInstance const& map_instance;
+		CountryInstanceManager const& country_instance_manager;
+		const Date today;
+		const ConditionScope this_scope;
+		const ConditionScope from_scope;
+	};
+
+	/* A ConditionNode tree flattened into a linear instruction list for a small stack machine. AND/OR/NOT lists
+	 * become short-circuiting jump chains, scope changes push and pop a scope stack and iterations loop over their
+	 * body, so evaluation is a single pass over the instructions with fixed-size stacks and no allocation.
+	 *
+	 * Leaves are resolved against the current scope at evaluation time, walking up the scope hierarchy as Paradox
+	 * does (e.g. literacy in a province scope compares the province's average literacy). Conditions without an
+	 * implementation compile to an UNSUPPORTED test which is always false, and are counted so callers can report
+	 * how much of a script is actually being checked. */
+	struct ConditionBytecode {
+		enum struct opcode_t : uint8_t {
+			PUSH_CONSTANT,   // push constants[operand]
+			LOAD_VALUE,      // push value_function_t(function) of the current scope, using arguments[operand]
+			TEST,            // push test_function_t(function) of the current scope, using arguments[operand]
+			GREATER_EQUAL,   // pop b, pop a, push a >= b
+			LESS_EQUAL,      // pop b, pop a, push a <= b
+			NOT,             // replace the top of the stack with its negation
+			JUMP_IF_FALSE,   // if the top is false jump to jump and keep it, otherwise pop it
+			JUMP_IF_TRUE,    // if the top is true jump to jump and keep it, otherwise pop it
+			ENTER_SCOPE,     // push scope_function_t(function) of the current scope, or push false and jump to jump
+			LEAVE_SCOPE,     // pop the current scope
+			BEGIN_ITERATION, // start iteration_function_t(function), operand is 1 for "all", 0 for "any"
+			NEXT_ITERATION   // short-circuit or move to the next element and jump back to the body at jump
+		};
+
+		enum struct value_function_t : uint16_t {
+			YEAR, MONTH, LITERACY, CONSCIOUSNESS, MILITANCY, PRESTIGE, MONEY, WAR_EXHAUSTION, PLURALITY, REVANCHISM,
+			TOTAL_POPULATION, STATE_COUNT, RANK, LIFE_RATING, LIFE_NEEDS, EVERYDAY_NEEDS, LUXURY_NEEDS, POP_TYPE_SHARE,
+			IDEOLOGY_SHARE, ISSUE_SUPPORT
+		};
+
+		enum struct test_function_t : uint16_t {
+			UNSUPPORTED, TAG, EXISTS, TAG_EXISTS, GOVERNMENT, PRIMARY_CULTURE, ACCEPTED_CULTURE, CULTURE, RELIGION,
+			RULING_PARTY_IDEOLOGY, TECH_SCHOOL, NATIONAL_VALUE, OWNS, CONTROLS, CAPITAL, IS_CORE, TECHNOLOGY, INVENTION,
+			REFORM, CIVILISED, GREAT_POWER, SECONDARY_POWER, DISARMED, MOBILISED, HAS_COUNTRY_MODIFIER, OWNED_BY,
+			CONTROLLED_BY, PROVINCE_ID, REGION, CONTINENT, TERRAIN, TRADE_GOODS, HAS_CRIME, COASTAL, PORT, IS_CAPITAL,
+			HAS_BUILDING, HAS_PROVINCE_MODIFIER, SLAVE, COLONIAL, POP_TYPE, STRATA
+		};
+
+		enum struct scope_function_t : uint16_t {
+			THIS, FROM, OWNER, CONTROLLER, LOCATION, STATE, CAPITAL, COUNTRY, ARGUMENT_COUNTRY, ARGUMENT_PROVINCE
+		};
+
+		enum struct iteration_function_t : uint16_t {
+			OWNED_PROVINCE, CORE, STATE, POP
+		};
+
+		struct instruction_t {
+			opcode_t opcode;
+			uint16_t function;
+			uint32_t operand;
+			uint32_t jump;
+		};
+
+		/* An item a leaf compares against. If item is nullptr then the THIS or FROM scope stands in for it, as with
+		 * tag = THIS, and item_type records which kind of item was parsed when the condition accepts several. */
+		struct argument_t {
+			HasIdentifier const* item;
+			identifier_type_t item_type;
+			scope_type_t scope;
+		};
+
+		/* A condition in the root list, covering instructions [begin, end). It is pop dependent if it reads data from
+		 * a pop in the initial scope, rather than only from things it shares with every other pop in its province. */
+		struct root_condition_t {
+			uint32_t begin;
+			uint32_t end;
+			bool pop_dependent;
+		};
+
+		static constexpr size_t MAX_STACK_DEPTH = 64;
+		static constexpr size_t MAX_SCOPE_DEPTH = 16;
+		static constexpr uint32_t NO_ARGUMENT = std::numeric_limits<uint32_t>::max();
+
+	private:
+		struct compile_state_t;
+
+		std::vector<instruction_t> PROPERTY(instructions);
+		std::vector<fixed_point_t> constants;
+		std::vector<argument_t> arguments;
+		std::vector<root_condition_t> PROPERTY(root_conditions);
+		/* Unsupported conditions compile to false, so scripts which must not pass by accident, such as event triggers,
+		 * should check this rather than rely on evaluation, as under a NOT they become true. */
+		size_t PROPERTY(unsupported_condition_count);
+		bool PROPERTY_CUSTOM_PREFIX(pop_dependent, is);
+
+		/* How many times each unsupported condition has been compiled since the last log_unsupported_conditions, null
+		 * standing in for invalid conditions. Scripts are compiled one at a time, so this needs no locking. */
+		static inline ordered_map<Condition const*, size_t> unsupported_condition_tally;
+
+		size_t _emit(opcode_t opcode, uint16_t function = 0, uint32_t operand = 0, uint32_t jump = 0);
+		void _patch_jump(size_t instruction_index);
+		uint32_t _add_constant(fixed_point_t constant);
+		uint32_t _add_argument(argument_t const& argument);
+
+		bool _compile_node(ConditionNode const& node, compile_state_t& state);
+		bool _compile_list(std::span<const ConditionNode> nodes, bool is_and, compile_state_t& state);
+		bool _compile_scope(ConditionNode const& node, compile_state_t& state);
+		bool _compile_leaf(ConditionNode const& node, compile_state_t& state);
+		bool _compile_comparison(
+			value_function_t function, uint32_t argument, ConditionNode::value_t const& value, bool less_equal,
+			compile_state_t& state
+		);
+		void _compile_test(test_function_t function, uint32_t argument, bool expected, compile_state_t& state);
+		void _compile_unsupported(ConditionNode const& node, compile_state_t& state);
+
+		bool _execute(size_t begin, size_t end, ConditionScope scope, ConditionContext const& context) const;
+		bool _evaluate_root_conditions(bool pop_dependent, ConditionScope scope, ConditionContext const& context) const;
+
+	public:
+		ConditionBytecode();
+
+		bool empty() const;
+		void clear();
+
+		/* Replaces any existing bytecode with a compiled version of root, which must be an AND-style list of
+		 * conditions (as produced for the root of a ConditionScript). */
+		bool compile(ConditionNode const& root);
+
+		/* Logs one warning per unsupported condition compiled since the last call, with how many times it was found,
+		 * rather than one per occurrence. */
+		static void log_unsupported_conditions();
+
+		/* Empty bytecode, e.g. for a script with no conditions, always evaluates to true. */
+		bool evaluate(ConditionScope scope, ConditionContext const& context) const;
+
+		/* Split evaluation for batches of pops in the same province: the result for a pop is the AND of both halves,
+		 * and the pop independent half only needs evaluating once for the whole batch, using any of its pops. */
+		bool evaluate_pop_independent(ConditionScope scope, ConditionContext const& context) const;
+		bool evaluate_pop_dependent(ConditionScope scope, ConditionContext const& context) const;
+	};
+}
@@ -10,11 +10,20 @@ ConditionScript::ConditionScript(
 ) : initial_scope { new_initial_scope }, this_scope { new_this_scope }, from_scope { new_from_scope } {}
 
 bool ConditionScript::_parse_script(ast::NodeCPtr root, DefinitionManager const& definition_manager) {
-	return definition_manager.get_script_manager().get_condition_manager().expect_condition_script(
+	bool ret = definition_manager.get_script_manager().get_condition_manager().expect_condition_script(
 		definition_manager,
 		initial_scope,
 		this_scope,
 		from_scope,
 		move_variable_callback(condition_root)
 	)(root);
+
+	// Scripts are parsed once every definition is loaded, so all condition items are already resolved
+	ret &= bytecode.compile(condition_root);
+
+	return ret;
+}
+
+bool ConditionScript::evaluate(ConditionScope scope, ConditionContext const& context) const {
+	return bytecode.evaluate(scope, context);
 }
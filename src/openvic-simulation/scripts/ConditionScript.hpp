@@ -1,6 +1,7 @@
 #pragma once
 
 #include "openvic-simulation/scripts/Condition.hpp"
+#include "openvic-simulation/scripts/ConditionBytecode.hpp"
 #include "openvic-simulation/scripts/Script.hpp"
 
 namespace OpenVic {
@@ -13,11 +14,15 @@ namespace OpenVic {
 		scope_type_t PROPERTY(initial_scope);
 		scope_type_t PROPERTY(this_scope);
 		scope_type_t PROPERTY(from_scope);
+		ConditionBytecode PROPERTY(bytecode);
 
 	protected:
 		bool _parse_script(ast::NodeCPtr root, DefinitionManager const& definition_manager) override;
 
 	public:
 		ConditionScript(scope_type_t new_initial_scope, scope_type_t new_this_scope, scope_type_t new_from_scope);
+
+		/* Scripts that haven't been parsed, or have no conditions, evaluate to true. */
+		bool evaluate(ConditionScope scope, ConditionContext const& context) const;
 	};
 }
@@ -1,5 +1,9 @@
 #include "ConditionalWeight.hpp"
 
+#include <algorithm>
+
+#include "openvic-simulation/pop/PopStore.hpp"
+
 using namespace OpenVic;
 using namespace OpenVic::NodeTools;
 
@@ -132,3 +136,74 @@ struct ConditionalWeight::parse_scripts_visitor_t {
 bool ConditionalWeight::parse_scripts(DefinitionManager const& definition_manager) {
 	return parse_scripts_visitor_t { definition_manager }(condition_weight_items);
 }
+
+template<typename Func>
+void ConditionalWeight::_for_each_condition_weight(Func func) const {
+	for (condition_weight_item_t const& item : condition_weight_items) {
+		if (condition_weight_t const* condition_weight = std::get_if<condition_weight_t>(&item)) {
+			func(*condition_weight);
+		} else {
+			for (condition_weight_t const& grouped_condition_weight : std::get<condition_weight_group_t>(item)) {
+				func(grouped_condition_weight);
+			}
+		}
+	}
+}
+
+fixed_point_t ConditionalWeight::evaluate(ConditionScope scope, ConditionContext const& context) const {
+	fixed_point_t weight = base;
+
+	_for_each_condition_weight([&weight, scope, &context](condition_weight_t const& condition_weight) -> void {
+		if (condition_weight.second.evaluate(scope, context)) {
+			weight *= condition_weight.first;
+		}
+	});
+
+	return weight;
+}
+
+void ConditionalWeight::evaluate_pops(
+	PopStore const& pop_store, std::span<const uint32_t> pop_handles, ConditionContext const& context,
+	std::span<fixed_point_t> weights
+) const {
+	static_assert(std::is_same_v<PopStore::handle_t, uint32_t>);
+
+	if (weights.size() != pop_handles.size()) {
+		Logger::error(
+			"Cannot evaluate ConditionalWeight for ", pop_handles.size(), " pops with ", weights.size(), " weight slots!"
+		);
+		return;
+	}
+
+	std::fill(weights.begin(), weights.end(), base);
+
+	if (pop_handles.empty()) {
+		return;
+	}
+
+	// Every pop shares its location with the first, so they all get the same pop independent results
+	const ConditionScope first_pop { &pop_store.get_pop(pop_handles.front()) };
+
+	_for_each_condition_weight(
+		[&pop_store, pop_handles, &context, weights, first_pop](condition_weight_t const& condition_weight) -> void {
+			ConditionBytecode const& bytecode = condition_weight.second.get_bytecode();
+
+			if (!bytecode.evaluate_pop_independent(first_pop, context)) {
+				return;
+			}
+
+			if (!bytecode.is_pop_dependent()) {
+				for (fixed_point_t& weight : weights) {
+					weight *= condition_weight.first;
+				}
+				return;
+			}
+
+			for (size_t index = 0; index < pop_handles.size(); ++index) {
+				if (bytecode.evaluate_pop_dependent(&pop_store.get_pop(pop_handles[index]), context)) {
+					weights[index] *= condition_weight.first;
+				}
+			}
+		}
+	);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <span>
 #include <variant>
 #include <vector>
 
@@ -8,6 +9,10 @@
 #include "openvic-simulation/types/fixed_point/FixedPoint.hpp"
 
 namespace OpenVic {
+	struct PopStore;
+
+	/* The base value multiplied by the factor of every modifier whose conditions hold. Modifiers in a group are
+	 * applied the same way as ungrouped modifiers. */
 	struct ConditionalWeight {
 		using condition_weight_t = std::pair<fixed_point_t, ConditionScript>;
 		using condition_weight_group_t = std::vector<condition_weight_t>;
@@ -27,6 +32,9 @@ namespace OpenVic {
 
 		struct parse_scripts_visitor_t;
 
+		template<typename Func>
+		void _for_each_condition_weight(Func func) const;
+
 	public:
 		ConditionalWeight(scope_type_t new_initial_scope, scope_type_t new_this_scope, scope_type_t new_from_scope);
 		ConditionalWeight(ConditionalWeight&&) = default;
@@ -34,5 +42,16 @@ namespace OpenVic {
 		NodeTools::node_callback_t expect_conditional_weight(base_key_t base_key);
 
 		bool parse_scripts(DefinitionManager const& definition_manager);
+
+		fixed_point_t evaluate(ConditionScope scope, ConditionContext const& context) const;
+
+		/* Fills weights with the weight of each pop in pop_handles (PopStore handles, which can't be named here as Pop.hpp
+		 * includes this header), which must all be in the same province. Conditions
+		 * which don't depend on the pops themselves are evaluated once for the whole batch, leaving only the pop
+		 * dependent conditions of modifiers that could still apply to be evaluated per pop. */
+		void evaluate_pops(
+			PopStore const& pop_store, std::span<const uint32_t> pop_handles, ConditionContext const& context,
+			std::span<fixed_point_t> weights
+		) const;
 	};
 }
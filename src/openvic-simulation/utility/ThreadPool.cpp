@@ -0,0 +1,122 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+using namespace OpenVic;
+
+ThreadPool::ThreadPool(size_t thread_count) {
+	if (thread_count == 0) {
+		thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	workers.reserve(thread_count - 1);
+	for (size_t index = 1; index < thread_count; ++index) {
+		workers.emplace_back(&ThreadPool::_worker_loop, this);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		const std::lock_guard lock { mutex };
+		stopping = true;
+	}
+	work_available.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+size_t ThreadPool::get_thread_count() const {
+	return workers.size() + 1;
+}
+
+void ThreadPool::_run_chunks(chunk_func_t const& func, size_t item_count, size_t chunk_size, size_t chunk_count) {
+	for (
+		size_t chunk_index = next_chunk.fetch_add(1, std::memory_order_relaxed);
+		chunk_index < chunk_count;
+		chunk_index = next_chunk.fetch_add(1, std::memory_order_relaxed)
+	) {
+		const size_t begin = chunk_index * chunk_size;
+		func(chunk_index, begin, std::min(begin + chunk_size, item_count));
+	}
+}
+
+void ThreadPool::_worker_loop() {
+	size_t seen_generation = 0;
+
+	while (true) {
+		chunk_func_t const* func;
+		size_t item_count, chunk_size, chunk_count;
+
+		{
+			std::unique_lock lock { mutex };
+			work_available.wait(lock, [this, seen_generation]() -> bool {
+				return stopping || job_generation != seen_generation;
+			});
+
+			if (stopping) {
+				return;
+			}
+
+			seen_generation = job_generation;
+
+			// Woke up after the job this generation refers to had already completed
+			if (job_func == nullptr) {
+				continue;
+			}
+
+			func = job_func;
+			item_count = job_item_count;
+			chunk_size = job_chunk_size;
+			chunk_count = job_chunk_count;
+			++workers_busy;
+		}
+
+		_run_chunks(*func, item_count, chunk_size, chunk_count);
+
+		{
+			const std::lock_guard lock { mutex };
+			--workers_busy;
+		}
+		work_finished.notify_one();
+	}
+}
+
+void ThreadPool::parallel_for(size_t item_count, size_t chunk_size, chunk_func_t func) {
+	const size_t chunk_count = get_chunk_count(item_count, chunk_size);
+
+	if (chunk_count == 0) {
+		return;
+	}
+
+	// Nothing to share, skip the synchronisation overhead
+	if (chunk_count == 1 || workers.empty()) {
+		for (size_t chunk_index = 0; chunk_index < chunk_count; ++chunk_index) {
+			const size_t begin = chunk_index * chunk_size;
+			func(chunk_index, begin, std::min(begin + chunk_size, item_count));
+		}
+		return;
+	}
+
+	{
+		const std::lock_guard lock { mutex };
+		job_func = &func;
+		job_item_count = item_count;
+		job_chunk_size = chunk_size;
+		job_chunk_count = chunk_count;
+		next_chunk.store(0, std::memory_order_relaxed);
+		++job_generation;
+	}
+	work_available.notify_all();
+
+	_run_chunks(func, item_count, chunk_size, chunk_count);
+
+	// Every chunk has been claimed at this point, wait for workers still running theirs. Workers which woke up late
+	// see an exhausted chunk counter and go straight back to waiting.
+	std::unique_lock lock { mutex };
+	work_finished.wait(lock, [this]() -> bool {
+		return workers_busy == 0;
+	});
+	job_func = nullptr;
+}
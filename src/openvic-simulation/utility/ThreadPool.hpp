@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "openvic-simulation/types/FunctionRef.hpp"
+
+namespace OpenVic {
+	/* Fixed-size pool of worker threads used to run data-parallel phases of the simulation. Work is split into
+	 * fixed-size chunks which idle threads claim from a shared counter, so faster threads pick up more chunks.
+	 * Which thread runs a chunk is non-deterministic, but chunk boundaries are not, so callers which write
+	 * per-chunk results and reduce them in chunk order get identical results regardless of thread count. */
+	struct ThreadPool {
+		/* func(chunk_index, begin, end), called once for every chunk covering [begin, end). */
+		using chunk_func_t = FunctionRef<void(size_t, size_t, size_t)>;
+
+	private:
+		std::vector<std::thread> workers;
+
+		std::mutex mutex;
+		std::condition_variable work_available;
+		std::condition_variable work_finished;
+
+		/* Current job, only valid while job_generation is ahead of a worker's last seen generation. */
+		chunk_func_t const* job_func = nullptr;
+		size_t job_item_count = 0;
+		size_t job_chunk_size = 0;
+		size_t job_chunk_count = 0;
+		std::atomic<size_t> next_chunk = 0;
+		size_t workers_busy = 0;
+		size_t job_generation = 0;
+		bool stopping = false;
+
+		void _worker_loop();
+		void _run_chunks(chunk_func_t const& func, size_t item_count, size_t chunk_size, size_t chunk_count);
+
+	public:
+		/* A thread_count of 0 uses one thread per hardware thread. The calling thread always takes part in
+		 * parallel_for, so thread_count - 1 workers are spawned. */
+		ThreadPool(size_t thread_count = 0);
+		ThreadPool(ThreadPool const&) = delete;
+		ThreadPool& operator=(ThreadPool const&) = delete;
+		~ThreadPool();
+
+		/* Total number of threads that take part in parallel_for, including the calling thread. */
+		size_t get_thread_count() const;
+
+		static constexpr size_t get_chunk_count(size_t item_count, size_t chunk_size) {
+			return chunk_size > 0 ? (item_count + chunk_size - 1) / chunk_size : 0;
+		}
+
+		/* Blocks until func has been called for every chunk of [0, item_count). Must not be called re-entrantly
+		 * from inside func. */
+		void parallel_for(size_t item_count, size_t chunk_size, chunk_func_t func);
+	};
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <climits>
+#include <cstdint>
 #include <functional>
 #include <type_traits>
 
@@ -37,6 +38,15 @@ namespace OpenVic::utility {
 		s ^= h(v) + 0x9e3779b9 + (s << 6) + (s >> 2);
 	}
 
+	/* SplitMix64 finaliser, used to hash a draw's identity into an evenly distributed random value, so that seeded
+	 * random draws don't depend on the order they're made in. */
+	inline constexpr uint64_t mix_bits(uint64_t value) {
+		value += 0x9E3779B97F4A7C15;
+		value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+		value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+		return value ^ (value >> 31);
+	}
+
 	template<size_t Shift, class T>
 	inline constexpr void hash_combine_index(std::size_t& s, T const& v) {
 		std::hash<T> h;